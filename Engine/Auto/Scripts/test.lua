@@ -6,6 +6,50 @@
 TestsPath = path.join(RootPath, "Tests")
 print("Make tests : "..TestsPath)
 
+-- Runtime source files which are compiled into tests directly as tests don't link Engine library.
+TestRuntimeSources = {
+	ECWorld = {
+		"ECWorld/ArchetypeStorage.cpp",
+		"ECWorld/CullingSystem.cpp",
+		"ECWorld/EntityCommandBuffer.cpp",
+		"ECWorld/TransformComponent.cpp",
+		"ECWorld/TransformSystem.cpp",
+		"Rendering/OcclusionBuffer.cpp",
+		"Scheduler/ThreadPool.cpp",
+	},
+	Rendering = {
+		"Rendering/LightClusters.cpp",
+		"Rendering/MeshLOD.cpp",
+		"Rendering/MeshOptimizer.cpp",
+		"Rendering/OcclusionBuffer.cpp",
+		"Rendering/OffsetAllocator.cpp",
+		"Rendering/RenderGraph.cpp",
+		"Rendering/RenderQueue.cpp",
+		"Rendering/ShadowAtlas.cpp",
+		"Rendering/ShadowCache.cpp",
+		"Rendering/VertexQuantization.cpp",
+	},
+	Resources = {
+		"Rendering/Resources/ResourceScheduler.cpp",
+		"Scheduler/ThreadPool.cpp",
+	},
+	Scheduler = {
+		"Scheduler/SystemScheduler.cpp",
+		"Scheduler/ThreadPool.cpp",
+	},
+	Snapshot = {
+		"Resources/BinarySnapshot.cpp",
+		"Resources/MappedFile.cpp",
+	},
+}
+
+-- AssetPipeline libraries which tests link to use its types such as cd::Mesh.
+TestAssetPipelineLinks = {
+	Rendering = {
+		"AssetPipelineCore",
+	},
+}
+
 function MakeTest(testName)
 	local testSourcePath = path.join(TestsPath, testName)
 
@@ -21,6 +65,26 @@ function MakeTest(testName)
 			["Source"] = { path.join(testSourcePath, "**.*") },
 		}
 
+		for _, runtimeSource in ipairs(TestRuntimeSources[testName] or {}) do
+			files {
+				path.join(EngineSourcePath, "Runtime", runtimeSource),
+			}
+
+			vpaths {
+				["Runtime"] = { path.join(EngineSourcePath, "Runtime", runtimeSource) },
+			}
+		end
+
+		local assetPipelineLinks = TestAssetPipelineLinks[testName]
+		if assetPipelineLinks then
+			libdirs {
+				path.join(ThirdPartySourcePath, "AssetPipeline/build/bin/%{cfg.buildcfg}"),
+			}
+
+			links(assetPipelineLinks)
+			CopyDllAutomatically()
+		end
+
 		includedirs {
 			path.join(EngineSourcePath, "Runtime/"),
 			ThirdPartySourcePath,
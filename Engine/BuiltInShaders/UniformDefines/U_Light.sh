@@ -8,12 +8,24 @@
 #define TUBE_LIGHT 6
 
 #define LIGHT_LENGTH 21	
-#define LIGHT_TRANSFORM_LENGTH 12 
 
 /*
-LIGHT_LENGTH = num of lights(3) * num of total vec4 in one light(7)
-LIGHT_TRANSFORM_LENGTH  = num of lights(3) * max num of total mat4 of light transform for different kind of light(4)
+LIGHT_LENGTH = num of lights read from uniforms by terrain and DDGI shaders(3) * num of total vec4 in one light(7)
+Shadow views of all lights are read from a texture, see U_Shadow.sh.
 */
+
+// Clustered lights : camera frustum is divided into X * Y tiles in screen space and Z slices in exponential view depth.
+// Light parameters are read from a texture with one row per light. Cluster ranges and light indices share another texture.
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define MAX_CLUSTERED_LIGHT_COUNT 256
+#define LIGHT_CLUSTER_TEXTURE_WIDTH 1024
+#define LIGHT_CLUSTER_TEXTURE_HEIGHT 64
+// Terrain maps use the same slots but terrain shaders don't read clustered lights.
+#define LIGHT_PARAMS_SLOT 7
+#define LIGHT_CLUSTER_SLOT 8
+
 struct U_Light {
 	// vec4 * 7
 	float type;
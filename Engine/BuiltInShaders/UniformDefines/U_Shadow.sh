@@ -1,3 +1,10 @@
-#define SHADOW_MAP_CUBE_FIRST_SLOT  11
-#define SHADOW_MAP_CUBE_SECOND_SLOT 12
-#define SHADOW_MAP_CUBE_THIRD_SLOT  13
+// All shadow views are rendered into one depth atlas.
+#define SHADOW_MAP_ATLAS_SIZE 4096
+#define SHADOW_MAP_ATLAS_SLOT 11
+
+// Shadow views : one row per view. Texels 0 - 3 are columns of the matrix from world space to atlas uv and depth,
+// texel 4 is the uv range of the view in the atlas. Every view is rendered by its own bgfx views so the count is limited.
+#define MAX_SHADOW_VIEW_COUNT 64
+#define SHADOW_VIEW_TEXTURE_WIDTH 5
+// Terrain elevation map uses the same slot but only in vertex shader.
+#define SHADOW_VIEWS_SLOT 10
\ No newline at end of file
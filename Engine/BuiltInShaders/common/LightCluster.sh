@@ -0,0 +1,76 @@
+//----------------------------------------------------------------------------------------------------------------//
+// @brief Calculates the contribution of global lights and local lights in the cluster of the fragment.            //
+//                                                                                                                //
+// vec3 CalculateClusteredLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF, float csmDepth) //
+//----------------------------------------------------------------------------------------------------------------//
+
+// Should be included after LightSource.sh.
+
+SAMPLER2D(s_lightParams, LIGHT_PARAMS_SLOT);
+SAMPLER2D(s_lightClusters, LIGHT_CLUSTER_SLOT);
+uniform vec4 u_lightClusterParams; // x : global light count, y : depth slice scale, z : depth slice bias
+
+U_Light GetClusteredLightParams(int lightIndex) {
+	// Same layout as GetLightParams with one row per light.
+	vec4 params0 = texelFetch(s_lightParams, ivec2(0, lightIndex), 0);
+	vec4 params1 = texelFetch(s_lightParams, ivec2(1, lightIndex), 0);
+	vec4 params2 = texelFetch(s_lightParams, ivec2(2, lightIndex), 0);
+	vec4 params3 = texelFetch(s_lightParams, ivec2(3, lightIndex), 0);
+	vec4 params4 = texelFetch(s_lightParams, ivec2(4, lightIndex), 0);
+	vec4 params5 = texelFetch(s_lightParams, ivec2(5, lightIndex), 0);
+	
+	U_Light light;
+	light.type              	= params0.x;
+	light.position          	= params0.yzw;
+	light.intensity         	= params1.x;
+	light.color             	= params1.yzw;
+	light.range             	= params2.x;
+	light.direction         	= params2.yzw;
+	light.radius            	= params3.x;
+	light.up                	= params3.yzw;
+	light.width             	= params4.x;
+	light.height            	= params4.y;
+	light.lightAngleScale   	= params4.z;
+	light.lightAngleOffeset 	= params4.w;
+	light.shadowType        	= asint(params5.x);
+	light.lightViewProjOffset	= asint(params5.y);
+	light.cascadeNum        	= asint(params5.z);
+	light.shadowBias        	= params5.w;
+	light.frustumClips      	= texelFetch(s_lightParams, ivec2(6, lightIndex), 0);
+	return light;
+}
+
+// Cluster ranges and light indices are stored in one texture row by row.
+vec2 GetLightClusterTexel(int texelIndex) {
+	return texelFetch(s_lightClusters, ivec2(texelIndex % LIGHT_CLUSTER_TEXTURE_WIDTH, texelIndex / LIGHT_CLUSTER_TEXTURE_WIDTH), 0).xy;
+}
+
+int GetLightCluster(vec3 worldPos) {
+	vec4 viewPos = mul(u_view, vec4(worldPos, 1.0));
+	vec4 clipPos = mul(u_proj, viewPos);
+	vec2 tile = clamp((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y),
+		vec2_splat(0.0), vec2(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1));
+	float slice = clamp(log(max(viewPos.z, 0.0001)) * u_lightClusterParams.y + u_lightClusterParams.z, 0.0, float(LIGHT_CLUSTER_Z - 1));
+	return int(tile.x) + int(tile.y) * LIGHT_CLUSTER_X + int(slice) * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+}
+
+vec3 CalculateClusteredLights(Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF, float csmDepth) {
+	vec3 color = vec3_splat(0.0);
+	
+	// Directional and area lights affect every cluster.
+	int globalLightCount = int(u_lightClusterParams.x);
+	for(int lightIndex = 0; lightIndex < globalLightCount; ++lightIndex) {
+		U_Light light = GetClusteredLightParams(lightIndex);
+		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF, csmDepth, lightIndex);
+	}
+	
+	vec2 clusterRange = GetLightClusterTexel(GetLightCluster(worldPos));
+	int lightIndexOffset = int(clusterRange.x);
+	int clusterLightCount = int(clusterRange.y);
+	for(int i = 0; i < clusterLightCount; ++i) {
+		int lightIndex = int(GetLightClusterTexel(lightIndexOffset + i).x);
+		U_Light light = GetClusteredLightParams(lightIndex);
+		color += CalculateLight(light, material, worldPos, viewDir, diffuseBRDF, csmDepth, lightIndex);
+	}
+	return color;
+}
\ No newline at end of file
@@ -9,14 +9,25 @@
 
 uniform vec4 u_lightCountAndStride;
 uniform vec4 u_lightParams[LIGHT_LENGTH];
-uniform mat4 u_lightViewProjs[4*3];
 uniform vec4 u_clipFrustumDepth;
 uniform vec4 u_bias[3]; // [LIGHT_NUM]
-uniform vec4 u_isCastShadow;
 
-SAMPLERCUBE(s_texCubeShadowMap_1, SHADOW_MAP_CUBE_FIRST_SLOT);
-SAMPLERCUBE(s_texCubeShadowMap_2, SHADOW_MAP_CUBE_SECOND_SLOT);
-SAMPLERCUBE(s_texCubeShadowMap_3, SHADOW_MAP_CUBE_THIRD_SLOT);
+SAMPLER2D(s_shadowAtlas, SHADOW_MAP_ATLAS_SLOT);
+SAMPLER2D(s_shadowViews, SHADOW_VIEWS_SLOT);
+
+// World space to atlas uv and depth
+mat4 GetShadowViewProj(int viewIndex) {
+	return mtxFromCols(
+		texelFetch(s_shadowViews, ivec2(0, viewIndex), 0),
+		texelFetch(s_shadowViews, ivec2(1, viewIndex), 0),
+		texelFetch(s_shadowViews, ivec2(2, viewIndex), 0),
+		texelFetch(s_shadowViews, ivec2(3, viewIndex), 0));
+}
+
+// uv range of the shadow view, shrunk by half texel
+vec4 GetShadowAtlasRect(int viewIndex) {
+	return texelFetch(s_shadowViews, ivec2(4, viewIndex), 0);
+}
 
 U_Light GetLightParams(int pointer) {
 	// struct {
@@ -124,47 +135,46 @@ vec3 closestPointOnSegment(vec3 a, vec3 b, vec3 c) {
 	return a + saturate(t) * ab;
 }
 
-// Return shadow map sampler according to light index
-float textureIndex(int lightIndex, vec3 sampleVec){
-	float closestDepth = 1.0;
-	if(0 == lightIndex){
-		closestDepth = textureCube(s_texCubeShadowMap_1, sampleVec).r; 
-	}else if(1 == lightIndex){
-		closestDepth = textureCube(s_texCubeShadowMap_2, sampleVec).r; 
-	}else if(2 == lightIndex){
-		closestDepth = textureCube(s_texCubeShadowMap_3, sampleVec).r; 
+// 3x3 PCF in the atlas. Samples are clamped to the rectangle of the shadow view so that they never read other views.
+float SampleShadowAtlas(int viewIndex, vec2 uv, float currentDepth) {
+	vec4 rect = GetShadowAtlasRect(viewIndex);
+	float shadow = 0.0;
+	for(int x = -1; x <= 1; ++x)
+	{
+		for(int y = -1; y <= 1; ++y)
+		{
+			vec2 sampleUV = clamp(uv + vec2(x, y) / float(SHADOW_MAP_ATLAS_SIZE), rect.xy, rect.zw);
+			float closestDepth = texture2D(s_shadowAtlas, sampleUV).r;
+			shadow += step(closestDepth, currentDepth);
+		}
 	}
-	return closestDepth; 
+	return shadow / 9.0;
 }
 
-
 // -------------------- Point -------------------- //
 
-float CalculatePointShadow(vec3 fragPosWorldSpace, vec3 lightPosWorldSpace, float far_plane, int lightIndex) {
+float CalculatePointShadow(vec3 fragPosWorldSpace, vec3 lightPosWorldSpace, float far_plane, int lightViewProjOffset) {
+	if(lightViewProjOffset < 0)
+		return 0.0;
+
+	// Faces are stored in the order of bgfx cube map : +X -X +Y -Y +Z -Z
 	vec3 lightToFrag = fragPosWorldSpace - lightPosWorldSpace;
-	float currentDepth = length(lightToFrag);
-    float bias = 0.05;
+	vec3 absLightToFrag = abs(lightToFrag);
+	int face = 0;
+	if(absLightToFrag.x >= absLightToFrag.y && absLightToFrag.x >= absLightToFrag.z)
+		face = lightToFrag.x > 0.0 ? 0 : 1;
+	else if(absLightToFrag.y >= absLightToFrag.z)
+		face = lightToFrag.y > 0.0 ? 2 : 3;
+	else
+		face = lightToFrag.z > 0.0 ? 4 : 5;
 
-	// PCF shadow | Filter Size : 3x3 
-	float shadow = 0.0;
-	float samples = 3.0;
-	float totalOffset = 0.03;
-	float stepOffset = totalOffset / ((samples-1) * 0.5);
-	for(float x = -totalOffset; x <= totalOffset; x += stepOffset)
-	{
-		for(float y = -totalOffset; y <= totalOffset; y += stepOffset)
-		{
-			for(float z = -totalOffset; z <= totalOffset; z += stepOffset)
-			{
-				float closestDepth = textureIndex(lightIndex, lightToFrag + vec3(x, y, z)); 
-				closestDepth *= far_plane;
-				shadow += step(closestDepth, currentDepth - bias); 
-			}
-		}
-	}
-	shadow /= (samples * samples * samples);
+	int viewIndex = lightViewProjOffset + face;
+	vec4 fragPosAtlas = mul(GetShadowViewProj(viewIndex), vec4(fragPosWorldSpace, 1.0));
 
-	return shadow;
+	// Point light shadow stores linear depth.
+	float bias = 0.05;
+	float currentDepth = (length(lightToFrag) - bias) / far_plane;
+	return SampleShadowAtlas(viewIndex, fragPosAtlas.xy / fragPosAtlas.w, currentDepth);
 }
 
 vec3 CalculatePointLight(U_Light light, Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF, int lightIndex) {
@@ -186,35 +196,22 @@ vec3 CalculatePointLight(U_Light light, Material material, vec3 worldPos, vec3 v
 	vec3 specularBRDF = Fre * NDF * Vis;
 	
 	vec3 KD = mix(vec3_splat(1.0) - Fre, vec3_splat(0.0), material.metallic);
-	float shadow = CalculatePointShadow(worldPos, light.position, light.range, lightIndex) * u_isCastShadow.x;
+	float shadow = CalculatePointShadow(worldPos, light.position, light.range, light.lightViewProjOffset);
 	return (1 - shadow) * (KD * diffuseBRDF + specularBRDF) * radiance * NdotL;
 }
 
 // -------------------- Spot -------------------- //
 
-float CalculateSpotShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir,int lightViewProjOffset, int lightIndex){
-    vec4 fragPosLightSpace = mul(u_lightViewProjs[lightViewProjOffset], vec4(fragPosWorldSpace, 1.0));
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-	vec3 sampleVec = vec3(1.0, projCoords.y, -projCoords.x);
-    float fragDepth = projCoords.z;
+float CalculateSpotShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir, int lightViewProjOffset){
+	if(lightViewProjOffset < 0)
+		return 0.0;
+
+    vec4 fragPosAtlas = mul(GetShadowViewProj(lightViewProjOffset), vec4(fragPosWorldSpace, 1.0));
+    vec3 projCoords = fragPosAtlas.xyz / fragPosAtlas.w;
     
 	// Calculate bias (based on depth map resolution and slope)
     float bias = max(0.001 * (1.0 - dot(normal, lightDir)), 0.00001);
-
-	// PCF Filter Size : 3x3 
-	float shadow = 0.0;
-	float samples = 3.0;
-	float totalOffset = 0.0015;
-	float stepOffset = totalOffset / ((samples-1) * 0.5);
-	for(float x = -totalOffset; x <= totalOffset; x += stepOffset){
-		for(float y = -totalOffset; y <= totalOffset; y += stepOffset){
-			float closestDepth = textureIndex(lightIndex, sampleVec + vec3(0, y, x));
-			shadow += step(closestDepth, fragDepth - bias); 
-		}
-	}
-	shadow /= (samples * samples);
-
-    return shadow;
+    return SampleShadowAtlas(lightViewProjOffset, projCoords.xy, projCoords.z - bias);
 }
 
 vec3 CalculateSpotLight(U_Light light, Material material, vec3 worldPos, vec3 viewDir, vec3 diffuseBRDF, int lightIndex) {
@@ -238,58 +235,30 @@ vec3 CalculateSpotLight(U_Light light, Material material, vec3 worldPos, vec3 vi
 	vec3 specularBRDF = Fre * NDF * Vis;
 	
 	vec3 KD = mix(1.0 - Fre, vec3_splat(0.0), material.metallic);
-	float shadow = CalculatePointShadow(worldPos, light.position, light.range, lightIndex) * u_isCastShadow.x;
+	float shadow = CalculateSpotShadow(worldPos, material.normal, lightDir, light.lightViewProjOffset);
 	return (1.0 - shadow) * (KD * diffuseBRDF + specularBRDF) * radiance * NdotL;
 }
 
 // -------------------- Directional -------------------- //
 
-float CalculateDirectionalShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir, mat4 lightViewProj, int lightIndex, float num){
-    vec4 fragPosLightSpace = mul(lightViewProj, vec4(fragPosWorldSpace, 1.0));
-    vec3 projCoords = fragPosLightSpace.xyz/fragPosLightSpace.w;
-    float currentDepth = projCoords.z;
+float CalculateDirectionalShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir, int viewIndex){
+    vec4 fragPosAtlas = mul(GetShadowViewProj(viewIndex), vec4(fragPosWorldSpace, 1.0));
+    vec3 projCoords = fragPosAtlas.xyz / fragPosAtlas.w;
     float bias = max(0.02 * (1.0 - dot(normal, lightDir)), 0.002);
-
-	// PCF shadow | Filter Size : 3x3 
-	vec3 sampleVec;
-	if(num < 0.5) sampleVec = vec3(1.0, projCoords.y, -projCoords.x);
-	else if(num > 0.5 && num < 1.5) sampleVec = vec3(-1.0, projCoords.y, projCoords.x);
-	else if(num > 1.5 && num < 2.5) sampleVec = vec3(projCoords.x, 1.0, projCoords.y);
-	else if(num > 2.5 && num < 3.5) sampleVec = vec3(projCoords.x, -1.0, projCoords.y);
-	float shadow = 0.0;
-	float samples = 3.0;
-	float totalOffset = 0.0015;
-	float stepOffset = totalOffset / ((samples-1) * 0.5);
-	if(num < 1.5){
-		for(float x = -totalOffset; x <= totalOffset; x += stepOffset){
-    		for(float y = -totalOffset; y <= totalOffset; y += stepOffset){
-				float closestDepth = textureIndex(lightIndex, sampleVec + vec3(0, y, x));
-				shadow += step(closestDepth, currentDepth - bias); 
-			}
-		}
-	}
-	else{
-		for(float x = -totalOffset; x <= totalOffset; x += stepOffset){
-    		for(float y = -totalOffset; y <= totalOffset; y += stepOffset){
-				float closestDepth = textureIndex(lightIndex, sampleVec + vec3(x, 0, y));
-				shadow += step(closestDepth, currentDepth - bias); 
-			}
-		}
-	}
-	shadow /= (samples * samples);
-	
-    return shadow;
+    return SampleShadowAtlas(viewIndex, projCoords.xy, projCoords.z - bias);
 }
 
-float CalculateCascadedDirectionalShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir, float csmDepth, int lightViewProjOffset, int lightIndex){
-	if(csmDepth > 0 && csmDepth <= u_clipFrustumDepth.x)
-		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, u_lightViewProjs[lightViewProjOffset], lightIndex, 0.0);
+float CalculateCascadedDirectionalShadow(vec3 fragPosWorldSpace, vec3 normal, vec3 lightDir, float csmDepth, int lightViewProjOffset){
+	if(lightViewProjOffset < 0)
+		return 0.0;
+	else if(csmDepth > 0 && csmDepth <= u_clipFrustumDepth.x)
+		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, lightViewProjOffset);
 	else if(csmDepth > u_clipFrustumDepth.x && csmDepth <= u_clipFrustumDepth.y)
-		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, u_lightViewProjs[lightViewProjOffset+1], lightIndex, 1.0);
+		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, lightViewProjOffset+1);
 	else if(csmDepth > u_clipFrustumDepth.y && csmDepth <= u_clipFrustumDepth.z)
-		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, u_lightViewProjs[lightViewProjOffset+2], lightIndex, 2.0);
+		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, lightViewProjOffset+2);
 	else if(csmDepth > u_clipFrustumDepth.z && csmDepth <= 1)
-		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, u_lightViewProjs[lightViewProjOffset+3], lightIndex, 3.0);
+		return CalculateDirectionalShadow(fragPosWorldSpace, normal, lightDir, lightViewProjOffset+3);
 	else
 		return 1.0;
 }
@@ -311,7 +280,7 @@ vec3 CalculateDirectionalLight(U_Light light, Material material, vec3 worldPos,
 	
 	vec3 KD = mix(1.0 - Fre, vec3_splat(0.0), material.metallic);
 	vec3 irradiance = light.color * light.intensity;
-	float shadow = CalculateCascadedDirectionalShadow(worldPos, material.normal, lightDir, csmDepth, light.lightViewProjOffset, lightIndex) * u_isCastShadow.x;
+	float shadow = CalculateCascadedDirectionalShadow(worldPos, material.normal, lightDir, csmDepth, light.lightViewProjOffset);
 	return (1.0 - shadow) * (KD * diffuseBRDF + specularBRDF) * irradiance * NdotL;
 }
 
@@ -13,3 +13,13 @@ float pow_low(float x, float n)
 	n = n * 1.4427 + 1.4427;
 	return exp2(x * n - n);
 }
+
+// Inverse of VertexQuantization::EncodeOctahedral. Quantized vertex attributes are expanded from snorm16 to [-1, 1] already.
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 direction = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-direction.z, 0.0);
+	direction.x += direction.x >= 0.0 ? -fold : fold;
+	direction.y += direction.y >= 0.0 ? -fold : fold;
+	return normalize(direction);
+}
@@ -6,6 +6,7 @@ $input v_worldPos, v_normal, v_texcoord0, v_TBN, v_color0
 #include "../common/Camera.sh"
 
 #include "../common/LightSource.sh"
+#include "../common/LightCluster.sh"
 #include "../common/Envirnoment.sh"
 
 uniform vec4 u_emissiveColorAndFactor;
@@ -13,7 +14,7 @@ uniform vec4 u_cameraNearFarPlane;
 
 vec3 GetDirectional(Material material, vec3 worldPos, vec3 viewDir, float csmDepth) {
 	vec3 diffuseBRDF = material.albedo * CD_PI_INV;
-	return CalculateLights(material, worldPos, viewDir, diffuseBRDF, csmDepth);
+	return CalculateClusteredLights(material, worldPos, viewDir, diffuseBRDF, csmDepth);
 }
 
 vec3 GetEnvironment(Material material, vec3 worldPos, vec3 viewDir, vec3 normal) {
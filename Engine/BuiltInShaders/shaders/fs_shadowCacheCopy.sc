@@ -0,0 +1,9 @@
+#include "../common/common.sh"
+
+SAMPLER2D(s_shadowStaticAtlas, 0);
+
+void main()
+{
+	// Static layer uses the same tile layout as the shadow atlas so texels map one to one.
+	gl_FragDepth = texelFetch(s_shadowStaticAtlas, ivec2(gl_FragCoord.xy), 0).r;
+}
\ No newline at end of file
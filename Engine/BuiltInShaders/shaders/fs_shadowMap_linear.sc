@@ -6,6 +6,7 @@ uniform vec4 u_lightWorldPos_farPlane;
 
 void main()
 {
+    // Point light faces share the depth atlas with other lights so linear depth is written as depth directly.
     float diatance = length(v_worldPos - u_lightWorldPos_farPlane.xyz);
-    gl_FragColor= vec4(diatance/u_lightWorldPos_farPlane.w, 0.0, 0.0, 1.0);
+    gl_FragDepth = diatance / u_lightWorldPos_farPlane.w;
 }
\ No newline at end of file
@@ -1,16 +1,48 @@
+#if defined(INSTANCING)
+$input a_position, a_normal, a_tangent, a_texcoord0, i_data0, i_data1, i_data2, i_data3
+#else
 $input a_position, a_normal, a_tangent, a_texcoord0
+#endif
 $output v_worldPos, v_normal, v_texcoord0, v_TBN, v_color0
 
 #include "../common/common.sh"
 
 void main()
 {
+	// Quantized positions are dequantized by the world matrix.
+#if defined(QUANTIZEDVERTEX)
+	vec3 normal = DecodeOctahedral(a_normal.xy);
+	vec3 tangentDirection = DecodeOctahedral(a_tangent.xy);
+#else
+	vec3 normal = a_normal;
+	vec3 tangentDirection = a_tangent;
+#endif
+
+#if defined(INSTANCING)
+	// Instance data are columns of the world matrix.
+	mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+	vec4 worldPos = mul(model, vec4(a_position, 1.0));
+	gl_Position = mul(u_viewProj, worldPos);
+	v_worldPos = worldPos.xyz;
+	v_color0 = mul(u_view, worldPos);
+	
+	// Cofactor matrix equals to inverse transpose scaled by determinant, normalize removes the scale.
+	vec3 axisX = i_data0.xyz;
+	vec3 axisY = i_data1.xyz;
+	vec3 axisZ = i_data2.xyz;
+	mat3 normalMatrix = mtxFromCols(cross(axisY, axisZ), cross(axisZ, axisX), cross(axisX, axisY));
+	float determinantSign = dot(axisX, cross(axisY, axisZ)) < 0.0 ? -1.0 : 1.0;
+	
+	v_normal     = normalize(mul(normalMatrix, normal) * determinantSign);
+	vec3 tangent = normalize(mul(normalMatrix, tangentDirection) * determinantSign);
+#else
 	gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0));
 	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
 	v_color0 = mul(u_modelView, vec4(a_position, 1.0));
 	
-	v_normal     = normalize(mul(u_modelInvTrans, vec4(a_normal, 0.0)).xyz);
-	vec3 tangent = normalize(mul(u_modelInvTrans, vec4(a_tangent, 0.0)).xyz);
+	v_normal     = normalize(mul(u_modelInvTrans, vec4(normal, 0.0)).xyz);
+	vec3 tangent = normalize(mul(u_modelInvTrans, vec4(tangentDirection, 0.0)).xyz);
+#endif
 	
 	// re-orthogonalize T with respect to N
 	tangent        = normalize(tangent - dot(tangent, v_normal) * v_normal);
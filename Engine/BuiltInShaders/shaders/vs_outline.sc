@@ -8,7 +8,11 @@ void main()
 {
 	float outline = u_outLineSize.x;
 	vec4 position = mul(u_modelViewProj, vec4(a_position, 1.0));
+#if defined(QUANTIZEDVERTEX)
+	vec3 normal = normalize(mul(u_modelInvTrans, vec4(DecodeOctahedral(a_normal.xy), 0.0)).xyz);
+#else
 	vec3 normal = normalize(mul(u_modelInvTrans, vec4(a_normal, 0.0)).xyz);;
+#endif
 	normal = normalize(mul(u_view,vec4(normal,0.0)).xyz);
 
 	// Treat the stroke width according to the screen aspect ratio.
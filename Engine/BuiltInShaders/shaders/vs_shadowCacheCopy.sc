@@ -0,0 +1,9 @@
+#include "../common/common.sh"
+
+void main()
+{
+	// One triangle covers the whole view without vertex buffers. Viewport clips it to the shadow atlas tile.
+	float x = float(gl_VertexID == 1) * 4.0 - 1.0;
+	float y = float(gl_VertexID == 2) * 4.0 - 1.0;
+	gl_Position = vec4(x, y, 0.0, 1.0);
+}
\ No newline at end of file
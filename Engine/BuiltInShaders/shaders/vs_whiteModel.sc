@@ -9,7 +9,11 @@ void main()
 
 	v_worldPos = mul(u_model[0], vec4(a_position, 1.0)).xyz;
 
+#if defined(QUANTIZEDVERTEX)
+	v_normal = normalize(mul(u_modelInvTrans, vec4(DecodeOctahedral(a_normal.xy), 0.0)).xyz);
+#else
 	v_normal = normalize(mul(u_modelInvTrans, vec4(a_normal, 0.0)).xyz);
+#endif
 
 	v_bc = vec3(a_color0.x, a_color0.y, a_color0.z);
 }
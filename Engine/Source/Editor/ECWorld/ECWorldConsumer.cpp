@@ -188,6 +188,12 @@ void ECWorldConsumer::AddStaticMesh(engine::Entity entity, const cd::Mesh& mesh,
 	engine::MeshResource* pMeshResource = m_pResourceContext->AddMeshResource(meshNameCrc);
 	pMeshResource->SetMeshAsset(&mesh);
 	pMeshResource->UpdateVertexFormat(vertexFormat);
+	// Static meshes are drawn in simplified LODs when they are small on screen and can hide other meshes in occlusion culling.
+	pMeshResource->SetLODEnabled(true);
+	pMeshResource->SetOccluderEnabled(true);
+	// Quantized vertices are decoded by material shaders. BlendShapeComponent builds its own vertex buffers in float.
+	bool canDecodeQuantizedVertex = m_pDefaultMaterialType->GetShaderSchema().GetConflictFeatureSet(engine::ShaderFeature::QUANTIZED_VERTEX).has_value();
+	pMeshResource->SetVertexQuantizationEnabled(m_isVertexQuantizationEnabled && canDecodeQuantizedVertex && 0U == mesh.GetBlendShapeIDCount());
 	staticMeshComponent.SetMeshResource(pMeshResource);
 }
 
@@ -246,6 +252,11 @@ void ECWorldConsumer::AddMaterial(engine::Entity entity, const cd::Material* pMa
 	materialComponent.SetMaterialType(pMaterialType);
 	materialComponent.SetMaterialData(pMaterial);
 	materialComponent.ActivateShaderFeature(engine::GetSkyTypeShaderFeature(m_pSceneWorld->GetSkyComponent(m_pSceneWorld->GetSkyEntity())->GetSkyType()));
+	if (const engine::StaticMeshComponent* pStaticMeshComponent = m_pSceneWorld->GetStaticMeshComponent(entity);
+		pStaticMeshComponent && pStaticMeshComponent->GetMeshResource()->IsVertexQuantized())
+	{
+		materialComponent.ActivateShaderFeature(engine::ShaderFeature::QUANTIZED_VERTEX);
+	}
 
 	if (!pMaterial)
 	{
@@ -437,8 +448,6 @@ void ECWorldConsumer::AddParticleEmitter(engine::Entity entity, const cd::Mesh&
 	engine::MaterialType* pMaterialType = m_pSceneWorld->GetParticleMaterialType();
 	engine::NameComponent& nameComponent = pWorld->CreateComponent<engine::NameComponent>(entity);
 	nameComponent.SetName(emitter.GetName());
-	auto& particleEmitterComponent = pWorld->CreateComponent<engine::ParticleEmitterComponent>(entity);
-	auto& particleMaterialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
 	// TODO : Some initialization here.
 	auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
 	cd::Vec3f pos = emitter.GetPosition();
@@ -451,6 +460,12 @@ void ECWorldConsumer::AddParticleEmitter(engine::Entity entity, const cd::Mesh&
 	transformComponent.GetTransform().SetScale(scale);
 	transformComponent.Build();
 
+	// Finish every component before adding the next one as adding a component can move the others in archetype storage mode.
+	auto& particleMaterialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
+	particleMaterialComponent.SetMaterialType(pMaterialType);
+	//particleMaterialComponent.ActivateShaderFeature(engine::ShaderFeature::PARTICLE_INSTANCE);
+
+	auto& particleEmitterComponent = pWorld->CreateComponent<engine::ParticleEmitterComponent>(entity);
 	particleEmitterComponent.SetRequiredVertexFormat(&vertexFormat);
 	////const cd::VertexFormat *requriredVertexFormat = emitter.GetVertexFormat();
 	////particleEmitterComponent.SetRequiredVertexFormat(requriredVertexFormat);
@@ -466,8 +481,6 @@ void ECWorldConsumer::AddParticleEmitter(engine::Entity entity, const cd::Mesh&
 	particleEmitterComponent.SetEmitterVelocity(emitter.GetVelocity());
 	particleEmitterComponent.SetEmitterAcceleration(emitter.GetAccelerate());
 	particleEmitterComponent.SetMeshData(&mesh); 
-	particleMaterialComponent.SetMaterialType(pMaterialType);
-	//particleMaterialComponent.ActivateShaderFeature(engine::ShaderFeature::PARTICLE_INSTANCE);
 	particleEmitterComponent.Build();
 }
 
@@ -58,6 +58,8 @@ public:
 	virtual ~ECWorldConsumer() = default;
 
 	void SetDefaultMaterialType(engine::MaterialType* pMaterialType) { m_pDefaultMaterialType = pMaterialType; }
+	// Static meshes store vertices in 16-bit values when their material type can decode them. Off by default.
+	void SetVertexQuantizationEnabled(bool enabled) { m_isVertexQuantizationEnabled = enabled; }
 	void SetSceneDatabaseIDs(uint32_t nodeID, uint32_t meshID);
 	virtual void Execute(const cd::SceneDatabase* pSceneDatabase) override;
 
@@ -77,6 +79,7 @@ private:
 	engine::SceneWorld* m_pSceneWorld = nullptr;
 	engine::RenderContext* m_pRenderContext = nullptr;
 	engine::ResourceContext* m_pResourceContext = nullptr;
+	bool m_isVertexQuantizationEnabled = false;
 
 	uint32_t m_nodeMinID;
 	uint32_t m_meshMinID;
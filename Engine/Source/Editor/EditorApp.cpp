@@ -42,6 +42,8 @@
 #include "Resources/ResourceBuilder.h"
 #include "Resources/ShaderBuilder.h"
 #include "Scene/SceneDatabase.h"
+#include "Scheduler/SystemScheduler.h"
+#include "Scheduler/ThreadPool.h"
 #include "UILayers/AssetBrowser.h"
 #include "UILayers/EntityList.h"
 #include "UILayers/GameView.h"
@@ -62,6 +64,7 @@
 #include "ImGui/imfilebrowser.h"
 
 //#include <format>
+#include <algorithm>
 #include <thread>
 
 namespace editor
@@ -73,6 +76,8 @@ EditorApp::EditorApp()
 
 EditorApp::~EditorApp()
 {
+	// Components hold handles of resources so that they should be destroyed before ResourceContext.
+	m_pSceneWorld.reset();
 }
 
 void EditorApp::Init(engine::EngineInitArgs initArgs)
@@ -109,17 +114,19 @@ void EditorApp::Init(engine::EngineInitArgs initArgs)
 
 	InitEngineRenderers();
 
-	// Add shader build tasks and create a thread to update tasks.
-	InitShaderPrograms(initArgs.compileAllShaders);
+	// Splash listens to build progress before any task is queued.
 	m_pEditorImGuiContext->AddStaticLayer(std::make_unique<Splash>("Splash"));
 
+	// Add shader build tasks and create a thread to update tasks.
+	InitShaderPrograms(initArgs.compileAllShaders);
 	std::thread resourceThread([]()
 	{
-		ResourceBuilder::Get().Update(false, true);
+		ResourceBuilder::Get().UpdateAll(false, true);
 	});
 	resourceThread.detach();
 
 	InitFileWatcher();
+	InitSystems();
 }
 
 void EditorApp::Shutdown()
@@ -268,7 +275,7 @@ void EditorApp::InitMaterialType()
 	m_pRenderContext->RegisterShaderProgram("ParticleProgram", "vs_particleSprite", "fs_particleSprite");
 	m_pRenderContext->RegisterShaderProgram("CelluloidProgram", "vs_celluloid", "fs_celluloid");
 
-	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+	m_pSceneWorld = std::make_unique<engine::SceneWorld>(m_initArgs.useArchetypeStorage);
 	m_pSceneWorld->CreatePBRMaterialType("WorldProgram", IsAtmosphericScatteringEnable());
 	m_pSceneWorld->CreateAnimationMaterialType("AnimationProgram");
 	m_pSceneWorld->CreateTerrainMaterialType("TerrainProgram");
@@ -312,7 +319,8 @@ void EditorApp::InitEditorCameraEntity()
 	cameraComponent.SetBloomEnable(false);
 	cameraComponent.SetBlurEnable(false);
 	cameraComponent.BuildProjectMatrix();
-	cameraComponent.BuildViewMatrix(cameraTransform);
+	// Look up transform again as creating camera component can move it in archetype storage mode.
+	cameraComponent.BuildViewMatrix(m_pSceneWorld->GetTransformComponent(cameraEntity)->GetTransform());
 }
 
 void EditorApp::InitSkyEntity()
@@ -390,6 +398,22 @@ void EditorApp::OnShaderHotModifiedCallback(const char* rootDir, const char* fil
 
 void EditorApp::UpdateMaterials()
 {
+	auto GetOrRegisterShaderResource = [this](const std::string& programName, const std::string& featuresCombine)
+	{
+		engine::ShaderResource* pShaderResource = m_pResourceContext->GetShaderResource(engine::StringCrc{ programName + featuresCombine });
+		if (!pShaderResource)
+		{
+			// We assume here that the ResourceContext hold informations about an
+			// original ShaderProgram that does not contain any ShaderFeature.
+			engine::ShaderResource* pOriginShaderResource = m_pResourceContext->GetShaderResource(engine::StringCrc{ programName });
+			assert(pOriginShaderResource);
+			pShaderResource = m_pRenderContext->RegisterShaderVariant(pOriginShaderResource, featuresCombine);
+		}
+
+		assert(pShaderResource);
+		return pShaderResource;
+	};
+
 	for (engine::Entity entity : m_pSceneWorld->GetMaterialEntities())
 	{
 		engine::MaterialComponent* pMaterialComponent = m_pSceneWorld->GetMaterialComponent(entity);
@@ -405,36 +429,7 @@ void EditorApp::UpdateMaterials()
 
 			const std::string& programName = pMaterialComponent->GetShaderProgramName();
 			const std::string& featuresCombine = pMaterialComponent->GetFeaturesCombine();
-
-			engine::ShaderResource* pShaderResource = m_pResourceContext->GetShaderResource(engine::StringCrc{ programName + featuresCombine });
-			if (!pShaderResource)
-			{
-				// We assume here that the ResourceContext hold informations about an
-				// original ShaderProgram that does not contain any ShaderFeature.
-				engine::ShaderResource* pOriginShaderResource = m_pResourceContext->GetShaderResource(engine::StringCrc{ programName });
-				assert(pOriginShaderResource);
-				
-				engine::ShaderProgramType programtype = pOriginShaderResource->GetType();
-				if (engine::ShaderProgramType::Standard == programtype)
-				{
-					pShaderResource = m_pRenderContext->RegisterShaderProgram(pOriginShaderResource->GetName(),
-						pOriginShaderResource->GetShaderInfo(0).name,
-						pOriginShaderResource->GetShaderInfo(1).name,
-						featuresCombine);
-				}
-				else
-				{
-					pShaderResource = m_pRenderContext->RegisterShaderProgram(pOriginShaderResource->GetName(),
-						pOriginShaderResource->GetShaderInfo(0).name,
-						programtype,
-						featuresCombine);
-				}
-
-				m_pRenderContext->AddRecompileShaderResource(pShaderResource);
-			}
-
-			assert(pShaderResource);
-			pMaterialComponent->SetShaderResource(pShaderResource);
+			pMaterialComponent->SetShaderResource(GetOrRegisterShaderResource(programName, featuresCombine));
 		}
 		assert(!pMaterialComponent->IsShaderResourceDirty());
 	}
@@ -624,6 +619,180 @@ void EditorApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 	m_pEngineRenderers.emplace_back(cd::MoveTemp(pRenderer));
 }
 
+void EditorApp::InitSystems()
+{
+	m_pThreadPool = std::make_unique<engine::ThreadPool>();
+	m_pSystemScheduler = std::make_unique<engine::SystemScheduler>(m_pThreadPool.get());
+	m_pEditorImGuiContext->SetSystemScheduler(m_pSystemScheduler.get());
+
+	// Resources are loaded and parsed on a few build workers of their own so that waiting systems never run them.
+	// Only GPU uploads stay in the ResourceContext system.
+	m_pResourceContext->GetScheduler()->SetBuildWorkerCount(std::max(1U, std::thread::hardware_concurrency() / 4U));
+	// Renderers record independent views on workers through bgfx encoders.
+	m_pRenderContext->SetThreadPool(m_pThreadPool.get());
+
+	const engine::StringCrc renderContextCrc("RenderContext");
+	const engine::StringCrc resourceContextCrc("ResourceContext");
+	const engine::StringCrc inputCrc("Input");
+	const engine::StringCrc cullingCrc("Culling");
+
+	// Editor UI can change anything so it runs alone.
+	m_pSystemScheduler->AddSystem("EditorImGui", engine::SystemAccess().WriteAll().MainThread(), [this](float deltaTime)
+	{
+		m_pEditorImGuiContext->Update(deltaTime);
+	});
+
+	m_pSystemScheduler->AddSystem("SceneWorld", engine::SystemAccess().WriteAll().MainThread(), [this](float deltaTime)
+	{
+		m_pSceneWorld->Update();
+	});
+
+	m_pSystemScheduler->AddSystem("ResourceContext", engine::SystemAccess().WriteResource(resourceContextCrc).MainThread(), [this](float deltaTime)
+	{
+		m_pResourceContext->Update();
+	});
+
+	m_pSystemScheduler->AddSystem("EditorRenderers", engine::SystemAccess().WriteResource(renderContextCrc).MainThread(), [this](float deltaTime)
+	{
+		m_pRenderContext->BeginFrame();
+		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEditorRenderers)
+		{
+			if (pRenderer->IsEnable())
+			{
+				const float* pViewMatrix = nullptr;
+				const float* pProjectionMatrix = nullptr;
+				pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+				pRenderer->Render(deltaTime);
+			}
+		}
+	});
+
+	// Camera and terrain systems only touch components so that they run on workers together with above main thread systems.
+	m_pSystemScheduler->AddSystem("CameraController", engine::SystemAccess().Write<engine::CameraComponent, engine::TransformComponent>().ReadResource(inputCrc),
+		[this](float deltaTime)
+	{
+		engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+		assert(pMainCameraComponent);
+		pMainCameraComponent->BuildProjectMatrix();
+
+		if (m_pEngineImGuiContext && m_pViewportCameraController)
+		{
+			m_pViewportCameraController->Update(deltaTime);
+		}
+	});
+
+	m_pSystemScheduler->AddSystem("TerrainSmoothing", engine::SystemAccess().Write<engine::TerrainComponent>()
+		.Read<engine::CameraComponent, engine::TransformComponent>().ReadResource(inputCrc), [this](float deltaTime)
+	{
+		engine::TerrainComponent* pTerrainComponent = m_pSceneWorld->GetTerrainComponent(m_pSceneWorld->GetSelectedEntity());
+		if (!m_pEngineImGuiContext || !pTerrainComponent || !m_pSceneView->IsTerrainEditMode() || !engine::Input::Get().IsMouseLBPressed())
+		{
+			return;
+		}
+
+		// Do Screen Space Smoothing
+		float screenSpaceX = 2.0f * static_cast<float>(engine::Input::Get().GetMousePositionX() - m_pSceneView->GetWindowPosX()) /
+			m_pSceneView->GetRenderTarget()->GetWidth() - 1.0f;
+		float screenSpaceY = 1.0f - 2.0f * static_cast<float>(engine::Input::Get().GetMousePositionY() - m_pSceneView->GetWindowPosY()) /
+			m_pSceneView->GetRenderTarget()->GetHeight();
+
+		engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+		engine::TransformComponent* pCameraTransformComponent = m_pSceneWorld->GetTransformComponent(m_pSceneWorld->GetMainCameraEntity());
+		cd::Vec3f camPos = pCameraTransformComponent->GetTransform().GetTranslation();
+
+		pTerrainComponent->ScreenSpaceSmooth(screenSpaceX, screenSpaceY, pMainCameraComponent->GetProjectionMatrix().Inverse(),
+			pMainCameraComponent->GetViewMatrix().Inverse(), camPos);
+	});
+
+	m_pSystemScheduler->AddSystem("EngineImGui", engine::SystemAccess().WriteAll().MainThread(), [this](float deltaTime)
+	{
+		if (!m_pEngineImGuiContext)
+		{
+			return;
+		}
+
+		GetMainWindow()->SetMouseVisible(m_pSceneView->IsShowMouse(), m_pSceneView->GetMouseFixedPositionX(), m_pSceneView->GetMouseFixedPositionY());
+		m_pEngineImGuiContext->SetWindowPosOffset(m_pSceneView->GetWindowPosX(), m_pSceneView->GetWindowPosY());
+		m_pEngineImGuiContext->Update(deltaTime);
+	});
+
+	m_pSystemScheduler->AddSystem("UpdateMaterials", engine::SystemAccess().Write<engine::MaterialComponent>()
+		.WriteResource(renderContextCrc).WriteResource(resourceContextCrc).MainThread(), [this](float deltaTime)
+	{
+		if (m_pEngineImGuiContext)
+		{
+			UpdateMaterials();
+		}
+	});
+
+	m_pSystemScheduler->AddSystem("TransformPropagation", engine::SystemAccess().Write<engine::TransformComponent>().Read<engine::HierarchyComponent>(),
+		[this](float deltaTime)
+	{
+		m_pSceneWorld->GetTransformSystem()->Update(m_pThreadPool.get());
+	});
+
+	// Main camera view is culled before renderers. Shadow views are culled by ShadowMapRenderer with the same bounds and occluders.
+	m_pSystemScheduler->AddSystem("FrustumCulling", engine::SystemAccess().Read<engine::CameraComponent, engine::TransformComponent, engine::CollisionMeshComponent>()
+		.Read<engine::StaticMeshComponent, engine::MaterialComponent, engine::AnimationComponent, engine::BlendShapeComponent>()
+		.WriteResource(cullingCrc), [this](float deltaTime)
+	{
+		engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+		engine::CullingSystem* pCullingSystem = m_pSceneWorld->GetCullingSystem();
+		pCullingSystem->ClearViews();
+		pCullingSystem->AddView(pMainCameraComponent->GetProjectionMatrix() * pMainCameraComponent->GetViewMatrix(), true);
+		m_pSceneWorld->CollectOccluders();
+		pCullingSystem->Update(m_pThreadPool.get());
+	});
+
+	// Engine renderers are passes of the render graph in registration order. Pass ID is the renderer index.
+	m_pSystemScheduler->AddSystem("RenderGraph", engine::SystemAccess().Read<engine::CameraComponent>().WriteResource(renderContextCrc).MainThread(),
+		[this](float deltaTime)
+	{
+		engine::RenderGraph* pRenderGraph = m_pRenderContext->GetRenderGraph();
+		pRenderGraph->Reset();
+		pRenderGraph->ImportResource(engine::StringCrc("SceneRenderTarget"), true);
+		pRenderGraph->ImportResource(engine::StringCrc("BackBuffer"), true);
+		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
+		{
+			bool isEnable = m_pEngineImGuiContext && pRenderer->IsEnable();
+			engine::RenderGraph::PassID passID = pRenderGraph->AddPass("Renderer" + std::to_string(pRenderer->GetViewID()), isEnable);
+			if (isEnable)
+			{
+				pRenderer->SetupRenderPass(pRenderGraph, passID);
+			}
+		}
+		pRenderGraph->Compile();
+		m_pRenderContext->UpdateTransientFrameBuffers();
+	});
+
+	// Renderers submit to bgfx on the main thread in registration order.
+	for (size_t rendererIndex = 0; rendererIndex < m_pEngineRenderers.size(); ++rendererIndex)
+	{
+		engine::Renderer* pEngineRenderer = m_pEngineRenderers[rendererIndex].get();
+		engine::RenderGraph::PassID passID = static_cast<engine::RenderGraph::PassID>(rendererIndex);
+		std::string systemName = "Renderer" + std::to_string(pEngineRenderer->GetViewID());
+		m_pSystemScheduler->AddSystem(cd::MoveTemp(systemName), engine::SystemAccess().Read<engine::CameraComponent, engine::TransformComponent>()
+			.ReadResource(cullingCrc).WriteResource(renderContextCrc).MainThread(), [this, pEngineRenderer, passID](float deltaTime)
+		{
+			if (!m_pRenderContext->GetRenderGraph()->IsPassActive(passID))
+			{
+				return;
+			}
+
+			engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+			const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().begin();
+			const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().begin();
+			pEngineRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+			pEngineRenderer->Render(deltaTime);
+		});
+	}
+
+	m_pSystemScheduler->AddSystem("EndFrame", engine::SystemAccess().WriteResource(renderContextCrc).MainThread(), [this](float deltaTime)
+	{
+		m_pRenderContext->EndFrame();
+	});
+}
+
 bool EditorApp::Update(float deltaTime)
 {
 	// TODO : it is better to remove these logics about splash -> editor switch here.
@@ -654,72 +823,14 @@ bool EditorApp::Update(float deltaTime)
 
 		InitEngineImGuiContext(m_initArgs.language);
 		m_pEngineImGuiContext->SetSceneWorld(m_pSceneWorld.get());
+		m_pEngineImGuiContext->SetSystemScheduler(m_pSystemScheduler.get());
 
 		InitEngineUILayers();
 	}
 
 	GetMainWindow()->Update();
 	m_crtInputFocus = GetMainWindow()->GetInputFocus();
-	m_pEditorImGuiContext->Update(deltaTime);
-	m_pSceneWorld->Update();
-
-	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
-	engine::TerrainComponent* pTerrainComponent = m_pSceneWorld->GetTerrainComponent(m_pSceneWorld->GetSelectedEntity());
-	assert(pMainCameraComponent);
-	pMainCameraComponent->BuildProjectMatrix();
-
-	m_pResourceContext->Update();
-	m_pRenderContext->BeginFrame();
-	for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEditorRenderers)
-	{
-		if (pRenderer->IsEnable())
-		{
-			const float* pViewMatrix = nullptr;
-			const float* pProjectionMatrix = nullptr;
-			pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
-			pRenderer->Render(deltaTime);
-		}
-	}
-
-	if (m_pEngineImGuiContext)
-	{
-		GetMainWindow()->SetMouseVisible(m_pSceneView->IsShowMouse(), m_pSceneView->GetMouseFixedPositionX(), m_pSceneView->GetMouseFixedPositionY());
-		if (m_pViewportCameraController)
-		{
-			m_pViewportCameraController->Update(deltaTime);
-		}
-		// Do Screen Space Smoothing
-		if (pTerrainComponent && m_pSceneView->IsTerrainEditMode() && engine::Input::Get().IsMouseLBPressed())
-		{
-			float screenSpaceX = 2.0f * static_cast<float>(engine::Input::Get().GetMousePositionX() - m_pSceneView->GetWindowPosX()) /
-				m_pSceneView->GetRenderTarget()->GetWidth() - 1.0f;
-			float screenSpaceY = 1.0f - 2.0f * static_cast<float>(engine::Input::Get().GetMousePositionY() - m_pSceneView->GetWindowPosY()) /
-				m_pSceneView->GetRenderTarget()->GetHeight();
-
-			engine::TransformComponent* pCameraTransformComponent = m_pSceneWorld->GetTransformComponent(m_pSceneWorld->GetMainCameraEntity());
-			cd::Vec3f camPos = pCameraTransformComponent->GetTransform().GetTranslation();
-
-			pTerrainComponent->ScreenSpaceSmooth(screenSpaceX, screenSpaceY, pMainCameraComponent->GetProjectionMatrix().Inverse(),
-				pMainCameraComponent->GetViewMatrix().Inverse(), camPos);
-		}
-
-		m_pEngineImGuiContext->SetWindowPosOffset(m_pSceneView->GetWindowPosX(), m_pSceneView->GetWindowPosY());
-		m_pEngineImGuiContext->Update(deltaTime);
-
-		UpdateMaterials();
-		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
-		{
-			if (pRenderer->IsEnable())
-			{
-				const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().begin();
-				const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().begin();
-				pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
-				pRenderer->Render(deltaTime);
-			}
-		}
-	}
-
-	m_pRenderContext->EndFrame();
+	m_pSystemScheduler->Execute(deltaTime);
 
 	engine::Input::Get().FlushInputs();
 
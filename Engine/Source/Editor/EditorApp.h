@@ -20,6 +20,8 @@ class ResourceContext;
 class AABBRenderer;
 class RenderTarget;
 class SceneWorld;
+class SystemScheduler;
+class ThreadPool;
 
 }
 
@@ -70,6 +72,7 @@ public:
 	void InitECWorld();
 	void InitMaterialType();
 	void InitEditorController();
+	void InitSystems();
 
 	bool IsAtmosphericScatteringEnable() const;
 
@@ -124,6 +127,10 @@ private:
 	std::unique_ptr<engine::CameraController> m_pViewportCameraController;
 
 	std::unique_ptr<FileWatcher> m_pFileWatcher;
+
+	// Frame work is split into systems which run in parallel when their component accesses don't conflict.
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
+	std::unique_ptr<engine::SystemScheduler> m_pSystemScheduler;
 };
 
 }
\ No newline at end of file
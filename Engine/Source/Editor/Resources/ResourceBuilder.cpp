@@ -6,7 +6,10 @@
 #include "Process/Process.h"
 #include "Time/Clock.h"
 
+#include <algorithm>
 #include <cassert>
+#include <thread>
+#include <vector>
 
 namespace editor
 {
@@ -19,12 +22,7 @@ ResourceBuilder::ResourceBuilder()
 		ReadModifyCacheFile();
 	}
 
-	m_numActiveTask = 0;
-	for (uint32_t index = 0; index < MaxTaskCount; ++index)
-	{
-		m_handleList[index] = TaskHandle{ index };
-		m_tasks[index].reset();
-	}
+	SetMaxConcurrentTaskCount(std::thread::hardware_concurrency());
 }
 
 ResourceBuilder::~ResourceBuilder()
@@ -62,6 +60,7 @@ void ResourceBuilder::ReadModifyCacheFile()
 
 void ResourceBuilder::WriteModifyCacheFile()
 {
+	std::lock_guard<std::mutex> lock(m_modifyTimeCacheMutex);
 	if (!HasNewModifyTimeCache())
 	{
 		return;
@@ -127,6 +126,14 @@ ProcessStatus ResourceBuilder::CheckFileStatus(const char* pInputFilePath, const
 
 	uint64_t crtTimeStamp = static_cast<uint64_t>(engine::Clock::FileTimePointToTimeStamp(std::filesystem::last_write_time(pInputFilePath)));
 
+	std::lock_guard<std::mutex> lock(m_modifyTimeCacheMutex);
+	// Programs can share the same shader variant. Only the first task builds it as parallel tasks can't write one file.
+	if (auto itNewTimeStamp = m_newModifyTimeCache.find(key); itNewTimeStamp != m_newModifyTimeCache.end() && itNewTimeStamp->second == crtTimeStamp)
+	{
+		CD_TRACE("Output file path {0} is already in build tasks.", pOutputFilePath);
+		return ProcessStatus::Stable;
+	}
+
 	if (m_modifyTimeCache.find(key) == m_modifyTimeCache.end())
 	{
 		CD_INFO("New input file {0} detected.", pInputFilePath);
@@ -144,6 +151,7 @@ ProcessStatus ResourceBuilder::CheckFileStatus(const char* pInputFilePath, const
 	if (!engine::Path::FileExists(pOutputFilePath))
 	{
 		CD_INFO("Output file path {0} dose not exist.", pOutputFilePath);
+		m_newModifyTimeCache[key] = crtTimeStamp;
 		return ProcessStatus::OutputNotExist;
 	}
 	else
@@ -160,22 +168,16 @@ ProcessStatus ResourceBuilder::CheckFileStatus(const char* pInputFilePath, const
 
 TaskHandle ResourceBuilder::AddTask(std::unique_ptr<Process> pProcess)
 {
-	if (m_numActiveTask >= MaxTaskCount)
-	{
-		CD_ERROR("Exceeding maximum number of tasks!");
-		return INVALID_TASK_HANDLE;
-	}
-
-	assert(m_numActiveTask >= 0 && m_numActiveTask < MaxTaskCount);
-	TaskHandle handle = m_handleList[m_numActiveTask++];
-
 	assert(pProcess);
-	pProcess->SetHandle(handle);
 
-	assert(!m_tasks[handle]);
-	m_tasks[handle] = cd::MoveTemp(pProcess);
+	std::lock_guard<std::mutex> lock(m_taskMutex);
+	TaskHandle handle = m_nextHandle;
+	m_nextHandle = (m_nextHandle + 1U) % InvalidHandle;
 
-	m_taskQueue.emplace(handle);
+	pProcess->SetHandle(handle);
+	std::thread::id ownerThreadID = std::this_thread::get_id();
+	m_taskQueue.push_back(Task{ cd::MoveTemp(pProcess), ownerThreadID });
+	++m_ownerTaskCounts[ownerThreadID];
 
 	return handle;
 }
@@ -339,50 +341,167 @@ TaskHandle ResourceBuilder::AddTextureBuildTask(cd::MaterialTextureType textureT
 
 void ResourceBuilder::Update(bool doPrintLog, bool doPrintErrorLog)
 {
-	assert(m_numActiveTask == m_taskQueue.size());
+	UpdateTasks(std::this_thread::get_id(), doPrintLog, doPrintErrorLog);
+}
+
+void ResourceBuilder::UpdateAll(bool doPrintLog, bool doPrintErrorLog)
+{
+	UpdateTasks(std::thread::id(), doPrintLog, doPrintErrorLog);
+}
 
-	if (0 == m_numActiveTask)
+void ResourceBuilder::DetachTasks()
+{
+	std::lock_guard<std::mutex> lock(m_taskMutex);
+	std::thread::id ownerThreadID = std::this_thread::get_id();
+	uint32_t detachedTaskCount = 0U;
+	for (Task& task : m_taskQueue)
 	{
-		return;
+		if (task.ownerThreadID == ownerThreadID)
+		{
+			task.ownerThreadID = std::thread::id();
+			++detachedTaskCount;
+		}
 	}
 
-	// It may wait until process exited which depends on process's setting.
-	while (!m_taskQueue.empty())
+	if (detachedTaskCount > 0U)
 	{
-		TaskHandle handle = m_taskQueue.front();
-		Process* pProcess = m_tasks[handle].get();
-		assert(pProcess);
+		m_ownerTaskCounts[std::thread::id()] += detachedTaskCount;
+		// Tasks which are already running stay owned by calling thread.
+		if (0U == (m_ownerTaskCounts[ownerThreadID] -= detachedTaskCount))
+		{
+			m_ownerTaskCounts.erase(ownerThreadID);
+		}
+	}
+}
 
-		pProcess->SetWaitUntilFinished(1 == m_taskQueue.size());
-		pProcess->SetPrintChildProcessLog(doPrintLog);
-		pProcess->SetPrintChildProcessErrorLog(doPrintErrorLog);
-		pProcess->Run();
+void ResourceBuilder::UpdateTasks(std::thread::id ownerThreadID, bool doPrintLog, bool doPrintErrorLog)
+{
+	std::unique_lock<std::mutex> lock(m_taskMutex);
+	while (true)
+	{
+		uint32_t queuedTaskCount = static_cast<uint32_t>(std::count_if(m_taskQueue.begin(), m_taskQueue.end(), [this, ownerThreadID](const Task& queuedTask)
+		{
+			return IsTaskOf(queuedTask, ownerThreadID);
+		}));
+		if (0U == queuedTaskCount)
+		{
+			if (std::thread::id() == ownerThreadID || !m_ownerTaskCounts.contains(ownerThreadID))
+			{
+				break;
+			}
+
+			// Wait for own tasks which are running in other Update calls.
+			m_taskFinishedCondition.wait(lock);
+			continue;
+		}
+
+		// Calling thread always runs tasks. Helper threads take free slots which are not used by other Update calls.
+		uint32_t freeSlotCount = m_maxConcurrentTaskCount > m_workerCount + 1U ? m_maxConcurrentTaskCount - m_workerCount - 1U : 0U;
+		uint32_t helperCount = std::min(freeSlotCount, queuedTaskCount - 1U);
+		m_workerCount += helperCount + 1U;
+		lock.unlock();
+
+		std::vector<std::thread> helpers;
+		helpers.reserve(helperCount);
+		for (uint32_t helperIndex = 0U; helperIndex < helperCount; ++helperIndex)
+		{
+			helpers.emplace_back([this, ownerThreadID, doPrintLog, doPrintErrorLog]()
+			{
+				RunTasks(ownerThreadID, doPrintLog, doPrintErrorLog);
+			});
+		}
+		RunTasks(ownerThreadID, doPrintLog, doPrintErrorLog);
+		for (std::thread& helper : helpers)
+		{
+			helper.join();
+		}
 
-		m_tasks[handle].reset();
-		m_taskQueue.pop();
+		lock.lock();
+	}
 
-		m_handleList[--m_numActiveTask] = handle;
+	// Other threads may still build tasks which are not waited here. Counts and caches are finalized by the last one.
+	bool isIdle = m_taskQueue.empty() && 0U == m_runningTaskCount;
+	if (isIdle)
+	{
+		m_finishedTaskCount = 0U;
 	}
-	assert(m_numActiveTask == m_taskQueue.size());
+	lock.unlock();
 
-	if (m_taskQueue.empty())
+	if (isIdle)
 	{
 		WriteModifyCacheFile();
 	}
 }
 
-uint32_t ResourceBuilder::GetCurrentTaskCount() const
+void ResourceBuilder::RunTasks(std::thread::id ownerThreadID, bool doPrintLog, bool doPrintErrorLog)
 {
-	assert(m_numActiveTask == m_taskQueue.size());
+	while (true)
+	{
+		Task task;
+		{
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			auto itTask = std::find_if(m_taskQueue.begin(), m_taskQueue.end(), [this, ownerThreadID](const Task& queuedTask)
+			{
+				return IsTaskOf(queuedTask, ownerThreadID);
+			});
+			if (itTask == m_taskQueue.end())
+			{
+				--m_workerCount;
+				return;
+			}
+
+			task = cd::MoveTemp(*itTask);
+			m_taskQueue.erase(itTask);
+			++m_runningTaskCount;
+		}
 
-	return m_numActiveTask;
+		// Wait until process exited so that a slot runs one process at a time.
+		std::unique_ptr<Process>& pProcess = task.pProcess;
+		pProcess->SetWaitUntilFinished(true);
+		pProcess->SetPrintChildProcessLog(doPrintLog);
+		pProcess->SetPrintChildProcessErrorLog(doPrintErrorLog);
+		pProcess->Run();
+		pProcess.reset();
+
+		uint32_t finishedTaskCount;
+		uint32_t totalTaskCount;
+		{
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			finishedTaskCount = ++m_finishedTaskCount;
+			totalTaskCount = finishedTaskCount + m_runningTaskCount - 1U + static_cast<uint32_t>(m_taskQueue.size());
+		}
+
+		// Task counts as running until its progress is reported, so listeners can unbind safely when builder is idle.
+		OnProgress.Invoke(finishedTaskCount, totalTaskCount);
+
+		{
+			std::lock_guard<std::mutex> lock(m_taskMutex);
+			--m_runningTaskCount;
+			if (0U == --m_ownerTaskCounts[task.ownerThreadID])
+			{
+				m_ownerTaskCounts.erase(task.ownerThreadID);
+			}
+		}
+		m_taskFinishedCondition.notify_all();
+	}
+}
+
+uint32_t ResourceBuilder::GetCurrentTaskCount() const
+{
+	std::lock_guard<std::mutex> lock(m_taskMutex);
+	return m_runningTaskCount + static_cast<uint32_t>(m_taskQueue.size());
 }
 
 bool ResourceBuilder::IsIdle() const
 {
-	assert(m_numActiveTask == m_taskQueue.size());
+	return 0U == GetCurrentTaskCount();
+}
 
-	return (0 == m_numActiveTask);
+void ResourceBuilder::SetMaxConcurrentTaskCount(uint32_t count)
+{
+	// hardware_concurrency may return 0 if it is not computable.
+	std::lock_guard<std::mutex> lock(m_taskMutex);
+	m_maxConcurrentTaskCount = std::max(count, 1U);
 }
 
 bool ResourceBuilder::HasNewModifyTimeCache() const
@@ -5,12 +5,17 @@
 #include "Scene/MaterialTextureType.h"
 
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <fstream>
-#include <queue>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <span>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 namespace editor
@@ -38,12 +43,13 @@ using TaskHandle = uint32_t;
 
 // ResourceBuilder is used to create processes to build different resource types.
 // So it is OK to update in the main thread or work thread.
+// Tasks wait in a growable queue and Update runs them in a bounded pool of concurrent processes.
+// Tasks belong to the thread which queued them so that Update calls only wait for their own tasks.
 // For resource build tasks which are using dll calls, it will be wrapped as a task to multithreading JobSystem.
 class ResourceBuilder final
 {
 public:
-	static constexpr uint32_t MaxTaskCount = 64;
-	static constexpr uint32_t InvalidHandle = MaxTaskCount;
+	static constexpr uint32_t InvalidHandle = std::numeric_limits<TaskHandle>::max();
 
 #define INVALID_TASK_HANDLE { InvalidHandle }
 
@@ -70,10 +76,24 @@ public:
 	TaskHandle AddRadianceCubeMapBuildTask(const char* pInputFilePath, const char* pOutputFilePath, TaskOutputCallbacks callbacks = {});
 	TaskHandle AddTextureBuildTask(cd::MaterialTextureType textureType, const char* pInputFilePath, const char* pOutputFilePath, TaskOutputCallbacks callbacks = {});
 
+	// Runs tasks queued by calling thread and returns when they are finished, including the ones picked by other threads.
+	// Calling thread runs tasks together with helper threads.
 	void Update(bool doPrintLog = false, bool doPrintErrorLog = true);
+	// Runs queued tasks of all threads until the queue is empty. Used by background threads to drain detached tasks.
+	void UpdateAll(bool doPrintLog = false, bool doPrintErrorLog = true);
+	// Tasks queued by calling thread so far are left to UpdateAll. Later Update calls of calling thread don't wait for them.
+	void DetachTasks();
+	// Count of queued and running tasks.
 	uint32_t GetCurrentTaskCount() const;
 	bool IsIdle() const;
 
+	// Count of processes which run at the same time. Default is hardware thread count.
+	void SetMaxConcurrentTaskCount(uint32_t count);
+	uint32_t GetMaxConcurrentTaskCount() const { return m_maxConcurrentTaskCount; }
+
+	// Invoked on the thread which finished a task. Counts restart after all tasks are finished.
+	engine::Delegate<void(uint32_t finishedTaskCount, uint32_t totalTaskCount)> OnProgress;
+
 private:
 	ResourceBuilder();
 	~ResourceBuilder();
@@ -90,12 +110,33 @@ private:
 
 	ProcessStatus CheckFileStatus(const char* pInputFilePath, const char* pOutputFilePath);
 
-private:
-	uint32_t m_numActiveTask;
-	std::array<TaskHandle, MaxTaskCount> m_handleList;
-	std::array<std::unique_ptr<Process>, MaxTaskCount> m_tasks;
-	std::queue<TaskHandle> m_taskQueue;
+	struct Task
+	{
+		std::unique_ptr<Process> pProcess;
+		// Default id for detached tasks.
+		std::thread::id ownerThreadID;
+	};
+
+	// Default ownerThreadID runs tasks of all owners.
+	void UpdateTasks(std::thread::id ownerThreadID, bool doPrintLog, bool doPrintErrorLog);
+	// Pops and runs tasks of the owner until there are no more in the queue.
+	void RunTasks(std::thread::id ownerThreadID, bool doPrintLog, bool doPrintErrorLog);
+	bool IsTaskOf(const Task& task, std::thread::id ownerThreadID) const { return std::thread::id() == ownerThreadID || task.ownerThreadID == ownerThreadID; }
 
+private:
+	mutable std::mutex m_taskMutex;
+	std::condition_variable m_taskFinishedCondition;
+	std::deque<Task> m_taskQueue;
+	// Queued and running tasks per owner thread.
+	std::unordered_map<std::thread::id, uint32_t> m_ownerTaskCounts;
+	TaskHandle m_nextHandle = 0U;
+	uint32_t m_maxConcurrentTaskCount;
+	// Threads which are running tasks in all Update calls.
+	uint32_t m_workerCount = 0U;
+	uint32_t m_runningTaskCount = 0U;
+	uint32_t m_finishedTaskCount = 0U;
+
+	std::mutex m_modifyTimeCacheMutex;
 	std::unordered_map<std::string, uint64_t> m_modifyTimeCache;
 	// We always access to fragment shader multiple times by using ubre options.
 	// So we can not update fragment shader's modify time every time we found it has been modified.
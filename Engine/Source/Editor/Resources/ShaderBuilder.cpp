@@ -44,7 +44,8 @@ void ShaderBuilder::BuildRegisteredShaderResources(engine::RenderContext* pRende
 		BuildShaderResource(pRenderContext, pShaderResource, callbacks);
 	}
 
-	ResourceBuilder::Get().Update();
+	// Tasks are only queued. A background thread runs them by ResourceBuilder::UpdateAll.
+	ResourceBuilder::Get().DetachTasks();
 }
 
 void ShaderBuilder::BuildRecompileShaderResources(engine::RenderContext* pRenderContext, TaskOutputCallbacks callbacks)
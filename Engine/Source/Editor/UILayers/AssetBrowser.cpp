@@ -6,6 +6,7 @@
 #endif
 #include "ECWorld/ECWorldConsumer.h"
 #include "ECWorld/MaterialComponent.h"
+#include "ECWorld/SceneGeometryCache.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/World.h"
@@ -23,6 +24,7 @@
 #ifdef ENABLE_GENERIC_PRODUCER
 #include "Producers/GenericProducer/GenericProducer.h"
 #endif
+#include "Rendering/MeshOptimizer.h"
 #include "Rendering/WorldRenderer.h"
 #include "Rendering/RenderContext.h"
 #include "Resources/ResourceBuilder.h"
@@ -119,6 +121,11 @@ bool IsParticleInputFile(const char* pFileExtension)
 	return false;
 }
 
+bool IsSceneGeometryCacheFile(const char* pFileExtension)
+{
+	return 0 == strcmp(".cdgeo", pFileExtension);
+}
+
 std::string GetFilePathExtension(const std::string& FileName)
 {
 	auto pos = FileName.find_last_of('.');
@@ -399,6 +406,14 @@ void AssetBrowser::UpdateAssetFolderTree()
 
 			CD_INFO("Import asset type: {}", nameof::nameof_enum(m_importOptions.AssetType));
 		}
+		else if (ImGui::Selectable("Scene Geometry Cache"))
+		{
+			m_importOptions.AssetType = IOAssetType::SceneGeometryCache;
+			m_pImportFileBrowser->SetTitle("ImportAssets - Scene Geometry Cache");
+			m_pImportFileBrowser->Open();
+
+			CD_INFO("Import asset type: {}", nameof::nameof_enum(m_importOptions.AssetType));
+		}
 
 #ifdef ENABLE_DDGI
 		else if (ImGui::Selectable("DDGI Model"))
@@ -434,6 +449,14 @@ void AssetBrowser::UpdateAssetFolderTree()
 
 			CD_INFO("Export asset type: {}", nameof::nameof_enum(m_exportOptions.AssetType));
 		}
+		else if (ImGui::Selectable("Scene Geometry Cache"))
+		{
+			m_exportOptions.AssetType = IOAssetType::SceneGeometryCache;
+			m_pExportFileBrowser->SetTitle("ExportAssets - Scene Geometry Cache");
+			m_pExportFileBrowser->Open();
+
+			CD_INFO("Export asset type: {}", nameof::nameof_enum(m_exportOptions.AssetType));
+		}
 
 		ImGui::EndPopup();
 	}
@@ -703,7 +726,8 @@ void AssetBrowser::UpdateAssetFileView()
 	ImGui::SliderFloat(" ", &m_gridSize, 40.0f, 160.0f, " ", ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_Logarithmic);
 }
 
-bool AssetBrowser::UpdateOptionDialog(const char* pTitle, bool& active, bool& importMesh, bool& importMaterial, bool& importTexture, bool& importAnimation, bool& importCamera, bool& importLight)
+bool AssetBrowser::UpdateOptionDialog(const char* pTitle, bool& active, bool& importMesh, bool& importMaterial, bool& importTexture, bool& importAnimation, bool& importCamera, bool& importLight,
+	bool* pQuantizeVertex)
 {
 	if (!active)
 	{
@@ -724,6 +748,10 @@ bool AssetBrowser::UpdateOptionDialog(const char* pTitle, bool& active, bool& im
 		if (isMeshOpen)
 		{
 			ImGuiUtils::ImGuiBoolProperty("Mesh", importMesh);
+			if (pQuantizeVertex)
+			{
+				ImGuiUtils::ImGuiBoolProperty("Quantize Vertex", *pQuantizeVertex);
+			}
 		}
 
 		ImGui::Separator();
@@ -814,6 +842,10 @@ void AssetBrowser::ImportAssetFile(const char* pFilePath)
 		{
 			m_importOptions.AssetType = IOAssetType::Particle;
 		}
+		else if (IsSceneGeometryCacheFile(pFileExtension.c_str()))
+		{
+			m_importOptions.AssetType = IOAssetType::SceneGeometryCache;
+		}
 		else
 		{
 			// Still unknown, exit.
@@ -890,6 +922,10 @@ void AssetBrowser::ImportAssetFile(const char* pFilePath)
 	{
 		ImportParticleEffect(pFilePath);
 	}
+	else if (IOAssetType::SceneGeometryCache == m_importOptions.AssetType)
+	{
+		ImportSceneGeometryCache(pFilePath);
+	}
 }
 
 void AssetBrowser::ProcessSceneDatabase(cd::SceneDatabase* pSceneDatabase, bool keepMesh, bool keepMaterial, bool keepTexture, bool keepCamera, bool keepLight)
@@ -987,6 +1023,27 @@ void AssetBrowser::ImportModelFile(const char* pFilePath)
 #endif
 	}
 
+	// Meshes in .cdbin files were optimized when they were imported from source files.
+	// Optimized data is exported in Step 4 so that loading it later needs no extra work.
+	if (0 != inputFileExtension.compare(".cdbin"))
+	{
+		for (cd::Mesh& mesh : newSceneDatabase->GetMeshes())
+		{
+			// Skinned meshes keep the data as imported.
+			if (0U == mesh.GetSkinIDCount())
+			{
+				if (auto optResult = engine::MeshOptimizer::OptimizeMesh(mesh); optResult.has_value())
+				{
+					CD_INFO("[AssetBrowser] Optimized mesh {} : ACMR {:.3f} -> {:.3f}", mesh.GetName(), optResult->sourceACMR, optResult->optimizedACMR);
+				}
+				else
+				{
+					CD_WARN("[AssetBrowser] Skip optimizing mesh {} which is not triangulated.", mesh.GetName());
+				}
+			}
+		}
+	}
+
 	// Move contents in temp scene database to SceneWorld.
 	pSceneDatabase->Merge(cd::MoveTemp(*newSceneDatabase));
 	newSceneDatabase.reset();
@@ -999,6 +1056,7 @@ void AssetBrowser::ImportModelFile(const char* pFilePath)
 		ECWorldConsumer ecConsumer(pSceneWorld, pCurrentRenderContext);
 		ecConsumer.SetDefaultMaterialType(pSceneWorld->GetPBRMaterialType());
 		ecConsumer.SetSceneDatabaseIDs(oldNodeCount, oldMeshCount);
+		ecConsumer.SetVertexQuantizationEnabled(m_importOptions.QuantizeVertex);
 #ifdef ENABLE_DDGI
 		if (m_importOptions.AssetType == IOAssetType::DDGIModel)
 		{
@@ -1037,15 +1095,16 @@ void AssetBrowser::ImportJson(const char* pFilePath)
 
 	auto CreateLightComponents = [&pWorld](engine::Entity entity, cd::LightType lightType, float intensity, cd::Vec3f color) -> engine::LightComponent&
 	{
+		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+		transformComponent.SetTransform(cd::Transform::Identity());
+		transformComponent.Build();
+
+		// Create light component last so that the returned reference stays valid in archetype storage mode.
 		auto& lightComponent = pWorld->CreateComponent<engine::LightComponent>(entity);
 		lightComponent.SetType(lightType);
 		lightComponent.SetIntensity(intensity);
 		lightComponent.SetColor(color);
 
-		auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
-		transformComponent.SetTransform(cd::Transform::Identity());
-		transformComponent.Build();
-
 		return lightComponent;
 	};
 
@@ -1165,6 +1224,34 @@ void AssetBrowser::ImportParticleEffect(const char* pFilePath)
 	//}
 }
 
+// Load entities and meshes from a memory mapped geometry cache without running asset pipeline.
+void AssetBrowser::ImportSceneGeometryCache(const char* pFilePath)
+{
+	engine::SceneWorld* pSceneWorld = GetImGuiContextInstance()->GetSceneWorld();
+	std::vector<engine::Entity> entities = engine::SceneGeometryCache::Load(pSceneWorld, GetRenderContext()->GetResourceContext(), pFilePath);
+
+	// Meshes which were saved without a material use default material.
+	engine::MaterialType* pMaterialType = pSceneWorld->GetPBRMaterialType();
+	engine::SkyType skyType = pSceneWorld->GetSkyComponent(pSceneWorld->GetSkyEntity())->GetSkyType();
+	for (engine::Entity entity : entities)
+	{
+		if (!pSceneWorld->GetStaticMeshComponent(entity) || pSceneWorld->GetMaterialComponent(entity))
+		{
+			continue;
+		}
+
+		engine::MaterialComponent& materialComponent = pSceneWorld->GetWorld()->CreateComponent<engine::MaterialComponent>(entity);
+		materialComponent.Init();
+		materialComponent.SetMaterialType(pMaterialType);
+		materialComponent.SetMaterialData(nullptr);
+		materialComponent.ActivateShaderFeature(engine::GetSkyTypeShaderFeature(skyType));
+		if (pSceneWorld->GetStaticMeshComponent(entity)->GetMeshResource()->IsVertexQuantized())
+		{
+			materialComponent.ActivateShaderFeature(engine::ShaderFeature::QUANTIZED_VERTEX);
+		}
+	}
+}
+
 void AssetBrowser::ExportAssetFile(const char* pFilePath)
 {
 	engine::SceneWorld* pSceneWorld = GetImGuiContextInstance()->GetSceneWorld();
@@ -1198,6 +1285,11 @@ void AssetBrowser::ExportAssetFile(const char* pFilePath)
 		cdtools::Processor processor(nullptr, &consumer, pSceneDatabase);
 		processor.Run();
 	}
+	else if (IOAssetType::SceneGeometryCache == m_exportOptions.AssetType)
+	{
+		std::filesystem::path outputFilePath = std::filesystem::path(pFilePath).replace_extension(".cdgeo");
+		engine::SceneGeometryCache::Save(pSceneWorld, outputFilePath.string().c_str());
+	}
 }
 
 void AssetBrowser::Update()
@@ -1233,7 +1325,7 @@ void AssetBrowser::Update()
 		m_importOptions.Active = true;
 	}
 	if (UpdateOptionDialog("Import Options", m_importOptions.Active, m_importOptions.ImportMesh, m_importOptions.ImportMaterial, m_importOptions.ImportTexture,
-		m_importOptions.ImportAnimation, m_importOptions.ImportCamera, m_importOptions.ImportLight))
+		m_importOptions.ImportAnimation, m_importOptions.ImportCamera, m_importOptions.ImportLight, &m_importOptions.QuantizeVertex))
 	{
 		ImportAssetFile(m_pImportFileBrowser->GetSelected().string().c_str());
 		m_pImportFileBrowser->ClearSelected();
@@ -36,6 +36,7 @@ enum class IOAssetType
 	Model,
 	Shader,
 	SceneDatabase,
+	SceneGeometryCache,
 	Terrain,
 	Light,
 	Particle,
@@ -52,6 +53,7 @@ struct AssetImportOptions
 	bool ImportMesh = true;
 	bool ImportTexture = true;
 	bool ImportAnimation = true;
+	bool QuantizeVertex = false;
 };
 
 struct AssetExportOptions
@@ -98,6 +100,7 @@ private:
 	void ImportModelFile(const char* pFilePath);
 	void ImportParticleEffect(const char* pFilePath);
 	void ImportJson(const char* pFilePath);
+	void ImportSceneGeometryCache(const char* pFilePath);
 	void DrawFolder(const std::shared_ptr<DirectoryInformation>& dirInfo, bool defaultOpen = false);
 	void ChangeDirectory(std::shared_ptr<DirectoryInformation>& directory);
 	
@@ -110,7 +113,8 @@ private:
 
 	void UpdateAssetFolderTree();
 	void UpdateAssetFileView();
-	bool UpdateOptionDialog(const char* pTitle, bool& active, bool& importMesh, bool& importMaterial, bool& importTexture, bool& importAnimation, bool& importCamera, bool& importLight);
+	bool UpdateOptionDialog(const char* pTitle, bool& active, bool& importMesh, bool& importMaterial, bool& importTexture, bool& importAnimation, bool& importCamera, bool& importLight,
+		bool* pQuantizeVertex = nullptr);
 
 private:
 	AssetImportOptions m_importOptions;
@@ -91,6 +91,11 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
 
     auto CreateLightComponents = [&pWorld](engine::Entity entity, cd::LightType lightType, float intensity, cd::Vec3f color, bool isCastShadow = false) -> engine::LightComponent&
     {
+        auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
+        transformComponent.SetTransform(cd::Transform::Identity());
+        transformComponent.Build();
+
+        // Create light component last so that the returned reference stays valid in archetype storage mode.
         auto& lightComponent = pWorld->CreateComponent<engine::LightComponent>(entity);
         lightComponent.SetType(lightType);
         lightComponent.SetIntensity(intensity);
@@ -99,10 +104,6 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         lightComponent.SetIsCastShadow(isCastShadow);
         lightComponent.SetShadowBias(0.0f);
 
-        auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
-        transformComponent.SetTransform(cd::Transform::Identity());
-        transformComponent.Build();
-
         return lightComponent;
     };
 
@@ -204,7 +205,6 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         auto& lightComponent = CreateLightComponents(entity, cd::LightType::Point, 1024.0f, cd::Vec3f(1.0f, 0.0f, 0.0f), true);
         lightComponent.SetPosition(cd::Point(0.0f, 0.0f, -16.0f));
         lightComponent.SetRange(1024.0f);
-        lightComponent.SetShadowMapTexture(BGFX_INVALID_HANDLE);
     }
     else if (ImGui::MenuItem("Add Spot Light"))
     {
@@ -214,7 +214,6 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         lightComponent.SetDirection(cd::Direction(0.0f, 0.0f, 1.0f));
         lightComponent.SetRange(1024.0f);
         lightComponent.SetInnerAndOuter(24.0f, 40.0f);
-        lightComponent.SetShadowMapTexture(BGFX_INVALID_HANDLE);
     }
     else if (ImGui::MenuItem("Add Directional Light"))
     {
@@ -223,7 +222,6 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         lightComponent.SetDirection(cd::Direction(0.0f, 0.0f, 1.0f));
         lightComponent.SetCascadeNum(4);
         lightComponent.SetFrustumClips(cd::Vec4f(0.0f, 0.0f, 0.0f, 0.0f));
-        lightComponent.SetShadowMapTexture(BGFX_INVALID_HANDLE);
     }
 
     // ---------------------------------------- Add Area Light ---------------------------------------- //
@@ -272,29 +270,33 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
     else if (ImGui::MenuItem("Add Particle Emitter"))
     {
         engine::Entity entity = AddNamedEntity("ParticleEmitter");
-        auto& particleEmitterComponent = pWorld->CreateComponent<engine::ParticleEmitterComponent>(entity);
-        auto& particleRibbonComponent = pWorld->CreateComponent<engine::ParticleRibbonComponent>(entity);
-        auto& particleMaterialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
         // TODO : Some initialization here.
         auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
         transformComponent.SetTransform(cd::Transform::Identity());
         transformComponent.Build();
-        particleEmitterComponent.SetRequiredVertexFormat(&pParticleMaterialType->GetRequiredVertexFormat());//to do : modify vertexFormat
+
+        // Finish every component before adding the next one as adding a component can move the others in archetype storage mode.
+        auto& particleMaterialComponent = pWorld->CreateComponent<engine::MaterialComponent>(entity);
         particleMaterialComponent.Init();
         particleMaterialComponent.SetMaterialType(pParticleMaterialType);
         //particleMaterialComponent.ActivateShaderFeature(engine::ShaderFeature::PARTICLE_INSTANCE);
-        particleEmitterComponent.Build();
+
+        auto& particleRibbonComponent = pWorld->CreateComponent<engine::ParticleRibbonComponent>(entity);
         particleRibbonComponent.Build();
+
+        auto& particleEmitterComponent = pWorld->CreateComponent<engine::ParticleEmitterComponent>(entity);
+        particleEmitterComponent.SetRequiredVertexFormat(&pParticleMaterialType->GetRequiredVertexFormat());//to do : modify vertexFormat
+        particleEmitterComponent.Build();
     }
     else if (ImGui::MenuItem("Add Particle ForceField"))
     {
         engine::Entity entity = AddNamedEntity("ParticleForceField");
-        auto& particleForceFieldComponent = pWorld->CreateComponent<engine::ParticleForceFieldComponent>(entity);
         // TODO : Some initialization here.
         auto& transformComponent = pWorld->CreateComponent<engine::TransformComponent>(entity);
         transformComponent.SetTransform(cd::Transform::Identity());
         transformComponent.Build();
 
+        auto& particleForceFieldComponent = pWorld->CreateComponent<engine::ParticleForceFieldComponent>(entity);
         particleForceFieldComponent.Build();
     }
     
@@ -306,7 +308,6 @@ void EntityList::AddEntity(engine::SceneWorld* pSceneWorld)
         lightComponent.SetCascadeNum(4);
         lightComponent.SetIsCastShadow(false);
         lightComponent.SetFrustumClips(cd::Vec4f(0.0f, 0.0f, 0.0f, 0.0f));
-        lightComponent.SetShadowMapTexture(BGFX_INVALID_HANDLE);
 
         for (int horizontalIndex = 0 ; horizontalIndex < 7; ++horizontalIndex)
         {
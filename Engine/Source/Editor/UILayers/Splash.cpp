@@ -5,6 +5,8 @@
 
 #include <imgui/imgui.h>
 
+#include <algorithm>
+
 //#include <format>
 
 namespace editor
@@ -12,27 +14,33 @@ namespace editor
 
 Splash::~Splash()
 {
-
+	ResourceBuilder::Get().OnProgress = {};
 }
 
 void Splash::Init()
 {
 	GetRenderContext()->CreateTexture("Textures/splash_texture.png");
 
-	m_shaderBuildTaskTotalCount = ResourceBuilder::Get().GetCurrentTaskCount();
+	ResourceBuilder::Get().OnProgress.Bind<Splash, &Splash::OnBuildProgress>(this);
+}
+
+void Splash::OnBuildProgress(uint32_t finishedTaskCount, uint32_t totalTaskCount)
+{
+	m_finishedBuildTaskCount = finishedTaskCount;
+	m_totalBuildTaskCount = totalTaskCount;
 }
 
 void Splash::Update()
 {
 	auto flags = ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_NoTitleBar;
 
-	size_t currentBuildCount = ResourceBuilder::Get().GetCurrentTaskCount();
-	assert(currentBuildCount <= m_shaderBuildTaskTotalCount);
-
+	// Tasks are queued after Init and progress is only reported when a task finishes.
+	uint32_t finishedBuildTaskCount = m_finishedBuildTaskCount;
+	uint32_t totalBuildTaskCount = std::max<uint32_t>(m_totalBuildTaskCount, finishedBuildTaskCount + ResourceBuilder::Get().GetCurrentTaskCount());
 
-	//std::string title = std::format("{}({}/{})", GetName(), m_shaderBuildTaskTotalCount - currentBuildCount, m_shaderBuildTaskTotalCount);
+	//std::string title = std::format("{}({}/{})", GetName(), finishedBuildTaskCount, totalBuildTaskCount);
 	std::string title = GetName();
-	title += "(" + std::to_string(m_shaderBuildTaskTotalCount - currentBuildCount) + "/" + std::to_string(m_shaderBuildTaskTotalCount) + ")";
+	title += "(" + std::to_string(finishedBuildTaskCount) + "/" + std::to_string(totalBuildTaskCount) + ")";
 	ImGui::Begin(title.c_str(), &m_isEnable, flags);
 
 	engine::StringCrc splashTexture("Textures/splash_texture.png");
@@ -1,5 +1,6 @@
 #include "ImGui/ImGuiBaseLayer.h"
 
+#include <atomic>
 #include <cstdint>
 
 namespace editor
@@ -15,7 +16,12 @@ public:
 	virtual void Update() override;
 
 private:
-	size_t m_shaderBuildTaskTotalCount = 0;
+	// Called by ResourceBuilder's threads.
+	void OnBuildProgress(uint32_t finishedTaskCount, uint32_t totalTaskCount);
+
+private:
+	std::atomic<uint32_t> m_finishedBuildTaskCount = 0U;
+	std::atomic<uint32_t> m_totalBuildTaskCount = 0U;
 };
 
 }
\ No newline at end of file
@@ -22,6 +22,8 @@
 #include "Rendering/WorldRenderer.h"
 #include "Resources/ShaderLoader.h"
 #include "Scene/SceneDatabase.h"
+#include "Scheduler/SystemScheduler.h"
+#include "Scheduler/ThreadPool.h"
 #include "Window/Input.h"
 #include "Window/Window.h"
 
@@ -120,7 +122,7 @@ void GameApp::RegisterImGuiUserData(engine::ImGuiContextInstance* pImGuiContext)
 
 void GameApp::InitECWorld()
 {
-	m_pSceneWorld = std::make_unique<engine::SceneWorld>();
+	m_pSceneWorld = std::make_unique<engine::SceneWorld>(m_initArgs.useArchetypeStorage);
 
 	InitEditorCameraEntity();
 
@@ -292,6 +294,111 @@ void GameApp::AddEngineRenderer(std::unique_ptr<engine::Renderer> pRenderer)
 	m_pEngineRenderers.emplace_back(cd::MoveTemp(pRenderer));
 }
 
+void GameApp::InitSystems()
+{
+	m_pThreadPool = std::make_unique<engine::ThreadPool>();
+	m_pSystemScheduler = std::make_unique<engine::SystemScheduler>(m_pThreadPool.get());
+	m_pEngineImGuiContext->SetSystemScheduler(m_pSystemScheduler.get());
+
+	// Renderers record independent views on workers through bgfx encoders.
+	m_pRenderContext->SetThreadPool(m_pThreadPool.get());
+
+	const engine::StringCrc renderContextCrc("RenderContext");
+	const engine::StringCrc inputCrc("Input");
+	const engine::StringCrc cullingCrc("Culling");
+
+	m_pSystemScheduler->AddSystem("SceneWorld", engine::SystemAccess().WriteAll().MainThread(), [this](float deltaTime)
+	{
+		m_pSceneWorld->Update();
+	});
+
+	m_pSystemScheduler->AddSystem("CameraController", engine::SystemAccess().Write<engine::CameraComponent, engine::TransformComponent>().ReadResource(inputCrc),
+		[this](float deltaTime)
+	{
+		if (m_pCameraController)
+		{
+			m_pCameraController->Update(deltaTime);
+		}
+
+		engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+		assert(pMainCameraComponent);
+		pMainCameraComponent->BuildProjectMatrix();
+	});
+
+	m_pSystemScheduler->AddSystem("EngineImGui", engine::SystemAccess().WriteAll().MainThread(), [this](float deltaTime)
+	{
+		m_pRenderContext->BeginFrame();
+		m_pEngineImGuiContext->Update(deltaTime);
+	});
+
+	m_pSystemScheduler->AddSystem("TransformPropagation", engine::SystemAccess().Write<engine::TransformComponent>().Read<engine::HierarchyComponent>(),
+		[this](float deltaTime)
+	{
+		m_pSceneWorld->GetTransformSystem()->Update(m_pThreadPool.get());
+	});
+
+	// Main camera view is culled before renderers. Shadow views are culled by ShadowMapRenderer with the same bounds and occluders.
+	m_pSystemScheduler->AddSystem("FrustumCulling", engine::SystemAccess().Read<engine::CameraComponent, engine::TransformComponent, engine::CollisionMeshComponent>()
+		.Read<engine::StaticMeshComponent, engine::MaterialComponent, engine::AnimationComponent, engine::BlendShapeComponent>()
+		.WriteResource(cullingCrc), [this](float deltaTime)
+	{
+		engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+		engine::CullingSystem* pCullingSystem = m_pSceneWorld->GetCullingSystem();
+		pCullingSystem->ClearViews();
+		pCullingSystem->AddView(pMainCameraComponent->GetProjectionMatrix() * pMainCameraComponent->GetViewMatrix(), true);
+		m_pSceneWorld->CollectOccluders();
+		pCullingSystem->Update(m_pThreadPool.get());
+	});
+
+	// Engine renderers are passes of the render graph in registration order. Pass ID is the renderer index.
+	m_pSystemScheduler->AddSystem("RenderGraph", engine::SystemAccess().Read<engine::CameraComponent>().WriteResource(renderContextCrc).MainThread(),
+		[this](float deltaTime)
+	{
+		engine::RenderGraph* pRenderGraph = m_pRenderContext->GetRenderGraph();
+		pRenderGraph->Reset();
+		pRenderGraph->ImportResource(engine::StringCrc("SceneRenderTarget"), true);
+		pRenderGraph->ImportResource(engine::StringCrc("BackBuffer"), true);
+		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
+		{
+			bool isEnable = pRenderer->IsEnable();
+			engine::RenderGraph::PassID passID = pRenderGraph->AddPass("Renderer" + std::to_string(pRenderer->GetViewID()), isEnable);
+			if (isEnable)
+			{
+				pRenderer->SetupRenderPass(pRenderGraph, passID);
+			}
+		}
+		pRenderGraph->Compile();
+		m_pRenderContext->UpdateTransientFrameBuffers();
+	});
+
+	// Renderers submit to bgfx on the main thread in registration order.
+	for (size_t rendererIndex = 0; rendererIndex < m_pEngineRenderers.size(); ++rendererIndex)
+	{
+		engine::Renderer* pEngineRenderer = m_pEngineRenderers[rendererIndex].get();
+		engine::RenderGraph::PassID passID = static_cast<engine::RenderGraph::PassID>(rendererIndex);
+		std::string systemName = "Renderer" + std::to_string(pEngineRenderer->GetViewID());
+		m_pSystemScheduler->AddSystem(cd::MoveTemp(systemName), engine::SystemAccess().Read<engine::CameraComponent, engine::TransformComponent>()
+			.ReadResource(cullingCrc).WriteResource(renderContextCrc).MainThread(), [this, pEngineRenderer, passID](float deltaTime)
+		{
+			if (!m_pRenderContext->GetRenderGraph()->IsPassActive(passID))
+			{
+				return;
+			}
+
+			engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
+			const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
+			const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
+			pEngineRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
+			pEngineRenderer->Render(deltaTime);
+		});
+	}
+
+	m_pSystemScheduler->AddSystem("EndFrame", engine::SystemAccess().WriteResource(renderContextCrc).MainThread(), [this](float deltaTime)
+	{
+		m_pRenderContext->EndFrame();
+	});
+}
+
 bool GameApp::Update(float deltaTime)
 {
 	// TODO : it is better to remove these logics about splash -> editor switch here.
@@ -328,39 +435,11 @@ bool GameApp::Update(float deltaTime)
 		m_pEngineImGuiContext->SetSceneWorld(m_pSceneWorld.get());
 
 		InitEngineUILayers();
-	}
-	else
-	{
-		if (m_pCameraController)
-		{
-			m_pCameraController->Update(deltaTime);
-		}
+		InitSystems();
 	}
 
 	GetMainWindow()->Update();
-	m_pSceneWorld->Update();
-
-	engine::CameraComponent* pMainCameraComponent = m_pSceneWorld->GetCameraComponent(m_pSceneWorld->GetMainCameraEntity());
-	assert(pMainCameraComponent);
-	pMainCameraComponent->BuildProjectMatrix();
-
-	m_pRenderContext->BeginFrame();
-	if (m_pEngineImGuiContext)
-	{
-		m_pEngineImGuiContext->Update(deltaTime);
-		for (std::unique_ptr<engine::Renderer>& pRenderer : m_pEngineRenderers)
-		{
-			if (pRenderer->IsEnable())
-			{
-				const float* pViewMatrix = pMainCameraComponent->GetViewMatrix().Begin();
-				const float* pProjectionMatrix = pMainCameraComponent->GetProjectionMatrix().Begin();
-				pRenderer->UpdateView(pViewMatrix, pProjectionMatrix);
-				pRenderer->Render(deltaTime);
-			}
-		}
-	}
-
-	m_pRenderContext->EndFrame();
+	m_pSystemScheduler->Execute(deltaTime);
 
 	engine::Input::Get().FlushInputs();
 
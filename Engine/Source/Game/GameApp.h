@@ -17,6 +17,8 @@ class RenderContext;
 class Renderer;
 class RenderTarget;
 class SceneWorld;
+class SystemScheduler;
+class ThreadPool;
 
 }
 
@@ -57,6 +59,7 @@ public:
 
 	void InitECWorld();
 	void InitController();
+	void InitSystems();
 
 	bool IsAtmosphericScatteringEnable() const;
 
@@ -89,6 +92,10 @@ private:
 
 	// Controllers for processing input events.
 	std::unique_ptr<engine::CameraController> m_pCameraController;
+
+	// Frame work is split into systems which run in parallel when their component accesses don't conflict.
+	std::unique_ptr<engine::ThreadPool> m_pThreadPool;
+	std::unique_ptr<engine::SystemScheduler> m_pSystemScheduler;
 };
 
 }
\ No newline at end of file
@@ -20,6 +20,7 @@ struct EngineInitArgs
 	Language language = Language::English;
 	GraphicsBackend backend = GraphicsBackend::Direct3D11;
 	bool compileAllShaders = false;
+	bool useArchetypeStorage = false;
 };
 
 class IApplication
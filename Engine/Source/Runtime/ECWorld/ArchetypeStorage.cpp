@@ -0,0 +1,352 @@
+#include "ArchetypeStorage.h"
+
+#include <algorithm>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Archetype
+///////////////////////////////////////////////////////////////////////////////////
+Archetype::Archetype(std::vector<const ComponentTypeInfo*> componentTypes) :
+	m_componentTypes(cd::MoveTemp(componentTypes))
+{
+	std::sort(m_componentTypes.begin(), m_componentTypes.end(),
+		[](const ComponentTypeInfo* pLhs, const ComponentTypeInfo* pRhs) { return pLhs->id < pRhs->id; });
+
+	size_t rowByteSize = sizeof(Entity);
+	for (const ComponentTypeInfo* pTypeInfo : m_componentTypes)
+	{
+		rowByteSize += pTypeInfo->size;
+	}
+
+	// Find the max row capacity which fits in one chunk after column alignment paddings.
+	// A row which is larger than the chunk still gets one row per chunk.
+	size_t capacity = std::max<size_t>(1, ChunkByteSize / rowByteSize);
+	m_columnOffsets.resize(m_componentTypes.size());
+	while (true)
+	{
+		size_t offset = sizeof(Entity) * capacity;
+		for (size_t columnIndex = 0; columnIndex < m_componentTypes.size(); ++columnIndex)
+		{
+			offset = AlignUp(offset, m_componentTypes[columnIndex]->alignment);
+			m_columnOffsets[columnIndex] = offset;
+			offset += static_cast<size_t>(m_componentTypes[columnIndex]->size) * capacity;
+		}
+
+		if (offset <= ChunkByteSize || 1 == capacity)
+		{
+			m_chunkByteSize = std::max(ChunkByteSize, AlignUp(offset, ChunkAlignment));
+			break;
+		}
+
+		--capacity;
+	}
+	m_chunkCapacity = static_cast<uint32_t>(capacity);
+}
+
+Archetype::~Archetype()
+{
+	for (size_t chunkIndex = 0; chunkIndex < m_chunks.size(); ++chunkIndex)
+	{
+		const Chunk& chunk = m_chunks[chunkIndex];
+		for (size_t columnIndex = 0; columnIndex < m_componentTypes.size(); ++columnIndex)
+		{
+			const ComponentTypeInfo* pTypeInfo = m_componentTypes[columnIndex];
+			std::byte* pColumn = chunk.pData + m_columnOffsets[columnIndex];
+			for (uint32_t row = 0; row < chunk.rowCount; ++row)
+			{
+				pTypeInfo->destruct(pColumn + static_cast<size_t>(row) * pTypeInfo->size);
+			}
+		}
+
+		::operator delete(chunk.pData, std::align_val_t{ ChunkAlignment });
+	}
+}
+
+int Archetype::GetColumnIndex(ComponentTypeID typeID) const
+{
+	// Signatures are short so that a linear search is faster than other containers.
+	for (size_t columnIndex = 0; columnIndex < m_componentTypes.size(); ++columnIndex)
+	{
+		if (m_componentTypes[columnIndex]->id == typeID)
+		{
+			return static_cast<int>(columnIndex);
+		}
+	}
+
+	return -1;
+}
+
+Archetype::Location Archetype::AllocateRow(Entity entity)
+{
+	if (m_chunks.empty() || m_chunks.back().rowCount == m_chunkCapacity)
+	{
+		Chunk chunk;
+		chunk.pData = static_cast<std::byte*>(::operator new(m_chunkByteSize, std::align_val_t{ ChunkAlignment }));
+		chunk.rowCount = 0U;
+		m_chunks.push_back(chunk);
+	}
+
+	Location location;
+	location.chunkIndex = static_cast<uint32_t>(m_chunks.size() - 1);
+	location.row = m_chunks.back().rowCount++;
+	GetEntities(location.chunkIndex)[location.row] = entity;
+	++m_rowCount;
+
+	return location;
+}
+
+Entity Archetype::RemoveRow(Location location)
+{
+	assert(location.chunkIndex < m_chunks.size() && location.row < m_chunks[location.chunkIndex].rowCount);
+
+	Location lastLocation;
+	lastLocation.chunkIndex = static_cast<uint32_t>(m_chunks.size() - 1);
+	lastLocation.row = m_chunks.back().rowCount - 1;
+
+	Entity movedEntity = INVALID_ENTITY;
+	if (location.chunkIndex != lastLocation.chunkIndex || location.row != lastLocation.row)
+	{
+		for (size_t columnIndex = 0; columnIndex < m_componentTypes.size(); ++columnIndex)
+		{
+			const ComponentTypeInfo* pTypeInfo = m_componentTypes[columnIndex];
+			void* pLastComponent = GetComponent(lastLocation, columnIndex);
+			pTypeInfo->moveConstruct(GetComponent(location, columnIndex), pLastComponent);
+			pTypeInfo->destruct(pLastComponent);
+		}
+
+		movedEntity = GetEntities(lastLocation.chunkIndex)[lastLocation.row];
+		GetEntities(location.chunkIndex)[location.row] = movedEntity;
+	}
+
+	if (0U == --m_chunks.back().rowCount)
+	{
+		::operator delete(m_chunks.back().pData, std::align_val_t{ ChunkAlignment });
+		m_chunks.pop_back();
+	}
+	--m_rowCount;
+
+	return movedEntity;
+}
+
+Archetype* Archetype::GetAddEdge(ComponentTypeID typeID) const
+{
+	auto itEdge = m_addEdges.find(typeID);
+	return itEdge == m_addEdges.end() ? nullptr : itEdge->second;
+}
+
+Archetype* Archetype::GetRemoveEdge(ComponentTypeID typeID) const
+{
+	auto itEdge = m_removeEdges.find(typeID);
+	return itEdge == m_removeEdges.end() ? nullptr : itEdge->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// ArchetypeStorage
+///////////////////////////////////////////////////////////////////////////////////
+ArchetypeStorage::~ArchetypeStorage()
+{
+	// Archetypes refer to component type infos so release them at first.
+	m_archetypes.clear();
+}
+
+void ArchetypeStorage::RemoveEntity(Entity entity)
+{
+	EntityRecord* pRecord = GetEntityRecord(entity);
+	if (!pRecord)
+	{
+		return;
+	}
+
+	MoveEntity(entity, *pRecord, nullptr);
+}
+
+void* ArchetypeStorage::AddComponent(Entity entity, ComponentTypeID typeID)
+{
+	assert(entity != INVALID_ENTITY);
+	auto itTypeInfo = m_componentTypes.find(typeID);
+	assert(itTypeInfo != m_componentTypes.end() && "Component type is not registered to archetype storage.");
+	const ComponentTypeInfo* pTypeInfo = &itTypeInfo->second;
+
+	EntityRecord& record = GetOrCreateEntityRecord(entity);
+	Archetype* pSrcArchetype = record.pArchetype;
+	assert(!pSrcArchetype || !pSrcArchetype->HasComponentType(typeID));
+
+	Archetype* pDstArchetype = pSrcArchetype ? pSrcArchetype->GetAddEdge(typeID) : nullptr;
+	if (!pDstArchetype)
+	{
+		std::vector<const ComponentTypeInfo*> componentTypes;
+		if (pSrcArchetype)
+		{
+			componentTypes = pSrcArchetype->GetComponentTypes();
+		}
+		componentTypes.push_back(pTypeInfo);
+		pDstArchetype = GetOrCreateArchetype(cd::MoveTemp(componentTypes));
+
+		if (pSrcArchetype)
+		{
+			pSrcArchetype->SetAddEdge(typeID, pDstArchetype);
+			pDstArchetype->SetRemoveEdge(typeID, pSrcArchetype);
+		}
+	}
+
+	MoveEntity(entity, record, pDstArchetype);
+
+	void* pComponent = pDstArchetype->GetComponent(record.location, static_cast<size_t>(pDstArchetype->GetColumnIndex(typeID)));
+	pTypeInfo->construct(pComponent);
+	return pComponent;
+}
+
+void ArchetypeStorage::RemoveComponent(Entity entity, ComponentTypeID typeID)
+{
+	EntityRecord* pRecord = GetEntityRecord(entity);
+	if (!pRecord || !pRecord->pArchetype->HasComponentType(typeID))
+	{
+		return;
+	}
+
+	EntityRecord& record = *pRecord;
+	Archetype* pSrcArchetype = record.pArchetype;
+
+	Archetype* pDstArchetype = pSrcArchetype->GetRemoveEdge(typeID);
+	if (!pDstArchetype && pSrcArchetype->GetColumnCount() > 1)
+	{
+		std::vector<const ComponentTypeInfo*> componentTypes;
+		for (const ComponentTypeInfo* pTypeInfo : pSrcArchetype->GetComponentTypes())
+		{
+			if (pTypeInfo->id != typeID)
+			{
+				componentTypes.push_back(pTypeInfo);
+			}
+		}
+		pDstArchetype = GetOrCreateArchetype(cd::MoveTemp(componentTypes));
+
+		pSrcArchetype->SetRemoveEdge(typeID, pDstArchetype);
+		pDstArchetype->SetAddEdge(typeID, pSrcArchetype);
+	}
+
+	MoveEntity(entity, record, pDstArchetype);
+}
+
+void* ArchetypeStorage::GetComponent(Entity entity, ComponentTypeID typeID) const
+{
+	const EntityRecord* pRecord = GetEntityRecord(entity);
+	if (!pRecord)
+	{
+		return nullptr;
+	}
+
+	int columnIndex = pRecord->pArchetype->GetColumnIndex(typeID);
+	return columnIndex < 0 ? nullptr : pRecord->pArchetype->GetComponent(pRecord->location, static_cast<size_t>(columnIndex));
+}
+
+const ArchetypeStorage::EntityRecord* ArchetypeStorage::GetEntityRecord(Entity entity) const
+{
+	// Records are addressed by entity index. Stale handles are rejected by comparing with the entity stored in chunk.
+	uint32_t entityIndex = GetEntityIndex(entity);
+	if (entityIndex >= m_entityRecords.size())
+	{
+		return nullptr;
+	}
+
+	const EntityRecord& record = m_entityRecords[entityIndex];
+	if (!record.pArchetype || record.pArchetype->GetEntities(record.location.chunkIndex)[record.location.row] != entity)
+	{
+		return nullptr;
+	}
+
+	return &record;
+}
+
+ArchetypeStorage::EntityRecord* ArchetypeStorage::GetEntityRecord(Entity entity)
+{
+	return const_cast<EntityRecord*>(static_cast<const ArchetypeStorage*>(this)->GetEntityRecord(entity));
+}
+
+ArchetypeStorage::EntityRecord& ArchetypeStorage::GetOrCreateEntityRecord(Entity entity)
+{
+	uint32_t entityIndex = GetEntityIndex(entity);
+	if (entityIndex >= m_entityRecords.size())
+	{
+		m_entityRecords.resize(static_cast<size_t>(entityIndex) + 1);
+	}
+
+	EntityRecord& record = m_entityRecords[entityIndex];
+	if (record.pArchetype && record.pArchetype->GetEntities(record.location.chunkIndex)[record.location.row] != entity)
+	{
+		// The index is recycled but components of stale entity are still alive. Release them.
+		MoveEntity(record.pArchetype->GetEntities(record.location.chunkIndex)[record.location.row], record, nullptr);
+	}
+
+	return record;
+}
+
+Archetype* ArchetypeStorage::GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> componentTypes)
+{
+	std::vector<ComponentTypeID> signature;
+	signature.reserve(componentTypes.size());
+	for (const ComponentTypeInfo* pTypeInfo : componentTypes)
+	{
+		signature.push_back(pTypeInfo->id);
+	}
+	std::sort(signature.begin(), signature.end());
+
+	auto itArchetype = m_archetypes.find(signature);
+	if (itArchetype != m_archetypes.end())
+	{
+		return itArchetype->second.get();
+	}
+
+	auto pArchetype = std::make_unique<Archetype>(cd::MoveTemp(componentTypes));
+	Archetype* pResult = pArchetype.get();
+	m_archetypes.emplace(cd::MoveTemp(signature), cd::MoveTemp(pArchetype));
+	return pResult;
+}
+
+void ArchetypeStorage::MoveEntity(Entity entity, EntityRecord& record, Archetype* pDstArchetype)
+{
+	Archetype* pSrcArchetype = record.pArchetype;
+	Archetype::Location dstLocation{ 0U, 0U };
+	if (pDstArchetype)
+	{
+		dstLocation = pDstArchetype->AllocateRow(entity);
+	}
+
+	if (pSrcArchetype)
+	{
+		const auto& srcComponentTypes = pSrcArchetype->GetComponentTypes();
+		for (size_t srcColumnIndex = 0; srcColumnIndex < srcComponentTypes.size(); ++srcColumnIndex)
+		{
+			const ComponentTypeInfo* pTypeInfo = srcComponentTypes[srcColumnIndex];
+			void* pSrcComponent = pSrcArchetype->GetComponent(record.location, srcColumnIndex);
+			int dstColumnIndex = pDstArchetype ? pDstArchetype->GetColumnIndex(pTypeInfo->id) : -1;
+			if (dstColumnIndex >= 0)
+			{
+				pTypeInfo->moveConstruct(pDstArchetype->GetComponent(dstLocation, static_cast<size_t>(dstColumnIndex)), pSrcComponent);
+			}
+			pTypeInfo->destruct(pSrcComponent);
+		}
+
+		Entity movedEntity = pSrcArchetype->RemoveRow(record.location);
+		if (movedEntity != INVALID_ENTITY)
+		{
+			m_entityRecords[GetEntityIndex(movedEntity)].location = record.location;
+		}
+	}
+
+	record.pArchetype = pDstArchetype;
+	record.location = dstLocation;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "Entity.h"
+#include "Base/Template.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine
+{
+
+using ComponentTypeID = uint32_t;
+
+// Type-erased operations to manage component lifetime inside archetype chunks.
+struct ComponentTypeInfo
+{
+	ComponentTypeID id;
+	uint32_t size;
+	uint32_t alignment;
+	void (*construct)(void* pDst);
+	void (*moveConstruct)(void* pDst, void* pSrc);
+	void (*destruct)(void* pDst);
+
+	template<typename Component>
+	static ComponentTypeInfo Create()
+	{
+		ComponentTypeInfo info;
+		info.id = Component::GetClassName().Value();
+		info.size = static_cast<uint32_t>(sizeof(Component));
+		info.alignment = static_cast<uint32_t>(alignof(Component));
+		info.construct = [](void* pDst) { new (pDst) Component(); };
+		info.moveConstruct = [](void* pDst, void* pSrc) { new (pDst) Component(cd::MoveTemp(*static_cast<Component*>(pSrc))); };
+		info.destruct = [](void* pDst) { static_cast<Component*>(pDst)->~Component(); };
+		return info;
+	}
+};
+
+// Archetype stores all entities which have the same component signature.
+// Entities are packed into fixed-size chunks. Every chunk uses SoA layout :
+// [Entity0, Entity1, ...][ComponentA0, ComponentA1, ...][ComponentB0, ComponentB1, ...]
+// All chunks are full except the last one so that removing a row only needs to move the last row into the hole.
+class Archetype
+{
+public:
+	static constexpr size_t ChunkByteSize = 16 * 1024;
+	static constexpr size_t ChunkAlignment = 64;
+
+	struct Location
+	{
+		uint32_t chunkIndex;
+		uint32_t row;
+	};
+
+public:
+	Archetype() = delete;
+	explicit Archetype(std::vector<const ComponentTypeInfo*> componentTypes);
+	Archetype(const Archetype&) = delete;
+	Archetype& operator=(const Archetype&) = delete;
+	Archetype(Archetype&&) = delete;
+	Archetype& operator=(Archetype&&) = delete;
+	~Archetype();
+
+	const std::vector<const ComponentTypeInfo*>& GetComponentTypes() const { return m_componentTypes; }
+	size_t GetColumnCount() const { return m_componentTypes.size(); }
+
+	// Returns column index of component type in this archetype or -1 if not exists.
+	int GetColumnIndex(ComponentTypeID typeID) const;
+	bool HasComponentType(ComponentTypeID typeID) const { return GetColumnIndex(typeID) >= 0; }
+
+	uint32_t GetChunkCapacity() const { return m_chunkCapacity; }
+	size_t GetChunkCount() const { return m_chunks.size(); }
+	uint32_t GetChunkRowCount(size_t chunkIndex) const { return m_chunks[chunkIndex].rowCount; }
+	size_t GetRowCount() const { return m_rowCount; }
+
+	Entity* GetEntities(size_t chunkIndex) const { return reinterpret_cast<Entity*>(m_chunks[chunkIndex].pData); }
+	void* GetColumn(size_t chunkIndex, size_t columnIndex) const { return m_chunks[chunkIndex].pData + m_columnOffsets[columnIndex]; }
+	void* GetComponent(Location location, size_t columnIndex) const
+	{
+		return static_cast<std::byte*>(GetColumn(location.chunkIndex, columnIndex)) + static_cast<size_t>(location.row) * m_componentTypes[columnIndex]->size;
+	}
+
+	// Append a row for entity. Components in the row are not constructed.
+	Location AllocateRow(Entity entity);
+
+	// Fill the hole with the last row. Components in the removed row should be destructed by caller already.
+	// Returns the entity which is moved into the hole, or INVALID_ENTITY if nothing moved.
+	Entity RemoveRow(Location location);
+
+	// Cached archetype graph edges to avoid signature lookups when adding/removing a component.
+	Archetype* GetAddEdge(ComponentTypeID typeID) const;
+	Archetype* GetRemoveEdge(ComponentTypeID typeID) const;
+	void SetAddEdge(ComponentTypeID typeID, Archetype* pArchetype) { m_addEdges[typeID] = pArchetype; }
+	void SetRemoveEdge(ComponentTypeID typeID, Archetype* pArchetype) { m_removeEdges[typeID] = pArchetype; }
+
+private:
+	struct Chunk
+	{
+		std::byte* pData;
+		uint32_t rowCount;
+	};
+
+	// Sorted by type id.
+	std::vector<const ComponentTypeInfo*> m_componentTypes;
+	std::vector<size_t> m_columnOffsets;
+	size_t m_chunkByteSize = ChunkByteSize;
+	uint32_t m_chunkCapacity = 0U;
+
+	std::vector<Chunk> m_chunks;
+	size_t m_rowCount = 0;
+
+	std::unordered_map<ComponentTypeID, Archetype*> m_addEdges;
+	std::unordered_map<ComponentTypeID, Archetype*> m_removeEdges;
+};
+
+// ArchetypeStorage manages components of all types by archetypes.
+// Compared with one ComponentsStorage per component type, systems which touch multiple components together
+// can iterate them chunk by chunk with good locality.
+// Note that adding/removing a component moves all components of the entity to another archetype,
+// so component pointers are only stable until next structural change.
+// It is enabled by World::EnableArchetypeStorage, e.g. SceneWorld with EngineInitArgs::useArchetypeStorage.
+class ArchetypeStorage
+{
+public:
+	ArchetypeStorage() = default;
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+	ArchetypeStorage(ArchetypeStorage&&) = default;
+	ArchetypeStorage& operator=(ArchetypeStorage&&) = default;
+	~ArchetypeStorage();
+
+	template<typename Component>
+	void RegisterComponentType()
+	{
+		ComponentTypeInfo info = ComponentTypeInfo::Create<Component>();
+		m_componentTypes[info.id] = info;
+	}
+
+	template<typename Component>
+	Component& AddComponent(Entity entity)
+	{
+		return *static_cast<Component*>(AddComponent(entity, Component::GetClassName().Value()));
+	}
+
+	template<typename Component>
+	void RemoveComponent(Entity entity)
+	{
+		RemoveComponent(entity, Component::GetClassName().Value());
+	}
+
+	template<typename Component>
+	Component* GetComponent(Entity entity) const
+	{
+		return static_cast<Component*>(GetComponent(entity, Component::GetClassName().Value()));
+	}
+
+	template<typename Component>
+	bool HasComponent(Entity entity) const
+	{
+		return GetComponent(entity, Component::GetClassName().Value()) != nullptr;
+	}
+
+	// Destruct all components of entity.
+	void RemoveEntity(Entity entity);
+
+	size_t GetArchetypeCount() const { return m_archetypes.size(); }
+
+	// Invoke func(uint32_t rowCount, const Entity* pEntities, Components*... pColumns) for every chunk
+	// whose archetype contains all of Components.
+	template<typename... Components, typename Func>
+	void ForEachChunk(Func&& func) const
+	{
+		constexpr size_t componentCount = sizeof...(Components);
+		const ComponentTypeID typeIDs[componentCount] = { Components::GetClassName().Value()... };
+
+		for (const auto& [_, pArchetype] : m_archetypes)
+		{
+			int columnIndexes[componentCount];
+			bool matched = true;
+			for (size_t index = 0; index < componentCount; ++index)
+			{
+				columnIndexes[index] = pArchetype->GetColumnIndex(typeIDs[index]);
+				matched &= columnIndexes[index] >= 0;
+			}
+
+			if (!matched)
+			{
+				continue;
+			}
+
+			for (size_t chunkIndex = 0; chunkIndex < pArchetype->GetChunkCount(); ++chunkIndex)
+			{
+				InvokeChunk<Components...>(func, *pArchetype, chunkIndex, columnIndexes, std::index_sequence_for<Components...>{});
+			}
+		}
+	}
+
+	// Invoke func(Entity, Components&...) for every entity which contains all of Components.
+	template<typename... Components, typename Func>
+	void ForEach(Func&& func) const
+	{
+		ForEachChunk<Components...>([&func](uint32_t rowCount, const Entity* pEntities, Components*... pColumns)
+		{
+			for (uint32_t row = 0; row < rowCount; ++row)
+			{
+				func(pEntities[row], pColumns[row]...);
+			}
+		});
+	}
+
+private:
+	struct EntityRecord
+	{
+		Archetype* pArchetype = nullptr;
+		Archetype::Location location;
+	};
+
+	template<typename... Components, typename Func, size_t... Indexes>
+	static void InvokeChunk(Func& func, const Archetype& archetype, size_t chunkIndex, const int* pColumnIndexes, std::index_sequence<Indexes...>)
+	{
+		func(archetype.GetChunkRowCount(chunkIndex), archetype.GetEntities(chunkIndex),
+			static_cast<Components*>(archetype.GetColumn(chunkIndex, static_cast<size_t>(pColumnIndexes[Indexes])))...);
+	}
+
+	void* AddComponent(Entity entity, ComponentTypeID typeID);
+	void RemoveComponent(Entity entity, ComponentTypeID typeID);
+	void* GetComponent(Entity entity, ComponentTypeID typeID) const;
+
+	// Returns nullptr if entity has no component or the handle is stale.
+	const EntityRecord* GetEntityRecord(Entity entity) const;
+	EntityRecord* GetEntityRecord(Entity entity);
+	EntityRecord& GetOrCreateEntityRecord(Entity entity);
+
+	Archetype* GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> componentTypes);
+
+	// Move entity's row from its current archetype to pDstArchetype. Components which don't exist in
+	// pDstArchetype are destructed and new components are left unconstructed.
+	void MoveEntity(Entity entity, EntityRecord& record, Archetype* pDstArchetype);
+
+private:
+	std::unordered_map<ComponentTypeID, ComponentTypeInfo> m_componentTypes;
+	std::map<std::vector<ComponentTypeID>, std::unique_ptr<Archetype>> m_archetypes;
+	std::vector<EntityRecord> m_entityRecords;
+};
+
+}
\ No newline at end of file
@@ -1,11 +1,11 @@
 #pragma once
 
+#include "ArchetypeStorage.h"
 #include "Entity.h"
 
 #include <algorithm>
 #include <cassert>
-#include <map>
-#include <unordered_map>
+#include <memory>
 #include <vector>
 
 namespace engine
@@ -15,15 +15,34 @@ class IComponentsStorage
 {
 public:
 	virtual ~IComponentsStorage() = default;
+
+	// Remove component of entity without knowing the component type.
+	virtual void RemoveEntity(Entity entity) = 0;
+
+	// Remove components of entities in one batch.
+	virtual void RemoveEntities(const Entity* pEntities, size_t count) = 0;
 };
 
 // ComponentsStorage stores an array of Components in the same type and the entity which contains the component.
+// It is a paged sparse set :
+// 1. Dense arrays store active entities and their components compactly so that iteration is a linear scan.
+// 2. Sparse pages map entity index to dense index. Pages are allocated lazily so that memory grows with used entity ranges.
+//    Dense entity is compared with the input handle so that stale handles of recycled indexes are rejected.
+// All of Contains/GetComponent/CreateComponent/RemoveComponent are O(1) without hashing.
+// When bound to an ArchetypeStorage, components live in archetype chunks instead of the dense component array.
+// The sparse set only tracks which entities own the component so that GetEntities() keeps working.
 template<typename Component>
 class ComponentsStorage : public IComponentsStorage
 {
 public:
 	static_assert(!std::is_pointer_v<Component> && !std::is_reference_v<Component>);
 
+	using DenseIndex = uint32_t;
+	static constexpr DenseIndex InvalidDenseIndex = static_cast<DenseIndex>(-1);
+	static constexpr size_t SparsePageBits = 12;
+	static constexpr size_t SparsePageSize = static_cast<size_t>(1) << SparsePageBits;
+	static constexpr size_t SparsePageMask = SparsePageSize - 1;
+
 public:
 	ComponentsStorage() = default;
 	ComponentsStorage(const ComponentsStorage&) = delete;
@@ -33,22 +52,45 @@ public:
 	virtual ~ComponentsStorage() = default;
 
 	// Returns if ComponentStorage stores component for entity.
-	bool Contains(Entity entity) const { return m_entityToIndex.find(entity) != m_entityToIndex.end(); }
+	bool Contains(Entity entity) const { return GetDenseIndex(entity) != InvalidDenseIndex; }
 
 	// Returns current active components count.
-	size_t GetCount() const { return m_entityToIndex.size(); }
+	size_t GetCount() const { return m_entities.size(); }
 
 	// Returns current components capcity.
-	size_t GetCapcity() const { assert(m_entities.size() == m_components.size()); return m_entities.size(); }
+	size_t GetCapcity() const { assert(m_pArchetypeStorage || m_entities.size() == m_components.size()); return m_entities.size(); }
 
-	// Need to check if it is still active.
+	// All entities in the dense array are active.
 	const std::vector<Entity>& GetEntities() const { return m_entities; }
 
+	// Packed components which align to GetEntities() by index. Not available in archetype mode, use World::View or GetComponent instead.
+	std::vector<Component>& GetComponents() { assert(!m_pArchetypeStorage); return m_components; }
+	const std::vector<Component>& GetComponents() const { assert(!m_pArchetypeStorage); return m_components; }
+
+	// Store components in archetype chunks. Should be called before creating any component.
+	void BindArchetypeStorage(ArchetypeStorage* pArchetypeStorage)
+	{
+		assert(m_entities.empty());
+		m_pArchetypeStorage = pArchetypeStorage;
+		m_pArchetypeStorage->RegisterComponentType<Component>();
+	}
+	bool IsArchetypeMode() const { return m_pArchetypeStorage != nullptr; }
+
 	// Get component by entity.
 	Component* GetComponent(Entity entity)
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+		DenseIndex denseIndex = GetDenseIndex(entity);
+		if (denseIndex == InvalidDenseIndex)
+		{
+			return nullptr;
+		}
+
+		return m_pArchetypeStorage ? m_pArchetypeStorage->GetComponent<Component>(entity) : &m_components[denseIndex];
+	}
+
+	const Component* GetComponent(Entity entity) const
+	{
+		return const_cast<ComponentsStorage*>(this)->GetComponent(entity);
 	}
 
 	// Create component for entity.
@@ -56,8 +98,13 @@ public:
 	{
 		assert(entity != INVALID_ENTITY && !Contains(entity));
 
-		m_entityToIndex[entity] = m_components.size();
+		GetOrCreateSparseSlot(entity) = static_cast<DenseIndex>(m_entities.size());
 		m_entities.emplace_back(entity);
+		if (m_pArchetypeStorage)
+		{
+			return m_pArchetypeStorage->AddComponent<Component>(entity);
+		}
+
 		m_components.emplace_back();
 		return m_components.back();
 	}
@@ -65,30 +112,161 @@ public:
 	// Remove actvie component from storage.
 	void RemoveComponent(Entity entity)
 	{
-		auto itIndex = m_entityToIndex.find(entity);
-		if (itIndex == m_entityToIndex.end())
+		DenseIndex unusedIndex = GetDenseIndex(entity);
+		if (InvalidDenseIndex == unusedIndex)
 		{
 			return;
 		}
 
-		if (m_entityToIndex.size() > 1)
+		if (m_pArchetypeStorage)
+		{
+			m_pArchetypeStorage->RemoveComponent<Component>(entity);
+		}
+
+		size_t lastIndex = m_entities.size() - 1;
+		if (unusedIndex != lastIndex)
 		{
-			size_t unusedIndex = itIndex->second;
 			Entity lastEntity = m_entities.back();
 			m_entities[unusedIndex] = lastEntity;
-			m_components[unusedIndex] = cd::MoveTemp(m_components.back());
-			m_entityToIndex[lastEntity] = unusedIndex;
+			if (!m_pArchetypeStorage)
+			{
+				m_components[unusedIndex] = cd::MoveTemp(m_components.back());
+			}
+			GetSparseSlot(lastEntity) = static_cast<DenseIndex>(unusedIndex);
 		}
 
 		m_entities.pop_back();
-		m_components.pop_back();
-		m_entityToIndex.erase(entity);
+		if (!m_pArchetypeStorage)
+		{
+			m_components.pop_back();
+		}
+		GetSparseSlot(entity) = InvalidDenseIndex;
+	}
+
+	virtual void RemoveEntity(Entity entity) override { RemoveComponent(entity); }
+
+	// Remove components of entities in one batch. Holes are filled by alive components from the tail
+	// so that every moved component is moved once and dense arrays are shrinked once.
+	virtual void RemoveEntities(const Entity* pEntities, size_t count) override
+	{
+		m_removedDenseIndexes.clear();
+		for (size_t index = 0; index < count; ++index)
+		{
+			Entity entity = pEntities[index];
+			DenseIndex denseIndex = GetDenseIndex(entity);
+			if (InvalidDenseIndex == denseIndex)
+			{
+				continue;
+			}
+
+			if (m_pArchetypeStorage)
+			{
+				m_pArchetypeStorage->RemoveComponent<Component>(entity);
+			}
+
+			GetSparseSlot(entity) = InvalidDenseIndex;
+			m_entities[denseIndex] = INVALID_ENTITY;
+			m_removedDenseIndexes.push_back(denseIndex);
+		}
+
+		if (m_removedDenseIndexes.empty())
+		{
+			return;
+		}
+
+		std::sort(m_removedDenseIndexes.begin(), m_removedDenseIndexes.end());
+		size_t newCount = m_entities.size() - m_removedDenseIndexes.size();
+		size_t tailIndex = m_entities.size();
+		for (DenseIndex holeIndex : m_removedDenseIndexes)
+		{
+			if (holeIndex >= newCount)
+			{
+				break;
+			}
+
+			do
+			{
+				--tailIndex;
+			} while (INVALID_ENTITY == m_entities[tailIndex]);
+
+			Entity tailEntity = m_entities[tailIndex];
+			m_entities[holeIndex] = tailEntity;
+			if (!m_pArchetypeStorage)
+			{
+				m_components[holeIndex] = cd::MoveTemp(m_components[tailIndex]);
+			}
+			GetSparseSlot(tailEntity) = holeIndex;
+		}
+
+		m_entities.resize(newCount);
+		if (!m_pArchetypeStorage)
+		{
+			m_components.erase(m_components.begin() + newCount, m_components.end());
+		}
+	}
+
+	// Reserve dense arrays to avoid reallocation when creating many components in batch.
+	void Reserve(size_t count)
+	{
+		m_entities.reserve(count);
+		if (!m_pArchetypeStorage)
+		{
+			m_components.reserve(count);
+		}
+	}
+
+private:
+	using SparsePage = std::unique_ptr<DenseIndex[]>;
+
+	DenseIndex GetDenseIndex(Entity entity) const
+	{
+		size_t entityIndex = GetEntityIndex(entity);
+		size_t pageIndex = entityIndex >> SparsePageBits;
+		if (pageIndex >= m_sparsePages.size() || !m_sparsePages[pageIndex])
+		{
+			return InvalidDenseIndex;
+		}
+
+		DenseIndex denseIndex = m_sparsePages[pageIndex][entityIndex & SparsePageMask];
+		return (denseIndex != InvalidDenseIndex && m_entities[denseIndex] == entity) ? denseIndex : InvalidDenseIndex;
+	}
+
+	// Caller makes sure that the page for entity is already allocated.
+	DenseIndex& GetSparseSlot(Entity entity)
+	{
+		size_t entityIndex = GetEntityIndex(entity);
+		size_t pageIndex = entityIndex >> SparsePageBits;
+		assert(pageIndex < m_sparsePages.size() && m_sparsePages[pageIndex]);
+		return m_sparsePages[pageIndex][entityIndex & SparsePageMask];
+	}
+
+	DenseIndex& GetOrCreateSparseSlot(Entity entity)
+	{
+		size_t entityIndex = GetEntityIndex(entity);
+		size_t pageIndex = entityIndex >> SparsePageBits;
+		if (pageIndex >= m_sparsePages.size())
+		{
+			m_sparsePages.resize(pageIndex + 1);
+		}
+
+		SparsePage& page = m_sparsePages[pageIndex];
+		if (!page)
+		{
+			page = std::make_unique<DenseIndex[]>(SparsePageSize);
+			std::fill_n(page.get(), SparsePageSize, InvalidDenseIndex);
+		}
+
+		return page[entityIndex & SparsePageMask];
 	}
 
 private:
 	std::vector<Entity> m_entities;
 	std::vector<Component> m_components;
-	std::unordered_map<Entity, size_t> m_entityToIndex;
+	std::vector<SparsePage> m_sparsePages;
+	ArchetypeStorage* m_pArchetypeStorage = nullptr;
+
+	// Reused by batch removal to avoid allocations.
+	std::vector<DenseIndex> m_removedDenseIndexes;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+
+#include <cassert>
+#include <tuple>
+#include <vector>
+
+namespace engine
+{
+
+// ComponentsView is a query to iterate entities which contain all of the required Components.
+// Iteration is driven by the smallest storage so that only a minimal set of entities will be tested.
+// Then other components are resolved by sparse set index which doesn't need any hash probe.
+// Entities are visited from back to front so that removing components of the current entity is allowed during iteration.
+// Other structural changes of the viewed types should be deferred by EntityCommandBuffer.
+template<typename... Components>
+class ComponentsView
+{
+public:
+	static_assert(sizeof...(Components) > 0);
+
+	using Storages = std::tuple<ComponentsStorage<Components>*...>;
+	using Value = std::tuple<Entity, Components&...>;
+
+	class Iterator
+	{
+	public:
+		// index : count of entities which are not visited yet. The current entity is at index - 1.
+		Iterator(const ComponentsView* pView, size_t index) :
+			m_pView(pView),
+			m_index(index)
+		{
+			SkipInvalid();
+		}
+
+		Value operator*() const
+		{
+			Entity entity = (*m_pView->m_pDrivingEntities)[m_index - 1];
+			return Value(entity, *std::get<ComponentsStorage<Components>*>(m_pView->m_storages)->GetComponent(entity)...);
+		}
+
+		Iterator& operator++()
+		{
+			--m_index;
+			SkipInvalid();
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+		bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+	private:
+		void SkipInvalid()
+		{
+			const std::vector<Entity>& entities = *m_pView->m_pDrivingEntities;
+			while (m_index > 0 && !m_pView->Contains(entities[m_index - 1]))
+			{
+				--m_index;
+			}
+		}
+
+	private:
+		const ComponentsView* m_pView;
+		size_t m_index;
+	};
+
+public:
+	ComponentsView() = delete;
+	explicit ComponentsView(ComponentsStorage<Components>*... pStorages) :
+		m_storages(pStorages...)
+	{
+		assert(((pStorages != nullptr) && ...));
+
+		// Choose the smallest storage to drive iteration.
+		((m_pDrivingEntities = (!m_pDrivingEntities || pStorages->GetCount() < m_pDrivingEntities->size()) ?
+			&pStorages->GetEntities() : m_pDrivingEntities), ...);
+	}
+	ComponentsView(const ComponentsView&) = default;
+	ComponentsView& operator=(const ComponentsView&) = default;
+	ComponentsView(ComponentsView&&) = default;
+	ComponentsView& operator=(ComponentsView&&) = default;
+	~ComponentsView() = default;
+
+	Iterator begin() const { return Iterator(this, m_pDrivingEntities->size()); }
+	Iterator end() const { return Iterator(this, 0); }
+
+	// Returns an upper bound of iteration count.
+	size_t GetMaxCount() const { return m_pDrivingEntities->size(); }
+
+	bool Contains(Entity entity) const
+	{
+		return (std::get<ComponentsStorage<Components>*>(m_storages)->Contains(entity) && ...);
+	}
+
+	// Invoke func(Entity, Components&...) for every entity which contains all of Components.
+	template<typename Func>
+	void Each(Func&& func) const
+	{
+		for (size_t index = m_pDrivingEntities->size(); index > 0; --index)
+		{
+			Entity entity = (*m_pDrivingEntities)[index - 1];
+			std::tuple<Components*...> components(std::get<ComponentsStorage<Components>*>(m_storages)->GetComponent(entity)...);
+			if (((std::get<Components*>(components) != nullptr) && ...))
+			{
+				func(entity, *std::get<Components*>(components)...);
+			}
+		}
+	}
+
+private:
+	Storages m_storages;
+	const std::vector<Entity>* m_pDrivingEntities = nullptr;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "CullingSystem.h"
+
+#include "CollisionMeshComponent.h"
+#include "Scheduler/ThreadPool.h"
+#include "TransformComponent.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE__)
+#define CD_CULLING_SYSTEM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr size_t FrustumPlaneCount = 6;
+
+struct FrustumPlane
+{
+	float normal[3];
+	float distance;
+};
+
+// Planes of a column major view projection matrix, pointing inside.
+// Near plane uses z >= -w for both ndc depth conventions so that it is conservative for [0, 1] depth.
+// Planes are not normalized because only the sign of the distance is tested.
+void ExtractFrustumPlanes(const cd::Matrix4x4& viewProjection, FrustumPlane* pPlanes)
+{
+	const float* pMatrix = viewProjection.begin();
+	auto GetRow = [pMatrix](int row, int column) { return pMatrix[column * 4 + row]; };
+
+	constexpr int planeRows[FrustumPlaneCount] = { 0, 0, 1, 1, 2, 2 };
+	constexpr float planeSigns[FrustumPlaneCount] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+	for (size_t planeIndex = 0; planeIndex < FrustumPlaneCount; ++planeIndex)
+	{
+		int row = planeRows[planeIndex];
+		float sign = planeSigns[planeIndex];
+		FrustumPlane& plane = pPlanes[planeIndex];
+		plane.normal[0] = GetRow(3, 0) + sign * GetRow(row, 0);
+		plane.normal[1] = GetRow(3, 1) + sign * GetRow(row, 1);
+		plane.normal[2] = GetRow(3, 2) + sign * GetRow(row, 2);
+		plane.distance = GetRow(3, 3) + sign * GetRow(row, 3);
+	}
+}
+
+}
+
+CullingSystem::CullingSystem(World* pWorld)
+{
+	assert(pWorld);
+	m_pTransformStorage = pWorld->GetComponents<TransformComponent>();
+	m_pCollisionMeshStorage = pWorld->GetComponents<CollisionMeshComponent>();
+	assert(m_pTransformStorage && m_pCollisionMeshStorage);
+}
+
+void CullingSystem::ClearViews()
+{
+	m_viewProjections.clear();
+	m_viewOcclusions.clear();
+}
+
+CullingSystem::ViewIndex CullingSystem::AddView(const cd::Matrix4x4& viewProjection, bool useOcclusion)
+{
+	m_viewProjections.push_back(viewProjection);
+	m_viewOcclusions.push_back(useOcclusion);
+	return static_cast<ViewIndex>(m_viewProjections.size() - 1);
+}
+
+void CullingSystem::ClearOccluders()
+{
+	m_occluders.clear();
+}
+
+void CullingSystem::AddOccluder(Entity entity, std::span<const cd::Point> positions, std::span<const uint32_t> indices)
+{
+	// Bounds are computed in Update with the current transform.
+	m_occluders.push_back(Occluder{ entity, positions, indices, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } });
+}
+
+void CullingSystem::Update(ThreadPool* pThreadPool)
+{
+	// Partition entities so that bounded ones are contiguous for SIMD batches.
+	const std::vector<Entity>& transformEntities = m_pTransformStorage->GetEntities();
+	const std::vector<Entity>& boundedEntities = m_pCollisionMeshStorage->GetEntities();
+	m_entities.clear();
+	m_entities.reserve(transformEntities.size() + boundedEntities.size());
+	m_entities.insert(m_entities.end(), boundedEntities.begin(), boundedEntities.end());
+	m_boundedCount = m_entities.size();
+	for (Entity entity : transformEntities)
+	{
+		if (!m_pCollisionMeshStorage->Contains(entity))
+		{
+			m_entities.push_back(entity);
+		}
+	}
+
+	size_t paddedCount = (m_boundedCount + 3) & ~static_cast<size_t>(3);
+	m_centerX.assign(paddedCount, 0.0f);
+	m_centerY.assign(paddedCount, 0.0f);
+	m_centerZ.assign(paddedCount, 0.0f);
+	m_extentX.assign(paddedCount, 0.0f);
+	m_extentY.assign(paddedCount, 0.0f);
+	m_extentZ.assign(paddedCount, 0.0f);
+
+	if (pThreadPool)
+	{
+		pThreadPool->ParallelFor(m_boundedCount, ParallelBatchSize, [this](size_t begin, size_t end) { GatherBounds(begin, end); });
+	}
+	else
+	{
+		GatherBounds(0, m_boundedCount);
+	}
+
+	// Occluders without bounds can't be ranked so that they are dropped.
+	std::erase_if(m_occluders, [this](Occluder& occluder)
+	{
+		return !m_pCollisionMeshStorage->Contains(occluder.entity) || !GetWorldBounds(occluder.entity, occluder.center, occluder.extent);
+	});
+
+	size_t viewCount = m_viewProjections.size();
+	m_visibleEntities.resize(viewCount);
+	m_occlusionBuffers.resize(std::max(viewCount, m_occlusionBuffers.size()));
+	for (size_t viewIndex = 0; viewIndex < viewCount; ++viewIndex)
+	{
+		if (m_viewOcclusions[viewIndex] && !m_occlusionBuffers[viewIndex])
+		{
+			m_occlusionBuffers[viewIndex] = std::make_unique<OcclusionBuffer>();
+		}
+	}
+
+	auto CullViewAt = [this](size_t viewIndex)
+	{
+		OcclusionBuffer* pOcclusionBuffer = m_viewOcclusions[viewIndex] ? m_occlusionBuffers[viewIndex].get() : nullptr;
+		CullView(m_viewProjections[viewIndex], m_visibleEntities[viewIndex], pOcclusionBuffer);
+	};
+
+	if (pThreadPool)
+	{
+		pThreadPool->ParallelFor(viewCount, 1, [&CullViewAt](size_t begin, size_t end)
+		{
+			for (size_t viewIndex = begin; viewIndex < end; ++viewIndex)
+			{
+				CullViewAt(viewIndex);
+			}
+		});
+	}
+	else
+	{
+		for (size_t viewIndex = 0; viewIndex < viewCount; ++viewIndex)
+		{
+			CullViewAt(viewIndex);
+		}
+	}
+}
+
+const std::vector<Entity>& CullingSystem::GetVisibleEntities(ViewIndex viewIndex) const
+{
+	assert(viewIndex < m_visibleEntities.size());
+	return m_visibleEntities[viewIndex];
+}
+
+const cd::Matrix4x4& CullingSystem::GetWorldMatrix(Entity entity) const
+{
+	static const cd::Matrix4x4 identity = cd::Matrix4x4::Identity();
+	const TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(entity);
+	return pTransformComponent ? pTransformComponent->GetWorldMatrix() : identity;
+}
+
+bool CullingSystem::GetWorldBounds(Entity entity, float* pCenter, float* pExtent) const
+{
+	const cd::AABB& aabb = m_pCollisionMeshStorage->GetComponent(entity)->GetAABB();
+	const float* pWorld = GetWorldMatrix(entity).begin();
+
+	float localMin[3] = { aabb.Min().x(), aabb.Min().y(), aabb.Min().z() };
+	float localMax[3] = { aabb.Max().x(), aabb.Max().y(), aabb.Max().z() };
+	if (localMin[0] > localMax[0] || localMin[1] > localMax[1] || localMin[2] > localMax[2])
+	{
+		return false;
+	}
+
+	// Transform center as a point and extent by absolute values of the upper 3x3 matrix.
+	float localCenter[3];
+	float localExtent[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		localCenter[axis] = 0.5f * (localMin[axis] + localMax[axis]);
+		localExtent[axis] = 0.5f * (localMax[axis] - localMin[axis]);
+	}
+
+	for (int row = 0; row < 3; ++row)
+	{
+		pCenter[row] = pWorld[row] * localCenter[0] + pWorld[4 + row] * localCenter[1] + pWorld[8 + row] * localCenter[2] + pWorld[12 + row];
+		pExtent[row] = std::abs(pWorld[row]) * localExtent[0] + std::abs(pWorld[4 + row]) * localExtent[1] + std::abs(pWorld[8 + row]) * localExtent[2];
+	}
+
+	return true;
+}
+
+void CullingSystem::GatherBounds(size_t beginIndex, size_t endIndex)
+{
+	for (size_t index = beginIndex; index < endIndex; ++index)
+	{
+		float worldCenter[3];
+		float worldExtent[3];
+		if (!GetWorldBounds(m_entities[index], worldCenter, worldExtent))
+		{
+			// Invalid box can't be culled so that the entity is treated as always visible.
+			m_extentX[index] = m_extentY[index] = m_extentZ[index] = FLT_MAX;
+			continue;
+		}
+
+		m_centerX[index] = worldCenter[0];
+		m_centerY[index] = worldCenter[1];
+		m_centerZ[index] = worldCenter[2];
+		m_extentX[index] = worldExtent[0];
+		m_extentY[index] = worldExtent[1];
+		m_extentZ[index] = worldExtent[2];
+	}
+}
+
+void CullingSystem::RasterizeOccluders(const cd::Matrix4x4& viewProjection, OcclusionBuffer& occlusionBuffer) const
+{
+	FrustumPlane planes[FrustumPlaneCount];
+	ExtractFrustumPlanes(viewProjection, planes);
+	const float* pMatrix = viewProjection.begin();
+
+	// Rank occluders in the frustum by bounding radius over view depth, which is proportional to their screen size.
+	std::vector<std::pair<float, const Occluder*>> rankedOccluders;
+	for (const Occluder& occluder : m_occluders)
+	{
+		bool isOutside = false;
+		for (size_t planeIndex = 0; planeIndex < FrustumPlaneCount && !isOutside; ++planeIndex)
+		{
+			const FrustumPlane& plane = planes[planeIndex];
+			float distance = plane.distance;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				distance += plane.normal[axis] * occluder.center[axis] + std::abs(plane.normal[axis]) * occluder.extent[axis];
+			}
+			isOutside = distance < 0.0f;
+		}
+
+		if (isOutside)
+		{
+			continue;
+		}
+
+		float radius = std::sqrt(occluder.extent[0] * occluder.extent[0] + occluder.extent[1] * occluder.extent[1] + occluder.extent[2] * occluder.extent[2]);
+		float w = pMatrix[3] * occluder.center[0] + pMatrix[7] * occluder.center[1] + pMatrix[11] * occluder.center[2] + pMatrix[15];
+		rankedOccluders.emplace_back(w > radius ? radius / w : FLT_MAX, &occluder);
+	}
+
+	size_t occluderCount = std::min(rankedOccluders.size(), static_cast<size_t>(OcclusionBuffer::MaxOccluderCountPerView));
+	std::partial_sort(rankedOccluders.begin(), rankedOccluders.begin() + occluderCount, rankedOccluders.end(),
+		[](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+	occlusionBuffer.Clear(viewProjection);
+	for (size_t occluderIndex = 0; occluderIndex < occluderCount; ++occluderIndex)
+	{
+		const Occluder& occluder = *rankedOccluders[occluderIndex].second;
+		const cd::Matrix4x4& worldMatrix = GetWorldMatrix(occluder.entity);
+		occlusionBuffer.RasterizeOccluder(worldMatrix, occluder.positions, occluder.indices);
+	}
+	occlusionBuffer.BuildHiZ();
+}
+
+void CullingSystem::CullView(const cd::Matrix4x4& viewProjection, std::vector<Entity>& visibleEntities, OcclusionBuffer* pOcclusionBuffer) const
+{
+	FrustumPlane planes[FrustumPlaneCount];
+	ExtractFrustumPlanes(viewProjection, planes);
+
+	visibleEntities.clear();
+	visibleEntities.reserve(m_entities.size());
+
+	if (pOcclusionBuffer && m_occluders.empty())
+	{
+		pOcclusionBuffer = nullptr;
+	}
+
+	if (pOcclusionBuffer)
+	{
+		RasterizeOccluders(viewProjection, *pOcclusionBuffer);
+	}
+
+	// Occlusion is tested only for boxes inside the frustum because it is much more expensive.
+	auto PushIfNotOccluded = [this, pOcclusionBuffer, &visibleEntities](size_t index)
+	{
+		if (pOcclusionBuffer)
+		{
+			const float center[3] = { m_centerX[index], m_centerY[index], m_centerZ[index] };
+			const float extent[3] = { m_extentX[index], m_extentY[index], m_extentZ[index] };
+			if (!pOcclusionBuffer->IsVisible(center, extent))
+			{
+				return;
+			}
+		}
+
+		visibleEntities.push_back(m_entities[index]);
+	};
+
+	// A box is outside if it is completely behind any plane : dot(n, c) + d + dot(|n|, e) < 0.
+#ifdef CD_CULLING_SYSTEM_SSE
+	__m128 planeNormalX[FrustumPlaneCount];
+	__m128 planeNormalY[FrustumPlaneCount];
+	__m128 planeNormalZ[FrustumPlaneCount];
+	__m128 planeAbsNormalX[FrustumPlaneCount];
+	__m128 planeAbsNormalY[FrustumPlaneCount];
+	__m128 planeAbsNormalZ[FrustumPlaneCount];
+	__m128 planeDistance[FrustumPlaneCount];
+	for (size_t planeIndex = 0; planeIndex < FrustumPlaneCount; ++planeIndex)
+	{
+		const FrustumPlane& plane = planes[planeIndex];
+		planeNormalX[planeIndex] = _mm_set1_ps(plane.normal[0]);
+		planeNormalY[planeIndex] = _mm_set1_ps(plane.normal[1]);
+		planeNormalZ[planeIndex] = _mm_set1_ps(plane.normal[2]);
+		planeAbsNormalX[planeIndex] = _mm_set1_ps(std::abs(plane.normal[0]));
+		planeAbsNormalY[planeIndex] = _mm_set1_ps(std::abs(plane.normal[1]));
+		planeAbsNormalZ[planeIndex] = _mm_set1_ps(std::abs(plane.normal[2]));
+		planeDistance[planeIndex] = _mm_set1_ps(plane.distance);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t batchBegin = 0; batchBegin < m_boundedCount; batchBegin += 4)
+	{
+		const __m128 centerX = _mm_loadu_ps(m_centerX.data() + batchBegin);
+		const __m128 centerY = _mm_loadu_ps(m_centerY.data() + batchBegin);
+		const __m128 centerZ = _mm_loadu_ps(m_centerZ.data() + batchBegin);
+		const __m128 extentX = _mm_loadu_ps(m_extentX.data() + batchBegin);
+		const __m128 extentY = _mm_loadu_ps(m_extentY.data() + batchBegin);
+		const __m128 extentZ = _mm_loadu_ps(m_extentZ.data() + batchBegin);
+
+		__m128 outside = zero;
+		for (size_t planeIndex = 0; planeIndex < FrustumPlaneCount; ++planeIndex)
+		{
+			__m128 distance = _mm_add_ps(planeDistance[planeIndex], _mm_mul_ps(planeNormalX[planeIndex], centerX));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeNormalY[planeIndex], centerY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeNormalZ[planeIndex], centerZ));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeAbsNormalX[planeIndex], extentX));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeAbsNormalY[planeIndex], extentY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeAbsNormalZ[planeIndex], extentZ));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		size_t batchEnd = std::min(batchBegin + 4, m_boundedCount);
+		for (size_t index = batchBegin; index < batchEnd; ++index)
+		{
+			if (0 == (outsideMask & (1 << (index - batchBegin))))
+			{
+				PushIfNotOccluded(index);
+			}
+		}
+	}
+#else
+	for (size_t index = 0; index < m_boundedCount; ++index)
+	{
+		bool isOutside = false;
+		for (size_t planeIndex = 0; planeIndex < FrustumPlaneCount && !isOutside; ++planeIndex)
+		{
+			const FrustumPlane& plane = planes[planeIndex];
+			float distance = plane.distance + plane.normal[0] * m_centerX[index] + plane.normal[1] * m_centerY[index] + plane.normal[2] * m_centerZ[index] +
+				std::abs(plane.normal[0]) * m_extentX[index] + std::abs(plane.normal[1]) * m_extentY[index] + std::abs(plane.normal[2]) * m_extentZ[index];
+			isOutside = distance < 0.0f;
+		}
+
+		if (!isOutside)
+		{
+			PushIfNotOccluded(index);
+		}
+	}
+#endif
+
+	visibleEntities.insert(visibleEntities.end(), m_entities.begin() + m_boundedCount, m_entities.end());
+}
+
+}
\ No newline at end of file
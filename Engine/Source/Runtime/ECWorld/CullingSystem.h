@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+#include "Math/Matrix.hpp"
+#include "Rendering/OcclusionBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+class CollisionMeshComponent;
+class ThreadPool;
+class TransformComponent;
+class World;
+
+// CullingSystem tests world space bounding boxes against view frustums.
+// Bounds of all CollisionMeshComponents are gathered once per Update into SoA arrays as center/extent pairs so that
+// every view tests 4 boxes per SSE instruction. Entities without a TransformComponent are placed at the origin.
+// Entities with a TransformComponent but without a CollisionMeshComponent have no bounds and are always visible.
+// Views added before Update are culled in parallel. Renderers which build view matrices later can call CullView directly.
+// Views can also be culled by occlusion : the largest registered occluders are rasterized into an OcclusionBuffer of the view
+// and boxes passing frustum test are tested against its Hi-Z pyramid.
+class CullingSystem
+{
+public:
+	using ViewIndex = uint32_t;
+	static constexpr ViewIndex InvalidViewIndex = static_cast<ViewIndex>(-1);
+
+	// Applications add main camera view first in every frame.
+	static constexpr ViewIndex MainCameraView = 0U;
+
+	// Bounds gathering smaller than it runs on the calling thread.
+	static constexpr size_t ParallelBatchSize = 4096;
+
+public:
+	CullingSystem() = delete;
+	explicit CullingSystem(World* pWorld);
+	CullingSystem(const CullingSystem&) = delete;
+	CullingSystem& operator=(const CullingSystem&) = delete;
+	CullingSystem(CullingSystem&&) = delete;
+	CullingSystem& operator=(CullingSystem&&) = delete;
+	~CullingSystem() = default;
+
+	// Views are registered every frame before Update.
+	void ClearViews();
+	ViewIndex AddView(const cd::Matrix4x4& viewProjection, bool useOcclusion = false);
+	size_t GetViewCount() const { return m_viewProjections.size(); }
+
+	// Occluders are registered every frame before Update. Geometry is in local space of the entity and must stay alive until next ClearOccluders.
+	// Occluders need bounds so that they are ranked by screen size.
+	void ClearOccluders();
+	void AddOccluder(Entity entity, std::span<const cd::Point> positions, std::span<const uint32_t> indices);
+	size_t GetOccluderCount() const { return m_occluders.size(); }
+
+	// Should be called after TransformSystem::Update. pThreadPool : nullptr to run on calling thread.
+	void Update(ThreadPool* pThreadPool = nullptr);
+
+	// Visible entities of a view added before last Update. Entities with bounds come first.
+	const std::vector<Entity>& GetVisibleEntities(ViewIndex viewIndex) const;
+
+	// Culls bounds gathered by last Update against any view projection matrix.
+	// pOcclusionBuffer : nullptr to skip occlusion culling. Thread safe when callers use different buffers.
+	void CullView(const cd::Matrix4x4& viewProjection, std::vector<Entity>& visibleEntities, OcclusionBuffer* pOcclusionBuffer = nullptr) const;
+
+	size_t GetCandidateCount() const { return m_entities.size(); }
+	size_t GetBoundedCount() const { return m_boundedCount; }
+
+private:
+	struct Occluder
+	{
+		Entity entity;
+		std::span<const cd::Point> positions;
+		std::span<const uint32_t> indices;
+		float center[3];
+		float extent[3];
+	};
+
+	const cd::Matrix4x4& GetWorldMatrix(Entity entity) const;
+	// Returns false when the entity has no valid bounding box.
+	bool GetWorldBounds(Entity entity, float* pCenter, float* pExtent) const;
+	void GatherBounds(size_t beginIndex, size_t endIndex);
+	void RasterizeOccluders(const cd::Matrix4x4& viewProjection, OcclusionBuffer& occlusionBuffer) const;
+
+private:
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	ComponentsStorage<CollisionMeshComponent>* m_pCollisionMeshStorage;
+
+	// Bounded entities are in [0, m_boundedCount) and their bounds are aligned by index.
+	// Unbounded entities follow them. Bounds arrays are padded to a multiple of 4 with empty boxes.
+	std::vector<Entity> m_entities;
+	size_t m_boundedCount = 0;
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+
+	std::vector<Occluder> m_occluders;
+
+	std::vector<cd::Matrix4x4> m_viewProjections;
+	std::vector<bool> m_viewOcclusions;
+	std::vector<std::vector<Entity>> m_visibleEntities;
+
+	// Buffers are created on first use and kept across frames. nullptr for views without occlusion.
+	std::vector<std::unique_ptr<OcclusionBuffer>> m_occlusionBuffers;
+};
+
+}
\ No newline at end of file
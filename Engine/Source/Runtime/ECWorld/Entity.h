@@ -5,8 +5,26 @@
 namespace engine
 {
 
-// Entity is a global unique unsigned integer identifier [0, max - 1] in the engine runtime.
+// Entity is a handle which packs [generation | index] into an unsigned integer.
+// Index addresses dense tables in the World so that they are sized to live entities.
+// Generation increases when an index is recycled so that stale handles can be detected in O(1).
 using Entity = uint32_t;
 static constexpr Entity INVALID_ENTITY = static_cast<uint32_t>(-1);
 
+static constexpr uint32_t ENTITY_INDEX_BITS = 20U;
+static constexpr uint32_t ENTITY_GENERATION_BITS = 32U - ENTITY_INDEX_BITS;
+static constexpr uint32_t ENTITY_INDEX_MASK = (1U << ENTITY_INDEX_BITS) - 1U;
+static constexpr uint32_t ENTITY_GENERATION_MASK = (1U << ENTITY_GENERATION_BITS) - 1U;
+
+// The max index is reserved for INVALID_ENTITY.
+static constexpr uint32_t MAX_ENTITY_INDEX = ENTITY_INDEX_MASK - 1U;
+
+// Deleted indexes are recycled in FIFO order after this many are free. An index is reused at most once every
+// MIN_FREE_ENTITY_INDEX_COUNT deletions so that a stale handle needs millions of deletions to wrap the generation.
+static constexpr uint32_t MIN_FREE_ENTITY_INDEX_COUNT = 1024U;
+
+constexpr uint32_t GetEntityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+constexpr uint32_t GetEntityGeneration(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+constexpr Entity MakeEntity(uint32_t index, uint32_t generation) { return ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK); }
+
 }
\ No newline at end of file
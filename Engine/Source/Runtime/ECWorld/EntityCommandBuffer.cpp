@@ -0,0 +1,190 @@
+#include "EntityCommandBuffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace engine
+{
+
+namespace
+{
+
+std::atomic<uint64_t> s_nextToken = 1U;
+
+// Threads usually record into a few command buffers in one frame.
+constexpr uint32_t LaneCacheSize = 4U;
+
+struct LaneCacheEntry
+{
+	uint64_t token = 0U;
+	void* pLane = nullptr;
+};
+
+}
+
+EntityCommandBuffer::EntityCommandBuffer(World* pWorld) :
+	m_pWorld(pWorld),
+	m_token(s_nextToken.fetch_add(1))
+{
+	assert(pWorld);
+}
+
+void EntityCommandBuffer::DeleteEntity(Entity entity)
+{
+	Command command;
+	command.type = CommandType::DeleteEntity;
+	command.entity = entity;
+	Record(cd::MoveTemp(command));
+}
+
+size_t EntityCommandBuffer::GetCommandCount() const
+{
+	size_t commandCount = 0;
+	for (uint32_t laneIndex = 0; laneIndex < m_usedLaneCount; ++laneIndex)
+	{
+		commandCount += m_lanes[laneIndex]->commands.size();
+	}
+
+	return commandCount;
+}
+
+EntityCommandBuffer::Lane& EntityCommandBuffer::GetLane()
+{
+	thread_local LaneCacheEntry s_laneCache[LaneCacheSize];
+	thread_local uint32_t s_nextCacheIndex = 0U;
+
+	uint64_t token = m_token.load(std::memory_order_acquire);
+	for (const LaneCacheEntry& entry : s_laneCache)
+	{
+		if (entry.token == token)
+		{
+			return *static_cast<Lane*>(entry.pLane);
+		}
+	}
+
+	// First time to record in this session. Claim a new lane.
+	// A thread whose cache entry was evicted claims another lane which is fine as commands are ordered by sequence.
+	Lane* pLane = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_laneMutex);
+		if (m_usedLaneCount == m_lanes.size())
+		{
+			m_lanes.push_back(std::make_unique<Lane>());
+		}
+		pLane = m_lanes[m_usedLaneCount++].get();
+	}
+
+	LaneCacheEntry& entry = s_laneCache[s_nextCacheIndex];
+	s_nextCacheIndex = (s_nextCacheIndex + 1) % LaneCacheSize;
+	entry.token = token;
+	entry.pLane = pLane;
+	return *pLane;
+}
+
+void EntityCommandBuffer::Record(Command command)
+{
+	command.sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed);
+	GetLane().commands.push_back(cd::MoveTemp(command));
+}
+
+void EntityCommandBuffer::DeleteEntities(const Entity* pEntities, size_t count)
+{
+	if (OnDeleteEntities.Empty())
+	{
+		m_pWorld->DeleteEntities(pEntities, count);
+	}
+	else
+	{
+		OnDeleteEntities.Invoke(pEntities, count);
+	}
+}
+
+void EntityCommandBuffer::FlushRemovals(IComponentsStorage* pStorage)
+{
+	for (RemovalBatch& removalBatch : m_removalBatches)
+	{
+		if ((!pStorage || pStorage == removalBatch.pStorage) && !removalBatch.entities.empty())
+		{
+			removalBatch.pStorage->RemoveEntities(removalBatch.entities.data(), removalBatch.entities.size());
+			removalBatch.entities.clear();
+		}
+	}
+}
+
+void EntityCommandBuffer::Playback()
+{
+	m_sortedCommands.clear();
+	for (uint32_t laneIndex = 0; laneIndex < m_usedLaneCount; ++laneIndex)
+	{
+		std::vector<Command>& commands = m_lanes[laneIndex]->commands;
+		std::move(commands.begin(), commands.end(), std::back_inserter(m_sortedCommands));
+		commands.clear();
+	}
+
+	// Start a new session so that threads will claim lanes again.
+	m_usedLaneCount = 0U;
+	m_nextSequence.store(0U);
+	m_token.store(s_nextToken.fetch_add(1), std::memory_order_release);
+
+	if (m_sortedCommands.empty())
+	{
+		return;
+	}
+
+	// Every lane is already in recorded order. Merge them by sequence.
+	std::sort(m_sortedCommands.begin(), m_sortedCommands.end(), [](const Command& lhs, const Command& rhs)
+	{
+		return lhs.sequence < rhs.sequence;
+	});
+
+	// Removals are deferred per storage so that every storage compacts its dense arrays once. They are applied before
+	// a later creation in the same storage, which may be for the same entity, and before deletions.
+	size_t commandIndex = 0;
+	const size_t commandCount = m_sortedCommands.size();
+	while (commandIndex < commandCount)
+	{
+		Command& command = m_sortedCommands[commandIndex];
+		if (CommandType::RemoveComponent == command.type)
+		{
+			auto itBatch = std::find_if(m_removalBatches.begin(), m_removalBatches.end(), [&command](const RemovalBatch& removalBatch)
+			{
+				return command.pStorage == removalBatch.pStorage;
+			});
+			if (itBatch == m_removalBatches.end())
+			{
+				itBatch = m_removalBatches.insert(m_removalBatches.end(), RemovalBatch{ command.pStorage, {} });
+			}
+			itBatch->entities.push_back(command.entity);
+			++commandIndex;
+			continue;
+		}
+
+		if (CommandType::CreateComponent == command.type)
+		{
+			FlushRemovals(command.pStorage);
+
+			// Entities which are already deleted are skipped.
+			if (m_pWorld->IsValid(command.entity))
+			{
+				command.pPayload->Apply(command.pStorage, command.entity);
+			}
+			++commandIndex;
+			continue;
+		}
+
+		// Batch consecutive deletions. Deletion handlers see all previous removals.
+		assert(CommandType::DeleteEntity == command.type);
+		FlushRemovals();
+		m_batchEntities.clear();
+		for (; commandIndex < commandCount && CommandType::DeleteEntity == m_sortedCommands[commandIndex].type; ++commandIndex)
+		{
+			m_batchEntities.push_back(m_sortedCommands[commandIndex].entity);
+		}
+		DeleteEntities(m_batchEntities.data(), m_batchEntities.size());
+	}
+	FlushRemovals();
+
+	m_sortedCommands.clear();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Core/Delegates/Delegate.hpp"
+#include "Entity.h"
+#include "World.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine
+{
+
+// EntityCommandBuffer records structural changes from multiple threads during a frame
+// and applies them to the World at a sync point. Every thread appends to its own lane which is claimed
+// under a lock on first use in a session, so recording a command doesn't contend with other threads.
+// Commands are stamped with a global sequence number and playback applies them in recorded order.
+// Removals are grouped per storage and consecutive entity deletions are applied in one batch.
+// Removals from different storages don't depend on each other, so every entity still sees its commands in recorded order.
+// Component storages must be registered to the World before recording.
+class EntityCommandBuffer
+{
+public:
+	EntityCommandBuffer() = delete;
+	explicit EntityCommandBuffer(World* pWorld);
+	EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer(EntityCommandBuffer&&) = delete;
+	EntityCommandBuffer& operator=(EntityCommandBuffer&&) = delete;
+	~EntityCommandBuffer() = default;
+
+	// Create a component for entity at playback which is initialized by the input value.
+	// It is skipped if the entity already has the component at that time.
+	template<typename Component>
+	void CreateComponent(Entity entity, Component component = Component())
+	{
+		Command command;
+		command.type = CommandType::CreateComponent;
+		command.entity = entity;
+		command.pStorage = GetStorage<Component>();
+		command.pPayload = std::make_unique<ComponentPayload<Component>>(cd::MoveTemp(component));
+		Record(cd::MoveTemp(command));
+	}
+
+	template<typename Component>
+	void RemoveComponent(Entity entity)
+	{
+		Command command;
+		command.type = CommandType::RemoveComponent;
+		command.entity = entity;
+		command.pStorage = GetStorage<Component>();
+		Record(cd::MoveTemp(command));
+	}
+
+	// Remove all components of entity and release its index at playback.
+	void DeleteEntity(Entity entity);
+
+	// Deletions are forwarded to it at playback if bound so that the owner of World can keep its invariants.
+	// Otherwise they are applied by World::DeleteEntities.
+	Delegate<void(const Entity*, size_t)> OnDeleteEntities;
+
+	// Returns recorded command count. Should not be called when other threads are recording.
+	size_t GetCommandCount() const;
+	bool IsEmpty() const { return 0U == GetCommandCount(); }
+
+	// Apply all recorded commands and reset. Must be called on one thread when no thread is recording.
+	void Playback();
+
+private:
+	enum class CommandType : uint8_t
+	{
+		CreateComponent,
+		RemoveComponent,
+		DeleteEntity,
+	};
+
+	class IComponentPayload
+	{
+	public:
+		virtual ~IComponentPayload() = default;
+		virtual void Apply(IComponentsStorage* pStorage, Entity entity) = 0;
+	};
+
+	template<typename Component>
+	class ComponentPayload final : public IComponentPayload
+	{
+	public:
+		explicit ComponentPayload(Component component) : m_component(cd::MoveTemp(component)) {}
+
+		virtual void Apply(IComponentsStorage* pStorage, Entity entity) override
+		{
+			auto* pComponentsStorage = static_cast<ComponentsStorage<Component>*>(pStorage);
+			if (!pComponentsStorage->Contains(entity))
+			{
+				pComponentsStorage->CreateComponent(entity) = cd::MoveTemp(m_component);
+			}
+		}
+
+	private:
+		Component m_component;
+	};
+
+	struct Command
+	{
+		uint64_t sequence = 0U;
+		CommandType type;
+		Entity entity;
+		IComponentsStorage* pStorage = nullptr;
+		std::unique_ptr<IComponentPayload> pPayload;
+	};
+
+	struct alignas(64) Lane
+	{
+		std::vector<Command> commands;
+	};
+
+	struct RemovalBatch
+	{
+		IComponentsStorage* pStorage;
+		std::vector<Entity> entities;
+	};
+
+	template<typename Component>
+	IComponentsStorage* GetStorage() const { return m_pWorld->GetComponents<Component>(); }
+
+	Lane& GetLane();
+	void Record(Command command);
+	void DeleteEntities(const Entity* pEntities, size_t count);
+	// Apply pending removals of the storage, or of all storages if it is nullptr.
+	void FlushRemovals(IComponentsStorage* pStorage = nullptr);
+
+private:
+	World* m_pWorld;
+
+	// Identifies current recording session. Threads compare it with their cached token to find their lanes.
+	std::atomic<uint64_t> m_token;
+	std::atomic<uint64_t> m_nextSequence = 0U;
+
+	// Lanes are kept between sessions and only grow when more threads record. Addresses are stable for cached lanes.
+	std::mutex m_laneMutex;
+	uint32_t m_usedLaneCount = 0U;
+	std::vector<std::unique_ptr<Lane>> m_lanes;
+
+	// Reused between frames to avoid allocations.
+	std::vector<Command> m_sortedCommands;
+	std::vector<Entity> m_batchEntities;
+	std::vector<RemovalBatch> m_removalBatches;
+};
+
+}
\ No newline at end of file
@@ -1,7 +1,5 @@
 #include "LightComponent.h"
 
-#include <bgfx/bgfx.h>
-
 namespace engine
 {
 
@@ -28,38 +26,4 @@ void LightComponent::SetInnerAndOuter(float inner, float outer)
 	m_lightUniformData.lightAngleOffeset = -outerCos * scale;
 }
 
-bool LightComponent::IsShadowMapFBsValid()
-{
-	// Include empty FBs
-	if ((cd::LightType::Spot == GetType() && m_shadowMapFBs.size() != 1U) ||
-		(cd::LightType::Point == GetType() && m_shadowMapFBs.size() != 6U) ||
-		(cd::LightType::Directional == GetType() && m_shadowMapFBs.size() != GetCascadeNum()))
-	{
-		return false;
-	}
-
-	for (const auto& fb : m_shadowMapFBs)
-	{
-		if (!bgfx::isValid(static_cast<bgfx::TextureHandle>(fb))) return false;
-	}
-	return true;
-}
-
-void LightComponent::ClearShadowMapTexture()
-{
-	bgfx::destroy(static_cast<bgfx::TextureHandle>(m_shadowMapTexture));
-	m_shadowMapTexture = BGFX_INVALID_HANDLE;
-}
-
-void LightComponent::ClearShadowMapFBs()
-{
-	for (auto shadowMapFB : m_shadowMapFBs) bgfx::destroy(static_cast<bgfx::FrameBufferHandle>(shadowMapFB));
-	m_shadowMapFBs.clear();
-}
-
-bool LightComponent::IsShadowMapTextureValid() 
-{ 
-	return bgfx::isValid(static_cast<bgfx::FrameBufferHandle>(m_shadowMapTexture));
-}
-
-}
+}
\ No newline at end of file
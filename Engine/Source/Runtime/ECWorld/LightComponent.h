@@ -132,15 +132,10 @@ public:
 	const std::vector<cd::Matrix4x4>& GetLightViewProjMatrix() const { return m_lightViewProjMatrices; }
 	void ClearLightViewProjMatrix() { m_lightViewProjMatrices.clear(); }
 
-	bool IsShadowMapFBsValid();
-	void AddShadowMapFB(uint16_t& shadowMapFB) { m_shadowMapFBs.push_back(std::move(shadowMapFB)); }
-	const std::vector<uint16_t>& GetShadowMapFBs() const { return m_shadowMapFBs; }
-	void ClearShadowMapFBs();
-
-	bool IsShadowMapTextureValid();
-	void SetShadowMapTexture(uint16_t shadowMapTexture) { m_shadowMapTexture = shadowMapTexture; }
-	const uint16_t& GetShadowMapTexture() { return m_shadowMapTexture; }
-	void ClearShadowMapTexture();
+	// uv ranges of shadow views in the shadow atlas, same order as light view projection matrices.
+	void AddShadowAtlasRect(cd::Vec4f shadowAtlasRect) { m_shadowAtlasRects.push_back(cd::MoveTemp(shadowAtlasRect)); }
+	const std::vector<cd::Vec4f>& GetShadowAtlasRects() const { return m_shadowAtlasRects; }
+	void ClearShadowAtlasRects() { m_shadowAtlasRects.clear(); }
 
 private:
 	U_Light m_lightUniformData;
@@ -154,12 +149,8 @@ private:
 	float m_computedCascadeSplit[4] = { 0.0 }; // computed split
 
 	// uniform
-	uint16_t m_shadowMapTexture;	// Texture Handle
 	std::vector<cd::Matrix4x4> m_lightViewProjMatrices;
-	std::vector<uint16_t> m_shadowMapFBs; // Framebuffer Handle
-
-	// Warning : We treat multiple light components as a complete and contiguous memory.
-	// any non-U_Light member of LightComponent will destroy this layout. --2023/6/21
+	std::vector<cd::Vec4f> m_shadowAtlasRects;
 };
 
 }
\ No newline at end of file
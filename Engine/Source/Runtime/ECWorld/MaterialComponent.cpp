@@ -154,13 +154,26 @@ void MaterialComponent::SetShaderResource(ShaderResource* pShaderResource)
 
 ShaderResource* MaterialComponent::GetShaderResource() const
 {
-	return m_isShaderResourceDirty ? nullptr : m_pShaderResource;
+	return m_isShaderResourceDirty ? nullptr : m_pShaderResource.Get();
+}
+
+bool MaterialComponent::IsInstancingSupported() const
+{
+	return m_pMaterialType->GetShaderSchema().GetConflictFeatureSet(ShaderFeature::INSTANCING).has_value();
+}
+
+std::string MaterialComponent::GetInstancedFeaturesCombine() const
+{
+	assert(IsInstancingSupported());
+	ShaderFeatureSet instancedFeatures = m_shaderFeatures;
+	instancedFeatures.insert(ShaderFeature::INSTANCING);
+	return m_pMaterialType->GetShaderSchema().GetFeaturesCombine(instancedFeatures);
 }
 
 TextureResource* MaterialComponent::GetTextureResource(cd::MaterialTextureType textureType) const
 {
 	auto itPropertyGroup = m_propertyGroups.find(textureType);
-	return itPropertyGroup != m_propertyGroups.end() ? itPropertyGroup->second.textureInfo.pTextureResource : nullptr;
+	return itPropertyGroup != m_propertyGroups.end() ? itPropertyGroup->second.textureInfo.pTextureResource.Get() : nullptr;
 }
 
 void MaterialComponent::SetTextureResource(cd::MaterialTextureType textureType, cd::Vec2f uvOffset, cd::Vec2f uvScale, TextureResource* pTextureResource)
@@ -3,6 +3,9 @@
 #include "Core/StringCrc.h"
 #include "ECWorld/SkyComponent.h"
 #include "Material/ShaderSchema.h"
+#include "Rendering/Resources/ResourceHandle.h"
+#include "Rendering/Resources/ShaderResource.h"
+#include "Rendering/Resources/TextureResource.h"
 #include "Scene/MaterialTextureType.h"
 #include "Scene/Texture.h"
 
@@ -32,8 +35,6 @@ namespace engine
 
 class MaterialType;
 class RenderContext;
-class ShaderResource;
-class TextureResource;
 
 class MaterialComponent final
 {
@@ -50,7 +51,7 @@ public:
 		cd::Vec2f uvOffset = cd::Vec2f::Zero();
 		cd::Vec2f uvScale = cd::Vec2f::One();
 		uint8_t slot;
-		TextureResource* pTextureResource = nullptr;
+		ResourceHandle<TextureResource> pTextureResource;
 
 		// TODO : Improve TextureInfo 
 		cd::Vec2f& GetUVOffset() { return uvOffset; }
@@ -119,6 +120,10 @@ public:
 	void SetShaderResource(ShaderResource* pShaderResource);
 	ShaderResource* GetShaderResource() const;
 
+	// Instanced variant is resolved by WorldRenderer to draw entities sharing mesh and material in one submit.
+	bool IsInstancingSupported() const;
+	std::string GetInstancedFeaturesCombine() const;
+
 	// Texture data.
 	TextureResource* GetTextureResource(cd::MaterialTextureType textureType) const;
 	void SetTextureResource(cd::MaterialTextureType textureType, cd::Vec2f uvOffset, cd::Vec2f uvScale, TextureResource* pTextureResource);
@@ -202,7 +207,7 @@ private:
 	bool m_isShaderResourceDirty = true;
 	std::string m_featureCombine;
 	std::set<ShaderFeature> m_shaderFeatures;
-	ShaderResource* m_pShaderResource = nullptr;
+	ResourceHandle<ShaderResource> m_pShaderResource;
 
 	// Output
 	bool m_twoSided;
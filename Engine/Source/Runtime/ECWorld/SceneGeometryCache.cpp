@@ -0,0 +1,725 @@
+#include "SceneGeometryCache.h"
+
+#include "Log/Log.h"
+#include "Rendering/Resources/MeshResource.h"
+#include "Rendering/Resources/ResourceContext.h"
+#include "Rendering/Resources/TextureResource.h"
+#include "Resources/BinarySnapshot.h"
+#include "SceneWorld.h"
+
+#include <algorithm>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace engine
+{
+
+namespace
+{
+
+enum class SceneGeometryCacheSection : uint32_t
+{
+	Transform,
+	Name,
+	NameChars,
+	Hierarchy,
+	CollisionMesh,
+	StaticMesh,
+	Mesh,
+	MeshVertexAttribute,
+	MeshIndexBuffer,
+	Light,
+	Camera,
+	Material,
+	MaterialFeature,
+	MaterialProperty,
+};
+
+// Links a node to another node or mesh by index.
+struct SnapshotNodeLink
+{
+	uint32_t node;
+	uint32_t target;
+};
+
+struct SnapshotNodeName
+{
+	uint32_t node;
+	uint32_t offset;
+	uint32_t length;
+};
+
+struct SnapshotNodeAABB
+{
+	cd::AABB aabb;
+	uint32_t node;
+};
+
+struct SnapshotVertexAttribute
+{
+	uint8_t type;
+	uint8_t valueType;
+	uint8_t count;
+	uint8_t padding;
+};
+
+struct SnapshotMesh
+{
+	uint32_t nameCrc;
+	uint32_t vertexCount;
+	uint32_t polygonCount;
+	uint32_t firstAttribute;
+	uint32_t attributeCount;
+	// Index buffers of all polygon groups per LOD, from LOD 0.
+	uint32_t firstIndexBuffer;
+	uint32_t indexBufferCount;
+	uint32_t lodCount;
+	SnapshotBlob vertexBuffer;
+	// Bounds of positions in quantized vertex format.
+	VertexQuantization::PositionQuantization positionQuantization;
+};
+
+// Range of chars in the NameChars section.
+struct SnapshotString
+{
+	uint32_t offset;
+	uint32_t length;
+};
+
+struct SnapshotLight
+{
+	U_Light uniformData;
+	float manualCascadeSplit[4];
+	uint32_t node;
+	uint16_t shadowMapSize;
+	uint8_t isCastShadow;
+	uint8_t isCastVolume;
+	uint8_t cascadePartitionMode;
+};
+
+struct SnapshotCamera
+{
+	uint32_t node;
+	float aspect;
+	float fov;
+	float nearPlane;
+	float farPlane;
+	float exposure;
+	float gammaCorrection;
+	float bloomIntensity;
+	float luminanceThreshold;
+	float blurSize;
+	int32_t bloomDownSampleTimes;
+	int32_t blurTimes;
+	int32_t blurScaling;
+	uint8_t ndcDepth;
+	uint8_t toneMappingMode;
+	uint8_t doConstrainAspectRatio;
+	uint8_t enableBloom;
+	uint8_t enableBlur;
+};
+
+struct SnapshotMaterial
+{
+	MaterialComponent::ToonParameters toonParameters;
+	uint32_t node;
+	// MaterialType is restored by its name from SceneWorld.
+	SnapshotString materialTypeName;
+	SnapshotString name;
+	uint32_t firstFeature;
+	uint32_t featureCount;
+	uint32_t firstProperty;
+	uint32_t propertyCount;
+	float alphaCutOff;
+	float iblStrength;
+	float reflectance;
+	uint8_t twoSided;
+	uint8_t blendMode;
+};
+
+struct SnapshotMaterialProperty
+{
+	cd::Vec4f factor;
+	cd::Vec2f uvOffset;
+	cd::Vec2f uvScale;
+	// Built DDS file of the texture. Empty if the property group doesn't use a texture.
+	SnapshotString texturePath;
+	uint8_t group;
+	// Index of the alternative in PropertyGroup::factor.
+	uint8_t factorIndex;
+	uint8_t useTexture;
+	uint8_t uMapMode;
+	uint8_t vMapMode;
+};
+
+static_assert(std::is_trivially_copyable_v<cd::Transform> && std::is_trivially_copyable_v<cd::AABB>);
+static_assert(std::is_trivially_copyable_v<VertexQuantization::PositionQuantization>);
+static_assert(std::is_trivially_copyable_v<U_Light> && std::is_trivially_copyable_v<MaterialComponent::ToonParameters>);
+
+CD_FORCEINLINE uint32_t ToID(SceneGeometryCacheSection section)
+{
+	return static_cast<uint32_t>(section);
+}
+
+SnapshotString AddString(std::vector<char>& chars, std::string_view str)
+{
+	SnapshotString snapshotString{ static_cast<uint32_t>(chars.size()), static_cast<uint32_t>(str.size()) };
+	chars.insert(chars.end(), str.begin(), str.end());
+	return snapshotString;
+}
+
+std::optional<std::string_view> GetString(std::span<const char> chars, const SnapshotString& str)
+{
+	if (str.offset > chars.size() || str.length > chars.size() - str.offset)
+	{
+		return std::nullopt;
+	}
+
+	return std::string_view(chars.data() + str.offset, str.length);
+}
+
+MaterialType* FindMaterialType(const SceneWorld* pSceneWorld, std::string_view materialTypeName)
+{
+	for (MaterialType* pMaterialType : { pSceneWorld->GetPBRMaterialType(), pSceneWorld->GetAnimationMaterialType(), pSceneWorld->GetTerrainMaterialType(),
+		pSceneWorld->GetParticleMaterialType(), pSceneWorld->GetCelluloidMaterialType() })
+	{
+		if (pMaterialType && materialTypeName == pMaterialType->GetMaterialName())
+		{
+			return pMaterialType;
+		}
+	}
+
+	return nullptr;
+}
+
+void SaveMaterial(const MaterialComponent& materialComponent, uint32_t nodeIndex, std::vector<char>& nameChars, std::vector<SnapshotMaterial>& materials,
+	std::vector<uint32_t>& materialFeatures, std::vector<SnapshotMaterialProperty>& materialProperties)
+{
+	SnapshotMaterial& material = materials.emplace_back();
+	material = SnapshotMaterial{};
+	material.toonParameters = materialComponent.GetToonParameters();
+	material.node = nodeIndex;
+	material.materialTypeName = AddString(nameChars, materialComponent.GetMaterialType()->GetMaterialName());
+	material.name = AddString(nameChars, materialComponent.GetName());
+	material.alphaCutOff = materialComponent.GetAlphaCutOff();
+	material.iblStrength = materialComponent.GetIblStrengeth();
+	material.reflectance = materialComponent.GetReflectance();
+	material.twoSided = materialComponent.GetTwoSided() ? 1U : 0U;
+	material.blendMode = static_cast<uint8_t>(materialComponent.GetBlendMode());
+
+	material.firstFeature = static_cast<uint32_t>(materialFeatures.size());
+	for (ShaderFeature feature : materialComponent.GetShaderFeatures())
+	{
+		materialFeatures.push_back(static_cast<uint32_t>(feature));
+	}
+	material.featureCount = static_cast<uint32_t>(materialFeatures.size()) - material.firstFeature;
+
+	material.firstProperty = static_cast<uint32_t>(materialProperties.size());
+	for (const auto& [group, propertyGroup] : materialComponent.GetPropertyGroups())
+	{
+		SnapshotMaterialProperty& property = materialProperties.emplace_back();
+		property = SnapshotMaterialProperty{};
+		property.group = static_cast<uint8_t>(group);
+		property.factorIndex = static_cast<uint8_t>(propertyGroup.factor.index());
+		std::visit([&property](const auto& factor)
+		{
+			const float* pFactor = reinterpret_cast<const float*>(&factor);
+			std::copy(pFactor, pFactor + sizeof(factor) / sizeof(float), property.factor.begin());
+		}, propertyGroup.factor);
+
+		const TextureResource* pTextureResource = propertyGroup.textureInfo.pTextureResource.Get();
+		if (propertyGroup.useTexture && pTextureResource && !pTextureResource->GetDDSBuiltTexturePath().empty())
+		{
+			property.useTexture = 1U;
+			property.uvOffset = propertyGroup.textureInfo.uvOffset;
+			property.uvScale = propertyGroup.textureInfo.uvScale;
+			property.texturePath = AddString(nameChars, pTextureResource->GetDDSBuiltTexturePath());
+			property.uMapMode = static_cast<uint8_t>(pTextureResource->GetUMapMode());
+			property.vMapMode = static_cast<uint8_t>(pTextureResource->GetVMapMode());
+		}
+	}
+	material.propertyCount = static_cast<uint32_t>(materialProperties.size()) - material.firstProperty;
+}
+
+void LoadMaterial(SceneWorld* pSceneWorld, ResourceContext* pResourceContext, Entity entity, MaterialType* pMaterialType, const SnapshotMaterial& material,
+	std::span<const char> nameChars, std::span<const uint32_t> features, std::span<const SnapshotMaterialProperty> properties)
+{
+	auto& materialComponent = pSceneWorld->GetWorld()->CreateComponent<MaterialComponent>(entity);
+	materialComponent.Init();
+	materialComponent.SetMaterialType(pMaterialType);
+	materialComponent.SetName(std::string(GetString(nameChars, material.name).value_or(std::string_view())));
+	materialComponent.SetToonParameters(material.toonParameters);
+	materialComponent.SetAlphaCutOff(material.alphaCutOff);
+	materialComponent.SetIblStrengeth(material.iblStrength);
+	materialComponent.SetReflectance(material.reflectance);
+	materialComponent.SetTwoSided(material.twoSided != 0U);
+	materialComponent.SetBlendMode(static_cast<cd::BlendMode>(material.blendMode));
+
+	std::set<ShaderFeature> shaderFeatures;
+	for (uint32_t feature : features)
+	{
+		shaderFeatures.insert(static_cast<ShaderFeature>(feature));
+	}
+	materialComponent.SetShaderFeatures(cd::MoveTemp(shaderFeatures));
+
+	for (const SnapshotMaterialProperty& property : properties)
+	{
+		auto textureType = static_cast<cd::MaterialTextureType>(property.group);
+		if (0U == property.factorIndex)
+		{
+			materialComponent.SetFactor<float>(textureType, property.factor.x());
+		}
+		else if (1U == property.factorIndex)
+		{
+			materialComponent.SetFactor<cd::Vec3f>(textureType, cd::Vec3f(property.factor.x(), property.factor.y(), property.factor.z()));
+		}
+		else
+		{
+			materialComponent.SetFactor<cd::Vec4f>(textureType, property.factor);
+		}
+
+		std::optional<std::string_view> optTexturePath = GetString(nameChars, property.texturePath);
+		if (0U == property.useTexture || !optTexturePath.has_value() || optTexturePath->empty())
+		{
+			continue;
+		}
+
+		std::string texturePath(optTexturePath.value());
+		TextureResource* pTextureResource = pResourceContext->AddTextureResource(StringCrc(texturePath));
+		if (pTextureResource->GetDDSBuiltTexturePath().empty())
+		{
+			pTextureResource->SetDDSBuiltTexturePath(cd::MoveTemp(texturePath));
+			pTextureResource->UpdateTextureType(textureType);
+			pTextureResource->UpdateUVMapMode(static_cast<cd::TextureMapMode>(property.uMapMode), static_cast<cd::TextureMapMode>(property.vMapMode));
+		}
+		materialComponent.SetTextureResource(textureType, property.uvOffset, property.uvScale, pTextureResource);
+	}
+
+	// Sky may differ from the saved scene. Quantization follows the mesh which is loaded from the cache.
+	materialComponent.ActivateShaderFeature(GetSkyTypeShaderFeature(pSceneWorld->GetSkyComponent(pSceneWorld->GetSkyEntity())->GetSkyType()));
+	const StaticMeshComponent* pStaticMeshComponent = pSceneWorld->GetStaticMeshComponent(entity);
+	if (pStaticMeshComponent && pStaticMeshComponent->GetMeshResource()->IsVertexQuantized())
+	{
+		materialComponent.ActivateShaderFeature(ShaderFeature::QUANTIZED_VERTEX);
+	}
+	else
+	{
+		materialComponent.DeactivateShaderFeature(ShaderFeature::QUANTIZED_VERTEX);
+	}
+}
+
+}
+
+bool SceneGeometryCache::Save(const SceneWorld* pSceneWorld, const char* pFilePath)
+{
+	// Ancestors are stored to keep world transforms of meshes, lights and cameras.
+	std::unordered_set<Entity> geometryEntities;
+	auto AddNodeEntity = [pSceneWorld, &geometryEntities](Entity entity)
+	{
+		Entity nodeEntity = entity;
+		while (INVALID_ENTITY != nodeEntity && pSceneWorld->GetTransformComponent(nodeEntity) && geometryEntities.insert(nodeEntity).second)
+		{
+			const HierarchyComponent* pHierarchyComponent = pSceneWorld->GetHierarchyComponent(nodeEntity);
+			nodeEntity = pHierarchyComponent ? pHierarchyComponent->GetParentEntity() : INVALID_ENTITY;
+		}
+	};
+
+	// Sky and terrain meshes are generated by their features so that they are not scene geometry.
+	for (Entity entity : pSceneWorld->GetStaticMeshEntities())
+	{
+		if (entity != pSceneWorld->GetSkyEntity() && !pSceneWorld->GetTerrainComponent(entity))
+		{
+			AddNodeEntity(entity);
+		}
+	}
+
+	for (Entity entity : pSceneWorld->GetLightEntities())
+	{
+		AddNodeEntity(entity);
+	}
+
+	// Main camera belongs to the editor or game rather than the scene.
+	for (Entity entity : pSceneWorld->GetCameraEntities())
+	{
+		if (entity != pSceneWorld->GetMainCameraEntity())
+		{
+			AddNodeEntity(entity);
+		}
+	}
+
+	std::vector<Entity> nodeEntities;
+	nodeEntities.reserve(geometryEntities.size());
+	for (Entity entity : pSceneWorld->GetTransformEntities())
+	{
+		if (geometryEntities.contains(entity))
+		{
+			nodeEntities.push_back(entity);
+		}
+	}
+	uint32_t nodeCount = static_cast<uint32_t>(nodeEntities.size());
+
+	std::unordered_map<Entity, uint32_t> entityToNode;
+	entityToNode.reserve(nodeCount);
+	for (uint32_t nodeIndex = 0U; nodeIndex < nodeCount; ++nodeIndex)
+	{
+		entityToNode[nodeEntities[nodeIndex]] = nodeIndex;
+	}
+
+	BinarySnapshotWriter writer(Version);
+
+	std::vector<cd::Transform> transforms;
+	std::vector<SnapshotNodeName> names;
+	std::vector<char> nameChars;
+	std::vector<SnapshotNodeLink> parents;
+	std::vector<SnapshotNodeAABB> aabbs;
+	std::vector<SnapshotNodeLink> staticMeshes;
+	std::vector<SnapshotLight> lights;
+	std::vector<SnapshotCamera> cameras;
+	std::vector<SnapshotMaterial> materials;
+	std::vector<uint32_t> materialFeatures;
+	std::vector<SnapshotMaterialProperty> materialProperties;
+	transforms.reserve(nodeCount);
+
+	std::vector<SnapshotMesh> meshes;
+	std::vector<SnapshotVertexAttribute> vertexAttributes;
+	std::vector<SnapshotBlob> indexBuffers;
+	std::unordered_map<const MeshResource*, uint32_t> meshIndexes;
+	MeshResource::MeshData meshData;
+
+	for (uint32_t nodeIndex = 0U; nodeIndex < nodeCount; ++nodeIndex)
+	{
+		Entity entity = nodeEntities[nodeIndex];
+		transforms.push_back(pSceneWorld->GetTransformComponent(entity)->GetTransform());
+
+		if (const NameComponent* pNameComponent = pSceneWorld->GetNameComponent(entity))
+		{
+			std::string_view name(pNameComponent->GetName());
+			names.push_back({ nodeIndex, static_cast<uint32_t>(nameChars.size()), static_cast<uint32_t>(name.size()) });
+			nameChars.insert(nameChars.end(), name.begin(), name.end());
+		}
+
+		if (const HierarchyComponent* pHierarchyComponent = pSceneWorld->GetHierarchyComponent(entity))
+		{
+			auto itParent = entityToNode.find(pHierarchyComponent->GetParentEntity());
+			if (itParent != entityToNode.end())
+			{
+				parents.push_back({ nodeIndex, itParent->second });
+			}
+		}
+
+		if (const CollisionMeshComponent* pCollisionMeshComponent = pSceneWorld->GetCollisionMeshComponent(entity))
+		{
+			aabbs.push_back({ pCollisionMeshComponent->GetAABB(), nodeIndex });
+		}
+
+		if (LightComponent* pLightComponent = pSceneWorld->GetLightComponent(entity))
+		{
+			SnapshotLight& light = lights.emplace_back();
+			light = SnapshotLight{};
+			light.uniformData = *pLightComponent->GetLightUniformData();
+			std::copy_n(pLightComponent->GetManualCascadeSplit(), 4, light.manualCascadeSplit);
+			light.node = nodeIndex;
+			light.shadowMapSize = pLightComponent->GetShadowMapSize();
+			light.isCastShadow = pLightComponent->IsCastShadow() ? 1U : 0U;
+			light.isCastVolume = pLightComponent->IsCastVolume() ? 1U : 0U;
+			light.cascadePartitionMode = static_cast<uint8_t>(pLightComponent->GetCascadePartitionMode());
+		}
+
+		if (const CameraComponent* pCameraComponent = pSceneWorld->GetCameraComponent(entity); pCameraComponent && entity != pSceneWorld->GetMainCameraEntity())
+		{
+			SnapshotCamera& camera = cameras.emplace_back();
+			camera = SnapshotCamera{};
+			camera.node = nodeIndex;
+			camera.aspect = pCameraComponent->GetAspect();
+			camera.fov = pCameraComponent->GetFov();
+			camera.nearPlane = pCameraComponent->GetNearPlane();
+			camera.farPlane = pCameraComponent->GetFarPlane();
+			camera.exposure = pCameraComponent->GetExposure();
+			camera.gammaCorrection = pCameraComponent->GetGammaCorrection();
+			camera.bloomIntensity = pCameraComponent->GetBloomIntensity();
+			camera.luminanceThreshold = pCameraComponent->GetLuminanceThreshold();
+			camera.blurSize = pCameraComponent->GetBlurSize();
+			camera.bloomDownSampleTimes = pCameraComponent->GetBloomDownSampleTimes();
+			camera.blurTimes = pCameraComponent->GetBlurTimes();
+			camera.blurScaling = pCameraComponent->GetBlurScaling();
+			camera.ndcDepth = static_cast<uint8_t>(pCameraComponent->GetNDCDepth());
+			camera.toneMappingMode = static_cast<uint8_t>(pCameraComponent->GetToneMappingMode());
+			camera.doConstrainAspectRatio = pCameraComponent->DoConstrainAspectRatio() ? 1U : 0U;
+			camera.enableBloom = pCameraComponent->GetIsBloomEnable() ? 1U : 0U;
+			camera.enableBlur = pCameraComponent->GetIsBlurEnable() ? 1U : 0U;
+		}
+
+		if (const MaterialComponent* pMaterialComponent = pSceneWorld->GetMaterialComponent(entity); pMaterialComponent && pMaterialComponent->GetMaterialType())
+		{
+			SaveMaterial(*pMaterialComponent, nodeIndex, nameChars, materials, materialFeatures, materialProperties);
+		}
+
+		const StaticMeshComponent* pStaticMeshComponent = pSceneWorld->GetStaticMeshComponent(entity);
+		if (!pStaticMeshComponent || !pStaticMeshComponent->GetMeshResource())
+		{
+			continue;
+		}
+
+		// Meshes shared by multiple nodes are stored once.
+		const MeshResource* pMeshResource = pStaticMeshComponent->GetMeshResource();
+		auto itMesh = meshIndexes.find(pMeshResource);
+		if (itMesh != meshIndexes.end())
+		{
+			staticMeshes.push_back({ nodeIndex, itMesh->second });
+			continue;
+		}
+
+		if (!pMeshResource->BuildMeshData(meshData))
+		{
+			CD_WARN("Skip mesh {0} in scene geometry cache as its vertex data is not available.", pMeshResource->GetName().Value());
+			continue;
+		}
+
+		SnapshotMesh& mesh = meshes.emplace_back();
+		mesh = SnapshotMesh{};
+		mesh.nameCrc = pMeshResource->GetName().Value();
+		mesh.vertexCount = pMeshResource->GetVertexCount();
+		mesh.polygonCount = pMeshResource->GetPolygonCount();
+		mesh.firstAttribute = static_cast<uint32_t>(vertexAttributes.size());
+		mesh.firstIndexBuffer = static_cast<uint32_t>(indexBuffers.size());
+		mesh.indexBufferCount = static_cast<uint32_t>(meshData.indexBuffers.size());
+		mesh.lodCount = meshData.lodCount;
+		mesh.vertexBuffer = writer.AddBlob(meshData.vertexBuffer.data(), meshData.vertexBuffer.size());
+		mesh.positionQuantization = meshData.positionQuantization;
+
+		for (const auto& layout : meshData.vertexFormat.GetVertexAttributeLayouts())
+		{
+			vertexAttributes.push_back({ static_cast<uint8_t>(layout.vertexAttributeType), static_cast<uint8_t>(layout.attributeValueType),
+				static_cast<uint8_t>(layout.attributeCount), 0U });
+		}
+		mesh.attributeCount = static_cast<uint32_t>(vertexAttributes.size()) - mesh.firstAttribute;
+
+		for (const MeshResource::IndexBuffer& indexBuffer : meshData.indexBuffers)
+		{
+			indexBuffers.push_back(writer.AddBlob(indexBuffer.data(), indexBuffer.size()));
+		}
+
+		uint32_t meshIndex = static_cast<uint32_t>(meshes.size() - 1);
+		meshIndexes[pMeshResource] = meshIndex;
+		staticMeshes.push_back({ nodeIndex, meshIndex });
+	}
+
+	writer.AddSection(ToID(SceneGeometryCacheSection::Transform), transforms);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Name), names);
+	writer.AddSection(ToID(SceneGeometryCacheSection::NameChars), nameChars);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Hierarchy), parents);
+	writer.AddSection(ToID(SceneGeometryCacheSection::CollisionMesh), aabbs);
+	writer.AddSection(ToID(SceneGeometryCacheSection::StaticMesh), staticMeshes);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Mesh), meshes);
+	writer.AddSection(ToID(SceneGeometryCacheSection::MeshVertexAttribute), vertexAttributes);
+	writer.AddSection(ToID(SceneGeometryCacheSection::MeshIndexBuffer), indexBuffers);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Light), lights);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Camera), cameras);
+	writer.AddSection(ToID(SceneGeometryCacheSection::Material), materials);
+	writer.AddSection(ToID(SceneGeometryCacheSection::MaterialFeature), materialFeatures);
+	writer.AddSection(ToID(SceneGeometryCacheSection::MaterialProperty), materialProperties);
+
+	if (!writer.Write(pFilePath))
+	{
+		CD_ERROR("Failed to write scene geometry cache {0}.", pFilePath);
+		return false;
+	}
+
+	CD_INFO("Saved scene geometry cache {0} : {1} nodes, {2} meshes, {3} materials, {4} lights, {5} cameras.", pFilePath, nodeCount, meshes.size(),
+		materials.size(), lights.size(), cameras.size());
+	return true;
+}
+
+std::vector<Entity> SceneGeometryCache::Load(SceneWorld* pSceneWorld, ResourceContext* pResourceContext, const char* pFilePath)
+{
+	BinarySnapshotReader reader;
+	if (!reader.Open(pFilePath, Version))
+	{
+		CD_ERROR("Failed to open scene geometry cache {0}. File is missing, corrupted or in another version.", pFilePath);
+		return {};
+	}
+
+	World* pWorld = pSceneWorld->GetWorld();
+	std::span<const cd::Transform> transforms = reader.GetElements<cd::Transform>(ToID(SceneGeometryCacheSection::Transform));
+	uint32_t nodeCount = static_cast<uint32_t>(transforms.size());
+
+	std::vector<Entity> nodeEntities(nodeCount);
+	pWorld->GetComponents<TransformComponent>()->Reserve(pSceneWorld->GetTransformEntities().size() + nodeCount);
+	for (uint32_t nodeIndex = 0U; nodeIndex < nodeCount; ++nodeIndex)
+	{
+		Entity entity = pWorld->CreateEntity();
+		auto& transformComponent = pWorld->CreateComponent<TransformComponent>(entity);
+		transformComponent.SetTransform(transforms[nodeIndex]);
+		transformComponent.Build();
+		nodeEntities[nodeIndex] = entity;
+	}
+
+	std::span<const char> nameChars = reader.GetElements<char>(ToID(SceneGeometryCacheSection::NameChars));
+	for (const SnapshotNodeName& name : reader.GetElements<SnapshotNodeName>(ToID(SceneGeometryCacheSection::Name)))
+	{
+		if (name.node < nodeCount && name.offset <= nameChars.size() && name.length <= nameChars.size() - name.offset)
+		{
+			auto& nameComponent = pWorld->CreateComponent<NameComponent>(nodeEntities[name.node]);
+			nameComponent.SetName(std::string(nameChars.data() + name.offset, name.length));
+		}
+	}
+
+	for (const SnapshotNodeLink& parent : reader.GetElements<SnapshotNodeLink>(ToID(SceneGeometryCacheSection::Hierarchy)))
+	{
+		if (parent.node < nodeCount && parent.target < nodeCount && parent.node != parent.target)
+		{
+			pSceneWorld->SetParentEntity(nodeEntities[parent.node], nodeEntities[parent.target]);
+		}
+	}
+
+	for (const SnapshotNodeAABB& aabb : reader.GetElements<SnapshotNodeAABB>(ToID(SceneGeometryCacheSection::CollisionMesh)))
+	{
+		if (aabb.node < nodeCount)
+		{
+			auto& collisionMeshComponent = pWorld->CreateComponent<CollisionMeshComponent>(nodeEntities[aabb.node]);
+			collisionMeshComponent.SetType(CollisonMeshType::AABB);
+			collisionMeshComponent.SetAABB(aabb.aabb);
+			collisionMeshComponent.Build();
+		}
+	}
+
+	// Vertex and index buffers stay in the mapping. MeshResources share the mapping so that it lives until they are destroyed.
+	std::span<const SnapshotVertexAttribute> vertexAttributes = reader.GetElements<SnapshotVertexAttribute>(ToID(SceneGeometryCacheSection::MeshVertexAttribute));
+	std::span<const SnapshotBlob> indexBuffers = reader.GetElements<SnapshotBlob>(ToID(SceneGeometryCacheSection::MeshIndexBuffer));
+	std::span<const SnapshotMesh> meshes = reader.GetElements<SnapshotMesh>(ToID(SceneGeometryCacheSection::Mesh));
+	std::vector<MeshResource*> meshResources(meshes.size(), nullptr);
+	for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+	{
+		const SnapshotMesh& mesh = meshes[meshIndex];
+		std::span<const std::byte> vertexData = reader.GetBlob(mesh.vertexBuffer);
+		if (vertexData.empty() || 0U == mesh.indexBufferCount || 0U == mesh.lodCount || 0U != mesh.indexBufferCount % mesh.lodCount ||
+			mesh.firstAttribute > vertexAttributes.size() || mesh.attributeCount > vertexAttributes.size() - mesh.firstAttribute ||
+			mesh.firstIndexBuffer > indexBuffers.size() || mesh.indexBufferCount > indexBuffers.size() - mesh.firstIndexBuffer)
+		{
+			CD_WARN("Skip corrupted mesh {0} in scene geometry cache {1}.", mesh.nameCrc, pFilePath);
+			continue;
+		}
+
+		StringCrc meshNameCrc;
+		meshNameCrc.Set(mesh.nameCrc);
+		MeshResource* pMeshResource = pResourceContext->AddMeshResource(meshNameCrc);
+		meshResources[meshIndex] = pMeshResource;
+		if (pMeshResource->GetMeshAsset() || pMeshResource->GetStatus() != ResourceStatus::Loading)
+		{
+			// Already loaded by another scene.
+			continue;
+		}
+
+		cd::VertexFormat vertexFormat;
+		for (const SnapshotVertexAttribute& attribute : vertexAttributes.subspan(mesh.firstAttribute, mesh.attributeCount))
+		{
+			vertexFormat.AddVertexAttributeLayout(static_cast<cd::VertexAttributeType>(attribute.type),
+				static_cast<cd::AttributeValueType>(attribute.valueType), attribute.count);
+		}
+
+		std::vector<std::span<const std::byte>> indexDatas;
+		indexDatas.reserve(mesh.indexBufferCount);
+		for (const SnapshotBlob& indexBuffer : indexBuffers.subspan(mesh.firstIndexBuffer, mesh.indexBufferCount))
+		{
+			indexDatas.push_back(reader.GetBlob(indexBuffer));
+		}
+
+		pMeshResource->SetPrebuiltMeshData(reader.GetMappedFile(), vertexFormat, mesh.vertexCount, mesh.polygonCount, vertexData, cd::MoveTemp(indexDatas), mesh.lodCount,
+			mesh.positionQuantization);
+	}
+
+	for (const SnapshotNodeLink& staticMesh : reader.GetElements<SnapshotNodeLink>(ToID(SceneGeometryCacheSection::StaticMesh)))
+	{
+		if (staticMesh.node < nodeCount && staticMesh.target < meshResources.size() && meshResources[staticMesh.target])
+		{
+			auto& staticMeshComponent = pWorld->CreateComponent<StaticMeshComponent>(nodeEntities[staticMesh.node]);
+			staticMeshComponent.SetMeshResource(meshResources[staticMesh.target]);
+		}
+	}
+
+	// Materials are created after static meshes as shader features depend on mesh quantization.
+	std::span<const uint32_t> materialFeatures = reader.GetElements<uint32_t>(ToID(SceneGeometryCacheSection::MaterialFeature));
+	std::span<const SnapshotMaterialProperty> materialProperties = reader.GetElements<SnapshotMaterialProperty>(ToID(SceneGeometryCacheSection::MaterialProperty));
+	std::span<const SnapshotMaterial> materials = reader.GetElements<SnapshotMaterial>(ToID(SceneGeometryCacheSection::Material));
+	for (const SnapshotMaterial& material : materials)
+	{
+		if (material.node >= nodeCount || material.firstFeature > materialFeatures.size() || material.featureCount > materialFeatures.size() - material.firstFeature ||
+			material.firstProperty > materialProperties.size() || material.propertyCount > materialProperties.size() - material.firstProperty)
+		{
+			CD_WARN("Skip corrupted material in scene geometry cache {0}.", pFilePath);
+			continue;
+		}
+
+		std::optional<std::string_view> optMaterialTypeName = GetString(nameChars, material.materialTypeName);
+		MaterialType* pMaterialType = optMaterialTypeName.has_value() ? FindMaterialType(pSceneWorld, optMaterialTypeName.value()) : nullptr;
+		if (!pMaterialType)
+		{
+			CD_WARN("Skip material in scene geometry cache {0} as its material type is unknown.", pFilePath);
+			continue;
+		}
+
+		LoadMaterial(pSceneWorld, pResourceContext, nodeEntities[material.node], pMaterialType, material, nameChars,
+			materialFeatures.subspan(material.firstFeature, material.featureCount), materialProperties.subspan(material.firstProperty, material.propertyCount));
+	}
+
+	std::span<const SnapshotLight> lights = reader.GetElements<SnapshotLight>(ToID(SceneGeometryCacheSection::Light));
+	for (const SnapshotLight& light : lights)
+	{
+		if (light.node >= nodeCount)
+		{
+			continue;
+		}
+
+		auto& lightComponent = pWorld->CreateComponent<LightComponent>(nodeEntities[light.node]);
+		*lightComponent.GetLightUniformData() = light.uniformData;
+		for (uint16_t splitIndex = 0U; splitIndex < 4U; ++splitIndex)
+		{
+			lightComponent.GetManualCascadeSplitAt(splitIndex) = light.manualCascadeSplit[splitIndex];
+		}
+		lightComponent.SetShadowMapSize(light.shadowMapSize);
+		lightComponent.SetIsCastShadow(light.isCastShadow != 0U);
+		lightComponent.GetIsCastVolume() = light.isCastVolume != 0U;
+		lightComponent.SetCascadePartitionMode(static_cast<CascadePartitionMode>(light.cascadePartitionMode));
+	}
+
+	std::span<const SnapshotCamera> cameras = reader.GetElements<SnapshotCamera>(ToID(SceneGeometryCacheSection::Camera));
+	for (const SnapshotCamera& camera : cameras)
+	{
+		if (camera.node >= nodeCount)
+		{
+			continue;
+		}
+
+		Entity entity = nodeEntities[camera.node];
+		auto& cameraComponent = pWorld->CreateComponent<CameraComponent>(entity);
+		cameraComponent.SetAspect(camera.aspect);
+		cameraComponent.SetFov(camera.fov);
+		cameraComponent.SetNearPlane(camera.nearPlane);
+		cameraComponent.SetFarPlane(camera.farPlane);
+		cameraComponent.SetNDCDepth(static_cast<cd::NDCDepth>(camera.ndcDepth));
+		cameraComponent.SetExposure(camera.exposure);
+		cameraComponent.SetGammaCorrection(camera.gammaCorrection);
+		cameraComponent.SetToneMappingMode(static_cast<cd::ToneMappingMode>(camera.toneMappingMode));
+		cameraComponent.SetConstrainAspectRatio(camera.doConstrainAspectRatio != 0U);
+		cameraComponent.SetBloomEnable(camera.enableBloom != 0U);
+		cameraComponent.GetIsBlurEnable() = camera.enableBlur != 0U;
+		cameraComponent.SetBloomDownSampleTimes(camera.bloomDownSampleTimes);
+		cameraComponent.SetBloomIntensity(camera.bloomIntensity);
+		cameraComponent.SetLuminanceThreshold(camera.luminanceThreshold);
+		cameraComponent.SetBlurTimes(camera.blurTimes);
+		cameraComponent.SetBlurSize(camera.blurSize);
+		cameraComponent.SetBlurScaling(camera.blurScaling);
+		cameraComponent.BuildProjectMatrix();
+		cameraComponent.BuildViewMatrix(pSceneWorld->GetTransformComponent(entity)->GetTransform());
+	}
+
+	CD_INFO("Loaded scene geometry cache {0} : {1} nodes, {2} meshes, {3} materials, {4} lights, {5} cameras.", pFilePath, nodeCount, meshes.size(),
+		materials.size(), lights.size(), cameras.size());
+	return nodeEntities;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Entity.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class ResourceContext;
+class SceneWorld;
+
+// SceneGeometryCache stores static mesh geometry of a scene in a BinarySnapshot so that it is opened by mapping
+// one file instead of running asset pipeline and ECWorldConsumer again.
+// Sky, terrain, animations and particles are not stored.
+// Nodes are entities which own TransformComponent and one of StaticMesh/Light/Camera components, plus their ancestors to keep the hierarchy.
+// Their Name/Hierarchy/CollisionMesh/StaticMesh/Material/Light/Camera components are stored together with vertex and index buffers of referenced
+// MeshResources in GPU layout, which are submitted to GPU from the mapped memory directly.
+// Materials refer to their MaterialType by name and to built DDS textures by file path.
+// Index buffers include the LOD chain so that it is not generated again on loading.
+// Vertex buffers of quantized meshes are stored quantized together with their position bounds.
+class SceneGeometryCache final
+{
+public:
+	// Increase it when any section layout changes. Caches in other versions are rejected.
+	static constexpr uint32_t Version = 4U;
+
+public:
+	SceneGeometryCache() = delete;
+	SceneGeometryCache(const SceneGeometryCache&) = delete;
+	SceneGeometryCache& operator=(const SceneGeometryCache&) = delete;
+	SceneGeometryCache(SceneGeometryCache&&) = delete;
+	SceneGeometryCache& operator=(SceneGeometryCache&&) = delete;
+	~SceneGeometryCache() = delete;
+
+	static bool Save(const SceneWorld* pSceneWorld, const char* pFilePath);
+
+	// Returns created node entities. MaterialTypes should be created in the SceneWorld before loading.
+	static std::vector<Entity> Load(SceneWorld* pSceneWorld, ResourceContext* pResourceContext, const char* pFilePath);
+};
+
+}
\ No newline at end of file
@@ -9,17 +9,24 @@
 #include "ddgi_sdk.h"
 #endif
 
+#include <algorithm>
 #include <vector>
 #include <string>
 
 namespace engine
 {
 
-SceneWorld::SceneWorld()
+SceneWorld::SceneWorld(bool useArchetypeStorage)
 {
 	m_pSceneDatabase = std::make_unique<cd::SceneDatabase>();
 
 	m_pWorld = std::make_unique<engine::World>();
+	if (useArchetypeStorage)
+	{
+		m_pWorld->EnableArchetypeStorage();
+	}
+	m_pCommandBuffer = std::make_unique<engine::EntityCommandBuffer>(m_pWorld.get());
+	m_pCommandBuffer->OnDeleteEntities.Bind<SceneWorld, &SceneWorld::DeleteEntities>(this);
 
 	// To add a new component : 2. Init component type here.
 	m_pAnimationComponentStorage = m_pWorld->Register<engine::AnimationComponent>();
@@ -43,6 +50,9 @@ SceneWorld::SceneWorld()
 	m_pTerrainComponentStorage = m_pWorld->Register<engine::TerrainComponent>();
 	m_pTransformComponentStorage = m_pWorld->Register<engine::TransformComponent>();
 	m_pMotionMatchingComponentStorage = m_pWorld->Register<engine::MotionMatchingComponent>();
+
+	m_pTransformSystem = std::make_unique<engine::TransformSystem>(m_pWorld.get());
+	m_pCullingSystem = std::make_unique<engine::CullingSystem>(m_pWorld.get());
 	
 #ifdef ENABLE_DDGI
 	CreateDDGIMaterialType();
@@ -62,6 +72,10 @@ void SceneWorld::CreatePBRMaterialType(std::string shaderProgramName, bool isAtm
 	shaderSchema.AddFeatureSet({ ShaderFeature::EMISSIVE_MAP });
 	// TODO : Compile atm shader in GL/VK mode correctly.
 	isAtmosphericScatteringEnable ? shaderSchema.AddFeatureSet({ ShaderFeature::IBL, ShaderFeature::ATM }) : shaderSchema.AddFeatureSet({ ShaderFeature::IBL });
+	// Instanced variants are selected by WorldRenderer, not activated by materials.
+	shaderSchema.AddLazyFeatureSet({ ShaderFeature::INSTANCING });
+	// Materials of meshes in quantized vertex format activate it to decode normals and tangents.
+	shaderSchema.AddLazyFeatureSet({ ShaderFeature::QUANTIZED_VERTEX });
 	shaderSchema.Build();
 	m_pPBRMaterialType->SetShaderSchema(cd::MoveTemp(shaderSchema));
 
@@ -189,12 +203,58 @@ void SceneWorld::CreateDDGIMaterialType(std::string shaderProgramName)
 }
 #endif
 
+void SceneWorld::DeleteEntities(const engine::Entity* pEntities, size_t count)
+{
+	m_deletingEntities.assign(pEntities, pEntities + count);
+	std::erase_if(m_deletingEntities, [this](engine::Entity entity)
+	{
+		if (entity != m_mainCameraEntity)
+		{
+			return false;
+		}
+
+		CD_WARN("You can't delete main camera entity.");
+		return true;
+	});
+
+	if (std::find(m_deletingEntities.begin(), m_deletingEntities.end(), m_selectedEntity) != m_deletingEntities.end())
+	{
+		m_selectedEntity = engine::INVALID_ENTITY;
+	}
+
+	m_pWorld->DeleteEntities(m_deletingEntities.data(), m_deletingEntities.size());
+}
+
 void SceneWorld::SetSelectedEntity(engine::Entity entity)
 {
 	CD_TRACE("Select entity : {0}", entity);
 	m_selectedEntity = entity;
 }
 
+void SceneWorld::SetParentEntity(engine::Entity entity, engine::Entity parentEntity)
+{
+	assert(entity != parentEntity);
+	HierarchyComponent* pHierarchyComponent = GetHierarchyComponent(entity);
+	if (!pHierarchyComponent)
+	{
+		pHierarchyComponent = &m_pWorld->CreateComponent<engine::HierarchyComponent>(entity);
+	}
+	pHierarchyComponent->SetParentEntity(parentEntity);
+
+	if (TransformComponent* pTransformComponent = GetTransformComponent(entity))
+	{
+		pTransformComponent->Dirty();
+	}
+	m_pTransformSystem->SetHierarchyDirty();
+}
+
+const cd::Matrix4x4& SceneWorld::GetWorldMatrix(engine::Entity entity) const
+{
+	static const cd::Matrix4x4 identity = cd::Matrix4x4::Identity();
+	const TransformComponent* pTransformComponent = GetTransformComponent(entity);
+	return pTransformComponent ? pTransformComponent->GetWorldMatrix() : identity;
+}
+
 void SceneWorld::SetMainCameraEntity(engine::Entity entity)
 {
 	CD_TRACE("Setup main camera entity : {0}", entity);
@@ -315,8 +375,44 @@ void SceneWorld::InitDDGISDK()
 }
 #endif
 
+void SceneWorld::CollectOccluders()
+{
+	m_pCullingSystem->ClearOccluders();
+	for (engine::Entity entity : GetStaticMeshEntities())
+	{
+		// Occluder geometry is built from rest pose so deforming meshes are skipped.
+		if (GetAnimationComponent(entity) || GetBlendShapeComponent(entity))
+		{
+			continue;
+		}
+
+		engine::MaterialComponent* pMaterialComponent = GetMaterialComponent(entity);
+		if (!pMaterialComponent || cd::BlendMode::Opaque != pMaterialComponent->GetBlendMode())
+		{
+			continue;
+		}
+
+		// Occluder is built by a job before the mesh becomes ready so status is checked before reading it.
+		const engine::MeshResource* pMeshResource = GetStaticMeshComponent(entity)->GetMeshResource();
+		if (!pMeshResource ||
+			(engine::ResourceStatus::Ready != pMeshResource->GetStatus() && engine::ResourceStatus::Optimized != pMeshResource->GetStatus()) ||
+			!pMeshResource->HasOccluder())
+		{
+			continue;
+		}
+
+		m_pCullingSystem->AddOccluder(entity, pMeshResource->GetOccluderPositions(), pMeshResource->GetOccluderIndices());
+	}
+}
+
 void SceneWorld::Update()
 {
+	// Sync point to apply structural changes recorded in last frame.
+	if (!m_pCommandBuffer->IsEmpty())
+	{
+		m_pCommandBuffer->Playback();
+	}
+
 #ifdef ENABLE_DDGI
 	// Send request 30 times per second.
 	static auto startTime = std::chrono::steady_clock::now();
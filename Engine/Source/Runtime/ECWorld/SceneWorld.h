@@ -1,6 +1,9 @@
 #pragma once
 
 #include "ECWorld/AllComponentsHeader.h"
+#include "ECWorld/CullingSystem.h"
+#include "ECWorld/EntityCommandBuffer.h"
+#include "ECWorld/TransformSystem.h"
 #include "ECWorld/World.h"
 #include "Log/Log.h"
 #include "Material/MaterialType.h"
@@ -50,17 +53,36 @@ class SceneWorld
 	DEFINE_COMPONENT_STORAGE_WITH_APIS(MotionMatching);
 
 public:
-	SceneWorld();
+	// Components are stored by archetype chunks when useArchetypeStorage is true. See World::EnableArchetypeStorage.
+	explicit SceneWorld(bool useArchetypeStorage = false);
 	SceneWorld(const SceneWorld&) = delete;
 	SceneWorld& operator=(const SceneWorld&) = delete;
-	SceneWorld(SceneWorld&&) = default;
-	SceneWorld& operator=(SceneWorld&&) = default;
+	SceneWorld(SceneWorld&&) = delete;
+	SceneWorld& operator=(SceneWorld&&) = delete;
 	~SceneWorld() = default;
 
 	CD_FORCEINLINE cd::SceneDatabase* GetSceneDatabase() { return m_pSceneDatabase.get(); }
 	CD_FORCEINLINE engine::World* GetWorld() { return m_pWorld.get(); }
 	CD_FORCEINLINE const engine::World* GetWorld() const { return m_pWorld.get(); }
 
+	// Systems running on worker threads record structural changes here. They are applied in Update().
+	CD_FORCEINLINE engine::EntityCommandBuffer* GetCommandBuffer() { return m_pCommandBuffer.get(); }
+
+	// Composes world matrices of TransformComponents through HierarchyComponent parents.
+	CD_FORCEINLINE engine::TransformSystem* GetTransformSystem() { return m_pTransformSystem.get(); }
+
+	// Frustum and occlusion culls world space bounds of CollisionMeshComponents per view.
+	CD_FORCEINLINE engine::CullingSystem* GetCullingSystem() { return m_pCullingSystem.get(); }
+
+	// Entities without a TransformComponent are placed at the origin.
+	const cd::Matrix4x4& GetWorldMatrix(engine::Entity entity) const;
+
+	// Registers opaque static meshes which have occluder geometry to CullingSystem. Should be called before CullingSystem::Update.
+	void CollectOccluders();
+
+	// Attach entity to parentEntity. INVALID_ENTITY detaches it.
+	void SetParentEntity(engine::Entity entity, engine::Entity parentEntity);
+
 	void SetSelectedEntity(engine::Entity entity);
 	CD_FORCEINLINE engine::Entity GetSelectedEntity() const { return m_selectedEntity; }
 
@@ -75,42 +97,10 @@ public:
 	void SetSkyEntity(engine::Entity entity);
 	CD_FORCEINLINE engine::Entity GetSkyEntity() const { return m_skyEntity; }
 
-	void DeleteEntity(engine::Entity entity)
-	{
-		if (entity == m_mainCameraEntity)
-		{
-			CD_WARN("You can't delete main camera entity.");
-			return;
-		}
-
-		if (entity == m_selectedEntity)
-		{
-			m_selectedEntity = engine::INVALID_ENTITY;
-		}
-
-		// To add a new component : 3. Delete component here when removing an entity.
-		DeleteAnimationComponent(entity);
-		DeleteBlendShapeComponent(entity);
-		DeleteCameraComponent(entity);
-		DeleteCollisionMeshComponent(entity);
-#ifdef ENABLE_DDGI
-		DeleteDDGIComponent(entity);
-#endif
-		DeleteHierarchyComponent(entity);
-		DeleteLightComponent(entity);
-		DeleteMaterialComponent(entity);
-		DeleteNameComponent(entity);
-		DeleteSkeletonComponent(entity);
-		DeleteSkinMeshComponent(entity);
-		DeleteSkyComponent(entity);
-		DeleteStaticMeshComponent(entity);
-		DeleteParticleEmitterComponent(entity);
-		DeleteParticleRibbonComponent(entity);
-		DeleteParticleForceFieldComponent(entity);
-		DeleteTerrainComponent(entity);
-		DeleteTransformComponent(entity);
-		DeleteMotionMatchingComponent(entity);
-	}
+	void DeleteEntity(engine::Entity entity) { DeleteEntities(&entity, 1); }
+
+	// Components in all registered storages are removed together. Deletions recorded in the command buffer also come here.
+	void DeleteEntities(const engine::Entity* pEntities, size_t count);
 
 	void CreatePBRMaterialType(std::string shaderProgramName, bool isAtmosphericScatteringEnable = false);
 	CD_FORCEINLINE engine::MaterialType* GetPBRMaterialType() const { return m_pPBRMaterialType.get(); }
@@ -145,6 +135,10 @@ public:
 private:
 	std::unique_ptr<cd::SceneDatabase> m_pSceneDatabase;
 	std::unique_ptr<engine::World> m_pWorld;
+	std::unique_ptr<engine::EntityCommandBuffer> m_pCommandBuffer;
+	std::vector<engine::Entity> m_deletingEntities;
+	std::unique_ptr<engine::TransformSystem> m_pTransformSystem;
+	std::unique_ptr<engine::CullingSystem> m_pCullingSystem;
 
 	std::unique_ptr<engine::MaterialType> m_pPBRMaterialType;
 	std::unique_ptr<engine::MaterialType> m_pAnimationMaterialType;
@@ -3,6 +3,7 @@
 #include "Core/StringCrc.h"
 #include "ECWorld/Entity.h"
 #include "Scene/Bone.h"
+#include "Rendering/Resources/ResourceHandle.h"
 #include <Rendering/Resources/SkeletonResource.h>
 
 namespace cd
@@ -32,7 +33,7 @@ public:
 	SkeletonComponent& operator=(SkeletonComponent&&) = default;
 	~SkeletonComponent() = default;
 
-	const SkeletonResource* GetSkeletonResource() const { return m_pSkeletonResource; }
+	const SkeletonResource* GetSkeletonResource() const { return m_pSkeletonResource.Get(); }
 	void SetSkeletonAsset(const SkeletonResource* pSkeletonResource);
 
 	void SetBoneMatricesUniform(uint16_t uniform) { m_boneMatricesUniform = uniform; }
@@ -63,7 +64,7 @@ public:
 private:
 	//input
 	uint32_t m_boneIndex = engine::INVALID_ENTITY;
-	const SkeletonResource* m_pSkeletonResource = nullptr;
+	ResourceHandle<const SkeletonResource> m_pSkeletonResource;
 	//output
 	uint16_t m_boneVBH = UINT16_MAX;
 	uint16_t m_boneIBH = UINT16_MAX;
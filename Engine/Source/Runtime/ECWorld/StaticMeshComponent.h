@@ -2,6 +2,8 @@
 
 #include "Core/StringCrc.h"
 #include "ECWorld/Entity.h"
+#include "Rendering/Resources/MeshResource.h"
+#include "Rendering/Resources/ResourceHandle.h"
 #include "Scene/Mesh.h"
 
 #include <cstdint>
@@ -10,8 +12,6 @@
 namespace engine
 {
 
-class MeshResource;
-
 class StaticMeshComponent final
 {
 public:
@@ -29,7 +29,7 @@ public:
 	StaticMeshComponent& operator=(StaticMeshComponent&&) = default;
 	~StaticMeshComponent() = default;
 
-	const MeshResource* GetMeshResource() const { return m_pMeshResource; }
+	const MeshResource* GetMeshResource() const { return m_pMeshResource.Get(); }
 	void SetMeshResource(const MeshResource* pMeshResource);
 
 	uint32_t GetStartVertex() const;
@@ -38,10 +38,16 @@ public:
 	uint32_t GetPolygonCount() const;
 	uint32_t GetIndexCount() const;
 
+	// Selected by screen size. Renderers clamp it by LOD count of the mesh.
+	uint32_t GetLOD() const { return m_lod; }
+	void SetLOD(uint32_t lod) { m_lod = lod; }
+
 private:
-	const MeshResource* m_pMeshResource = nullptr;
+	// Keeps mesh resident while the component is alive.
+	ResourceHandle<const MeshResource> m_pMeshResource;
 	uint32_t m_currentVertexCount = UINT32_MAX;
 	uint32_t m_currentPolygonCount = UINT32_MAX;
+	uint32_t m_lod = 0U;
 };
 
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "TransformComponent.h"
 
+#include <cstring>
+
 namespace engine
 {
 
@@ -7,7 +9,8 @@ void TransformComponent::Reset()
 {
 	m_transform.Clear();
 	m_localToWorldMatrix.Clear();
-	m_isMatrixDirty = true;
+	++m_worldMatrixVersion;
+	Dirty();
 }
 
 void TransformComponent::Build()
@@ -15,9 +18,23 @@ void TransformComponent::Build()
 	if (m_isMatrixDirty)
 	{
 		m_localToWorldMatrix = m_transform.GetMatrix();
+		++m_worldMatrixVersion;
 		m_isMatrixDirty = false;
 	}
 }
+
+void TransformComponent::SetWorldMatrix(const cd::Matrix4x4& worldMatrix)
+{
+	// TransformSystem recomputes children of a dirty parent even if their matrices end up the same.
+	if (0 != std::memcmp(m_localToWorldMatrix.begin(), worldMatrix.begin(), 16 * sizeof(float)))
+	{
+		m_localToWorldMatrix = worldMatrix;
+		++m_worldMatrixVersion;
+	}
+
+	m_isMatrixDirty = false;
+	m_isHierarchyDirty = false;
+}
 #ifdef EDITOR_MODE
 bool TransformComponent::m_doUseUniformScale = true;
 #endif
@@ -25,11 +25,19 @@ public:
 
 	const cd::Transform& GetTransform() const { return m_transform; }
 	cd::Transform& GetTransform() { return m_transform; }
-	void SetTransform(cd::Transform transform) { m_transform = cd::MoveTemp(transform); m_isMatrixDirty = true;  }
+	void SetTransform(cd::Transform transform) { m_transform = cd::MoveTemp(transform); Dirty(); }
 
 	const cd::Matrix4x4& GetWorldMatrix() const { return m_localToWorldMatrix; }
 
-	void Dirty() const { m_isMatrixDirty = true; }
+	void Dirty() const { m_isMatrixDirty = true; m_isHierarchyDirty = true; }
+
+	// TransformSystem composes local matrix with parents and clears hierarchy dirty flag.
+	// Build() only clears local dirty flag so that TransformSystem still knows which entities changed.
+	bool IsHierarchyDirty() const { return m_isHierarchyDirty; }
+	void SetWorldMatrix(const cd::Matrix4x4& worldMatrix);
+
+	// Increases when world matrix changes so that caches of world space data can detect moved entities.
+	uint32_t GetWorldMatrixVersion() const { return m_worldMatrixVersion; }
 
 	void Reset();
 	void Build();
@@ -48,10 +56,12 @@ private:
 	cd::Transform m_transform;
 
 	// Status
-	mutable bool m_isMatrixDirty;
+	mutable bool m_isMatrixDirty = true;
+	mutable bool m_isHierarchyDirty = true;
 
 	// Output
 	cd::Matrix4x4 m_localToWorldMatrix;
+	uint32_t m_worldMatrixVersion = 0U;
 
 #ifdef EDITOR_MODE
 	static bool m_doUseUniformScale;
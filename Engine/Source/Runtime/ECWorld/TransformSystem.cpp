@@ -0,0 +1,232 @@
+#include "TransformSystem.h"
+
+#include "HierarchyComponent.h"
+#include "Scheduler/ThreadPool.h"
+#include "TransformComponent.h"
+#include "World.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE__)
+#define CD_TRANSFORM_SYSTEM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+// Column major 4x4 matrix multiplication : result = a * b.
+// Every column of result is a linear combination of columns of a weighted by the column of b.
+CD_FORCEINLINE void MultiplyMatrix4x4(const float* pA, const float* pB, float* pResult)
+{
+#ifdef CD_TRANSFORM_SYSTEM_SSE
+	const __m128 aColumn0 = _mm_loadu_ps(pA + 0);
+	const __m128 aColumn1 = _mm_loadu_ps(pA + 4);
+	const __m128 aColumn2 = _mm_loadu_ps(pA + 8);
+	const __m128 aColumn3 = _mm_loadu_ps(pA + 12);
+
+	for (int column = 0; column < 4; ++column)
+	{
+		const float* pBColumn = pB + column * 4;
+		__m128 result = _mm_mul_ps(aColumn0, _mm_set1_ps(pBColumn[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(aColumn1, _mm_set1_ps(pBColumn[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(aColumn2, _mm_set1_ps(pBColumn[2])));
+		result = _mm_add_ps(result, _mm_mul_ps(aColumn3, _mm_set1_ps(pBColumn[3])));
+		_mm_storeu_ps(pResult + column * 4, result);
+	}
+#else
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			pResult[column * 4 + row] = pA[row] * pB[column * 4] + pA[4 + row] * pB[column * 4 + 1] +
+				pA[8 + row] * pB[column * 4 + 2] + pA[12 + row] * pB[column * 4 + 3];
+		}
+	}
+#endif
+}
+
+}
+
+TransformSystem::TransformSystem(World* pWorld)
+{
+	assert(pWorld);
+	m_pTransformStorage = pWorld->GetComponents<TransformComponent>();
+	m_pHierarchyStorage = pWorld->GetComponents<HierarchyComponent>();
+	assert(m_pTransformStorage && m_pHierarchyStorage);
+}
+
+void TransformSystem::Update(ThreadPool* pThreadPool)
+{
+	if (m_isHierarchyDirty.load(std::memory_order_relaxed) ||
+		m_lastTransformCount != m_pTransformStorage->GetCount() ||
+		m_lastHierarchyCount != m_pHierarchyStorage->GetCount())
+	{
+		RebuildHierarchy();
+	}
+
+	m_updatedNodeCount = 0;
+	for (size_t levelIndex = 0; levelIndex < GetLevelCount(); ++levelIndex)
+	{
+		size_t levelBegin = m_levelOffsets[levelIndex];
+		size_t levelCount = m_levelOffsets[levelIndex + 1] - levelBegin;
+		if (!pThreadPool)
+		{
+			m_updatedNodeCount += UpdateNodes(levelBegin, levelBegin + levelCount);
+			continue;
+		}
+
+		std::atomic<size_t> updatedNodeCount = 0;
+		pThreadPool->ParallelFor(levelCount, ParallelBatchSize, [this, levelBegin, &updatedNodeCount](size_t begin, size_t end)
+		{
+			updatedNodeCount.fetch_add(UpdateNodes(levelBegin + begin, levelBegin + end), std::memory_order_relaxed);
+		});
+		m_updatedNodeCount += updatedNodeCount.load(std::memory_order_relaxed);
+	}
+
+	m_forceUpdate = false;
+}
+
+size_t TransformSystem::UpdateNodes(size_t beginNode, size_t endNode)
+{
+	size_t updatedNodeCount = 0;
+	for (size_t nodeIndex = beginNode; nodeIndex < endNode; ++nodeIndex)
+	{
+		TransformComponent* pTransformComponent = m_pTransformStorage->GetComponent(m_nodeEntities[nodeIndex]);
+		if (!pTransformComponent)
+		{
+			// Entity was removed and another one was created in the same frame. Rebuild in next update.
+			m_isHierarchyDirty.store(true, std::memory_order_relaxed);
+			m_changedFlags[nodeIndex] = 0;
+			continue;
+		}
+
+		uint32_t parentIndex = m_nodeParents[nodeIndex];
+		bool isParentChanged = parentIndex != InvalidNodeIndex && m_changedFlags[parentIndex];
+		if (!m_forceUpdate && !isParentChanged && !pTransformComponent->IsHierarchyDirty())
+		{
+			m_changedFlags[nodeIndex] = 0;
+			continue;
+		}
+
+		cd::Matrix4x4& worldMatrix = m_worldMatrices[nodeIndex];
+		if (InvalidNodeIndex == parentIndex)
+		{
+			worldMatrix = pTransformComponent->GetTransform().GetMatrix();
+		}
+		else
+		{
+			cd::Matrix4x4 localMatrix = pTransformComponent->GetTransform().GetMatrix();
+			MultiplyMatrix4x4(m_worldMatrices[parentIndex].begin(), localMatrix.begin(), worldMatrix.begin());
+		}
+
+		pTransformComponent->SetWorldMatrix(worldMatrix);
+		m_changedFlags[nodeIndex] = 1;
+		++updatedNodeCount;
+	}
+
+	return updatedNodeCount;
+}
+
+uint32_t TransformSystem::GetDepth(Entity entity, std::vector<uint32_t>& depthCache) const
+{
+	uint32_t entityIndex = GetEntityIndex(entity);
+	if (depthCache[entityIndex] != InvalidNodeIndex)
+	{
+		return depthCache[entityIndex];
+	}
+
+	// Parents without TransformComponent are ignored so that the entity becomes a root.
+	uint32_t depth = 0U;
+	const HierarchyComponent* pHierarchyComponent = m_pHierarchyStorage->GetComponent(entity);
+	if (pHierarchyComponent)
+	{
+		Entity parentEntity = pHierarchyComponent->GetParentEntity();
+		if (parentEntity != entity && m_pTransformStorage->Contains(parentEntity))
+		{
+			// Mark as visiting to break cycles.
+			depthCache[entityIndex] = MaxHierarchyDepth;
+			depth = std::min(GetDepth(parentEntity, depthCache) + 1U, MaxHierarchyDepth);
+		}
+	}
+
+	depthCache[entityIndex] = depth;
+	return depth;
+}
+
+void TransformSystem::RebuildHierarchy()
+{
+	const std::vector<Entity>& transformEntities = m_pTransformStorage->GetEntities();
+	size_t nodeCount = transformEntities.size();
+
+	uint32_t maxEntityIndex = 0U;
+	for (Entity entity : transformEntities)
+	{
+		maxEntityIndex = std::max(maxEntityIndex, GetEntityIndex(entity));
+	}
+
+	// Depth per entity index, then counting sort nodes by depth.
+	std::vector<uint32_t> depthCache(nodeCount > 0 ? maxEntityIndex + 1U : 0U, InvalidNodeIndex);
+	std::vector<uint32_t> depths(nodeCount);
+	uint32_t levelCount = 0U;
+	for (size_t index = 0; index < nodeCount; ++index)
+	{
+		depths[index] = GetDepth(transformEntities[index], depthCache);
+		levelCount = std::max(levelCount, depths[index] + 1U);
+	}
+
+	m_levelOffsets.assign(levelCount + 1U, 0);
+	for (uint32_t depth : depths)
+	{
+		++m_levelOffsets[depth + 1U];
+	}
+	for (uint32_t levelIndex = 0U; levelIndex < levelCount; ++levelIndex)
+	{
+		m_levelOffsets[levelIndex + 1U] += m_levelOffsets[levelIndex];
+	}
+
+	std::vector<size_t> levelCursors(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+	std::vector<uint32_t> entityToNode(depthCache.size(), InvalidNodeIndex);
+	m_nodeEntities.resize(nodeCount);
+	for (size_t index = 0; index < nodeCount; ++index)
+	{
+		size_t nodeIndex = levelCursors[depths[index]]++;
+		m_nodeEntities[nodeIndex] = transformEntities[index];
+		entityToNode[GetEntityIndex(transformEntities[index])] = static_cast<uint32_t>(nodeIndex);
+	}
+
+	m_nodeParents.resize(nodeCount);
+	for (size_t nodeIndex = 0; nodeIndex < nodeCount; ++nodeIndex)
+	{
+		m_nodeParents[nodeIndex] = InvalidNodeIndex;
+		Entity entity = m_nodeEntities[nodeIndex];
+		const HierarchyComponent* pHierarchyComponent = m_pHierarchyStorage->GetComponent(entity);
+		if (!pHierarchyComponent || !m_pTransformStorage->Contains(pHierarchyComponent->GetParentEntity()))
+		{
+			continue;
+		}
+
+		// Parent must be in an earlier level. Otherwise there is a cycle or the hierarchy is too deep,
+		// then the node is treated as a root.
+		uint32_t parentEntityIndex = GetEntityIndex(pHierarchyComponent->GetParentEntity());
+		if (depthCache[parentEntityIndex] < depthCache[GetEntityIndex(entity)])
+		{
+			m_nodeParents[nodeIndex] = entityToNode[parentEntityIndex];
+		}
+	}
+
+	m_worldMatrices.resize(nodeCount);
+	m_changedFlags.assign(nodeCount, 0);
+
+	m_lastTransformCount = nodeCount;
+	m_lastHierarchyCount = m_pHierarchyStorage->GetCount();
+	m_isHierarchyDirty.store(false, std::memory_order_relaxed);
+	m_forceUpdate = true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ComponentsStorage.hpp"
+#include "Entity.h"
+#include "Math/Matrix.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+class HierarchyComponent;
+class ThreadPool;
+class TransformComponent;
+class World;
+
+// TransformSystem propagates world matrices through HierarchyComponent parents.
+// Entities are kept in a flat array sorted by hierarchy depth so that every parent is processed before its children.
+// One update is a linear pass per depth level : a node is recomputed only if its own transform is dirty or its parent
+// changed in this pass. Nodes in the same level are independent so that each level is split into parallel batches.
+class TransformSystem
+{
+public:
+	static constexpr uint32_t InvalidNodeIndex = static_cast<uint32_t>(-1);
+	static constexpr uint32_t MaxHierarchyDepth = 256U;
+
+	// Levels smaller than it run on the calling thread.
+	static constexpr size_t ParallelBatchSize = 4096;
+
+public:
+	TransformSystem() = delete;
+	explicit TransformSystem(World* pWorld);
+	TransformSystem(const TransformSystem&) = delete;
+	TransformSystem& operator=(const TransformSystem&) = delete;
+	TransformSystem(TransformSystem&&) = delete;
+	TransformSystem& operator=(TransformSystem&&) = delete;
+	~TransformSystem() = default;
+
+	// Should be called after changing parent of any entity.
+	// Creating or removing Transform/Hierarchy components is detected automatically.
+	void SetHierarchyDirty() { m_isHierarchyDirty = true; }
+
+	// pThreadPool : nullptr to run on calling thread.
+	void Update(ThreadPool* pThreadPool = nullptr);
+
+	size_t GetNodeCount() const { return m_nodeEntities.size(); }
+	size_t GetLevelCount() const { return m_levelOffsets.empty() ? 0 : m_levelOffsets.size() - 1; }
+
+	// Returns how many nodes were recomputed in last Update.
+	size_t GetUpdatedNodeCount() const { return m_updatedNodeCount; }
+
+private:
+	void RebuildHierarchy();
+	uint32_t GetDepth(Entity entity, std::vector<uint32_t>& depthCache) const;
+	size_t UpdateNodes(size_t beginNode, size_t endNode);
+
+private:
+	ComponentsStorage<TransformComponent>* m_pTransformStorage;
+	ComponentsStorage<HierarchyComponent>* m_pHierarchyStorage;
+
+	// Also set by worker threads when they find a node whose entity was removed.
+	std::atomic<bool> m_isHierarchyDirty = true;
+	bool m_forceUpdate = true;
+	size_t m_lastTransformCount = 0;
+	size_t m_lastHierarchyCount = 0;
+	size_t m_updatedNodeCount = 0;
+
+	// Nodes sorted by depth. Arrays are aligned by node index.
+	std::vector<Entity> m_nodeEntities;
+	std::vector<uint32_t> m_nodeParents;
+	std::vector<cd::Matrix4x4> m_worldMatrices;
+	std::vector<uint8_t> m_changedFlags;
+
+	// Nodes of level i are in [m_levelOffsets[i], m_levelOffsets[i + 1]).
+	std::vector<size_t> m_levelOffsets;
+};
+
+}
\ No newline at end of file
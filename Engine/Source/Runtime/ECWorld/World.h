@@ -1,12 +1,16 @@
 #pragma once
 
+#include "ArchetypeStorage.h"
 #include "ComponentsStorage.hpp"
+#include "ComponentsView.hpp"
 #include "Entity.h"
 #include "Core/StringCrc.h"
 
-#include <atomic>
 #include <cassert>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace engine
@@ -20,33 +24,109 @@ public:
 	World() = default;
 	World(const World&) = delete;
 	World& operator=(const World&) = delete;
-	World(World&&) = default;
-	World& operator=(World&&) = default;
+	World(World&&) = delete;
+	World& operator=(World&&) = delete;
 	~World() = default;
 
+	// Thread safe. Recycles the oldest deleted index once enough are free so that dense tables stay compact
+	// and generations of recycled indexes don't wrap quickly.
 	Entity CreateEntity()
 	{
-		// Overflow is expected as I want to use the max value of EntityID as invalid value.
-		// So I allocate entity id from 0.
-		static std::atomic<Entity> nextEntity = INVALID_ENTITY + 1;
-		return nextEntity.fetch_add(1);
+		std::lock_guard<std::mutex> lock(m_entityMutex);
+
+		if (m_freeEntityIndexes.size() > MIN_FREE_ENTITY_INDEX_COUNT)
+		{
+			uint32_t index = m_freeEntityIndexes.front();
+			m_freeEntityIndexes.pop_front();
+			return MakeEntity(index, m_entityGenerations[index]);
+		}
+
+		uint32_t index = static_cast<uint32_t>(m_entityGenerations.size());
+		assert(index <= MAX_ENTITY_INDEX && "Entity index overflow.");
+		m_entityGenerations.push_back(0U);
+		return MakeEntity(index, 0U);
 	}
 
+	// Removes all components of entity and releases its index. The handle becomes stale after that.
+	void DeleteEntity(Entity entity)
+	{
+		if (!IsValid(entity))
+		{
+			return;
+		}
+
+		for (auto& [_, pStorage] : m_componentsLib)
+		{
+			pStorage->RemoveEntity(entity);
+		}
+
+		ReleaseEntities(&entity, 1);
+	}
+
+	// Batch version of DeleteEntity. Every storage removes entities once.
+	// Entities should be unique and still valid.
+	void DeleteEntities(const Entity* pEntities, size_t count)
+	{
+		if (0 == count)
+		{
+			return;
+		}
+
+		for (auto& [_, pStorage] : m_componentsLib)
+		{
+			pStorage->RemoveEntities(pEntities, count);
+		}
+
+		ReleaseEntities(pEntities, count);
+	}
+
+	// Returns false if entity is invalid or already deleted.
+	bool IsValid(Entity entity) const
+	{
+		std::lock_guard<std::mutex> lock(m_entityMutex);
+		uint32_t index = GetEntityIndex(entity);
+		return entity != INVALID_ENTITY && index < m_entityGenerations.size() &&
+			m_entityGenerations[index] == GetEntityGeneration(entity);
+	}
+
+	// Returns count of alive entities.
+	size_t GetEntityCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_entityMutex);
+		return m_entityGenerations.size() - m_freeEntityIndexes.size();
+	}
+
+	// Opt-in to store components by archetype chunks. It should be called before registering any component type.
+	// Adding/removing a component moves the entity to another archetype, so finish using references returned by
+	// CreateComponent/GetComponent before the next structural change. ComponentsStorage::GetComponents() is unavailable.
+	void EnableArchetypeStorage()
+	{
+		assert(m_componentsLib.empty());
+		m_pArchetypeStorage = std::make_unique<ArchetypeStorage>();
+	}
+	ArchetypeStorage* GetArchetypeStorage() const { return m_pArchetypeStorage.get(); }
+
 	template<typename Component>
 	ComponentsStorage<Component>* Register()
 	{
 		StringCrc componentName = Component::GetClassName();
 		assert(m_componentsLib.find(componentName.Value()) == m_componentsLib.end());
-		m_componentsLib[componentName.Value()] = std::make_unique<ComponentsStorage<Component>>();
+		auto pStorage = std::make_unique<ComponentsStorage<Component>>();
+		if (m_pArchetypeStorage)
+		{
+			pStorage->BindArchetypeStorage(m_pArchetypeStorage.get());
+		}
+		m_componentsLib[componentName.Value()] = cd::MoveTemp(pStorage);
 		return static_cast<ComponentsStorage<Component>*>(m_componentsLib[componentName.Value()].get());
 	}
 
 	template<typename Component>
 	ComponentsStorage<Component>* GetComponents()
 	{
-		StringCrc componentName = Component::GetClassName();
-		assert(m_componentsLib.find(componentName.Value()) != m_componentsLib.end());
-		return static_cast<ComponentsStorage<Component>*>(m_componentsLib[componentName.Value()].get());
+		// Only lookup so that it is safe to call from multiple threads after all storages are registered.
+		auto itStorage = m_componentsLib.find(Component::GetClassName().Value());
+		assert(itStorage != m_componentsLib.end());
+		return static_cast<ComponentsStorage<Component>*>(itStorage->second.get());
 	}
 
 	template<typename Component>
@@ -58,7 +138,39 @@ public:
 		return pStorage->CreateComponent(entity);
 	}
 
+	// Query entities which contain all of Components. See ComponentsView for details.
+	template<typename... Components>
+	ComponentsView<Components...> View()
+	{
+		return ComponentsView<Components...>(GetComponents<Components>()...);
+	}
+
+private:
+	void ReleaseEntities(const Entity* pEntities, size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_entityMutex);
+		for (size_t index = 0; index < count; ++index)
+		{
+			Entity entity = pEntities[index];
+			uint32_t entityIndex = GetEntityIndex(entity);
+			if (entityIndex >= m_entityGenerations.size() || m_entityGenerations[entityIndex] != GetEntityGeneration(entity))
+			{
+				// Already deleted.
+				continue;
+			}
+
+			m_entityGenerations[entityIndex] = (m_entityGenerations[entityIndex] + 1U) & ENTITY_GENERATION_MASK;
+			m_freeEntityIndexes.push_back(entityIndex);
+		}
+	}
+
 private:
+	mutable std::mutex m_entityMutex;
+	std::vector<uint32_t> m_entityGenerations;
+	std::deque<uint32_t> m_freeEntityIndexes;
+
+	// Declared before storages so that it is destructed after them.
+	std::unique_ptr<ArchetypeStorage> m_pArchetypeStorage;
 	std::unordered_map<size_t, std::unique_ptr<IComponentsStorage>> m_componentsLib;
 };
 
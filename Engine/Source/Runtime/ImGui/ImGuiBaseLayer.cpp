@@ -24,4 +24,9 @@ SceneWorld* ImGuiBaseLayer::GetSceneWorld() const
 	return GetImGuiContextInstance()->GetSceneWorld();
 }
 
+SystemScheduler* ImGuiBaseLayer::GetSystemScheduler() const
+{
+	return GetImGuiContextInstance()->GetSystemScheduler();
+}
+
 }
\ No newline at end of file
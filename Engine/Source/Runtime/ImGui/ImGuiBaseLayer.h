@@ -7,6 +7,7 @@ class ImGuiContextInstance;
 class RenderContext;
 class ResourceContext;
 class SceneWorld;
+class SystemScheduler;
 
 class ImGuiBaseLayer
 {
@@ -33,6 +34,7 @@ public:
 	ResourceContext* GetResourceContext() const;
 	RenderContext* GetRenderContext() const;
 	SceneWorld* GetSceneWorld() const;
+	SystemScheduler* GetSystemScheduler() const;
 
 protected:
 	const char* m_pName = nullptr;
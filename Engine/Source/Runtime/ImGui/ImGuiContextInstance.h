@@ -15,6 +15,7 @@ namespace engine
 
 class ImGuiBaseLayer;
 class SceneWorld;
+class SystemScheduler;
 
 class ImGuiContextInstance
 {
@@ -62,6 +63,9 @@ public:
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pSceneWorld = pSceneWorld; }
 	SceneWorld* GetSceneWorld() const { return m_pSceneWorld; }
 
+	void SetSystemScheduler(SystemScheduler* pSystemScheduler) { m_pSystemScheduler = pSystemScheduler; }
+	SystemScheduler* GetSystemScheduler() const { return m_pSystemScheduler; }
+
 private:
 	void AddInputEvent();
 	void SetImGuiStyles();
@@ -70,6 +74,7 @@ private:
 
 private:
 	SceneWorld* m_pSceneWorld = nullptr;
+	SystemScheduler* m_pSystemScheduler = nullptr;
 	ImGuiContext* m_pImGuiContext = nullptr;
 	Language m_language;
 	ThemeColor m_themeColor;
@@ -1,5 +1,6 @@
 #include "DebugPanel.h"
 #include "ImGui/IconFont/IconsMaterialDesignIcons.h"
+#include "Rendering/RenderContext.h"
 
 #include <bgfx/bgfx.h>
 #include <bx/string.h>
@@ -136,6 +137,24 @@ void DebugPanel::ShowProfiler()
 	
 		ImGui::Text("GPU mem: %s / %s", tmp0, tmp1);
 	}
+
+	const DrawStats& drawStats = GetRenderContext()->GetLastFrameDrawStats();
+	ImGui::Text("Draws: %u (Instances: %u), Program changes: %u", drawStats.drawCount, drawStats.instanceCount, drawStats.programChangeCount);
+	ImGui::Text("Binds skipped: %u (State: %u, Texture: %u, Uniform: %u)"
+		, drawStats.GetSkippedBindCount()
+		, drawStats.skippedStateBindCount
+		, drawStats.skippedTextureBindCount
+		, drawStats.skippedUniformBindCount
+	);
+	ImGui::Text("Shadow views: %u cached, %u re-rendered", drawStats.cachedShadowViewCount, drawStats.renderedShadowViewCount);
+
+	const RenderGraph* pRenderGraph = GetRenderContext()->GetRenderGraph();
+	ImGui::Text("Render passes: %u / %u, Transient textures: %u (Physical: %u)"
+		, pRenderGraph->GetActivePassCount()
+		, static_cast<uint32_t>(pRenderGraph->GetPassCount())
+		, pRenderGraph->GetTransientTextureCount()
+		, static_cast<uint32_t>(pRenderGraph->GetPhysicalTextureDescs().size())
+	);
 }
 
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Profiler.h"
 #include "ImGui/IconFont/IconsMaterialDesignIcons.h"
+#include "Scheduler/SystemScheduler.h"
 
 #include <bgfx/bgfx.h>
 #include <bx/string.h>
@@ -71,6 +72,7 @@ void Profiler::Update()
     static bool showFrameTime = true;
     static bool showViewStats = true;
     static bool showGPUMemory = true;
+    static bool showSystemStats = true;
 
     // title
     ImGui::Text("Stats");
@@ -186,6 +188,65 @@ void Profiler::Update()
         }
     }
 
+    if (showSystemStats)
+    {
+        ImGui::Separator();
+        ImGui::Text("System stats");
+        const engine::SystemScheduler* pSystemScheduler = GetSystemScheduler();
+        if (pSystemScheduler && pSystemScheduler->GetSystemCount() > 0)
+        {
+            ImGui::Text("Threads: %u", pSystemScheduler->GetThreadCount());
+            ImGui::Text("Total: %.2f ms", pSystemScheduler->GetFrameTime());
+
+            ImVec4 mainThreadColor(0.5f, 1.0f, 0.5f, 1.0f);
+            ImVec4 workerThreadColor(1.0f, 0.7f, 0.3f, 1.0f);
+
+            const float itemHeight = ImGui::GetTextLineHeightWithSpacing();
+            const float itemHeightWithSpacing = ImGui::GetFrameHeightWithSpacing();
+            const float scale = 2.0f;
+            const int systemCount = static_cast<int>(pSystemScheduler->GetSystemCount());
+
+            if (ImGui::BeginListBox("##SystemStats", ImVec2(overlayWidth, std::min(systemCount, 10) * itemHeightWithSpacing)))
+            {
+                ImGuiListClipper clipper;
+                clipper.Begin(systemCount, itemHeight);
+
+                while (clipper.Step())
+                {
+                    for (int32_t pos = clipper.DisplayStart; pos < clipper.DisplayEnd; ++pos)
+                    {
+                        engine::SystemScheduler::SystemID systemID = static_cast<engine::SystemScheduler::SystemID>(pos);
+                        const std::string& systemName = pSystemScheduler->GetSystemName(systemID);
+                        const engine::SystemScheduler::SystemStats& systemStats = pSystemScheduler->GetSystemStats(systemID);
+                        float elapsed = systemStats.endTime - systemStats.beginTime;
+                        bool isMainThread = engine::SystemScheduler::MainThreadIndex == systemStats.threadIndex;
+
+                        ImGui::TextUnformatted(systemName.c_str());
+
+                        const float maxWidth = overlayWidth * 0.35f;
+                        const float width = bx::clamp(elapsed * scale, 1.0f, maxWidth);
+
+                        ImGui::SameLine(overlayWidth * 0.6f);
+
+                        if (DrawBar(systemName.c_str(), width, maxWidth, itemHeight, isMainThread ? mainThreadColor : workerThreadColor))
+                        {
+                            ImGui::SetTooltip("%s -- %.2f ms, starts at %.2f ms on thread %u", systemName.c_str(), elapsed,
+                                systemStats.beginTime, systemStats.threadIndex);
+                        }
+                    }
+                }
+
+                clipper.End();
+
+                ImGui::EndListBox();
+            }
+        }
+        else
+        {
+            ImGui::TextWrapped("No systems");
+        }
+    }
+
     if (showGPUMemory)
     {
         int64_t used = stats->gpuMemoryUsed;
@@ -234,6 +295,7 @@ void Profiler::Update()
         ImGui::Checkbox("Frame time", &showFrameTime);
         ImGui::Checkbox("View stats", &showViewStats);
         ImGui::Checkbox("GPU memory", &showGPUMemory);
+        ImGui::Checkbox("System stats", &showSystemStats);
         ImGui::EndPopup();
     }
     ImGui::End();
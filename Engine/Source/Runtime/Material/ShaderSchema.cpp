@@ -21,6 +21,11 @@ void ShaderSchema::Build()
 
 	for (const auto& featureSet : m_shaderFeatureSets)
 	{
+		if (m_lazyFeatureSets.find(featureSet) != m_lazyFeatureSets.end())
+		{
+			continue;
+		}
+
 		for (const auto& feature : featureSet)
 		{
 			std::string newFeatureName = GetFeatureName(feature);
@@ -68,6 +73,7 @@ void ShaderSchema::CleanAll()
 	m_isDirty = false;
 
 	m_shaderFeatureSets.clear();
+	m_lazyFeatureSets.clear();
 }
 
 void ShaderSchema::AddFeatureSet(ShaderFeatureSet featureSet)
@@ -89,6 +95,16 @@ void ShaderSchema::AddFeatureSet(ShaderFeatureSet featureSet)
 	m_shaderFeatureSets.insert(cd::MoveTemp(featureSet));
 }
 
+void ShaderSchema::AddLazyFeatureSet(ShaderFeatureSet featureSet)
+{
+	size_t featureSetCount = m_shaderFeatureSets.size();
+	AddFeatureSet(featureSet);
+	if (m_shaderFeatureSets.size() > featureSetCount)
+	{
+		m_lazyFeatureSets.insert(cd::MoveTemp(featureSet));
+	}
+}
+
 std::optional<ShaderFeatureSet> ShaderSchema::GetConflictFeatureSet(const ShaderFeature feature) const
 {
 	for (const auto& shaderFeatureSet : m_shaderFeatureSets)
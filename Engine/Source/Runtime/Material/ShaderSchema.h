@@ -50,6 +50,9 @@ public:
 	void CleanAll();
 
 	void AddFeatureSet(ShaderFeatureSet featureSet);
+	// Lazy feature sets are known by materials but their permutations are not in GetAllFeatureCombines().
+	// Variants which use them are registered and compiled on first use.
+	void AddLazyFeatureSet(ShaderFeatureSet featureSet);
 	std::optional<ShaderFeatureSet> GetConflictFeatureSet(const ShaderFeature feature) const;
 	std::string GetFeaturesCombine(const ShaderFeatureSet& featureSet) const;
 
@@ -65,6 +68,7 @@ private:
 	bool m_isDirty = false;
 	// Registration order of shader feature sets.
 	std::set<ShaderFeatureSet> m_shaderFeatureSets;
+	std::set<ShaderFeatureSet> m_lazyFeatureSets;
 	// All permutations matching the registered shader features.
 	std::set<std::string> m_allFeatureCombines;
 };
@@ -75,7 +75,8 @@ void Process::Run()
 
 void Process::PrintSubProcessLog(OutputType outputType, subprocess_s* const pSubProcess, SubProcessReadLogFunction readMethod)
 {
-	static char processOutputData[65536] = { 0 };
+	// Processes run in parallel threads of ResourceBuilder.
+	thread_local char processOutputData[65536] = { 0 };
 	uint32_t processOutputDataIndex = 0U;
 	uint32_t processOutputDataReadBytes = 0U;
 
@@ -85,6 +86,7 @@ void Process::PrintSubProcessLog(OutputType outputType, subprocess_s* const pSub
 		processOutputDataIndex += processOutputDataReadBytes;
 	}
 	while (processOutputDataReadBytes != 0U);
+	processOutputData[processOutputDataIndex] = '\0';
 
 	if (processOutputDataIndex > 0U)
 	{
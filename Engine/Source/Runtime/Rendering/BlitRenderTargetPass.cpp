@@ -14,6 +14,15 @@ BlitRenderTargetPass::~BlitRenderTargetPass()
 {
 }
 
+void BlitRenderTargetPass::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
+{
+	// Copies are culled if no pass samples them.
+	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
+	constexpr StringCrc sceneRenderTargetBlit("SceneRenderTargetBlit");
+	pRenderGraph->Read(passID, pRenderGraph->ImportResource(sceneRenderTarget));
+	pRenderGraph->Write(passID, pRenderGraph->ImportResource(sceneRenderTargetBlit));
+}
+
 void BlitRenderTargetPass::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
 {
 }
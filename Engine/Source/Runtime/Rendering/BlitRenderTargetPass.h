@@ -14,6 +14,7 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
+	virtual void SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID) override;
 
 private:
 	uint16_t m_blitTextureWidth;
@@ -27,6 +27,17 @@ constexpr StringCrc UpSampleProgramCrc{ UpSampleProgram };
 constexpr StringCrc KawaseBlurProgramCrc{ KawaseBlurProgram };
 constexpr StringCrc CombineProgramCrc{ CombineProgram };
 
+constexpr StringCrc SampleChainTextureCrcs[TEX_CHAIN_LEN] =
+{
+	StringCrc("BloomSampleChain0"), StringCrc("BloomSampleChain1"), StringCrc("BloomSampleChain2"),
+	StringCrc("BloomSampleChain3"), StringCrc("BloomSampleChain4"), StringCrc("BloomSampleChain5"),
+	StringCrc("BloomSampleChain6"), StringCrc("BloomSampleChain7"), StringCrc("BloomSampleChain8"),
+};
+constexpr StringCrc BlurChainTextureCrcs[2] = { StringCrc("BloomBlurChain0"), StringCrc("BloomBlurChain1") };
+constexpr StringCrc CombineTextureCrc("BloomCombine");
+
+constexpr uint64_t TextureFlags = BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
 }
 
 void BloomRenderer::Init()
@@ -103,50 +114,62 @@ bool BloomRenderer::IsEnable() const
 	return pCameraComponent->GetIsBloomEnable();
 }
 
-void BloomRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
+void BloomRenderer::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
 {
-	uint16_t tempW = 0;
-	uint16_t tempH = 0;
 	if (m_pRenderTarget)
 	{
-		tempW = GetRenderTarget()->GetWidth();
-		tempH = GetRenderTarget()->GetHeight();
+		m_width = GetRenderTarget()->GetWidth();
+		m_height = GetRenderTarget()->GetHeight();
 	}
 	else
 	{
-		tempW = GetRenderContext()->GetBackBufferWidth();
-		tempH = GetRenderContext()->GetBackBufferHeight();
+		m_width = GetRenderContext()->GetBackBufferWidth();
+		m_height = GetRenderContext()->GetBackBufferHeight();
 	}
 
-	if (m_width != tempW || m_height != tempH)
-	{
-		m_width = tempW;
-		m_height = tempH;
+	// Bloom adds to the lighting result in place. It is the blit copy when output is the scene render target.
+	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
+	constexpr StringCrc sceneRenderTargetBlit("SceneRenderTargetBlit");
+	RenderGraph::ResourceID lightingResult = pRenderGraph->ImportResource(m_pRenderTarget ? sceneRenderTargetBlit : sceneRenderTarget);
+	pRenderGraph->Read(passID, lightingResult);
+	pRenderGraph->Write(passID, lightingResult);
 
-		Entity entity = m_pCurrentSceneWorld->GetMainCameraEntity();
-		CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(entity);
+	Entity entity = m_pCurrentSceneWorld->GetMainCameraEntity();
+	CameraComponent* pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(entity);
 
-		constexpr uint64_t tsFlags = 0 | BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
-		for (int ii = 0; ii < TEX_CHAIN_LEN; ++ii)
+	// Chain textures are released by the render graph when bloom is disabled.
+	for (int ii = 0; ii < TEX_CHAIN_LEN; ++ii)
+	{
+		int viewWidth = m_width >> ii;
+		int viewHeight = m_height >> ii;
+		if (viewWidth < 2 || viewHeight < 2)
 		{
-			if (bgfx::isValid(m_sampleChainFB[ii]))
-			{
-				bgfx::destroy(m_sampleChainFB[ii]);
-			}
-
-			int viewWidth = m_width >> ii;
-			int viewHeight = m_height >> ii;
-			if (viewWidth < 2 || viewHeight < 2)
-			{
-				pCameraComponent->SetBloomDownSampleMaxTimes(std::max(ii - 1, 0));
-				break;
-			}
-
-			m_sampleChainFB[ii] = bgfx::createFrameBuffer(viewWidth, viewHeight, bgfx::TextureFormat::RGBA32F, tsFlags);
+			pCameraComponent->SetBloomDownSampleMaxTimes(std::max(ii - 1, 0));
+			break;
 		}
 
-		m_combineFB = bgfx::createFrameBuffer(m_width, m_height, bgfx::TextureFormat::RGBA32F, tsFlags);
+		RenderGraphTextureDesc desc{ static_cast<uint16_t>(viewWidth), static_cast<uint16_t>(viewHeight), bgfx::TextureFormat::RGBA32F, TextureFlags };
+		pRenderGraph->Write(passID, pRenderGraph->CreateTexture(SampleChainTextureCrcs[ii], desc));
+	}
+
+	if (pCameraComponent->GetIsBlurEnable() && pCameraComponent->GetBlurTimes() != 0)
+	{
+		int sampleTimes = std::min(pCameraComponent->GetBloomDownSampleTimes(), pCameraComponent->GetBloomDownSampleMaxTimes());
+		uint16_t blurWidth = static_cast<uint16_t>((m_width >> sampleTimes) / pCameraComponent->GetBlurScaling());
+		uint16_t blurHeight = static_cast<uint16_t>((m_height >> sampleTimes) / pCameraComponent->GetBlurScaling());
+		for (int ii = 0; ii < 2; ++ii)
+		{
+			RenderGraphTextureDesc desc{ blurWidth, blurHeight, bgfx::TextureFormat::RGBA32F, TextureFlags };
+			pRenderGraph->Write(passID, pRenderGraph->CreateTexture(BlurChainTextureCrcs[ii], desc));
+		}
 	}
+
+	RenderGraphTextureDesc combineDesc{ m_width, m_height, bgfx::TextureFormat::RGBA32F, TextureFlags };
+	pRenderGraph->Write(passID, pRenderGraph->CreateTexture(CombineTextureCrc, combineDesc));
+}
+
+void BloomRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
+{
 }
 
 void BloomRenderer::Render(float deltaTime)
@@ -160,6 +183,16 @@ void BloomRenderer::Render(float deltaTime)
 		}
 	}
 
+	for (int ii = 0; ii < TEX_CHAIN_LEN; ++ii)
+	{
+		m_sampleChainFB[ii] = GetRenderContext()->GetTransientFrameBuffer(SampleChainTextureCrcs[ii]);
+	}
+	for (int ii = 0; ii < 2; ++ii)
+	{
+		m_blurChainFB[ii] = GetRenderContext()->GetTransientFrameBuffer(BlurChainTextureCrcs[ii]);
+	}
+	m_combineFB = GetRenderContext()->GetTransientFrameBuffer(CombineTextureCrc);
+
 	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
 
 	const RenderTarget* pInputRT = GetRenderContext()->GetRenderTarget(sceneRenderTarget);
@@ -298,16 +331,10 @@ void BloomRenderer::Render(float deltaTime)
 
 void BloomRenderer::Blur(uint16_t width, uint16_t height, int iteration, float blursize, int blurscaling, cd::Matrix4x4 ortho, bgfx::TextureHandle texture)
 {
+	// Blur chain frame buffers are allocated by SetupRenderPass with the same size.
 	width = static_cast<int>(width / blurscaling);
 	height = static_cast<int>(height / blurscaling);
 
-	const uint64_t tsFlags = 0 | BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
-	for (int ii = 0; ii < 2; ++ii)
-	{
-		if (bgfx::isValid(m_blurChainFB[ii])) bgfx::destroy(m_blurChainFB[ii]);
-		m_blurChainFB[ii] = bgfx::createFrameBuffer(width, height, bgfx::TextureFormat::RGBA32F, tsFlags);
-	}
-
 	uint16_t verticalViewID = m_startVerticalBlurPassID;
 	uint16_t horizontalViewID = m_startHorizontalBlurPassID;
 	for (int i = 0; i < iteration; i++)
@@ -18,6 +18,7 @@ namespace engine
 		virtual void Init() override;
 		virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 		virtual void Render(float deltaTime) override;
+		virtual void SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID) override;
 
 		virtual void SetEnable(bool value) override;
 		virtual bool IsEnable() const override;
@@ -30,12 +31,13 @@ namespace engine
 
 		SceneWorld* m_pCurrentSceneWorld = nullptr;
 
+		// Transient frame buffers from the render graph. They are refreshed every frame.
 		bgfx::FrameBufferHandle m_blurChainFB[2];
 		bgfx::FrameBufferHandle m_sampleChainFB[TEX_CHAIN_LEN];
 		bgfx::FrameBufferHandle m_combineFB;
 
-		uint16_t m_width;
-		uint16_t m_height;
+		uint16_t m_width = 0;
+		uint16_t m_height = 0;
 
 		uint16_t m_startDowmSamplePassID;
 		uint16_t m_startVerticalBlurPassID;
@@ -5,6 +5,7 @@
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
+#include "LightUniforms.h"
 #include "Material/ShaderSchema.h"
 #include "RenderContext.h"
 #include "Rendering/DDGIDefinition.h"
@@ -207,6 +208,20 @@ void DDGIRenderer::Render(float deltaTime)
 	const engine::CameraComponent *pCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
 	const engine::TransformComponent* pCameraTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
 
+	// Components can be moved when other components are added or removed so that look up them every frame.
+	m_pDDGIComponent = m_pCurrentSceneWorld->GetDDGIComponent(m_pCurrentSceneWorld->GetDDGIEntity());
+
+	// Light components are not guaranteed to be contiguous in component storage so that copy them into one array.
+	std::vector<U_Light> lightParamsData;
+	for (Entity lightEntity : m_pCurrentSceneWorld->GetLightEntities())
+	{
+		if (lightParamsData.size() >= MAX_LIGHT_COUNT)
+		{
+			break;
+		}
+		lightParamsData.push_back(*m_pCurrentSceneWorld->GetLightComponent(lightEntity)->GetLightUniformData());
+	}
+
 	for(Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
 	{
 		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
@@ -252,17 +267,14 @@ void DDGIRenderer::Render(float deltaTime)
 
 		GetRenderContext()->FillUniform(StringCrc(cameraPos), &pCameraTransformComponent->GetTransform().GetTranslation().x(), 1);
 
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
+		size_t lightCount = lightParamsData.size();
 		static cd::Vec4f lightInfoData(0.0f, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
+		lightInfoData.x() = static_cast<float>(lightCount);
 		GetRenderContext()->FillUniform(StringCrc(lightCountAndStride), lightInfoData.Begin(), 1);
 
-		if (lightEntityCount > 0)
+		if (lightCount > 0)
 		{
-			// Light component storage has continus memory address and layout.
-			float *pLightDataBegin = reinterpret_cast<float *>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
-			GetRenderContext()->FillUniform(StringCrc(lightParams), pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+			GetRenderContext()->FillUniform(StringCrc(lightParams), lightParamsData.data(), static_cast<uint16_t>(lightCount * LightUniform::LIGHT_STRIDE));
 		}
 
 		GetRenderContext()->FillUniform(StringCrc(volumeOrigin), &m_pDDGIComponent->GetVolumeOrigin().x(), 1);
@@ -0,0 +1,174 @@
+#include "DrawStateCache.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+uint32_t GetUniformElementSize(bgfx::UniformHandle uniform)
+{
+	bgfx::UniformInfo info;
+	bgfx::getUniformInfo(uniform, info);
+	switch (info.type)
+	{
+	case bgfx::UniformType::Sampler:
+		return sizeof(int32_t);
+	case bgfx::UniformType::Mat3:
+		return sizeof(float) * 9;
+	case bgfx::UniformType::Mat4:
+		return sizeof(float) * 16;
+	default:
+		return sizeof(float) * 4;
+	}
+}
+
+}
+
+void DrawStats::Merge(const DrawStats& other)
+{
+	drawCount += other.drawCount;
+	instanceCount += other.instanceCount;
+	programChangeCount += other.programChangeCount;
+	stateBindCount += other.stateBindCount;
+	textureBindCount += other.textureBindCount;
+	uniformBindCount += other.uniformBindCount;
+	skippedStateBindCount += other.skippedStateBindCount;
+	skippedTextureBindCount += other.skippedTextureBindCount;
+	skippedUniformBindCount += other.skippedUniformBindCount;
+	cachedShadowViewCount += other.cachedShadowViewCount;
+	renderedShadowViewCount += other.renderedShadowViewCount;
+}
+
+void DrawStateCache::Reset()
+{
+	m_state = 0U;
+	m_isStateValid = false;
+	m_programHandle = bgfx::kInvalidHandle;
+	for (TextureBinding& binding : m_textureBindings)
+	{
+		binding.isValid = false;
+	}
+
+	// Keep allocated buffers for next view.
+	for (auto& [handle, value] : m_uniformValues)
+	{
+		value.data.clear();
+	}
+}
+
+void DrawStateCache::SetState(uint64_t state)
+{
+	if (m_isStateValid && m_state == state)
+	{
+		++m_stats.skippedStateBindCount;
+		return;
+	}
+
+	if (m_pEncoder)
+	{
+		m_pEncoder->setState(state);
+	}
+	else
+	{
+		bgfx::setState(state);
+	}
+	m_state = state;
+	m_isStateValid = true;
+	++m_stats.stateBindCount;
+}
+
+bool DrawStateCache::BindTextureSlot(uint8_t slot, uint64_t key)
+{
+	assert(slot < MaxTextureSlotCount);
+	TextureBinding& binding = m_textureBindings[slot];
+	if (binding.isValid && binding.key == key)
+	{
+		++m_stats.skippedTextureBindCount;
+		return false;
+	}
+
+	binding.key = key;
+	binding.isValid = true;
+	++m_stats.textureBindCount;
+	return true;
+}
+
+void DrawStateCache::SetTexture(uint8_t slot, bgfx::UniformHandle sampler, bgfx::TextureHandle texture)
+{
+	uint64_t key = static_cast<uint64_t>(sampler.idx) << 16 | texture.idx;
+	if (BindTextureSlot(slot, key))
+	{
+		if (m_pEncoder)
+		{
+			m_pEncoder->setTexture(slot, sampler, texture);
+		}
+		else
+		{
+			bgfx::setTexture(slot, sampler, texture);
+		}
+	}
+}
+
+void DrawStateCache::SetImage(uint8_t slot, bgfx::TextureHandle texture, uint8_t mip, bgfx::Access::Enum access, bgfx::TextureFormat::Enum format)
+{
+	// Highest bit separates images from textures in the same slot.
+	uint64_t key = static_cast<uint64_t>(1) << 63 | static_cast<uint64_t>(format) << 32 | static_cast<uint64_t>(access) << 24 |
+		static_cast<uint64_t>(mip) << 16 | texture.idx;
+	if (BindTextureSlot(slot, key))
+	{
+		if (m_pEncoder)
+		{
+			m_pEncoder->setImage(slot, texture, mip, access, format);
+		}
+		else
+		{
+			bgfx::setImage(slot, texture, mip, access, format);
+		}
+	}
+}
+
+void DrawStateCache::SetUniform(bgfx::UniformHandle uniform, const void* pData, uint16_t num)
+{
+	auto itValue = m_uniformValues.find(uniform.idx);
+	if (itValue == m_uniformValues.end())
+	{
+		itValue = m_uniformValues.emplace(uniform.idx, UniformValue{ GetUniformElementSize(uniform), {} }).first;
+	}
+
+	UniformValue& value = itValue->second;
+	size_t dataSize = static_cast<size_t>(value.elementSize) * num;
+	if (value.data.size() == dataSize && 0 == std::memcmp(value.data.data(), pData, dataSize))
+	{
+		++m_stats.skippedUniformBindCount;
+		return;
+	}
+
+	if (m_pEncoder)
+	{
+		m_pEncoder->setUniform(uniform, pData, num);
+	}
+	else
+	{
+		bgfx::setUniform(uniform, pData, num);
+	}
+	value.data.resize(dataSize);
+	std::memcpy(value.data.data(), pData, dataSize);
+	++m_stats.uniformBindCount;
+}
+
+void DrawStateCache::OnDraw(uint16_t programHandle, uint32_t instanceCount)
+{
+	++m_stats.drawCount;
+	m_stats.instanceCount += instanceCount;
+	if (programHandle != m_programHandle)
+	{
+		m_programHandle = programHandle;
+		++m_stats.programChangeCount;
+	}
+}
+
+}
\ No newline at end of file
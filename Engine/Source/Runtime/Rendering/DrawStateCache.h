@@ -0,0 +1,93 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+struct DrawStats
+{
+	uint32_t drawCount = 0U;
+	uint32_t instanceCount = 0U;
+	uint32_t programChangeCount = 0U;
+	uint32_t stateBindCount = 0U;
+	uint32_t textureBindCount = 0U;
+	uint32_t uniformBindCount = 0U;
+	uint32_t skippedStateBindCount = 0U;
+	uint32_t skippedTextureBindCount = 0U;
+	uint32_t skippedUniformBindCount = 0U;
+	uint32_t cachedShadowViewCount = 0U;
+	uint32_t renderedShadowViewCount = 0U;
+
+	void Reset() { *this = DrawStats(); }
+	void Merge(const DrawStats& other);
+	uint32_t GetSkippedBindCount() const { return skippedStateBindCount + skippedTextureBindCount + skippedUniformBindCount; }
+};
+
+// DrawStateCache remembers render state, texture bindings and uniform values which were set in current view
+// so that sorted draws only bind what changed. Draws have to be submitted with KeepBindingsDiscardFlags and
+// the view should use bgfx::ViewMode::Sequential, otherwise bgfx reorders draws and skipped binds are lost.
+// Binds go to the encoder when one is set. Every encoder needs its own cache because encoders don't share bindings.
+class DrawStateCache
+{
+public:
+	static constexpr uint8_t KeepBindingsDiscardFlags = BGFX_DISCARD_INDEX_BUFFER | BGFX_DISCARD_VERTEX_STREAMS |
+		BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_INSTANCE_DATA;
+	static constexpr uint8_t MaxTextureSlotCount = 32U;
+
+public:
+	DrawStateCache() { Reset(); }
+	DrawStateCache(const DrawStateCache&) = delete;
+	DrawStateCache& operator=(const DrawStateCache&) = delete;
+	DrawStateCache(DrawStateCache&&) = default;
+	DrawStateCache& operator=(DrawStateCache&&) = default;
+	~DrawStateCache() = default;
+
+	// Should be called before the first draw of a view because bgfx state is unknown at that time.
+	void Reset();
+
+	// nullptr to bind through bgfx API on main thread.
+	void SetEncoder(bgfx::Encoder* pEncoder) { m_pEncoder = pEncoder; }
+	bgfx::Encoder* GetEncoder() const { return m_pEncoder; }
+
+	void SetState(uint64_t state);
+	void SetTexture(uint8_t slot, bgfx::UniformHandle sampler, bgfx::TextureHandle texture);
+	void SetImage(uint8_t slot, bgfx::TextureHandle texture, uint8_t mip, bgfx::Access::Enum access, bgfx::TextureFormat::Enum format);
+	void SetUniform(bgfx::UniformHandle uniform, const void* pData, uint16_t num = 1);
+
+	// Call once per submitted draw to count program changes.
+	void OnDraw(uint16_t programHandle, uint32_t instanceCount = 1U);
+
+	const DrawStats& GetStats() const { return m_stats; }
+	void ResetStats() { m_stats.Reset(); }
+
+private:
+	struct TextureBinding
+	{
+		uint64_t key;
+		bool isValid;
+	};
+
+	struct UniformValue
+	{
+		uint32_t elementSize;
+		std::vector<uint8_t> data;
+	};
+
+	bool BindTextureSlot(uint8_t slot, uint64_t key);
+
+private:
+	bgfx::Encoder* m_pEncoder = nullptr;
+	uint64_t m_state;
+	bool m_isStateValid;
+	uint16_t m_programHandle;
+	TextureBinding m_textureBindings[MaxTextureSlotCount];
+	std::unordered_map<uint16_t, UniformValue> m_uniformValues;
+	DrawStats m_stats;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace engine
+{
+
+void LightClusters::Reset(const cd::Matrix4x4& viewMatrix, const cd::Matrix4x4& projectionMatrix, float nearPlane, float farPlane)
+{
+	assert(nearPlane > 0.0f && farPlane > nearPlane);
+	m_viewMatrix = viewMatrix;
+	m_projectionMatrix = projectionMatrix;
+	m_nearPlane = nearPlane;
+	m_farPlane = farPlane;
+
+	// slice = log(depth / near) / log(far / near) * Z
+	float logDepthRange = std::log(farPlane / nearPlane);
+	m_depthSliceScale = static_cast<float>(ClusterCountZ) / logDepthRange;
+	m_depthSliceBias = -static_cast<float>(ClusterCountZ) * std::log(nearPlane) / logDepthRange;
+
+	m_lightBounds.clear();
+}
+
+void LightClusters::AddPointLight(uint16_t lightIndex, const cd::Point& position, float range)
+{
+	AddLightBounds(lightIndex, position, range);
+}
+
+void LightClusters::AddSpotLight(uint16_t lightIndex, const cd::Point& position, const cd::Direction& direction, float range, float outerAngle)
+{
+	// Smallest sphere around the cone. Wide cones are bounded by their cap, narrow ones by the apex and the cap rim.
+	float cosAngle = std::cos(outerAngle);
+	if (cosAngle < 0.70710678f)
+	{
+		AddLightBounds(lightIndex, position + direction * (range * cosAngle), range * std::sin(outerAngle));
+	}
+	else
+	{
+		float radius = range / (2.0f * cosAngle);
+		AddLightBounds(lightIndex, position + direction * radius, radius);
+	}
+}
+
+void LightClusters::AddLightBounds(uint16_t lightIndex, const cd::Point& center, float radius)
+{
+	cd::Vec4f viewCenter = m_viewMatrix * cd::Vec4f(center.x(), center.y(), center.z(), 1.0f);
+	m_lightBounds.push_back(LightBounds{ cd::Vec3f(viewCenter.x(), viewCenter.y(), viewCenter.z()), radius, lightIndex });
+}
+
+uint32_t LightClusters::GetDepthSlice(float viewDepth) const
+{
+	float slice = std::floor(std::log(std::max(viewDepth, std::numeric_limits<float>::min())) * m_depthSliceScale + m_depthSliceBias);
+	return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(ClusterCountZ - 1)));
+}
+
+float LightClusters::GetSliceDepth(uint32_t slice) const
+{
+	return m_nearPlane * std::pow(m_farPlane / m_nearPlane, static_cast<float>(slice) / static_cast<float>(ClusterCountZ));
+}
+
+template<typename Func>
+void LightClusters::ForEachCluster(const LightBounds& lightBounds, Func&& func) const
+{
+	const cd::Vec3f& center = lightBounds.viewCenter;
+	float radius = lightBounds.radius;
+	float minDepth = std::max(center.z() - radius, m_nearPlane);
+	float maxDepth = std::min(center.z() + radius, m_farPlane);
+	if (minDepth > maxDepth)
+	{
+		return;
+	}
+
+	uint32_t lastSlice = GetDepthSlice(maxDepth);
+	for (uint32_t slice = GetDepthSlice(minDepth); slice <= lastSlice; ++slice)
+	{
+		float sliceMinDepth = std::max(GetSliceDepth(slice), minDepth);
+		float sliceMaxDepth = std::min(GetSliceDepth(slice + 1U), maxDepth);
+
+		// Sphere is cut by the slice. Use the largest section inside the slice.
+		float depthDistance = std::max({ sliceMinDepth - center.z(), center.z() - sliceMaxDepth, 0.0f });
+		float sectionRadius = std::sqrt(std::max(radius * radius - depthDistance * depthDistance, 0.0f));
+
+		// Screen bounds of the box around the section. Depth is positive so the box projects into the hull of its corners.
+		float minX = std::numeric_limits<float>::max();
+		float maxX = std::numeric_limits<float>::lowest();
+		float minY = std::numeric_limits<float>::max();
+		float maxY = std::numeric_limits<float>::lowest();
+		for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+		{
+			cd::Vec4f corner((cornerIndex & 1U) ? center.x() + sectionRadius : center.x() - sectionRadius,
+				(cornerIndex & 2U) ? center.y() + sectionRadius : center.y() - sectionRadius,
+				(cornerIndex & 4U) ? sliceMaxDepth : sliceMinDepth, 1.0f);
+			cd::Vec4f clipCorner = m_projectionMatrix * corner;
+			float ndcX = clipCorner.x() / clipCorner.w();
+			float ndcY = clipCorner.y() / clipCorner.w();
+			minX = std::min(minX, ndcX);
+			maxX = std::max(maxX, ndcX);
+			minY = std::min(minY, ndcY);
+			maxY = std::max(maxY, ndcY);
+		}
+
+		if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+		{
+			continue;
+		}
+
+		auto GetTile = [](float ndc, uint32_t tileCount)
+		{
+			float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(tileCount));
+			return static_cast<uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(tileCount - 1)));
+		};
+
+		uint32_t firstX = GetTile(minX, ClusterCountX);
+		uint32_t lastX = GetTile(maxX, ClusterCountX);
+		uint32_t firstY = GetTile(minY, ClusterCountY);
+		uint32_t lastY = GetTile(maxY, ClusterCountY);
+		for (uint32_t y = firstY; y <= lastY; ++y)
+		{
+			for (uint32_t x = firstX; x <= lastX; ++x)
+			{
+				func(x + y * ClusterCountX + slice * ClusterCountX * ClusterCountY);
+			}
+		}
+	}
+}
+
+void LightClusters::Build()
+{
+	// Count lights per cluster, then fill light indices by the offsets. Two passes avoid lists per cluster.
+	m_clusterLightCounts.assign(ClusterCount, 0U);
+	for (const LightBounds& lightBounds : m_lightBounds)
+	{
+		ForEachCluster(lightBounds, [this](uint32_t clusterIndex)
+		{
+			++m_clusterLightCounts[clusterIndex];
+		});
+	}
+
+	m_clusterOffsets.resize(ClusterCount);
+	m_droppedLightIndexCount = 0U;
+	uint32_t lightIndexCount = 0U;
+	for (uint32_t clusterIndex = 0U; clusterIndex < ClusterCount; ++clusterIndex)
+	{
+		uint32_t lightCount = std::min(m_clusterLightCounts[clusterIndex], MaxLightIndexCount - lightIndexCount);
+		m_droppedLightIndexCount += m_clusterLightCounts[clusterIndex] - lightCount;
+		m_clusterOffsets[clusterIndex] = lightIndexCount;
+		m_clusterLightCounts[clusterIndex] = lightCount;
+		lightIndexCount += lightCount;
+	}
+
+	m_lightIndices.resize(lightIndexCount);
+	std::vector<uint32_t> clusterCursors(m_clusterOffsets);
+	for (const LightBounds& lightBounds : m_lightBounds)
+	{
+		ForEachCluster(lightBounds, [this, &clusterCursors, &lightBounds](uint32_t clusterIndex)
+		{
+			uint32_t& cursor = clusterCursors[clusterIndex];
+			if (cursor < m_clusterOffsets[clusterIndex] + m_clusterLightCounts[clusterIndex])
+			{
+				m_lightIndices[cursor++] = lightBounds.lightIndex;
+			}
+		});
+	}
+
+	// Offsets in the texture are texel indices so light indices start after cluster ranges.
+	m_textureData.resize(TextureWidth * TextureHeight * 2U);
+	for (uint32_t clusterIndex = 0U; clusterIndex < ClusterCount; ++clusterIndex)
+	{
+		m_textureData[clusterIndex * 2U] = static_cast<float>(ClusterCount + m_clusterOffsets[clusterIndex]);
+		m_textureData[clusterIndex * 2U + 1U] = static_cast<float>(m_clusterLightCounts[clusterIndex]);
+	}
+	for (uint32_t index = 0U; index < lightIndexCount; ++index)
+	{
+		m_textureData[(ClusterCount + index) * 2U] = static_cast<float>(m_lightIndices[index]);
+		m_textureData[(ClusterCount + index) * 2U + 1U] = 0.0f;
+	}
+}
+
+uint32_t LightClusters::GetClusterLightCount(uint32_t x, uint32_t y, uint32_t z) const
+{
+	return m_clusterLightCounts[x + y * ClusterCountX + z * ClusterCountX * ClusterCountY];
+}
+
+uint16_t LightClusters::GetClusterLightIndex(uint32_t x, uint32_t y, uint32_t z, uint32_t index) const
+{
+	uint32_t clusterIndex = x + y * ClusterCountX + z * ClusterCountX * ClusterCountY;
+	assert(index < m_clusterLightCounts[clusterIndex]);
+	return m_lightIndices[m_clusterOffsets[clusterIndex] + index];
+}
+
+uint16_t LightClusters::GetTextureRowCount() const
+{
+	uint32_t texelCount = ClusterCount + GetLightIndexCount();
+	return static_cast<uint16_t>((texelCount + TextureWidth - 1U) / TextureWidth);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Light.h"
+#include "Math/Matrix.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// LightClusters bins local lights into clusters of the camera frustum on CPU. Clusters are uniform in screen space
+// and exponential in view depth so that near clusters stay small. Every cluster stores an offset and a count of a flat
+// light index list, and both are packed into one RG32F texture : cluster ranges first, light indices after them.
+class LightClusters
+{
+public:
+	static constexpr uint32_t ClusterCountX = LIGHT_CLUSTER_X;
+	static constexpr uint32_t ClusterCountY = LIGHT_CLUSTER_Y;
+	static constexpr uint32_t ClusterCountZ = LIGHT_CLUSTER_Z;
+	static constexpr uint32_t ClusterCount = ClusterCountX * ClusterCountY * ClusterCountZ;
+	static constexpr uint32_t TextureWidth = LIGHT_CLUSTER_TEXTURE_WIDTH;
+	static constexpr uint32_t TextureHeight = LIGHT_CLUSTER_TEXTURE_HEIGHT;
+	static constexpr uint32_t MaxLightIndexCount = TextureWidth * TextureHeight - ClusterCount;
+
+public:
+	LightClusters() = default;
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+	LightClusters(LightClusters&&) = default;
+	LightClusters& operator=(LightClusters&&) = default;
+	~LightClusters() = default;
+
+	// Camera matrices should be left handed so that view depth increases along +z.
+	void Reset(const cd::Matrix4x4& viewMatrix, const cd::Matrix4x4& projectionMatrix, float nearPlane, float farPlane);
+
+	// lightIndex : row of the light in light parameters texture.
+	void AddPointLight(uint16_t lightIndex, const cd::Point& position, float range);
+	void AddSpotLight(uint16_t lightIndex, const cd::Point& position, const cd::Direction& direction, float range, float outerAngle);
+
+	void Build();
+
+	// Shaders compute the slice by log(viewDepth) * scale + bias.
+	uint32_t GetDepthSlice(float viewDepth) const;
+	float GetDepthSliceScale() const { return m_depthSliceScale; }
+	float GetDepthSliceBias() const { return m_depthSliceBias; }
+
+	uint32_t GetClusterLightCount(uint32_t x, uint32_t y, uint32_t z) const;
+	uint16_t GetClusterLightIndex(uint32_t x, uint32_t y, uint32_t z, uint32_t index) const;
+	uint32_t GetLightIndexCount() const { return static_cast<uint32_t>(m_lightIndices.size()); }
+	// Light indices which didn't fit into the texture. Later clusters lose their lights first.
+	uint32_t GetDroppedLightIndexCount() const { return m_droppedLightIndexCount; }
+
+	// RG32F texels. Only rows before GetTextureRowCount() are written in current frame.
+	const std::vector<float>& GetTextureData() const { return m_textureData; }
+	uint16_t GetTextureRowCount() const;
+
+private:
+	struct LightBounds
+	{
+		cd::Vec3f viewCenter;
+		float radius;
+		uint16_t lightIndex;
+	};
+
+	void AddLightBounds(uint16_t lightIndex, const cd::Point& center, float radius);
+	float GetSliceDepth(uint32_t slice) const;
+
+	template<typename Func>
+	void ForEachCluster(const LightBounds& lightBounds, Func&& func) const;
+
+private:
+	cd::Matrix4x4 m_viewMatrix;
+	cd::Matrix4x4 m_projectionMatrix;
+	float m_nearPlane = 0.0f;
+	float m_farPlane = 0.0f;
+	float m_depthSliceScale = 0.0f;
+	float m_depthSliceBias = 0.0f;
+
+	std::vector<LightBounds> m_lightBounds;
+	std::vector<uint32_t> m_clusterOffsets;
+	std::vector<uint32_t> m_clusterLightCounts;
+	std::vector<uint16_t> m_lightIndices;
+	uint32_t m_droppedLightIndexCount = 0U;
+	std::vector<float> m_textureData;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include "MeshLOD.h"
+
+#include "Base/Template.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+
+struct Vector3
+{
+	float x;
+	float y;
+	float z;
+};
+
+Vector3 Subtract(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Dot(const Vector3& a, const Vector3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Sum of area weighted plane equations : error(p) = p'Ap + 2b'p + c.
+struct Quadric
+{
+	double a00 = 0.0;
+	double a01 = 0.0;
+	double a02 = 0.0;
+	double a11 = 0.0;
+	double a12 = 0.0;
+	double a22 = 0.0;
+	double b0 = 0.0;
+	double b1 = 0.0;
+	double b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+
+	void AddPlane(const Vector3& normal, float distance, float planeWeight)
+	{
+		a00 += planeWeight * normal.x * normal.x;
+		a01 += planeWeight * normal.x * normal.y;
+		a02 += planeWeight * normal.x * normal.z;
+		a11 += planeWeight * normal.y * normal.y;
+		a12 += planeWeight * normal.y * normal.z;
+		a22 += planeWeight * normal.z * normal.z;
+		b0 += planeWeight * normal.x * distance;
+		b1 += planeWeight * normal.y * distance;
+		b2 += planeWeight * normal.z * distance;
+		c += planeWeight * distance * distance;
+		weight += planeWeight;
+	}
+
+	void Add(const Quadric& other)
+	{
+		a00 += other.a00;
+		a01 += other.a01;
+		a02 += other.a02;
+		a11 += other.a11;
+		a12 += other.a12;
+		a22 += other.a22;
+		b0 += other.b0;
+		b1 += other.b1;
+		b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+	}
+
+	// Average squared distance to the planes.
+	float GetError(const Vector3& p) const
+	{
+		if (weight <= 0.0)
+		{
+			return 0.0f;
+		}
+
+		double error = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+			2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+			2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+		return static_cast<float>(std::max(error, 0.0) / weight);
+	}
+};
+
+struct Collapse
+{
+	uint32_t fromVertex;
+	uint32_t toVertex;
+	float error;
+};
+
+}
+
+namespace engine
+{
+
+MeshLOD::IndexList MeshLOD::Simplify(std::span<const cd::Point> positions, std::span<const uint32_t> indices, uint32_t targetIndexCount, float maxError)
+{
+	assert(0U == indices.size() % 3U);
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+	// Positions are normalized by mesh extent so that errors are relative.
+	Vector3 minPosition{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 maxPosition{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const cd::Point& position : positions)
+	{
+		minPosition = Vector3{ std::min(minPosition.x, position.x()), std::min(minPosition.y, position.y()), std::min(minPosition.z, position.z()) };
+		maxPosition = Vector3{ std::max(maxPosition.x, position.x()), std::max(maxPosition.y, position.y()), std::max(maxPosition.z, position.z()) };
+	}
+
+	float extent = std::max({ maxPosition.x - minPosition.x, maxPosition.y - minPosition.y, maxPosition.z - minPosition.z });
+	if (!(extent > 0.0f) || indices.size() <= targetIndexCount)
+	{
+		return IndexList(indices.begin(), indices.end());
+	}
+
+	std::vector<Vector3> points(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		const cd::Point& position = positions[vertexIndex];
+		points[vertexIndex] = Vector3{ (position.x() - minPosition.x) / extent, (position.y() - minPosition.y) / extent, (position.z() - minPosition.z) / extent };
+	}
+
+	// Vertices at the same position are corners of one surface point with different attributes, e.g. UV seams.
+	// They share the first of them as position ID.
+	std::vector<uint32_t> sortedVertices(vertexCount);
+	std::iota(sortedVertices.begin(), sortedVertices.end(), 0U);
+	auto PositionLess = [&positions](uint32_t a, uint32_t b)
+	{
+		const cd::Point& pa = positions[a];
+		const cd::Point& pb = positions[b];
+		if (pa.x() != pb.x())
+		{
+			return pa.x() < pb.x();
+		}
+		if (pa.y() != pb.y())
+		{
+			return pa.y() < pb.y();
+		}
+		return pa.z() < pb.z();
+	};
+	std::sort(sortedVertices.begin(), sortedVertices.end(), PositionLess);
+
+	std::vector<uint32_t> positionIDs(vertexCount);
+	for (uint32_t sortedIndex = 0U; sortedIndex < vertexCount; ++sortedIndex)
+	{
+		uint32_t vertexIndex = sortedVertices[sortedIndex];
+		bool isNewPosition = 0U == sortedIndex || PositionLess(sortedVertices[sortedIndex - 1U], vertexIndex);
+		positionIDs[vertexIndex] = isNewPosition ? vertexIndex : positionIDs[sortedVertices[sortedIndex - 1U]];
+	}
+
+	auto IsDegenerate = [&positionIDs](uint32_t a, uint32_t b, uint32_t c)
+	{
+		return positionIDs[a] == positionIDs[b] || positionIDs[b] == positionIDs[c] || positionIDs[c] == positionIDs[a];
+	};
+
+	IndexList result;
+	result.reserve(indices.size());
+	for (size_t index = 0; index < indices.size(); index += 3)
+	{
+		if (!IsDegenerate(indices[index], indices[index + 1], indices[index + 2]))
+		{
+			result.insert(result.end(), indices.begin() + index, indices.begin() + index + 3);
+		}
+	}
+
+	// Seams are positions referenced by multiple vertices. Borders are edges which don't have exactly two triangles.
+	// Both are locked to keep the surface closed and attributes continuous.
+	std::vector<uint8_t> isLocked(vertexCount, 0U);
+	std::vector<uint32_t> referencedVertices(vertexCount, UINT32_MAX);
+	for (uint32_t vertexIndex : result)
+	{
+		uint32_t& referencedVertex = referencedVertices[positionIDs[vertexIndex]];
+		if (UINT32_MAX == referencedVertex)
+		{
+			referencedVertex = vertexIndex;
+		}
+		else if (referencedVertex != vertexIndex)
+		{
+			isLocked[positionIDs[vertexIndex]] = 1U;
+		}
+	}
+
+	std::unordered_map<uint64_t, uint32_t> edgeTriangleCounts;
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t index = 0; index < result.size(); index += 3)
+	{
+		uint32_t triangle[3] = { positionIDs[result[index]], positionIDs[result[index + 1]], positionIDs[result[index + 2]] };
+		for (uint32_t edge = 0U; edge < 3U; ++edge)
+		{
+			uint64_t a = triangle[edge];
+			uint64_t b = triangle[(edge + 1U) % 3U];
+			++edgeTriangleCounts[a < b ? (a << 32) | b : (b << 32) | a];
+		}
+
+		Vector3 normal = Cross(Subtract(points[triangle[1]], points[triangle[0]]), Subtract(points[triangle[2]], points[triangle[0]]));
+		float length = std::sqrt(Dot(normal, normal));
+		if (length > 0.0f)
+		{
+			normal = Vector3{ normal.x / length, normal.y / length, normal.z / length };
+			float distance = -Dot(normal, points[triangle[0]]);
+			for (uint32_t positionID : triangle)
+			{
+				quadrics[positionID].AddPlane(normal, distance, 0.5f * length);
+			}
+		}
+	}
+
+	for (const auto& [edge, triangleCount] : edgeTriangleCounts)
+	{
+		if (triangleCount != 2U)
+		{
+			isLocked[static_cast<uint32_t>(edge >> 32)] = 1U;
+			isLocked[static_cast<uint32_t>(edge & UINT32_MAX)] = 1U;
+		}
+	}
+
+	// Every pass collapses the cheapest edges whose neighborhoods don't overlap, then rebuilds triangles.
+	const float maxSquaredError = maxError * maxError;
+	const size_t targetTriangleCount = targetIndexCount / 3U;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> triangleOffsets;
+	std::vector<uint32_t> adjacentTriangles;
+	std::vector<uint8_t> isTouched(vertexCount);
+	std::vector<uint32_t> collapseTargets(vertexCount);
+	std::vector<uint32_t> ringFrom;
+	std::vector<uint32_t> ringTo;
+	while (result.size() > targetIndexCount)
+	{
+		collapses.clear();
+		for (size_t index = 0; index < result.size(); ++index)
+		{
+			uint32_t a = result[index];
+			uint32_t b = result[index % 3U == 2U ? index - 2U : index + 1U];
+			for (auto [fromVertex, toVertex] : { std::pair{ a, b }, std::pair{ b, a } })
+			{
+				if (isLocked[positionIDs[fromVertex]])
+				{
+					continue;
+				}
+
+				Quadric quadric = quadrics[positionIDs[fromVertex]];
+				quadric.Add(quadrics[positionIDs[toVertex]]);
+				float error = quadric.GetError(points[toVertex]);
+				if (error <= maxSquaredError)
+				{
+					collapses.push_back(Collapse{ fromVertex, toVertex, error });
+				}
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+		{
+			if (lhs.error != rhs.error)
+			{
+				return lhs.error < rhs.error;
+			}
+			return lhs.fromVertex != rhs.fromVertex ? lhs.fromVertex < rhs.fromVertex : lhs.toVertex < rhs.toVertex;
+		});
+
+		// Triangles around every position.
+		triangleOffsets.assign(vertexCount + 1U, 0U);
+		for (uint32_t vertexIndex : result)
+		{
+			++triangleOffsets[positionIDs[vertexIndex] + 1U];
+		}
+		std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+		adjacentTriangles.resize(result.size());
+		std::vector<uint32_t> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t index = 0; index < result.size(); ++index)
+		{
+			adjacentTriangles[cursors[positionIDs[result[index]]]++] = static_cast<uint32_t>(index / 3U);
+		}
+
+		auto GatherRing = [&](uint32_t center, uint32_t excluded, std::vector<uint32_t>& ring)
+		{
+			ring.clear();
+			for (uint32_t offset = triangleOffsets[center]; offset < triangleOffsets[center + 1U]; ++offset)
+			{
+				const uint32_t* pTriangle = &result[adjacentTriangles[offset] * 3U];
+				for (uint32_t corner = 0U; corner < 3U; ++corner)
+				{
+					uint32_t positionID = positionIDs[pTriangle[corner]];
+					if (positionID != center && positionID != excluded)
+					{
+						ring.push_back(positionID);
+					}
+				}
+			}
+			std::sort(ring.begin(), ring.end());
+			ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+		};
+
+		std::fill(isTouched.begin(), isTouched.end(), 0U);
+		std::fill(collapseTargets.begin(), collapseTargets.end(), UINT32_MAX);
+		size_t remainingTriangleCount = result.size() / 3U;
+		bool hasCollapse = false;
+		for (const Collapse& collapse : collapses)
+		{
+			if (remainingTriangleCount <= targetTriangleCount)
+			{
+				break;
+			}
+
+			uint32_t from = positionIDs[collapse.fromVertex];
+			uint32_t to = positionIDs[collapse.toVertex];
+			if (isTouched[from] || isTouched[to])
+			{
+				continue;
+			}
+
+			// Triangles on the edge are removed. Others around the moving vertex must not flip.
+			const Vector3& target = points[collapse.toVertex];
+			uint32_t removedTriangleCount = 0U;
+			bool isFlipped = false;
+			for (uint32_t offset = triangleOffsets[from]; offset < triangleOffsets[from + 1U] && !isFlipped; ++offset)
+			{
+				const uint32_t* pTriangle = &result[adjacentTriangles[offset] * 3U];
+				uint32_t triangle[3] = { positionIDs[pTriangle[0]], positionIDs[pTriangle[1]], positionIDs[pTriangle[2]] };
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					++removedTriangleCount;
+					continue;
+				}
+
+				Vector3 before[3] = { points[triangle[0]], points[triangle[1]], points[triangle[2]] };
+				Vector3 after[3] = { before[0], before[1], before[2] };
+				for (uint32_t corner = 0U; corner < 3U; ++corner)
+				{
+					if (triangle[corner] == from)
+					{
+						after[corner] = target;
+					}
+				}
+
+				Vector3 normalBefore = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+				Vector3 normalAfter = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+				// Large rotations also count as flips. They fold triangles along locked borders into fins.
+				float lengthProduct = std::sqrt(Dot(normalBefore, normalBefore) * Dot(normalAfter, normalAfter));
+				isFlipped = Dot(normalBefore, normalAfter) <= 0.25f * lengthProduct;
+			}
+
+			if (isFlipped || 0U == removedTriangleCount)
+			{
+				continue;
+			}
+
+			// Link condition : the edge's end points only share the opposite vertices of removed triangles.
+			// Otherwise the collapse pinches the surface into non-manifold edges.
+			GatherRing(from, to, ringFrom);
+			GatherRing(to, from, ringTo);
+			size_t sharedCount = 0;
+			for (auto itFrom = ringFrom.begin(), itTo = ringTo.begin(); itFrom != ringFrom.end() && itTo != ringTo.end();)
+			{
+				if (*itFrom == *itTo)
+				{
+					++sharedCount;
+					++itFrom;
+					++itTo;
+				}
+				else if (*itFrom < *itTo)
+				{
+					++itFrom;
+				}
+				else
+				{
+					++itTo;
+				}
+			}
+			if (sharedCount != removedTriangleCount)
+			{
+				continue;
+			}
+
+			collapseTargets[from] = collapse.toVertex;
+			quadrics[to].Add(quadrics[from]);
+			isTouched[from] = 1U;
+			isTouched[to] = 1U;
+			for (uint32_t positionID : ringFrom)
+			{
+				isTouched[positionID] = 1U;
+			}
+			remainingTriangleCount -= removedTriangleCount;
+			hasCollapse = true;
+		}
+
+		if (!hasCollapse)
+		{
+			break;
+		}
+
+		size_t writeIndex = 0;
+		for (size_t index = 0; index < result.size(); index += 3)
+		{
+			uint32_t triangle[3];
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				uint32_t vertexIndex = result[index + corner];
+				uint32_t collapseTarget = collapseTargets[positionIDs[vertexIndex]];
+				triangle[corner] = UINT32_MAX == collapseTarget ? vertexIndex : collapseTarget;
+			}
+
+			if (!IsDegenerate(triangle[0], triangle[1], triangle[2]))
+			{
+				std::copy(triangle, triangle + 3, result.begin() + writeIndex);
+				writeIndex += 3;
+			}
+		}
+		result.resize(writeIndex);
+	}
+
+	return result;
+}
+
+std::vector<std::vector<MeshLOD::IndexList>> MeshLOD::BuildLODChain(std::span<const cd::Point> positions, std::span<const IndexList> groupIndices)
+{
+	// Small meshes are cheaper to draw than to switch levels.
+	constexpr size_t minIndexCount = 3U * 64U;
+	size_t previousIndexCount = 0;
+	for (const IndexList& indices : groupIndices)
+	{
+		previousIndexCount += indices.size();
+	}
+
+	// Every level is simplified from the original so that its error is measured against the original surface.
+	std::vector<std::vector<IndexList>> lods;
+	float maxError = LOD1MaxError;
+	for (uint32_t lod = 1U; lod < MaxLODCount && previousIndexCount >= minIndexCount; ++lod)
+	{
+		std::vector<IndexList> lodIndices;
+		lodIndices.reserve(groupIndices.size());
+		size_t indexCount = 0;
+		for (size_t groupIndex = 0; groupIndex < groupIndices.size(); ++groupIndex)
+		{
+			const IndexList& indices = groupIndices[groupIndex];
+			uint32_t targetIndexCount = std::max(static_cast<uint32_t>(indices.size() >> lod) / 3U * 3U, 3U);
+			IndexList simplifiedIndices = Simplify(positions, indices, targetIndexCount, maxError);
+			if (simplifiedIndices.empty())
+			{
+				// Keep the previous level instead of making the group disappear.
+				simplifiedIndices = lods.empty() ? indices : lods.back()[groupIndex];
+			}
+			indexCount += simplifiedIndices.size();
+			lodIndices.push_back(cd::MoveTemp(simplifiedIndices));
+		}
+
+		// A level should save enough triangles to be worth its memory.
+		if (indexCount * 4U > previousIndexCount * 3U)
+		{
+			break;
+		}
+
+		lods.push_back(cd::MoveTemp(lodIndices));
+		previousIndexCount = indexCount;
+		maxError *= 2.0f;
+	}
+
+	return lods;
+}
+
+float MeshLOD::GetScreenSize(float radius, float distance, float projectionScale)
+{
+	if (distance <= radius)
+	{
+		return 1.0f;
+	}
+
+	return radius * projectionScale / distance;
+}
+
+uint32_t MeshLOD::SelectLOD(float screenSize, uint32_t lodCount)
+{
+	uint32_t lod = 0U;
+	float lodScreenSize = LOD1ScreenSize;
+	while (lod + 1U < lodCount && screenSize < lodScreenSize)
+	{
+		++lod;
+		lodScreenSize *= 0.5f;
+	}
+
+	return lod;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// MeshLOD builds simplified index lists of a mesh by quadric edge collapse and selects a level by screen size.
+// Vertices only move onto their neighbors so that all levels share the original vertex buffer.
+// Vertices on borders and attribute seams are locked, so polygon groups and UV islands stay closed.
+class MeshLOD
+{
+public:
+	using IndexList = std::vector<uint32_t>;
+
+	// Level 0 is the original mesh.
+	static constexpr uint32_t MaxLODCount = 4U;
+
+	// Level 1 is used below this fraction of screen height. Every next level starts at half size of the previous one.
+	static constexpr float LOD1ScreenSize = 0.25f;
+
+	// Error of level 1 relative to mesh extent. It doubles per level as screen size halves, so error stays about same in pixels.
+	static constexpr float LOD1MaxError = 0.01f;
+
+public:
+	MeshLOD() = delete;
+	MeshLOD(const MeshLOD&) = delete;
+	MeshLOD& operator=(const MeshLOD&) = delete;
+	MeshLOD(MeshLOD&&) = delete;
+	MeshLOD& operator=(MeshLOD&&) = delete;
+	~MeshLOD() = delete;
+
+	// Collapses edges in the order of quadric error until the index count reaches targetIndexCount
+	// or the next collapse moves the surface further than maxError, which is relative to mesh extent.
+	static IndexList Simplify(std::span<const cd::Point> positions, std::span<const uint32_t> indices, uint32_t targetIndexCount, float maxError);
+
+	// groupIndices : index lists of polygon groups which share positions.
+	// Returns levels after level 0 and every level has one list per group. Levels which can't remove enough triangles are not built.
+	static std::vector<std::vector<IndexList>> BuildLODChain(std::span<const cd::Point> positions, std::span<const IndexList> groupIndices);
+
+	// Fraction of screen height covered by a bounding sphere. projectionScale : element (1, 1) of the projection matrix.
+	static float GetScreenSize(float radius, float distance, float projectionScale);
+
+	static uint32_t SelectLOD(float screenSize, uint32_t lodCount);
+};
+
+}
\ No newline at end of file
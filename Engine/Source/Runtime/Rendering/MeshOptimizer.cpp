@@ -0,0 +1,514 @@
+#include "MeshOptimizer.h"
+
+#include "Scene/Mesh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
+namespace
+{
+
+constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+// Forsyth's scoring of a LRU cache which is larger than hardware ones, so it also works for different GPUs.
+constexpr uint32_t ScoringCacheSize = 32U;
+constexpr float CacheDecayPower = 1.5f;
+constexpr float LastTriangleScore = 0.75f;
+constexpr float ValenceBoostScale = 2.0f;
+constexpr float ValenceBoostPower = 0.5f;
+
+float GetVertexScore(int32_t cachePosition, uint32_t remainingValence)
+{
+	if (0U == remainingValence)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// Vertices of the last triangle get a fixed score so that the next triangle doesn't prefer a specific edge of it.
+		if (cachePosition < 3)
+		{
+			score = LastTriangleScore;
+		}
+		else
+		{
+			float scaler = 1.0f / static_cast<float>(ScoringCacheSize - 3U);
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, CacheDecayPower);
+		}
+	}
+
+	// Vertices with few remaining triangles are finished first to avoid leaving lonely triangles.
+	score += ValenceBoostScale * std::pow(static_cast<float>(remainingValence), -ValenceBoostPower);
+	return score;
+}
+
+// FIFO cache simulation by timestamps. A vertex is in cache if less than cacheSize vertices were added after it.
+class VertexCacheSimulator
+{
+public:
+	VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize) :
+		m_cacheTimestamps(vertexCount, 0U), m_timestamp(cacheSize + 1U), m_cacheSize(cacheSize)
+	{
+	}
+
+	void Flush() { m_timestamp += m_cacheSize + 1U; }
+
+	uint32_t AddTriangle(const uint32_t* pTriangle)
+	{
+		uint32_t misses = 0U;
+		for (uint32_t cornerIndex = 0U; cornerIndex < 3U; ++cornerIndex)
+		{
+			uint32_t vertexIndex = pTriangle[cornerIndex];
+			if (m_timestamp - m_cacheTimestamps[vertexIndex] > m_cacheSize)
+			{
+				m_cacheTimestamps[vertexIndex] = m_timestamp++;
+				++misses;
+			}
+		}
+		return misses;
+	}
+
+private:
+	std::vector<uint32_t> m_cacheTimestamps;
+	uint32_t m_timestamp;
+	uint32_t m_cacheSize;
+};
+
+struct Vector3
+{
+	float x;
+	float y;
+	float z;
+};
+
+Vector3 ToVector3(const cd::Point& point)
+{
+	return Vector3{ point.x(), point.y(), point.z() };
+}
+
+Vector3 Subtract(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+	return Vector3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Dot(const Vector3& a, const Vector3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Area weighted centroid and summed normal of a triangle range. Normal length is twice the area.
+void GetSurface(std::span<const cd::Point> positions, std::span<const uint32_t> indices, Vector3& centroid, Vector3& normal)
+{
+	centroid = Vector3{ 0.0f, 0.0f, 0.0f };
+	normal = Vector3{ 0.0f, 0.0f, 0.0f };
+	float totalWeight = 0.0f;
+	for (size_t indexOffset = 0; indexOffset < indices.size(); indexOffset += 3)
+	{
+		Vector3 a = ToVector3(positions[indices[indexOffset]]);
+		Vector3 b = ToVector3(positions[indices[indexOffset + 1]]);
+		Vector3 c = ToVector3(positions[indices[indexOffset + 2]]);
+		Vector3 triangleNormal = Cross(Subtract(b, a), Subtract(c, a));
+		float weight = std::sqrt(Dot(triangleNormal, triangleNormal));
+
+		centroid.x += (a.x + b.x + c.x) * weight;
+		centroid.y += (a.y + b.y + c.y) * weight;
+		centroid.z += (a.z + b.z + c.z) * weight;
+		normal.x += triangleNormal.x;
+		normal.y += triangleNormal.y;
+		normal.z += triangleNormal.z;
+		totalWeight += weight;
+	}
+
+	if (totalWeight > 0.0f)
+	{
+		float scale = 1.0f / (3.0f * totalWeight);
+		centroid = Vector3{ centroid.x * scale, centroid.y * scale, centroid.z * scale };
+	}
+}
+
+}
+
+namespace engine
+{
+
+float MeshOptimizer::GetACMR(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (0 == triangleCount)
+	{
+		return 0.0f;
+	}
+
+	VertexCacheSimulator cacheSimulator(vertexCount, cacheSize);
+	uint32_t misses = 0U;
+	for (size_t triangleIndex = 0; triangleIndex < triangleCount; ++triangleIndex)
+	{
+		misses += cacheSimulator.AddTriangle(&indices[triangleIndex * 3]);
+	}
+
+	return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+MeshOptimizer::IndexList MeshOptimizer::OptimizeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	IndexList optimizedIndices;
+	optimizedIndices.reserve(triangleCount * 3U);
+	if (0U == triangleCount)
+	{
+		return optimizedIndices;
+	}
+
+	// Triangles of every vertex. Remaining ones are kept in front of each range.
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1U, 0U);
+	for (size_t index = 0; index < triangleCount * 3U; ++index)
+	{
+		++triangleOffsets[indices[index] + 1U];
+	}
+	std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3U);
+	std::vector<uint32_t> remainingValences(vertexCount, 0U);
+	for (uint32_t triangleIndex = 0U; triangleIndex < triangleCount; ++triangleIndex)
+	{
+		for (uint32_t cornerIndex = 0U; cornerIndex < 3U; ++cornerIndex)
+		{
+			uint32_t vertexIndex = indices[triangleIndex * 3U + cornerIndex];
+			vertexTriangles[triangleOffsets[vertexIndex] + remainingValences[vertexIndex]++] = triangleIndex;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		vertexScores[vertexIndex] = GetVertexScore(-1, remainingValences[vertexIndex]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	for (uint32_t triangleIndex = 0U; triangleIndex < triangleCount; ++triangleIndex)
+	{
+		const uint32_t* pTriangle = &indices[triangleIndex * 3U];
+		triangleScores[triangleIndex] = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+	}
+
+	std::vector<bool> isEmitted(triangleCount, false);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(ScoringCacheSize + 3U);
+	nextCache.reserve(ScoringCacheSize + 3U);
+
+	uint32_t bestTriangle = static_cast<uint32_t>(std::distance(triangleScores.begin(), std::max_element(triangleScores.begin(), triangleScores.end())));
+	uint32_t inputCursor = 0U;
+	for (uint32_t emittedCount = 0U; emittedCount < triangleCount; ++emittedCount)
+	{
+		// No triangles around cached vertices. Continue from the next triangle in input order.
+		if (InvalidIndex == bestTriangle)
+		{
+			while (isEmitted[inputCursor])
+			{
+				++inputCursor;
+			}
+			bestTriangle = inputCursor;
+		}
+
+		const uint32_t* pTriangle = &indices[bestTriangle * 3U];
+		optimizedIndices.insert(optimizedIndices.end(), pTriangle, pTriangle + 3);
+		isEmitted[bestTriangle] = true;
+
+		for (uint32_t cornerIndex = 0U; cornerIndex < 3U; ++cornerIndex)
+		{
+			uint32_t vertexIndex = pTriangle[cornerIndex];
+			uint32_t* pBegin = &vertexTriangles[triangleOffsets[vertexIndex]];
+			uint32_t* pEnd = pBegin + remainingValences[vertexIndex];
+			uint32_t* pFound = std::find(pBegin, pEnd, bestTriangle);
+			assert(pFound != pEnd);
+			std::swap(*pFound, *(pEnd - 1));
+			--remainingValences[vertexIndex];
+		}
+
+		// Vertices of the emitted triangle move to the front of the LRU cache.
+		nextCache.clear();
+		for (uint32_t cornerIndex = 0U; cornerIndex < 3U; ++cornerIndex)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), pTriangle[cornerIndex]) == nextCache.end())
+			{
+				nextCache.push_back(pTriangle[cornerIndex]);
+			}
+		}
+		for (uint32_t vertexIndex : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), vertexIndex) == nextCache.end())
+			{
+				nextCache.push_back(vertexIndex);
+			}
+		}
+
+		// Update scores of cached and evicted vertices and their remaining triangles.
+		for (uint32_t cacheIndex = 0U; cacheIndex < nextCache.size(); ++cacheIndex)
+		{
+			uint32_t vertexIndex = nextCache[cacheIndex];
+			cachePositions[vertexIndex] = cacheIndex < ScoringCacheSize ? static_cast<int32_t>(cacheIndex) : -1;
+
+			float score = GetVertexScore(cachePositions[vertexIndex], remainingValences[vertexIndex]);
+			float scoreDelta = score - vertexScores[vertexIndex];
+			vertexScores[vertexIndex] = score;
+
+			const uint32_t* pTriangles = &vertexTriangles[triangleOffsets[vertexIndex]];
+			for (uint32_t triangleIndex = 0U; triangleIndex < remainingValences[vertexIndex]; ++triangleIndex)
+			{
+				triangleScores[pTriangles[triangleIndex]] += scoreDelta;
+			}
+		}
+		nextCache.resize(std::min(static_cast<uint32_t>(nextCache.size()), ScoringCacheSize));
+		std::swap(cache, nextCache);
+
+		bestTriangle = InvalidIndex;
+		float bestScore = 0.0f;
+		for (uint32_t vertexIndex : cache)
+		{
+			const uint32_t* pTriangles = &vertexTriangles[triangleOffsets[vertexIndex]];
+			for (uint32_t triangleIndex = 0U; triangleIndex < remainingValences[vertexIndex]; ++triangleIndex)
+			{
+				if (InvalidIndex == bestTriangle || triangleScores[pTriangles[triangleIndex]] > bestScore)
+				{
+					bestTriangle = pTriangles[triangleIndex];
+					bestScore = triangleScores[bestTriangle];
+				}
+			}
+		}
+	}
+
+	return optimizedIndices;
+}
+
+MeshOptimizer::IndexList MeshOptimizer::OptimizeOverdraw(std::span<const cd::Point> positions, std::span<const uint32_t> indices, float threshold)
+{
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (0U == triangleCount)
+	{
+		return IndexList(indices.begin(), indices.end());
+	}
+
+	// Hard boundaries are where the cache has nothing to reuse, so reordering clusters there costs few extra vertex transforms.
+	VertexCacheSimulator cacheSimulator(vertexCount, DefaultCacheSize);
+	std::vector<uint32_t> hardClusterStarts;
+	for (uint32_t triangleIndex = 0U; triangleIndex < triangleCount; ++triangleIndex)
+	{
+		if (3U == cacheSimulator.AddTriangle(&indices[triangleIndex * 3U]) || 0U == triangleIndex)
+		{
+			hardClusterStarts.push_back(triangleIndex);
+		}
+	}
+	hardClusterStarts.push_back(triangleCount);
+
+	// Soft boundaries split hard clusters further where ACMR from a cold cache is still within threshold of the whole cluster.
+	std::vector<uint32_t> clusterStarts;
+	for (size_t hardClusterIndex = 0; hardClusterIndex + 1 < hardClusterStarts.size(); ++hardClusterIndex)
+	{
+		uint32_t hardClusterStart = hardClusterStarts[hardClusterIndex];
+		uint32_t hardClusterEnd = hardClusterStarts[hardClusterIndex + 1];
+
+		cacheSimulator.Flush();
+		uint32_t hardClusterMisses = 0U;
+		for (uint32_t triangleIndex = hardClusterStart; triangleIndex < hardClusterEnd; ++triangleIndex)
+		{
+			hardClusterMisses += cacheSimulator.AddTriangle(&indices[triangleIndex * 3U]);
+		}
+		float maxACMR = threshold * static_cast<float>(hardClusterMisses) / static_cast<float>(hardClusterEnd - hardClusterStart);
+
+		cacheSimulator.Flush();
+		clusterStarts.push_back(hardClusterStart);
+		uint32_t clusterStart = hardClusterStart;
+		uint32_t clusterMisses = 0U;
+		for (uint32_t triangleIndex = hardClusterStart; triangleIndex + 1U < hardClusterEnd; ++triangleIndex)
+		{
+			clusterMisses += cacheSimulator.AddTriangle(&indices[triangleIndex * 3U]);
+			if (static_cast<float>(clusterMisses) <= maxACMR * static_cast<float>(triangleIndex + 1U - clusterStart))
+			{
+				clusterStart = triangleIndex + 1U;
+				clusterMisses = 0U;
+				clusterStarts.push_back(clusterStart);
+				cacheSimulator.Flush();
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Clusters which face away from mesh center are in front of others in most views, so they are drawn first.
+	Vector3 meshCentroid;
+	Vector3 meshNormal;
+	GetSurface(positions, indices, meshCentroid, meshNormal);
+
+	struct Cluster
+	{
+		uint32_t start;
+		uint32_t end;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters;
+	clusters.reserve(clusterStarts.size() - 1);
+	for (size_t clusterIndex = 0; clusterIndex + 1 < clusterStarts.size(); ++clusterIndex)
+	{
+		Cluster& cluster = clusters.emplace_back();
+		cluster.start = clusterStarts[clusterIndex];
+		cluster.end = clusterStarts[clusterIndex + 1];
+
+		Vector3 centroid;
+		Vector3 normal;
+		GetSurface(positions, indices.subspan(cluster.start * 3U, (cluster.end - cluster.start) * 3U), centroid, normal);
+		float normalLength = std::sqrt(Dot(normal, normal));
+		cluster.sortKey = normalLength > 0.0f ? Dot(Subtract(centroid, meshCentroid), normal) / normalLength : 0.0f;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; });
+
+	IndexList optimizedIndices;
+	optimizedIndices.reserve(indices.size());
+	for (const Cluster& cluster : clusters)
+	{
+		optimizedIndices.insert(optimizedIndices.end(), indices.begin() + cluster.start * 3U, indices.begin() + cluster.end * 3U);
+	}
+
+	return optimizedIndices;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, InvalidIndex);
+	uint32_t nextVertexIndex = 0U;
+	for (uint32_t& index : indices)
+	{
+		if (InvalidIndex == remap[index])
+		{
+			remap[index] = nextVertexIndex++;
+		}
+		index = remap[index];
+	}
+
+	for (uint32_t& newIndex : remap)
+	{
+		if (InvalidIndex == newIndex)
+		{
+			newIndex = nextVertexIndex++;
+		}
+	}
+
+	return remap;
+}
+
+std::optional<MeshOptimizer::MeshOptimizeResult> MeshOptimizer::OptimizeMesh(cd::Mesh& mesh)
+{
+	const uint32_t vertexCount = mesh.GetVertexCount();
+	std::vector<IndexList> groupIndices(mesh.GetPolygonGroupCount());
+	for (uint32_t polygonGroupIndex = 0U; polygonGroupIndex < mesh.GetPolygonGroupCount(); ++polygonGroupIndex)
+	{
+		IndexList& indices = groupIndices[polygonGroupIndex];
+		for (const cd::Polygon& polygon : mesh.GetPolygonGroup(polygonGroupIndex))
+		{
+			if (3U != polygon.size())
+			{
+				return std::nullopt;
+			}
+
+			for (cd::VertexID vertexID : polygon)
+			{
+				indices.push_back(vertexID.Data());
+			}
+		}
+	}
+
+	std::vector<cd::Point> positions;
+	positions.reserve(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		positions.push_back(mesh.GetVertexPosition(vertexIndex));
+	}
+
+	// Polygon groups are drawn separately so triangles only move inside their groups. All groups share one vertex order.
+	IndexList sourceIndices;
+	IndexList optimizedIndices;
+	for (IndexList& indices : groupIndices)
+	{
+		sourceIndices.insert(sourceIndices.end(), indices.begin(), indices.end());
+		indices = OptimizeOverdraw(positions, OptimizeVertexCache(indices, vertexCount));
+		optimizedIndices.insert(optimizedIndices.end(), indices.begin(), indices.end());
+	}
+
+	// Vertices are referred by blend shapes, skins and vertex instances. Keep their order for these meshes.
+	bool canReorderVertices = 0U == mesh.GetBlendShapeIDCount() && 0U == mesh.GetSkinIDCount() && 0U == mesh.GetVertexInstanceToIDCount();
+	if (canReorderVertices)
+	{
+		std::vector<uint32_t> remap = OptimizeVertexFetch(optimizedIndices, vertexCount);
+		auto RemapVertexAttribute = [&remap, vertexCount](auto getVertexAttribute, auto setVertexAttribute)
+		{
+			using Attribute = std::decay_t<decltype(getVertexAttribute(0U))>;
+			std::vector<Attribute> attributes;
+			attributes.reserve(vertexCount);
+			for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+			{
+				attributes.push_back(getVertexAttribute(vertexIndex));
+			}
+			for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+			{
+				setVertexAttribute(remap[vertexIndex], attributes[vertexIndex]);
+			}
+		};
+
+		const cd::VertexFormat& vertexFormat = mesh.GetVertexFormat();
+		RemapVertexAttribute([&mesh](uint32_t index) { return mesh.GetVertexPosition(index); },
+			[&mesh](uint32_t index, const auto& position) { mesh.SetVertexPosition(index, position); });
+		if (vertexFormat.Contains(cd::VertexAttributeType::Normal))
+		{
+			RemapVertexAttribute([&mesh](uint32_t index) { return mesh.GetVertexNormal(index); },
+				[&mesh](uint32_t index, const auto& normal) { mesh.SetVertexNormal(index, normal); });
+		}
+		if (vertexFormat.Contains(cd::VertexAttributeType::Tangent))
+		{
+			RemapVertexAttribute([&mesh](uint32_t index) { return mesh.GetVertexTangent(index); },
+				[&mesh](uint32_t index, const auto& tangent) { mesh.SetVertexTangent(index, tangent); });
+		}
+		if (vertexFormat.Contains(cd::VertexAttributeType::Bitangent))
+		{
+			RemapVertexAttribute([&mesh](uint32_t index) { return mesh.GetVertexBiTangent(index); },
+				[&mesh](uint32_t index, const auto& bitangent) { mesh.SetVertexBiTangent(index, bitangent); });
+		}
+		for (uint32_t uvSetIndex = 0U; uvSetIndex < mesh.GetVertexUVSetCount(); ++uvSetIndex)
+		{
+			RemapVertexAttribute([&mesh, uvSetIndex](uint32_t index) { return mesh.GetVertexUV(uvSetIndex, index); },
+				[&mesh, uvSetIndex](uint32_t index, const auto& uv) { mesh.SetVertexUV(uvSetIndex, index, uv); });
+		}
+		for (uint32_t colorSetIndex = 0U; colorSetIndex < mesh.GetVertexColorSetCount(); ++colorSetIndex)
+		{
+			RemapVertexAttribute([&mesh, colorSetIndex](uint32_t index) { return mesh.GetVertexColor(colorSetIndex, index); },
+				[&mesh, colorSetIndex](uint32_t index, const auto& color) { mesh.SetVertexColor(colorSetIndex, index, color); });
+		}
+	}
+
+	size_t indexOffset = 0;
+	for (uint32_t polygonGroupIndex = 0U; polygonGroupIndex < mesh.GetPolygonGroupCount(); ++polygonGroupIndex)
+	{
+		for (cd::Polygon& polygon : mesh.GetPolygonGroup(polygonGroupIndex))
+		{
+			for (cd::VertexID& vertexID : polygon)
+			{
+				vertexID = optimizedIndices[indexOffset++];
+			}
+		}
+	}
+
+	return MeshOptimizeResult{ GetACMR(sourceIndices, vertexCount), GetACMR(optimizedIndices, vertexCount) };
+}
+
+}
\ No newline at end of file
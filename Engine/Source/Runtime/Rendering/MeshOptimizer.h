@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Math/Vector.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace cd
+{
+
+class Mesh;
+
+}
+
+namespace engine
+{
+
+// MeshOptimizer reorders triangle lists for GPU efficiency. It runs at import time so saved meshes are already optimized :
+// 1. OptimizeVertexCache sorts triangles for post-transform vertex cache hits by Forsyth's scoring.
+// 2. OptimizeOverdraw splits the result into clusters at cache restarts and draws outward facing clusters first.
+// 3. OptimizeVertexFetch renumbers vertices in the order they are used so that vertex fetch reads memory linearly.
+// OptimizeMesh applies all of them to a cd::Mesh.
+class MeshOptimizer
+{
+public:
+	using IndexList = std::vector<uint32_t>;
+
+	// FIFO cache size to measure ACMR. It is close to post-transform caches of current GPUs.
+	static constexpr uint32_t DefaultCacheSize = 16U;
+
+	// Clusters of OptimizeOverdraw can make ACMR worse by this ratio.
+	static constexpr float DefaultOverdrawThreshold = 1.05f;
+
+	struct MeshOptimizeResult
+	{
+		float sourceACMR;
+		float optimizedACMR;
+	};
+
+public:
+	MeshOptimizer() = delete;
+	MeshOptimizer(const MeshOptimizer&) = delete;
+	MeshOptimizer& operator=(const MeshOptimizer&) = delete;
+	MeshOptimizer(MeshOptimizer&&) = delete;
+	MeshOptimizer& operator=(MeshOptimizer&&) = delete;
+	~MeshOptimizer() = delete;
+
+	// Average cache miss ratio : transformed vertices per triangle by a FIFO cache. 3 is the worst and 0.5 is the best for large grids.
+	static float GetACMR(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+	static IndexList OptimizeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount);
+
+	// indices : output of OptimizeVertexCache.
+	static IndexList OptimizeOverdraw(std::span<const cd::Point> positions, std::span<const uint32_t> indices, float threshold = DefaultOverdrawThreshold);
+
+	// Rewrites indices and returns the new index of every old vertex. Unused vertices are moved to the end.
+	static std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, uint32_t vertexCount);
+
+	// Triangles only move inside their polygon groups as groups are drawn separately. All groups share one vertex order which
+	// is kept for meshes with blend shapes, skins or vertex instances as they refer to vertices. Returns std::nullopt and
+	// leaves the mesh unchanged if it is not triangulated.
+	static std::optional<MeshOptimizeResult> OptimizeMesh(cd::Mesh& mesh);
+};
+
+}
\ No newline at end of file
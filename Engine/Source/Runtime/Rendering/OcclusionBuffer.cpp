@@ -0,0 +1,355 @@
+#include "OcclusionBuffer.h"
+
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE__)
+#define CD_OCCLUSION_BUFFER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+// Geometry is clipped by w > 0 for the projection and by z >= 0, which is the near plane for [0, 1] depth and
+// a bit behind it for [-1, 1] depth. So occluder parts which GPU clips away never hide anything in both conventions.
+constexpr float MinClipW = 1e-4f;
+constexpr uint32_t ClipPlaneCount = 2U;
+
+float GetClipDistance(float z, float w, uint32_t planeIndex)
+{
+	return 0U == planeIndex ? w - MinClipW : z;
+}
+
+static_assert(0U == OcclusionBuffer::Width % 4U, "Rows are rasterized in 4 pixel batches.");
+
+}
+
+OcclusionBuffer::OcclusionBuffer()
+{
+	uint32_t offset = 0U;
+	for (uint32_t level = 0U; ; ++level)
+	{
+		m_levelOffsets.push_back(offset);
+		offset += GetLevelWidth(level) * GetLevelHeight(level);
+		if (1U == GetLevelWidth(level) && 1U == GetLevelHeight(level))
+		{
+			break;
+		}
+	}
+	m_depths.assign(offset, FLT_MAX);
+}
+
+void OcclusionBuffer::Clear(const cd::Matrix4x4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+	std::fill(m_depths.begin(), m_depths.end(), FLT_MAX);
+	m_rasterizedTriangleCount = 0U;
+}
+
+void OcclusionBuffer::RasterizeOccluder(const cd::Matrix4x4& worldMatrix, std::span<const cd::Point> positions, std::span<const uint32_t> indices)
+{
+	assert(0U == indices.size() % 3U);
+	cd::Matrix4x4 worldViewProjection = m_viewProjection * worldMatrix;
+	const float* pMatrix = worldViewProjection.begin();
+
+	m_clipVertices.resize(positions.size());
+	for (size_t vertexIndex = 0; vertexIndex < positions.size(); ++vertexIndex)
+	{
+		const cd::Point& position = positions[vertexIndex];
+		float clip[4];
+		for (int row = 0; row < 4; ++row)
+		{
+			clip[row] = pMatrix[row] * position.x() + pMatrix[4 + row] * position.y() + pMatrix[8 + row] * position.z() + pMatrix[12 + row];
+		}
+		m_clipVertices[vertexIndex] = ClipVertex{ clip[0], clip[1], clip[2], clip[3] };
+	}
+
+	for (size_t index = 0; index < indices.size(); index += 3)
+	{
+		ClipTriangle(m_clipVertices[indices[index]], m_clipVertices[indices[index + 1]], m_clipVertices[indices[index + 2]]);
+	}
+}
+
+void OcclusionBuffer::ClipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	auto ToScreen = [](const ClipVertex& vertex)
+	{
+		float inverseW = 1.0f / vertex.w;
+		return ScreenVertex{ (vertex.x * inverseW * 0.5f + 0.5f) * static_cast<float>(Width),
+			(vertex.y * inverseW * 0.5f + 0.5f) * static_cast<float>(Height), vertex.z * inverseW };
+	};
+
+	auto IsInside = [](const ClipVertex& vertex, uint32_t planeIndex)
+	{
+		return GetClipDistance(vertex.z, vertex.w, planeIndex) >= 0.0f;
+	};
+
+	uint32_t insideCount = 0U;
+	for (uint32_t planeIndex = 0U; planeIndex < ClipPlaneCount; ++planeIndex)
+	{
+		insideCount += (IsInside(v0, planeIndex) && IsInside(v1, planeIndex) && IsInside(v2, planeIndex)) ? 1U : 0U;
+	}
+
+	if (ClipPlaneCount == insideCount)
+	{
+		RasterizeTriangle(ToScreen(v0), ToScreen(v1), ToScreen(v2));
+		return;
+	}
+
+	// Sutherland-Hodgman. Cutting by every plane adds at most one vertex.
+	ClipVertex polygons[2][3 + ClipPlaneCount] = { { v0, v1, v2 } };
+	uint32_t polygonSize = 3U;
+	for (uint32_t planeIndex = 0U; planeIndex < ClipPlaneCount && polygonSize >= 3U; ++planeIndex)
+	{
+		const ClipVertex* pSource = polygons[planeIndex % 2U];
+		ClipVertex* pTarget = polygons[(planeIndex + 1U) % 2U];
+		uint32_t targetSize = 0U;
+		for (uint32_t corner = 0U; corner < polygonSize; ++corner)
+		{
+			const ClipVertex& current = pSource[corner];
+			const ClipVertex& next = pSource[(corner + 1U) % polygonSize];
+			float currentDistance = GetClipDistance(current.z, current.w, planeIndex);
+			float nextDistance = GetClipDistance(next.z, next.w, planeIndex);
+			if (currentDistance >= 0.0f)
+			{
+				pTarget[targetSize++] = current;
+			}
+
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				float t = currentDistance / (currentDistance - nextDistance);
+				pTarget[targetSize++] = ClipVertex{ current.x + (next.x - current.x) * t, current.y + (next.y - current.y) * t,
+					current.z + (next.z - current.z) * t, current.w + (next.w - current.w) * t };
+			}
+		}
+		polygonSize = targetSize;
+	}
+
+	const ClipVertex* pPolygon = polygons[ClipPlaneCount % 2U];
+	for (uint32_t corner = 1U; corner + 1U < polygonSize; ++corner)
+	{
+		RasterizeTriangle(ToScreen(pPolygon[0]), ToScreen(pPolygon[corner]), ToScreen(pPolygon[corner + 1U]));
+	}
+}
+
+void OcclusionBuffer::RasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+{
+	// Pixels are covered when their centers are inside. Edge functions are made positive inside by swapping back faces.
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (!(std::abs(area) > 0.0f))
+	{
+		return;
+	}
+
+	const ScreenVertex* pVertices[3] = { &v0, area > 0.0f ? &v1 : &v2, area > 0.0f ? &v2 : &v1 };
+	area = std::abs(area);
+
+	auto ToPixelRange = [](float minValue, float maxValue, uint32_t size, int& first, int& last)
+	{
+		first = static_cast<int>(std::ceil(std::clamp(minValue - 0.5f, -1.0f, static_cast<float>(size))));
+		last = static_cast<int>(std::floor(std::clamp(maxValue - 0.5f, -1.0f, static_cast<float>(size))));
+		first = std::max(first, 0);
+		last = std::min(last, static_cast<int>(size) - 1);
+	};
+
+	int minX, maxX, minY, maxY;
+	ToPixelRange(std::min({ v0.x, v1.x, v2.x }), std::max({ v0.x, v1.x, v2.x }), Width, minX, maxX);
+	ToPixelRange(std::min({ v0.y, v1.y, v2.y }), std::max({ v0.y, v1.y, v2.y }), Height, minY, maxY);
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	// Edge i goes from vertex i to vertex i + 1 : e(x, y) = a * x + b * y + c.
+	// Edge i is opposite to vertex i + 2, so e / area is the barycentric weight of that vertex.
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	for (uint32_t edge = 0U; edge < 3U; ++edge)
+	{
+		const ScreenVertex& from = *pVertices[edge];
+		const ScreenVertex& to = *pVertices[(edge + 1U) % 3U];
+		edgeA[edge] = from.y - to.y;
+		edgeB[edge] = to.x - from.x;
+		edgeC[edge] = from.x * to.y - from.y * to.x;
+	}
+
+	// Depth is affine in screen space : depth(x, y) = a * x + b * y + c.
+	float inverseArea = 1.0f / area;
+	float depthA = 0.0f;
+	float depthB = 0.0f;
+	float depthC = 0.0f;
+	for (uint32_t edge = 0U; edge < 3U; ++edge)
+	{
+		float depth = pVertices[(edge + 2U) % 3U]->depth * inverseArea;
+		depthA += edgeA[edge] * depth;
+		depthB += edgeB[edge] * depth;
+		depthC += edgeC[edge] * depth;
+	}
+
+	++m_rasterizedTriangleCount;
+
+#ifdef CD_OCCLUSION_BUFFER_SSE
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 firstX = _mm_set1_ps(static_cast<float>(minX));
+	const __m128 lastX = _mm_set1_ps(static_cast<float>(maxX));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 vectorEdgeA0 = _mm_set1_ps(edgeA[0]);
+	const __m128 vectorEdgeA1 = _mm_set1_ps(edgeA[1]);
+	const __m128 vectorEdgeA2 = _mm_set1_ps(edgeA[2]);
+	const __m128 vectorDepthA = _mm_set1_ps(depthA);
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float centerY = static_cast<float>(y) + 0.5f;
+		const __m128 rowEdge0 = _mm_set1_ps(edgeB[0] * centerY + edgeC[0]);
+		const __m128 rowEdge1 = _mm_set1_ps(edgeB[1] * centerY + edgeC[1]);
+		const __m128 rowEdge2 = _mm_set1_ps(edgeB[2] * centerY + edgeC[2]);
+		const __m128 rowDepth = _mm_set1_ps(depthB * centerY + depthC);
+		float* pRow = m_depths.data() + y * Width;
+
+		// Batches start at multiples of 4 so that they never cross the row end.
+		for (int x = minX & ~3; x <= maxX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+			__m128 centerX = _mm_add_ps(pixelX, _mm_set1_ps(0.5f));
+			__m128 edge0 = _mm_add_ps(_mm_mul_ps(vectorEdgeA0, centerX), rowEdge0);
+			__m128 edge1 = _mm_add_ps(_mm_mul_ps(vectorEdgeA1, centerX), rowEdge1);
+			__m128 edge2 = _mm_add_ps(_mm_mul_ps(vectorEdgeA2, centerX), rowEdge2);
+			__m128 mask = _mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_and_ps(_mm_cmpge_ps(edge1, zero), _mm_cmpge_ps(edge2, zero)));
+			mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(pixelX, firstX), _mm_cmple_ps(pixelX, lastX)));
+			if (0 == _mm_movemask_ps(mask))
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(vectorDepthA, centerX), rowDepth);
+			__m128 oldDepth = _mm_loadu_ps(pRow + x);
+			__m128 newDepth = _mm_min_ps(oldDepth, depth);
+			_mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(mask, newDepth), _mm_andnot_ps(mask, oldDepth)));
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float centerY = static_cast<float>(y) + 0.5f;
+		float* pRow = m_depths.data() + y * Width;
+		for (int x = minX; x <= maxX; ++x)
+		{
+			float centerX = static_cast<float>(x) + 0.5f;
+			if (edgeA[0] * centerX + edgeB[0] * centerY + edgeC[0] >= 0.0f &&
+				edgeA[1] * centerX + edgeB[1] * centerY + edgeC[1] >= 0.0f &&
+				edgeA[2] * centerX + edgeB[2] * centerY + edgeC[2] >= 0.0f)
+			{
+				pRow[x] = std::min(pRow[x], depthA * centerX + depthB * centerY + depthC);
+			}
+		}
+	}
+#endif
+}
+
+void OcclusionBuffer::BuildHiZ()
+{
+	for (uint32_t level = 1U; level < GetLevelCount(); ++level)
+	{
+		uint32_t sourceWidth = GetLevelWidth(level - 1U);
+		uint32_t sourceHeight = GetLevelHeight(level - 1U);
+		const float* pSource = m_depths.data() + m_levelOffsets[level - 1U];
+		float* pTarget = m_depths.data() + m_levelOffsets[level];
+		for (uint32_t y = 0U; y < GetLevelHeight(level); ++y)
+		{
+			uint32_t sourceY0 = std::min(y * 2U, sourceHeight - 1U);
+			uint32_t sourceY1 = std::min(y * 2U + 1U, sourceHeight - 1U);
+			for (uint32_t x = 0U; x < GetLevelWidth(level); ++x)
+			{
+				uint32_t sourceX0 = std::min(x * 2U, sourceWidth - 1U);
+				uint32_t sourceX1 = std::min(x * 2U + 1U, sourceWidth - 1U);
+				pTarget[y * GetLevelWidth(level) + x] = std::max(
+					std::max(pSource[sourceY0 * sourceWidth + sourceX0], pSource[sourceY0 * sourceWidth + sourceX1]),
+					std::max(pSource[sourceY1 * sourceWidth + sourceX0], pSource[sourceY1 * sourceWidth + sourceX1]));
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsVisible(const float* pCenter, const float* pExtent) const
+{
+	if (!(pExtent[0] < FLT_MAX && pExtent[1] < FLT_MAX && pExtent[2] < FLT_MAX))
+	{
+		return true;
+	}
+
+	// Screen rectangle and nearest depth of the box corners.
+	const float* pMatrix = m_viewProjection.begin();
+	float minX = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+	float minDepth = FLT_MAX;
+	for (uint32_t cornerIndex = 0U; cornerIndex < 8U; ++cornerIndex)
+	{
+		float corner[3];
+		for (uint32_t axis = 0U; axis < 3U; ++axis)
+		{
+			corner[axis] = (cornerIndex & (1U << axis)) ? pCenter[axis] + pExtent[axis] : pCenter[axis] - pExtent[axis];
+		}
+
+		float clip[4];
+		for (int row = 0; row < 4; ++row)
+		{
+			clip[row] = pMatrix[row] * corner[0] + pMatrix[4 + row] * corner[1] + pMatrix[8 + row] * corner[2] + pMatrix[12 + row];
+		}
+
+		if (!(GetClipDistance(clip[2], clip[3], 0U) >= 0.0f && GetClipDistance(clip[2], clip[3], 1U) >= 0.0f))
+		{
+			return true;
+		}
+
+		float inverseW = 1.0f / clip[3];
+		float screenX = (clip[0] * inverseW * 0.5f + 0.5f) * static_cast<float>(Width);
+		float screenY = (clip[1] * inverseW * 0.5f + 0.5f) * static_cast<float>(Height);
+		minX = std::min(minX, screenX);
+		maxX = std::max(maxX, screenX);
+		minY = std::min(minY, screenY);
+		maxY = std::max(maxY, screenY);
+		minDepth = std::min(minDepth, clip[2] * inverseW);
+	}
+
+	// Outside of the screen is up to frustum culling.
+	if (maxX < 0.0f || minX >= static_cast<float>(Width) || maxY < 0.0f || minY >= static_cast<float>(Height))
+	{
+		return true;
+	}
+
+	// All pixels which the rectangle touches.
+	uint32_t firstX = static_cast<uint32_t>(std::max(minX, 0.0f));
+	uint32_t lastX = static_cast<uint32_t>(std::min(maxX, static_cast<float>(Width - 1U)));
+	uint32_t firstY = static_cast<uint32_t>(std::max(minY, 0.0f));
+	uint32_t lastY = static_cast<uint32_t>(std::min(maxY, static_cast<float>(Height - 1U)));
+
+	// The first level where the rectangle covers at most 2x2 texels.
+	uint32_t level = 0U;
+	while (level + 1U < GetLevelCount() && ((lastX >> level) - (firstX >> level) > 1U || (lastY >> level) - (firstY >> level) > 1U))
+	{
+		++level;
+	}
+
+	for (uint32_t y = firstY >> level; y <= std::min(lastY >> level, GetLevelHeight(level) - 1U); ++y)
+	{
+		for (uint32_t x = firstX >> level; x <= std::min(lastX >> level, GetLevelWidth(level) - 1U); ++x)
+		{
+			if (minDepth <= GetDepth(level, x, y))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+}
\ No newline at end of file
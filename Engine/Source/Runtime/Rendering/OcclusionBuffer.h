@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// OcclusionBuffer rasterizes occluder triangles into a low resolution depth buffer on CPU and reduces it into a
+// Hi-Z pyramid which keeps the farthest depth of every texel footprint. A box is occluded when its nearest depth is
+// behind the farthest occluder depth in all texels which it covers.
+// Depth is z / w of the view projection matrix, which increases with view depth in both NDC depth conventions.
+class OcclusionBuffer
+{
+public:
+	static constexpr uint32_t Width = 256U;
+	static constexpr uint32_t Height = 128U;
+
+	// Meshes whose simplified versions fit in the budget within the error, relative to mesh extent, can be occluders.
+	static constexpr uint32_t MaxOccluderTriangleCount = 256U;
+	static constexpr float OccluderMaxError = 0.005f;
+
+	// Occluders covering most of the screen are rasterized first and the others are skipped.
+	static constexpr uint32_t MaxOccluderCountPerView = 32U;
+
+public:
+	OcclusionBuffer();
+	OcclusionBuffer(const OcclusionBuffer&) = delete;
+	OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+	OcclusionBuffer(OcclusionBuffer&&) = default;
+	OcclusionBuffer& operator=(OcclusionBuffer&&) = default;
+	~OcclusionBuffer() = default;
+
+	void Clear(const cd::Matrix4x4& viewProjection);
+
+	// Both faces of triangles are rasterized so that occluders don't depend on winding order.
+	void RasterizeOccluder(const cd::Matrix4x4& worldMatrix, std::span<const cd::Point> positions, std::span<const uint32_t> indices);
+
+	// Should be called after rasterizing occluders and before testing boxes.
+	void BuildHiZ();
+
+	// World space box as center and half extent. Boxes crossing the near plane are always visible.
+	bool IsVisible(const float* pCenter, const float* pExtent) const;
+
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_levelOffsets.size()); }
+	uint32_t GetLevelWidth(uint32_t level) const { return std::max(Width >> level, 1U); }
+	uint32_t GetLevelHeight(uint32_t level) const { return std::max(Height >> level, 1U); }
+	float GetDepth(uint32_t level, uint32_t x, uint32_t y) const { return m_depths[m_levelOffsets[level] + y * GetLevelWidth(level) + x]; }
+
+	uint32_t GetRasterizedTriangleCount() const { return m_rasterizedTriangleCount; }
+
+private:
+	struct ClipVertex
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	struct ScreenVertex
+	{
+		float x;
+		float y;
+		float depth;
+	};
+
+	void ClipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void RasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+
+private:
+	cd::Matrix4x4 m_viewProjection;
+	std::vector<ClipVertex> m_clipVertices;
+
+	// Level 0 is the rasterized depth buffer. Every next level halves width and height.
+	std::vector<float> m_depths;
+	std::vector<uint32_t> m_levelOffsets;
+	uint32_t m_rasterizedTriangleCount = 0U;
+};
+
+}
\ No newline at end of file
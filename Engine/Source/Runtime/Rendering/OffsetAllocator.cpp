@@ -0,0 +1,105 @@
+#include "OffsetAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace engine
+{
+
+OffsetAllocator::OffsetAllocator(uint32_t capacity)
+{
+	Reset(capacity);
+}
+
+void OffsetAllocator::Reset(uint32_t capacity)
+{
+	m_capacity = capacity;
+	m_freeSize = 0U;
+	m_freeRangesByOffset.clear();
+	m_freeRangesBySize.clear();
+	if (capacity > 0U)
+	{
+		AddFreeRange(0U, capacity);
+	}
+}
+
+uint32_t OffsetAllocator::Allocate(uint32_t size)
+{
+	assert(size > 0U);
+
+	// Best fit keeps large ranges for large meshes.
+	auto itBestFit = m_freeRangesBySize.lower_bound(size);
+	if (itBestFit == m_freeRangesBySize.end())
+	{
+		return InvalidOffset;
+	}
+
+	uint32_t offset = itBestFit->second;
+	uint32_t freeSize = itBestFit->first;
+	RemoveFreeRange(m_freeRangesByOffset.find(offset));
+	if (freeSize > size)
+	{
+		AddFreeRange(offset + size, freeSize - size);
+	}
+
+	return offset;
+}
+
+void OffsetAllocator::Free(uint32_t offset, uint32_t size)
+{
+	assert(size > 0U && offset + size <= m_capacity);
+
+	// Merge with the free neighbors so that freed space doesn't stay fragmented.
+	auto itNext = m_freeRangesByOffset.lower_bound(offset);
+	assert(itNext == m_freeRangesByOffset.end() || offset + size <= itNext->first);
+	if (itNext != m_freeRangesByOffset.end() && offset + size == itNext->first)
+	{
+		size += itNext->second;
+		auto itErase = itNext++;
+		RemoveFreeRange(itErase);
+	}
+
+	if (itNext != m_freeRangesByOffset.begin())
+	{
+		auto itPrevious = std::prev(itNext);
+		assert(itPrevious->first + itPrevious->second <= offset);
+		if (itPrevious->first + itPrevious->second == offset)
+		{
+			offset = itPrevious->first;
+			size += itPrevious->second;
+			RemoveFreeRange(itPrevious);
+		}
+	}
+
+	AddFreeRange(offset, size);
+}
+
+uint32_t OffsetAllocator::GetLargestFreeSize() const
+{
+	return m_freeRangesBySize.empty() ? 0U : m_freeRangesBySize.rbegin()->first;
+}
+
+void OffsetAllocator::AddFreeRange(uint32_t offset, uint32_t size)
+{
+	m_freeRangesByOffset.emplace(offset, size);
+	m_freeRangesBySize.emplace(size, offset);
+	m_freeSize += size;
+}
+
+void OffsetAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator itRange)
+{
+	auto [itBegin, itEnd] = m_freeRangesBySize.equal_range(itRange->second);
+	for (auto itSize = itBegin; itSize != itEnd; ++itSize)
+	{
+		if (itSize->second == itRange->first)
+		{
+			m_freeRangesBySize.erase(itSize);
+			break;
+		}
+	}
+
+	m_freeSize -= itRange->second;
+	m_freeRangesByOffset.erase(itRange);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+namespace engine
+{
+
+// OffsetAllocator hands out ranges of a fixed size buffer in units such as vertices or indices.
+// Free ranges are indexed by offset to merge neighbors when a range is freed, and by size to find the best fit.
+class OffsetAllocator
+{
+public:
+	static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+public:
+	OffsetAllocator() = default;
+	explicit OffsetAllocator(uint32_t capacity);
+	OffsetAllocator(const OffsetAllocator&) = default;
+	OffsetAllocator& operator=(const OffsetAllocator&) = default;
+	OffsetAllocator(OffsetAllocator&&) = default;
+	OffsetAllocator& operator=(OffsetAllocator&&) = default;
+	~OffsetAllocator() = default;
+
+	// Frees all ranges.
+	void Reset(uint32_t capacity);
+	uint32_t GetCapacity() const { return m_capacity; }
+
+	// Returns InvalidOffset if no free range is large enough.
+	uint32_t Allocate(uint32_t size);
+
+	// size : same as the one passed to Allocate.
+	void Free(uint32_t offset, uint32_t size);
+
+	uint32_t GetFreeSize() const { return m_freeSize; }
+	uint32_t GetLargestFreeSize() const;
+	uint32_t GetFreeRangeCount() const { return static_cast<uint32_t>(m_freeRangesByOffset.size()); }
+	bool IsEmpty() const { return m_freeSize == m_capacity; }
+
+private:
+	void AddFreeRange(uint32_t offset, uint32_t size);
+	void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator itRange);
+
+private:
+	uint32_t m_capacity = 0U;
+	uint32_t m_freeSize = 0U;
+
+	// offset -> size and size -> offset of the same free ranges.
+	std::map<uint32_t, uint32_t> m_freeRangesByOffset;
+	std::multimap<uint32_t, uint32_t> m_freeRangesBySize;
+};
+
+}
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "Rendering/RenderContext.h"
+#include "Rendering/Resources/MeshResource.h"
 #include "Rendering/Resources/ShaderResource.h"
+#include "Rendering/ShaderFeature.h"
 #include "Scene/Texture.h"
 
 namespace engine
@@ -22,6 +24,8 @@ constexpr const char* outLineSize  = "u_outLineSize";
 void OutLineRenderer::Init()
 {
 	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("OutLineProgram", "vs_outline", "fs_outline"));
+	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("OutLineProgram", "vs_outline", "fs_outline",
+		GetFeatureName(ShaderFeature::QUANTIZED_VERTEX)));
 
 	GetRenderContext()->CreateUniform(outLineColor, bgfx::UniformType::Vec4, 1);
 	GetRenderContext()->CreateUniform(outLineSize, bgfx::UniformType::Vec4, 1);
@@ -70,10 +74,11 @@ void OutLineRenderer::Render(float deltaTime)
 		{
 			continue;
 		}
+		const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
 			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
+			bgfx::setTransform(pMeshResource->GetDequantizedWorldMatrix(pTransformComponent->GetWorldMatrix()).begin());
 		}
 
 		constexpr StringCrc outLineColorCrc(outLineColor);
@@ -85,8 +90,10 @@ void OutLineRenderer::Render(float deltaTime)
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_CULL_CW;
 		bgfx::setState(state);
 
+		// Program names are suffixed by feature combines.
 		constexpr StringCrc programHandleIndex{ "OutLineProgram" };
-		SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), programHandleIndex);
+		constexpr StringCrc quantizedProgramHandleIndex{ "OutLineProgramQUANTIZEDVERTEX;" };
+		SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), pMeshResource->IsVertexQuantized() ? quantizedProgramHandleIndex : programHandleIndex);
 	}
 }
 
@@ -7,8 +7,11 @@
 #include "Log/Log.h"
 #include "Rendering/RenderContext.h"
 #include "Rendering/Resources/ShaderResource.h"
+#include "Scheduler/ThreadPool.h"
 #include "../UniformDefines/U_Particle.sh"
 
+#include <algorithm>
+
 namespace engine
 {
 
@@ -22,6 +25,8 @@ constexpr const char* particleColor = "u_particleColor";
 constexpr const char* ribbonCount = "u_ribbonCount";
 constexpr const char* ribbonMaxPos = "u_ribbonMaxPos";
 
+constexpr uint16_t instanceStride = 80;
+
 uint64_t state_tristrip = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS |
 BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA) | BGFX_STATE_PT_TRISTRIP;
 
@@ -90,13 +95,13 @@ void ParticleRenderer::Render(float deltaTime)
 		SetForceFieldRange(pForceFieldComponent,  forcefieldTransform.GetScale());
 	}
 
-	Entity pMainCameraEntity = m_pCurrentSceneWorld->GetMainCameraEntity();
+	// Particles are simulated on main thread because random values come from rand().
+	m_emitterEntities.clear();
+	m_instanceDataBuffers.clear();
 	for (Entity entity : m_pCurrentSceneWorld->GetParticleEmitterEntities())
 	{
 		const cd::Transform& particleTransform = m_pCurrentSceneWorld->GetTransformComponent(entity)->GetTransform();
-		const cd::Quaternion& particleRotation = m_pCurrentSceneWorld->GetTransformComponent(entity)->GetTransform().GetRotation();
 		ParticleEmitterComponent* pEmitterComponent = m_pCurrentSceneWorld->GetParticleEmitterComponent(entity);
-		ParticleRibbonComponent* pRibbonEmitterComponet = m_pCurrentSceneWorld->GetParticleRibbonComponent(entity);
 		MaterialComponent* pParticleMaterialComponet = m_pCurrentSceneWorld->GetMaterialComponent(entity);
 		//NOTE: This ShaderResource Not Used Just For Judge
 		const ShaderResource* pShaderResource = pParticleMaterialComponet->GetShaderResource();
@@ -106,8 +111,6 @@ void ParticleRenderer::Render(float deltaTime)
 			continue;
 		}
 
-		const cd::Transform& pMainCameraTransform = m_pCurrentSceneWorld->GetTransformComponent(pMainCameraEntity)->GetTransform();
-		//const cd::Quaternion& cameraRotation = pMainCameraTransform.GetRotation();
 		//Not include particle attribute
 		pEmitterComponent->GetParticlePool().SetParticleMaxCount(pEmitterComponent->GetSpawnCount());
 		pEmitterComponent->GetParticlePool().AllParticlesReset();
@@ -137,170 +140,210 @@ void ParticleRenderer::Render(float deltaTime)
 
 		pEmitterComponent->GetParticlePool().Update(1.0f/60.0f);
 
+		// Checking and allocating transient memory are not atomic together so that instance data is allocated here and filled by jobs.
+		bgfx::InstanceDataBuffer& idb = m_instanceDataBuffers.emplace_back();
 		if (pEmitterComponent->GetInstanceState())
 		{
-			//Particle Emitter Instance
-			const uint16_t instanceStride = 80;
 			// to total number of instances to draw
-			uint32_t totalSprites;
-			totalSprites = pEmitterComponent->GetParticlePool().GetParticleMaxCount();
+			uint32_t totalSprites = pEmitterComponent->GetParticlePool().GetParticleMaxCount();
 			uint32_t drawnSprites = bgfx::getAvailInstanceDataBuffer(totalSprites, instanceStride);
-
-			bgfx::InstanceDataBuffer idb;
 			bgfx::allocInstanceDataBuffer(&idb, drawnSprites, instanceStride);
+		}
+		m_emitterEntities.push_back(entity);
+	}
+
+	auto RecordEmitterRange = [this](size_t begin, size_t end)
+	{
+		bgfx::Encoder* pEncoder = GetRenderContext()->BeginEncoder();
+		for (size_t emitterIndex = begin; emitterIndex < end; ++emitterIndex)
+		{
+			RecordEmitter(pEncoder, emitterIndex);
+		}
+		GetRenderContext()->EndEncoder(pEncoder);
+	};
+
+	// The view sorts draws by itself so that encoders can record emitters in any order.
+	ThreadPool* pThreadPool = GetRenderContext()->GetThreadPool();
+	size_t emitterCount = m_emitterEntities.size();
+	if (!pThreadPool || emitterCount < 2)
+	{
+		RecordEmitterRange(0, emitterCount);
+		return;
+	}
+
+	size_t jobCount = std::min<size_t>(pThreadPool->GetWorkerCount() + 1, GetRenderContext()->GetMaxWorkerEncoderCount());
+	size_t batchSize = (emitterCount + jobCount - 1) / jobCount;
+	pThreadPool->ParallelFor(emitterCount, batchSize, RecordEmitterRange);
+}
+
+void ParticleRenderer::RecordEmitter(bgfx::Encoder* pEncoder, size_t emitterIndex)
+{
+	Entity entity = m_emitterEntities[emitterIndex];
+	Entity pMainCameraEntity = m_pCurrentSceneWorld->GetMainCameraEntity();
+	const cd::Transform& particleTransform = m_pCurrentSceneWorld->GetTransformComponent(entity)->GetTransform();
+	const cd::Quaternion& particleRotation = m_pCurrentSceneWorld->GetTransformComponent(entity)->GetTransform().GetRotation();
+	ParticleEmitterComponent* pEmitterComponent = m_pCurrentSceneWorld->GetParticleEmitterComponent(entity);
+	ParticleRibbonComponent* pRibbonEmitterComponet = m_pCurrentSceneWorld->GetParticleRibbonComponent(entity);
+	MaterialComponent* pParticleMaterialComponet = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+	const cd::Transform& pMainCameraTransform = m_pCurrentSceneWorld->GetTransformComponent(pMainCameraEntity)->GetTransform();
+	//const cd::Quaternion& cameraRotation = pMainCameraTransform.GetRotation();
+
+	if (pEmitterComponent->GetInstanceState())
+	{
+		//Particle Emitter Instance
+		const bgfx::InstanceDataBuffer& idb = m_instanceDataBuffers[emitterIndex];
+		uint32_t drawnSprites = idb.num;
+		uint8_t* data = idb.data;
+		for (uint32_t ii = 0; ii < drawnSprites; ++ii)
+		{
+			float* mtx = (float*)data;
+			bx::mtxSRT(mtx, particleTransform.GetScale().x(), particleTransform.GetScale().y(), particleTransform.GetScale().z(),
+				particleRotation.Pitch(), particleRotation.Yaw(), particleRotation.Roll(),
+				pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().x(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().y(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().z());
+			
+			float* color = (float*)&data[64];
+			color[0] = pEmitterComponent->GetEmitterColor().x();
+			color[1] = pEmitterComponent->GetEmitterColor().y();
+			color[2] = pEmitterComponent->GetEmitterColor().z();
+			color[3] = pEmitterComponent->GetEmitterColor().w();
+
+			data += instanceStride;
+		}
+
+		//Billboard particlePos particleScale
+		constexpr StringCrc particlePosCrc(particlePos);
+		pEncoder->setUniform(GetRenderContext()->GetUniform(particlePosCrc), &particleTransform.GetTranslation(), 1);
+		constexpr StringCrc ParticleScaleCrc(particleScale);
+		pEncoder->setUniform(GetRenderContext()->GetUniform(ParticleScaleCrc), &particleTransform.GetScale(), 1);
+
+		if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Sprite)
+		{
+			constexpr StringCrc ParticleSampler("s_texColor");
+			pEncoder->setTexture(0, GetRenderContext()->GetUniform(ParticleSampler), m_particleSpriteTextureHandle);
+			pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetSpriteParticleVertexBufferHandle() });
+			pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{  pEmitterComponent->GetSpriteParticleIndexBufferHandle() });
+		}
+		else if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Ribbon)
+		{
+			constexpr StringCrc ribbonParticleSampler("r_texColor");
+			pEncoder->setTexture(1, GetRenderContext()->GetUniform(ribbonParticleSampler), m_particleRibbonTextureHandle);
+			pEncoder->setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() });
+			pEncoder->setVertexBuffer(1, bgfx::VertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticleRemainVertexBufferHandle() });
+			pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{  pRibbonEmitterComponet->GetRibbonParticleIndexBufferHandle() });
+		}
+
+		pEncoder->setState(state_tristrip);
+		pEncoder->setInstanceDataBuffer(&idb);
+
+		SetRenderMode(pEncoder, pEmitterComponent->GetRenderMode(), pEmitterComponent->GetEmitterParticleType(), pParticleMaterialComponet);
+	}
+	else
+	{
+		constexpr StringCrc particleColorCrc(particleColor);
+		pEncoder->setUniform(GetRenderContext()->GetUniform(particleColorCrc), &pEmitterComponent->GetEmitterColor(), 1);
 
-			uint8_t* data = idb.data;
-			for (uint32_t ii = 0; ii < drawnSprites; ++ii)
+		uint32_t drawnSprites = pEmitterComponent->GetParticlePool().GetParticleMaxCount();
+		for (uint32_t ii = 0; ii < drawnSprites; ++ii)
+		{
+			float mtx[16];
+			if (pEmitterComponent->GetRenderMode() == engine::ParticleRenderMode::Mesh)
 			{
-				float* mtx = (float*)data;
 				bx::mtxSRT(mtx, particleTransform.GetScale().x(), particleTransform.GetScale().y(), particleTransform.GetScale().z(),
 					particleRotation.Pitch(), particleRotation.Yaw(), particleRotation.Roll(),
 					pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().x(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().y(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().z());
-				
-				float* color = (float*)&data[64];
-				color[0] = pEmitterComponent->GetEmitterColor().x();
-				color[1] = pEmitterComponent->GetEmitterColor().y();
-				color[2] = pEmitterComponent->GetEmitterColor().z();
-				color[3] = pEmitterComponent->GetEmitterColor().w();
-
-				data += instanceStride;
 			}
-
-			//Billboard particlePos particleScale
-			constexpr StringCrc particlePosCrc(particlePos);
-			bgfx::setUniform(GetRenderContext()->GetUniform(particlePosCrc), &particleTransform.GetTranslation(), 1);
-			constexpr StringCrc ParticleScaleCrc(particleScale);
-			bgfx::setUniform(GetRenderContext()->GetUniform(ParticleScaleCrc), &particleTransform.GetScale(), 1);
-
-			if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Sprite)
+			else if (pEmitterComponent->GetRenderMode() == engine::ParticleRenderMode::Billboard)
 			{
-				constexpr StringCrc ParticleSampler("s_texColor");
-				bgfx::setTexture(0, GetRenderContext()->GetUniform(ParticleSampler), m_particleSpriteTextureHandle);
-				bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetSpriteParticleVertexBufferHandle() });
-				bgfx::setIndexBuffer(bgfx::IndexBufferHandle{  pEmitterComponent->GetSpriteParticleIndexBufferHandle() });
+				auto up = particleTransform.GetRotation().ToMatrix3x3() * cd::Vec3f(0, 1, 0);
+				auto vec =  pMainCameraTransform.GetTranslation() - pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos();
+				auto right = up.Cross(vec);
+				float yaw = atan2f(right.z(), right.x());
+				float pitch = atan2f(vec.y(), sqrtf(vec.x() * vec.x() + vec.z() * vec.z())); 
+				float roll = atan2f(right.x(), -right.y()); 
+				bx::mtxSRT(mtx, particleTransform.GetScale().x(), particleTransform.GetScale().y(), particleTransform.GetScale().z(),
+					pitch, yaw, roll,
+					pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().x(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().y(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().z());
 			}
-			else if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Ribbon)
+			pEncoder->setTransform(mtx);
+			pEncoder->setState(state_tristrip);
+			if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Sprite)
 			{
-				constexpr StringCrc ribbonParticleSampler("r_texColor");
-				bgfx::setTexture(1, GetRenderContext()->GetUniform(ribbonParticleSampler), m_particleRibbonTextureHandle);
-				bgfx::setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() });
-				bgfx::setVertexBuffer(1, bgfx::VertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticleRemainVertexBufferHandle() });
-				bgfx::setIndexBuffer(bgfx::IndexBufferHandle{  pRibbonEmitterComponet->GetRibbonParticleIndexBufferHandle() });
+				constexpr StringCrc spriteParticleSampler("s_texColor");
+				pEncoder->setTexture(0, GetRenderContext()->GetUniform(spriteParticleSampler), m_particleSpriteTextureHandle);
+				pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetSpriteParticleVertexBufferHandle() });
+				pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{  pEmitterComponent->GetSpriteParticleIndexBufferHandle() });
 			}
-
-			bgfx::setState(state_tristrip);
-			bgfx::setInstanceDataBuffer(&idb);
-
-			SetRenderMode(pEmitterComponent->GetRenderMode(), pEmitterComponent->GetEmitterParticleType(), pParticleMaterialComponet);
-		}
-		else
-		{
-			constexpr StringCrc particleColorCrc(particleColor);
-			bgfx::setUniform(GetRenderContext()->GetUniform(particleColorCrc), &pEmitterComponent->GetEmitterColor(), 1);
-
-			uint32_t drawnSprites = pEmitterComponent->GetParticlePool().GetParticleMaxCount();
-			for (uint32_t ii = 0; ii < drawnSprites; ++ii)
+			else if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Ribbon)
 			{
-				float mtx[16];
-				if (pEmitterComponent->GetRenderMode() == engine::ParticleRenderMode::Mesh)
-				{
-					bx::mtxSRT(mtx, particleTransform.GetScale().x(), particleTransform.GetScale().y(), particleTransform.GetScale().z(),
-						particleRotation.Pitch(), particleRotation.Yaw(), particleRotation.Roll(),
-						pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().x(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().y(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().z());
-				}
-				else if (pEmitterComponent->GetRenderMode() == engine::ParticleRenderMode::Billboard)
-				{
-					auto up = particleTransform.GetRotation().ToMatrix3x3() * cd::Vec3f(0, 1, 0);
-					auto vec =  pMainCameraTransform.GetTranslation() - pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos();
-					auto right = up.Cross(vec);
-					float yaw = atan2f(right.z(), right.x());
-					float pitch = atan2f(vec.y(), sqrtf(vec.x() * vec.x() + vec.z() * vec.z())); 
-					float roll = atan2f(right.x(), -right.y()); 
-					bx::mtxSRT(mtx, particleTransform.GetScale().x(), particleTransform.GetScale().y(), particleTransform.GetScale().z(),
-						pitch, yaw, roll,
-						pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().x(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().y(), pEmitterComponent->GetParticlePool().GetParticle(ii).GetPos().z());
-				}
-				bgfx::setTransform(mtx);
-				bgfx::setState(state_tristrip);
-				if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Sprite)
+				pEncoder->setBuffer(PT_RIBBON_VERTEX_STAGE, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() }, bgfx::Access::ReadWrite);
+
+				//ribbonCount Uinform
+				constexpr StringCrc ribbontCounts(ribbonCount);
+				cd::Vec4f allRibbonCount{ static_cast<float>(pEmitterComponent->GetParticlePool().GetParticleMaxCount()* Particle::GetMeshVertexCount<ParticleType::Ribbon>()),
+					pEmitterComponent->GetParticlePool().GetParticleMaxCount(),
+					0,
+					0};
+				GetRenderContext()->FillUniform(pEncoder, ribbontCounts, &allRibbonCount, 1);
+
+				//ribbonListUniform
+				cd::Vec4f ribbonPosList[300]{};
+				for (int i = 0; i < 300; i++)
 				{
-					constexpr StringCrc spriteParticleSampler("s_texColor");
-					bgfx::setTexture(0, GetRenderContext()->GetUniform(spriteParticleSampler), m_particleSpriteTextureHandle);
-					bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetSpriteParticleVertexBufferHandle() });
-					bgfx::setIndexBuffer(bgfx::IndexBufferHandle{  pEmitterComponent->GetSpriteParticleIndexBufferHandle() });
-				}
-				else if (pEmitterComponent->GetEmitterParticleType() == engine::ParticleType::Ribbon)
-				{
-					bgfx::setBuffer(PT_RIBBON_VERTEX_STAGE, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() }, bgfx::Access::ReadWrite);
-
-					//ribbonCount Uinform
-					constexpr StringCrc ribbontCounts(ribbonCount);
-					cd::Vec4f allRibbonCount{ static_cast<float>(pEmitterComponent->GetParticlePool().GetParticleMaxCount()* Particle::GetMeshVertexCount<ParticleType::Ribbon>()),
-						pEmitterComponent->GetParticlePool().GetParticleMaxCount(),
-						0,
-						0};
-					GetRenderContext()->FillUniform(ribbontCounts, &allRibbonCount, 1);
-
-					//ribbonListUniform
-					cd::Vec4f ribbonPosList[300]{};
-					for (int i = 0; i < 300; i++)
+					if (i >= pEmitterComponent->GetParticlePool().GetParticleMaxCount())
+					{
+						ribbonPosList[i] = cd::Vec4f(0.0f,0.0f,0.0f,0.0f);
+					}
+					else
 					{
-						if (i >= pEmitterComponent->GetParticlePool().GetParticleMaxCount())
-						{
-							ribbonPosList[i] = cd::Vec4f(0.0f,0.0f,0.0f,0.0f);
-						}
-						else
-						{
-						ribbonPosList[i] =cd::Vec4f(pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().x(),
-							pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().y(),
-							pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().z()
-							, 0.0f);
-						}
+					ribbonPosList[i] =cd::Vec4f(pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().x(),
+						pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().y(),
+						pEmitterComponent->GetParticlePool().GetParticle(i).GetPos().z()
+						, 0.0f);
 					}
-					constexpr StringCrc maxPosList(ribbonMaxPos);
-					GetRenderContext()->FillUniform(maxPosList, &ribbonPosList, 300);
-					GetRenderContext()->Dispatch(GetViewID(), RibbonParticleProgramCsCrc, 1U, 1U, 1U);
-					//pEmitterComponent->UpdateRibbonPosBuffer();
-					constexpr StringCrc ribbonParticleSampler("r_texColor");
-					bgfx::setTexture(1, GetRenderContext()->GetUniform(ribbonParticleSampler), m_particleRibbonTextureHandle);
-					bgfx::setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() });
-					bgfx::setVertexBuffer(1, bgfx::VertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticleRemainVertexBufferHandle() });
-					bgfx::setIndexBuffer(bgfx::IndexBufferHandle{  pRibbonEmitterComponet->GetRibbonParticleIndexBufferHandle() });
 				}
-				SetRenderMode(pEmitterComponent->GetRenderMode(), pEmitterComponent->GetEmitterParticleType(),pParticleMaterialComponet);
+				constexpr StringCrc maxPosList(ribbonMaxPos);
+				GetRenderContext()->FillUniform(pEncoder, maxPosList, &ribbonPosList, 300);
+				GetRenderContext()->Dispatch(pEncoder, GetViewID(), RibbonParticleProgramCsCrc, 1U, 1U, 1U);
+				//pEmitterComponent->UpdateRibbonPosBuffer();
+				constexpr StringCrc ribbonParticleSampler("r_texColor");
+				pEncoder->setTexture(1, GetRenderContext()->GetUniform(ribbonParticleSampler), m_particleRibbonTextureHandle);
+				pEncoder->setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticlePrePosVertexBufferHandle() });
+				pEncoder->setVertexBuffer(1, bgfx::VertexBufferHandle{ pRibbonEmitterComponet->GetRibbonParticleRemainVertexBufferHandle() });
+				pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{  pRibbonEmitterComponet->GetRibbonParticleIndexBufferHandle() });
 			}
+			SetRenderMode(pEncoder, pEmitterComponent->GetRenderMode(), pEmitterComponent->GetEmitterParticleType(),pParticleMaterialComponet);
 		}
+	}
 
-		constexpr StringCrc emitShapeRangeCrc(shapeRange);
-		bgfx::setUniform(GetRenderContext()->GetUniform(emitShapeRangeCrc), &pEmitterComponent->GetEmitterShapeRange(), 1);
-		bgfx::setTransform(m_pCurrentSceneWorld->GetTransformComponent(entity)->GetWorldMatrix().begin());
-		bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetEmitterShapeVertexBufferHandle() });
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pEmitterComponent->GetEmitterShapeIndexBufferHandle() });
-		bgfx::setState(state_lines);
+	constexpr StringCrc emitShapeRangeCrc(shapeRange);
+	pEncoder->setUniform(GetRenderContext()->GetUniform(emitShapeRangeCrc), &pEmitterComponent->GetEmitterShapeRange(), 1);
+	pEncoder->setTransform(m_pCurrentSceneWorld->GetTransformComponent(entity)->GetWorldMatrix().begin());
+	pEncoder->setVertexBuffer(0, bgfx::VertexBufferHandle{ pEmitterComponent->GetEmitterShapeVertexBufferHandle() });
+	pEncoder->setIndexBuffer(bgfx::IndexBufferHandle{ pEmitterComponent->GetEmitterShapeIndexBufferHandle() });
+	pEncoder->setState(state_lines);
 
-		GetRenderContext()->Submit(GetViewID(), ParticleEmitterShapeProgramCrc);
-	}
+	GetRenderContext()->Submit(pEncoder, GetViewID(), ParticleEmitterShapeProgramCrc);
 }
 
-void ParticleRenderer::SetRenderMode(engine::ParticleRenderMode& rendermode, engine::ParticleType type, engine::MaterialComponent* shaderFeature_MaterialCompoent)
+void ParticleRenderer::SetRenderMode(bgfx::Encoder* pEncoder, engine::ParticleRenderMode& rendermode, engine::ParticleType type, engine::MaterialComponent* shaderFeature_MaterialCompoent)
 {
 	if (rendermode == engine::ParticleRenderMode::Mesh)
 	{
 		if (type == engine::ParticleType::Sprite)
 		{
 			const ShaderResource* pShaderResource = shaderFeature_MaterialCompoent->GetShaderResource();
-			GetRenderContext()->Submit(GetViewID(), pShaderResource->GetHandle());
+			GetRenderContext()->Submit(pEncoder, GetViewID(), pShaderResource->GetHandle());
 		}
 		else if (type == engine::ParticleType::Ribbon)
 		{
-			GetRenderContext()->Submit(GetViewID(), RibbonParticleProgramCrc);
+			GetRenderContext()->Submit(pEncoder, GetViewID(), RibbonParticleProgramCrc);
 		}
 	}
 	else if (rendermode == engine::ParticleRenderMode::Billboard)
 	{
 		if (type == engine::ParticleType::Sprite)
 		{
-			GetRenderContext()->Submit(GetViewID(), WO_BillboardParticleProgramCrc);
+			GetRenderContext()->Submit(pEncoder, GetViewID(), WO_BillboardParticleProgramCrc);
 		}
 		else if (type == engine::ParticleType::Ribbon)
 		{
@@ -8,6 +8,8 @@
 #include "RenderContext.h"
 #include "Rendering/Utility/VertexLayoutUtility.h"
 
+#include <vector>
+
 namespace engine
 {
 
@@ -27,11 +29,19 @@ public:
 	void SetForceFieldRotationForce(ParticleForceFieldComponent* forcefield) { m_forcefieldRotationFoce = forcefield->GetRotationForce(); }
 	void SetForceFieldRange(ParticleForceFieldComponent* forcefield ,cd::Vec3f scale) { m_forcefieldRange = forcefield->GetForceFieldRange()*scale; }
 
-	void SetRenderMode(engine::ParticleRenderMode& rendermode, engine::ParticleType type, engine::MaterialComponent* materialcomponent);
+	void SetRenderMode(bgfx::Encoder* pEncoder, engine::ParticleRenderMode& rendermode, engine::ParticleType type, engine::MaterialComponent* materialcomponent);
 	void SetRandomPosState(engine::Particle& particle, cd::Vec3f value, cd::Vec3f randomvalue, bool state);
 	void SetRandomVelocityState(engine::Particle& particle, cd::Vec3f value, cd::Vec3f randomvalue, bool state);
+
+private:
+	// Records on worker threads after particles of the emitter are simulated.
+	void RecordEmitter(bgfx::Encoder* pEncoder, size_t emitterIndex);
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	// Emitters to record in current frame. Instance data of an emitter is empty when it doesn't draw instances.
+	std::vector<Entity> m_emitterEntities;
+	std::vector<bgfx::InstanceDataBuffer> m_instanceDataBuffers;
 	bgfx::TextureHandle m_particleSpriteTextureHandle;
 	bgfx::TextureHandle m_particleRibbonTextureHandle;
 	ParticleType m_currentType = ParticleType::Sprite;
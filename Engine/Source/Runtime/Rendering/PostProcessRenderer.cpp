@@ -16,6 +16,16 @@ void PostProcessRenderer::Init()
 	bgfx::setViewName(GetViewID(), "PostProcessRenderer");
 }
 
+void PostProcessRenderer::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
+{
+	Renderer::SetupRenderPass(pRenderGraph, passID);
+
+	// Reads the blit copy when it outputs to the scene render target.
+	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
+	constexpr StringCrc sceneRenderTargetBlit("SceneRenderTargetBlit");
+	pRenderGraph->Read(passID, pRenderGraph->ImportResource(m_pRenderTarget ? sceneRenderTargetBlit : sceneRenderTarget));
+}
+
 void PostProcessRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
 {
 	UpdateViewRenderTarget();
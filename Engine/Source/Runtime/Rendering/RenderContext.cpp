@@ -89,6 +89,7 @@ void RenderContext::Init(GraphicsBackend backend, void* hwnd)
 	}
 
 	initDesc.platformData.nwh = hwnd;
+	initDesc.limits.maxEncoders = MaxEncoderCount;
 	bgfx::init(initDesc);
 }
 
@@ -103,21 +104,55 @@ void RenderContext::Shutdown()
 	{
 		bgfx::destroy(bgfx::UniformHandle{ it.second });
 	}
+
+	for (bgfx::FrameBufferHandle frameBufferHandle : m_transientFrameBuffers)
+	{
+		bgfx::destroy(frameBufferHandle);
+	}
+	m_transientFrameBuffers.clear();
+	m_transientFrameBufferDescs.clear();
 }
 
 void RenderContext::BeginFrame()
 {
+	m_lastFrameDrawStats = m_drawStats;
+	m_drawStats.Reset();
 }
 
-void RenderContext::Submit(uint16_t viewID, uint16_t programHandle)
+void RenderContext::Submit(uint16_t viewID, uint16_t programHandle, uint8_t discardFlags)
 {
 	assert(bgfx::isValid(bgfx::ProgramHandle{ programHandle }));
-	bgfx::submit(viewID, bgfx::ProgramHandle{ programHandle });
+	bgfx::submit(viewID, bgfx::ProgramHandle{ programHandle }, 0, discardFlags);
+}
+
+void RenderContext::Submit(uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags)
+{
+	Submit(viewID, m_pResourceContext->GetShaderResource(programHandleIndex)->GetHandle(), discardFlags);
+}
+
+void RenderContext::Submit(bgfx::Encoder* pEncoder, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags)
+{
+	assert(pEncoder && bgfx::isValid(bgfx::ProgramHandle{ programHandle }));
+	pEncoder->submit(viewID, bgfx::ProgramHandle{ programHandle }, 0, discardFlags);
 }
 
-void RenderContext::Submit(uint16_t viewID, StringCrc programHandleIndex)
+void RenderContext::Submit(bgfx::Encoder* pEncoder, uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags)
 {
-	Submit(viewID, m_pResourceContext->GetShaderResource(programHandleIndex)->GetHandle());
+	Submit(pEncoder, viewID, m_pResourceContext->GetShaderResource(programHandleIndex)->GetHandle(), discardFlags);
+}
+
+bgfx::Encoder* RenderContext::BeginEncoder()
+{
+	bgfx::Encoder* pEncoder = bgfx::begin(true);
+	assert(pEncoder && "Too many encoders at the same time.");
+	m_activeEncoderCount.fetch_add(1, std::memory_order_relaxed);
+	return pEncoder;
+}
+
+void RenderContext::EndEncoder(bgfx::Encoder* pEncoder)
+{
+	bgfx::end(pEncoder);
+	m_activeEncoderCount.fetch_sub(1, std::memory_order_relaxed);
 }
 
 void RenderContext::Dispatch(uint16_t viewID, uint16_t programHandle, uint32_t numX, uint32_t numY, uint32_t numZ)
@@ -130,10 +165,18 @@ void RenderContext::Dispatch(uint16_t viewID, StringCrc programHandleIndex, uint
 	Dispatch(viewID, m_pResourceContext->GetShaderResource(programHandleIndex)->GetHandle(), numX, numY, numZ);
 }
 
+void RenderContext::Dispatch(bgfx::Encoder* pEncoder, uint16_t viewID, StringCrc programHandleIndex, uint32_t numX, uint32_t numY, uint32_t numZ)
+{
+	bgfx::ProgramHandle programHandle{ m_pResourceContext->GetShaderResource(programHandleIndex)->GetHandle() };
+	assert(pEncoder && bgfx::isValid(programHandle));
+	pEncoder->dispatch(viewID, programHandle, numX, numY, numZ);
+}
+
 void RenderContext::EndFrame()
 {
 	// Advance to next frame. Rendering thread will be kicked to
 	// process submitted rendering primitives.
+	assert(0U == m_activeEncoderCount.load(std::memory_order_relaxed));
 	bgfx::frame();
 }
 
@@ -144,6 +187,48 @@ void RenderContext::OnResize(uint16_t width, uint16_t height)
 	m_backBufferHeight = height;
 }
 
+void RenderContext::UpdateTransientFrameBuffers()
+{
+	const std::vector<RenderGraphTextureDesc>& physicalTextureDescs = m_renderGraph.GetPhysicalTextureDescs();
+	size_t physicalTextureCount = physicalTextureDescs.size();
+
+	// Textures of culled and disabled passes are released.
+	for (size_t frameBufferIndex = physicalTextureCount; frameBufferIndex < m_transientFrameBuffers.size(); ++frameBufferIndex)
+	{
+		bgfx::destroy(m_transientFrameBuffers[frameBufferIndex]);
+	}
+	m_transientFrameBuffers.resize(physicalTextureCount, BGFX_INVALID_HANDLE);
+	m_transientFrameBufferDescs.resize(physicalTextureCount);
+
+	for (size_t frameBufferIndex = 0; frameBufferIndex < physicalTextureCount; ++frameBufferIndex)
+	{
+		const RenderGraphTextureDesc& desc = physicalTextureDescs[frameBufferIndex];
+		bgfx::FrameBufferHandle& frameBufferHandle = m_transientFrameBuffers[frameBufferIndex];
+		if (bgfx::isValid(frameBufferHandle) && m_transientFrameBufferDescs[frameBufferIndex] == desc)
+		{
+			continue;
+		}
+
+		if (bgfx::isValid(frameBufferHandle))
+		{
+			bgfx::destroy(frameBufferHandle);
+		}
+		frameBufferHandle = bgfx::createFrameBuffer(desc.width, desc.height, static_cast<bgfx::TextureFormat::Enum>(desc.format), desc.flags);
+		m_transientFrameBufferDescs[frameBufferIndex] = desc;
+	}
+}
+
+bgfx::FrameBufferHandle RenderContext::GetTransientFrameBuffer(StringCrc resourceCrc) const
+{
+	uint32_t physicalIndex = m_renderGraph.GetPhysicalTextureIndex(resourceCrc);
+	if (RenderGraph::InvalidID == physicalIndex || physicalIndex >= m_transientFrameBuffers.size())
+	{
+		return BGFX_INVALID_HANDLE;
+	}
+
+	return m_transientFrameBuffers[physicalIndex];
+}
+
 uint16_t RenderContext::CreateView()
 {
 	assert(m_currentViewCount < MaxViewCount && "Overflow the max count of views.");
@@ -187,6 +272,28 @@ ShaderResource* RenderContext::RegisterShaderProgram(const std::string& programN
 	return pShaderResource;
 }
 
+ShaderResource* RenderContext::RegisterShaderVariant(const ShaderResource* pShaderResource, const std::string& combine)
+{
+	const std::string& programName = pShaderResource->GetName();
+	if (ShaderResource* pVariantShaderResource = m_pResourceContext->GetShaderResource(StringCrc{ programName + combine }))
+	{
+		return pVariantShaderResource;
+	}
+
+	ShaderResource* pVariantShaderResource = nullptr;
+	if (ShaderProgramType::Standard == pShaderResource->GetType())
+	{
+		pVariantShaderResource = RegisterShaderProgram(programName, pShaderResource->GetShaderInfo(0).name, pShaderResource->GetShaderInfo(1).name, combine);
+	}
+	else
+	{
+		pVariantShaderResource = RegisterShaderProgram(programName, pShaderResource->GetShaderInfo(0).name, pShaderResource->GetType(), combine);
+	}
+
+	AddRecompileShaderResource(pVariantShaderResource);
+	return pVariantShaderResource;
+}
+
 void RenderContext::OnShaderHotModified(std::string modifiedShaderName)
 {
 	// Delete all related compiled uber shader file.
@@ -487,6 +594,11 @@ void RenderContext::FillUniform(StringCrc resourceCrc, const void *pData, uint16
 	bgfx::setUniform(GetUniform(resourceCrc), pData, vec4Count);
 }
 
+void RenderContext::FillUniform(bgfx::Encoder* pEncoder, StringCrc resourceCrc, const void* pData, uint16_t vec4Count) const
+{
+	pEncoder->setUniform(GetUniform(resourceCrc), pData, vec4Count);
+}
+
 RenderTarget* RenderContext::GetRenderTarget(StringCrc resourceCrc) const
 {
 	auto itResource = m_renderTargetCaches.find(resourceCrc);
@@ -1,15 +1,18 @@
 #pragma once
 
 #include "Core/StringCrc.h"
+#include "DrawStateCache.h"
 #include "Graphics/GraphicsBackend.h"
 #include "Math/Matrix.hpp"
 #include "Rendering/ShaderType.h"
+#include "RenderGraph.h"
 #include "RenderTarget.h"
 #include "Scene/VertexAttribute.h"
 #include "Scene/VertexFormat.h"
 
 #include <bgfx/bgfx.h>
 
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -24,9 +27,11 @@ class Camera;
 class Renderer;
 class ResourceContext;
 class ShaderResource;
+class ThreadPool;
 
 static constexpr uint8_t MaxViewCount = 255;
 static constexpr uint8_t MaxRenderTargetCount = 255;
+static constexpr uint16_t MaxEncoderCount = 8;
 
 // In current design, RenderContext needs to be a singleton.
 // The reason is that it binds to bgfx graphics initialization which should only happen once.
@@ -46,20 +51,43 @@ public:
 	void Init(GraphicsBackend backend, void* hwnd = nullptr);
 	void OnResize(uint16_t width, uint16_t height);
 	void BeginFrame();
-	void Submit(uint16_t viewID, uint16_t programHandle);
-	void Submit(uint16_t viewID, StringCrc programHandleIndex);
+	void Submit(uint16_t viewID, uint16_t programHandle, uint8_t discardFlags = BGFX_DISCARD_ALL);
+	void Submit(uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags = BGFX_DISCARD_ALL);
+	void Submit(bgfx::Encoder* pEncoder, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags = BGFX_DISCARD_ALL);
+	void Submit(bgfx::Encoder* pEncoder, uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags = BGFX_DISCARD_ALL);
 	void Dispatch(uint16_t viewID, uint16_t programHandle, uint32_t numX, uint32_t numY, uint32_t numZ);
 	void Dispatch(uint16_t viewID, StringCrc programHandleIndex, uint32_t numX, uint32_t numY, uint32_t numZ);
+	void Dispatch(bgfx::Encoder* pEncoder, uint16_t viewID, StringCrc programHandleIndex, uint32_t numX, uint32_t numY, uint32_t numZ);
 	void EndFrame();
 	void Shutdown();
 
 	void SetResourceContext(ResourceContext* pContext) { m_pResourceContext = pContext; }
 	ResourceContext* GetResourceContext() const { return m_pResourceContext; }
 
+	// Renderers record draws of independent views on workers through encoders. bgfx merges them in EndFrame.
+	// All encoders have to be ended before EndFrame.
+	void SetThreadPool(ThreadPool* pThreadPool) { m_pThreadPool = pThreadPool; }
+	ThreadPool* GetThreadPool() const { return m_pThreadPool; }
+	bgfx::Encoder* BeginEncoder();
+	void EndEncoder(bgfx::Encoder* pEncoder);
+	// Main thread keeps one encoder for global bgfx APIs.
+	uint16_t GetMaxWorkerEncoderCount() const { return MaxEncoderCount - 1; }
+
 	uint16_t GetBackBufferWidth() const { return m_backBufferWidth; }
 	uint16_t GetBackBufferHeight() const { return m_backBufferHeight; }
 	void SetBackBufferSize(uint16_t width, uint16_t height) { m_backBufferWidth = width; m_backBufferHeight = height; }
 
+	// Renderers merge counters of their DrawStateCaches here. BeginFrame keeps them as last frame stats.
+	DrawStats& GetDrawStats() { return m_drawStats; }
+	const DrawStats& GetLastFrameDrawStats() const { return m_lastFrameDrawStats; }
+
+	// Apps rebuild the graph every frame before renderers. Frame buffers of transient textures are kept
+	// across frames while their descs don't change and destroyed when no active pass uses them.
+	RenderGraph* GetRenderGraph() { return &m_renderGraph; }
+	const RenderGraph* GetRenderGraph() const { return &m_renderGraph; }
+	void UpdateTransientFrameBuffers();
+	bgfx::FrameBufferHandle GetTransientFrameBuffer(StringCrc resourceCrc) const;
+
 	uint16_t CreateView();
 	void ResetViewCount() { m_currentViewCount = 0; }
 	uint16_t GetCurrentViewCount() const { return m_currentViewCount; }
@@ -68,6 +96,9 @@ public:
 	ShaderResource* RegisterShaderProgram(const std::string& programName, const std::string& vsName, const std::string& fsName, const std::string& combine = "");
 	// For non-Standard ShaderProgramType
 	ShaderResource* RegisterShaderProgram(const std::string& programName, const std::string& shaderName, ShaderProgramType type, const std::string& combine = "");
+	// Registers the same program as pShaderResource with another feature combine. New variants are added to recompile list
+	// so that the editor builds them. Games load prebuilt variants.
+	ShaderResource* RegisterShaderVariant(const ShaderResource* pShaderResource, const std::string& combine);
 
 	void AddShaderResource(StringCrc shaderName, ShaderResource* resource) { m_shaderResources.insert({ shaderName, resource }); }
 	void DeleteShaderResource(StringCrc shaderName) { m_shaderResources.erase(shaderName); }
@@ -110,6 +141,7 @@ public:
 	void SetTexture(StringCrc resourceCrc, bgfx::TextureHandle textureHandle);
 	void SetUniform(StringCrc resourceCrc, bgfx::UniformHandle uniformreHandle);
 	void FillUniform(StringCrc resourceCrc, const void *pData, uint16_t vec4Count = 1) const;
+	void FillUniform(bgfx::Encoder* pEncoder, StringCrc resourceCrc, const void* pData, uint16_t vec4Count = 1) const;
 
 	RenderTarget* GetRenderTarget(StringCrc resourceCrc) const;
 	const bgfx::VertexLayout& GetVertexAttributeLayouts(StringCrc resourceCrc) const;
@@ -122,11 +154,20 @@ public:
 
 private:
 	ResourceContext* m_pResourceContext = nullptr;
+	ThreadPool* m_pThreadPool = nullptr;
+	std::atomic<uint32_t> m_activeEncoderCount = 0U;
 
 	uint8_t m_currentViewCount = 0;
 	uint16_t m_backBufferWidth;
 	uint16_t m_backBufferHeight;
 
+	DrawStats m_drawStats;
+	DrawStats m_lastFrameDrawStats;
+
+	RenderGraph m_renderGraph;
+	std::vector<RenderGraphTextureDesc> m_transientFrameBufferDescs;
+	std::vector<bgfx::FrameBufferHandle> m_transientFrameBuffers;
+
 	std::unordered_map<StringCrc, std::unique_ptr<RenderTarget>> m_renderTargetCaches;
 	std::unordered_map<StringCrc, bgfx::VertexLayout> m_vertexLayoutCaches;
 	std::unordered_map<StringCrc, uint16_t> m_textureHandleCaches;
@@ -0,0 +1,198 @@
+#include "RenderGraph.h"
+
+#include "Base/Template.h"
+
+#include <cassert>
+
+namespace engine
+{
+
+void RenderGraph::Reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_resourceIDs.clear();
+	m_physicalTextureDescs.clear();
+	m_activePassCount = 0U;
+	m_transientTextureCount = 0U;
+}
+
+RenderGraph::ResourceID RenderGraph::ImportResource(StringCrc name, bool isOutput)
+{
+	auto itResource = m_resourceIDs.find(name);
+	if (itResource != m_resourceIDs.end())
+	{
+		Resource& resource = m_resources[itResource->second];
+		assert(!resource.isTransient && "Transient texture can't be imported.");
+		resource.isOutput |= isOutput;
+		return itResource->second;
+	}
+
+	ResourceID resourceID = static_cast<ResourceID>(m_resources.size());
+	m_resources.push_back(Resource{ name, RenderGraphTextureDesc(), false, isOutput, InvalidID, InvalidID, InvalidID });
+	m_resourceIDs[name] = resourceID;
+	return resourceID;
+}
+
+RenderGraph::ResourceID RenderGraph::CreateTexture(StringCrc name, const RenderGraphTextureDesc& desc)
+{
+	assert(!m_resourceIDs.contains(name) && "Transient texture is created twice.");
+
+	ResourceID resourceID = static_cast<ResourceID>(m_resources.size());
+	m_resources.push_back(Resource{ name, desc, true, false, InvalidID, InvalidID, InvalidID });
+	m_resourceIDs[name] = resourceID;
+	return resourceID;
+}
+
+RenderGraph::ResourceID RenderGraph::GetResource(StringCrc name) const
+{
+	auto itResource = m_resourceIDs.find(name);
+	return itResource != m_resourceIDs.end() ? itResource->second : InvalidID;
+}
+
+RenderGraph::PassID RenderGraph::AddPass(std::string name, bool isEnable)
+{
+	PassID passID = static_cast<PassID>(m_passes.size());
+	Pass& pass = m_passes.emplace_back();
+	pass.name = cd::MoveTemp(name);
+	pass.isEnable = isEnable;
+	pass.isActive = false;
+	return passID;
+}
+
+void RenderGraph::Read(PassID passID, ResourceID resourceID)
+{
+	assert(passID < m_passes.size() && resourceID < m_resources.size());
+	m_passes[passID].reads.push_back(resourceID);
+}
+
+void RenderGraph::Write(PassID passID, ResourceID resourceID)
+{
+	assert(passID < m_passes.size() && resourceID < m_resources.size());
+	m_passes[passID].writes.push_back(resourceID);
+}
+
+void RenderGraph::Compile()
+{
+	// Cull passes from the last one. A resource is needed if an output or an active pass after current one reads it.
+	// Writes don't end the need because passes can write a part of the resource such as a render target shared by passes.
+	std::vector<bool> isResourceNeeded(m_resources.size(), false);
+	for (size_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+	{
+		isResourceNeeded[resourceIndex] = m_resources[resourceIndex].isOutput;
+	}
+
+	m_activePassCount = 0U;
+	for (size_t passIndex = m_passes.size(); passIndex-- > 0;)
+	{
+		Pass& pass = m_passes[passIndex];
+		pass.isActive = false;
+		if (!pass.isEnable)
+		{
+			continue;
+		}
+
+		for (ResourceID resourceID : pass.writes)
+		{
+			pass.isActive |= isResourceNeeded[resourceID];
+		}
+
+		if (pass.isActive)
+		{
+			++m_activePassCount;
+			for (ResourceID resourceID : pass.reads)
+			{
+				isResourceNeeded[resourceID] = true;
+			}
+		}
+	}
+
+	// Lifetimes of transient textures.
+	for (Resource& resource : m_resources)
+	{
+		resource.firstPass = InvalidID;
+		resource.lastPass = InvalidID;
+		resource.physicalIndex = InvalidID;
+	}
+
+	auto UpdateLifetime = [this](PassID passID, ResourceID resourceID)
+	{
+		Resource& resource = m_resources[resourceID];
+		if (resource.isTransient)
+		{
+			resource.firstPass = InvalidID == resource.firstPass ? passID : resource.firstPass;
+			resource.lastPass = passID;
+		}
+	};
+
+	for (PassID passID = 0U; passID < m_passes.size(); ++passID)
+	{
+		const Pass& pass = m_passes[passID];
+		if (pass.isActive)
+		{
+			for (ResourceID resourceID : pass.reads)
+			{
+				UpdateLifetime(passID, resourceID);
+			}
+			for (ResourceID resourceID : pass.writes)
+			{
+				UpdateLifetime(passID, resourceID);
+			}
+		}
+	}
+
+	// Assign physical textures in pass order. Textures of a pass are all allocated before any of them is released
+	// so that textures used by the same pass never alias.
+	std::vector<std::vector<ResourceID>> firstUses(m_passes.size());
+	std::vector<std::vector<ResourceID>> lastUses(m_passes.size());
+	m_transientTextureCount = 0U;
+	for (ResourceID resourceID = 0U; resourceID < m_resources.size(); ++resourceID)
+	{
+		const Resource& resource = m_resources[resourceID];
+		if (resource.isTransient && InvalidID != resource.firstPass)
+		{
+			firstUses[resource.firstPass].push_back(resourceID);
+			lastUses[resource.lastPass].push_back(resourceID);
+			++m_transientTextureCount;
+		}
+	}
+
+	m_physicalTextureDescs.clear();
+	std::vector<bool> isPhysicalTextureFree;
+	for (PassID passID = 0U; passID < m_passes.size(); ++passID)
+	{
+		for (ResourceID resourceID : firstUses[passID])
+		{
+			Resource& resource = m_resources[resourceID];
+			for (uint32_t physicalIndex = 0U; physicalIndex < m_physicalTextureDescs.size(); ++physicalIndex)
+			{
+				if (isPhysicalTextureFree[physicalIndex] && m_physicalTextureDescs[physicalIndex] == resource.desc)
+				{
+					resource.physicalIndex = physicalIndex;
+					isPhysicalTextureFree[physicalIndex] = false;
+					break;
+				}
+			}
+
+			if (InvalidID == resource.physicalIndex)
+			{
+				resource.physicalIndex = static_cast<uint32_t>(m_physicalTextureDescs.size());
+				m_physicalTextureDescs.push_back(resource.desc);
+				isPhysicalTextureFree.push_back(false);
+			}
+		}
+
+		for (ResourceID resourceID : lastUses[passID])
+		{
+			isPhysicalTextureFree[m_resources[resourceID].physicalIndex] = true;
+		}
+	}
+}
+
+uint32_t RenderGraph::GetPhysicalTextureIndex(StringCrc name) const
+{
+	ResourceID resourceID = GetResource(name);
+	return InvalidID != resourceID ? GetPhysicalTextureIndex(resourceID) : InvalidID;
+}
+
+}
\ No newline at end of file
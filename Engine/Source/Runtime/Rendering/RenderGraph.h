@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Core/StringCrc.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+// Transient textures are created as frame buffers with a single color attachment.
+struct RenderGraphTextureDesc
+{
+	uint16_t width = 0U;
+	uint16_t height = 0U;
+	// bgfx::TextureFormat::Enum
+	uint16_t format = 0U;
+	uint64_t flags = 0U;
+
+	bool operator==(const RenderGraphTextureDesc&) const = default;
+};
+
+// RenderGraph is rebuilt every frame. Passes are added in execution order and declare resources which they read and write.
+// Compile walks passes backwards and culls disabled passes and passes whose writes are not consumed by a later active pass
+// or a graph output. Then transient textures get physical textures : textures with the same desc share one physical texture
+// when their lifetimes in active passes don't overlap.
+class RenderGraph
+{
+public:
+	using PassID = uint32_t;
+	using ResourceID = uint32_t;
+	static constexpr uint32_t InvalidID = UINT32_MAX;
+
+public:
+	RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+	RenderGraph(RenderGraph&&) = default;
+	RenderGraph& operator=(RenderGraph&&) = default;
+	~RenderGraph() = default;
+
+	// Clears passes and resources but keeps allocated memory for next frame.
+	void Reset();
+
+	// Imported resources live outside of the graph such as the scene render target or shadow maps.
+	// isOutput : consumed after the graph so that passes writing it are never culled.
+	// Importing the same name again returns the same resource.
+	ResourceID ImportResource(StringCrc name, bool isOutput = false);
+	ResourceID CreateTexture(StringCrc name, const RenderGraphTextureDesc& desc);
+	ResourceID GetResource(StringCrc name) const;
+	bool IsTransient(ResourceID resourceID) const { return m_resources[resourceID].isTransient; }
+	const RenderGraphTextureDesc& GetTextureDesc(ResourceID resourceID) const { return m_resources[resourceID].desc; }
+
+	PassID AddPass(std::string name, bool isEnable = true);
+	void Read(PassID passID, ResourceID resourceID);
+	void Write(PassID passID, ResourceID resourceID);
+	size_t GetPassCount() const { return m_passes.size(); }
+	const std::string& GetPassName(PassID passID) const { return m_passes[passID].name; }
+
+	void Compile();
+
+	bool IsPassActive(PassID passID) const { return m_passes[passID].isActive; }
+	uint32_t GetActivePassCount() const { return m_activePassCount; }
+
+	// Returns InvalidID if the resource is not transient or not used by any active pass.
+	uint32_t GetPhysicalTextureIndex(ResourceID resourceID) const { return m_resources[resourceID].physicalIndex; }
+	uint32_t GetPhysicalTextureIndex(StringCrc name) const;
+	const std::vector<RenderGraphTextureDesc>& GetPhysicalTextureDescs() const { return m_physicalTextureDescs; }
+	uint32_t GetTransientTextureCount() const { return m_transientTextureCount; }
+
+private:
+	struct Resource
+	{
+		StringCrc name;
+		RenderGraphTextureDesc desc;
+		bool isTransient;
+		bool isOutput;
+
+		// Compiled lifetime in active passes.
+		PassID firstPass;
+		PassID lastPass;
+		uint32_t physicalIndex;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		std::vector<ResourceID> reads;
+		std::vector<ResourceID> writes;
+		bool isEnable;
+		bool isActive;
+	};
+
+private:
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::unordered_map<StringCrc, ResourceID> m_resourceIDs;
+	std::vector<RenderGraphTextureDesc> m_physicalTextureDescs;
+	uint32_t m_activePassCount = 0U;
+	uint32_t m_transientTextureCount = 0U;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+
+namespace
+{
+
+constexpr uint32_t RadixBits = 8U;
+constexpr uint32_t RadixSize = 1U << RadixBits;
+constexpr uint32_t RadixPassCount = 64U / RadixBits;
+
+uint64_t QuantizeDepth(float depth)
+{
+	constexpr float maxDepthValue = static_cast<float>((1U << RenderQueue::DepthBits) - 1U);
+	float clampedDepth = std::clamp(depth, 0.0f, 1.0f);
+	return static_cast<uint64_t>(clampedDepth * maxDepthValue + 0.5f);
+}
+
+uint64_t MaskBits(uint64_t value, uint32_t bitCount)
+{
+	return value & ((static_cast<uint64_t>(1) << bitCount) - 1U);
+}
+
+}
+
+uint64_t RenderQueue::MakeOpaqueKey(uint16_t viewID, uint16_t programKey, uint16_t materialKey, uint16_t meshKey, float depth)
+{
+	uint64_t key = MaskBits(viewID, ViewBits);
+	key = (key << TranslucentBits);
+	key = (key << ProgramBits) | MaskBits(programKey, ProgramBits);
+	key = (key << MaterialBits) | MaskBits(materialKey, MaterialBits);
+	key = (key << MeshBits) | MaskBits(meshKey, MeshBits);
+	key = (key << DepthBits) | QuantizeDepth(depth);
+	return key;
+}
+
+uint64_t RenderQueue::MakeTranslucentKey(uint16_t viewID, uint16_t programKey, uint16_t materialKey, uint16_t meshKey, float depth)
+{
+	constexpr uint64_t maxDepthValue = (1U << DepthBits) - 1U;
+
+	uint64_t key = MaskBits(viewID, ViewBits);
+	key = (key << TranslucentBits) | 1U;
+	key = (key << DepthBits) | (maxDepthValue - QuantizeDepth(depth));
+	key = (key << ProgramBits) | MaskBits(programKey, ProgramBits);
+	key = (key << MaterialBits) | MaskBits(materialKey, MaterialBits);
+	key = (key << MeshBits) | MaskBits(meshKey, MeshBits);
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	m_lastSortPassCount = 0U;
+	size_t packetCount = m_packets.size();
+	if (packetCount < 2)
+	{
+		return;
+	}
+
+	// Build histograms of all passes in one read.
+	uint32_t histograms[RadixPassCount][RadixSize] = {};
+	for (const DrawPacket& packet : m_packets)
+	{
+		for (uint32_t passIndex = 0U; passIndex < RadixPassCount; ++passIndex)
+		{
+			++histograms[passIndex][(packet.key >> (passIndex * RadixBits)) & (RadixSize - 1U)];
+		}
+	}
+
+	m_sortBuffer.resize(packetCount);
+	DrawPacket* pSource = m_packets.data();
+	DrawPacket* pDestination = m_sortBuffer.data();
+	for (uint32_t passIndex = 0U; passIndex < RadixPassCount; ++passIndex)
+	{
+		uint32_t* pHistogram = histograms[passIndex];
+		uint32_t shift = passIndex * RadixBits;
+		if (packetCount == pHistogram[(pSource[0].key >> shift) & (RadixSize - 1U)])
+		{
+			continue;
+		}
+
+		uint32_t offset = 0U;
+		for (uint32_t bucket = 0U; bucket < RadixSize; ++bucket)
+		{
+			uint32_t count = pHistogram[bucket];
+			pHistogram[bucket] = offset;
+			offset += count;
+		}
+
+		for (size_t packetIndex = 0; packetIndex < packetCount; ++packetIndex)
+		{
+			const DrawPacket& packet = pSource[packetIndex];
+			pDestination[pHistogram[(packet.key >> shift) & (RadixSize - 1U)]++] = packet;
+		}
+
+		std::swap(pSource, pDestination);
+		++m_lastSortPassCount;
+	}
+
+	if (pSource != m_packets.data())
+	{
+		m_packets.swap(m_sortBuffer);
+	}
+}
+
+void RenderQueue::SplitChunks(const std::vector<uint32_t>& groupSizes, size_t maxChunkCount, size_t minChunkSize, std::vector<size_t>& chunkEnds)
+{
+	chunkEnds.clear();
+	size_t packetCount = groupSizes.size();
+	if (0 == packetCount)
+	{
+		return;
+	}
+
+	size_t chunkCount = std::clamp<size_t>(packetCount / std::max<size_t>(minChunkSize, 1), 1, std::max<size_t>(maxChunkCount, 1));
+	size_t chunkSize = (packetCount + chunkCount - 1) / chunkCount;
+	size_t packetIndex = 0;
+	while (packetIndex < packetCount)
+	{
+		assert(groupSizes[packetIndex] > 0U);
+		packetIndex = std::min(packetIndex + groupSizes[packetIndex], packetCount);
+
+		// A large group pushes the end over the next boundaries so that there are never more ranges than chunkCount.
+		if (packetIndex >= (chunkEnds.size() + 1) * chunkSize || packetIndex == packetCount)
+		{
+			chunkEnds.push_back(packetIndex);
+		}
+	}
+}
+
+}
\ No newline at end of file
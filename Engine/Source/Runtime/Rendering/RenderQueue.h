@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// RenderQueue collects draw packets of a frame and sorts them by a packed 64-bit key so that draws sharing
+// program, material and mesh are adjacent. Payload is an index which the renderer uses to find its own draw data.
+//
+// Key layout from the most significant bit :
+//   Opaque      : view(8) | translucent(1) = 0 | program(11) | material(16) | mesh(12) | depth(16)
+//   Translucent : view(8) | translucent(1) = 1 | inverted depth(16) | program(11) | material(16) | mesh(12)
+// Opaque draws are sorted by state and then front to back. Translucent draws are sorted back to front.
+class RenderQueue
+{
+public:
+	struct DrawPacket
+	{
+		uint64_t key;
+		uint32_t payload;
+	};
+
+	static constexpr uint32_t ViewBits = 8U;
+	static constexpr uint32_t TranslucentBits = 1U;
+	static constexpr uint32_t ProgramBits = 11U;
+	static constexpr uint32_t MaterialBits = 16U;
+	static constexpr uint32_t MeshBits = 12U;
+	static constexpr uint32_t DepthBits = 16U;
+	static_assert(ViewBits + TranslucentBits + ProgramBits + MaterialBits + MeshBits + DepthBits == 64U);
+
+	// depth : normalized to [0, 1], values out of range are clamped.
+	static uint64_t MakeOpaqueKey(uint16_t viewID, uint16_t programKey, uint16_t materialKey, uint16_t meshKey, float depth);
+	static uint64_t MakeTranslucentKey(uint16_t viewID, uint16_t programKey, uint16_t materialKey, uint16_t meshKey, float depth);
+
+	static bool IsTranslucentKey(uint64_t key) { return (key >> (64U - ViewBits - TranslucentBits)) & 1U; }
+	static uint16_t GetViewID(uint64_t key) { return static_cast<uint16_t>(key >> (64U - ViewBits)); }
+
+public:
+	RenderQueue() = default;
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+	RenderQueue(RenderQueue&&) = default;
+	RenderQueue& operator=(RenderQueue&&) = default;
+	~RenderQueue() = default;
+
+	void Clear() { m_packets.clear(); }
+	void Push(uint64_t key, uint32_t payload) { m_packets.push_back(DrawPacket{ key, payload }); }
+
+	// LSD radix sort by 8 bits per pass. Passes are skipped when all keys have the same byte.
+	// Stable so that packets with equal keys keep push order.
+	void Sort();
+
+	bool IsEmpty() const { return m_packets.empty(); }
+	size_t GetCount() const { return m_packets.size(); }
+	const std::vector<DrawPacket>& GetPackets() const { return m_packets; }
+
+	// Returns end index of the run of sorted packets from firstIndex which canGroup(firstPacket, packet) accepts.
+	// Translucent packets are never grouped because they have to keep back to front order.
+	template<typename Predicate>
+	size_t GetGroupEnd(size_t firstIndex, Predicate&& canGroup) const
+	{
+		const DrawPacket& firstPacket = m_packets[firstIndex];
+		size_t endIndex = firstIndex + 1;
+		if (IsTranslucentKey(firstPacket.key))
+		{
+			return endIndex;
+		}
+
+		while (endIndex < m_packets.size() && !IsTranslucentKey(m_packets[endIndex].key) && canGroup(firstPacket, m_packets[endIndex]))
+		{
+			++endIndex;
+		}
+		return endIndex;
+	}
+
+	// Splits packets into at most maxChunkCount contiguous ranges of similar sizes so that each range can be recorded
+	// by its own encoder. groupSizes holds the size of every group at its first packet and a range never cuts a group.
+	// Less packets than minChunkSize per range gives less ranges. chunkEnds receives the end index of every range.
+	static void SplitChunks(const std::vector<uint32_t>& groupSizes, size_t maxChunkCount, size_t minChunkSize, std::vector<size_t>& chunkEnds);
+
+	// Returns how many radix passes ran in last Sort.
+	uint32_t GetLastSortPassCount() const { return m_lastSortPassCount; }
+
+private:
+	std::vector<DrawPacket> m_packets;
+	std::vector<DrawPacket> m_sortBuffer;
+	uint32_t m_lastSortPassCount = 0U;
+};
+
+}
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 #include <bgfx/bgfx.h>
 
+#include <algorithm>
+
 namespace engine
 {
 
@@ -30,17 +32,24 @@ RenderContext* Renderer::GetRenderContext()
 	return m_pRenderContext;
 }
 
-void Renderer::UpdateViewRenderTarget()
+void Renderer::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
+{
+	constexpr StringCrc sceneRenderTarget("SceneRenderTarget");
+	constexpr StringCrc backBuffer("BackBuffer");
+	pRenderGraph->Write(passID, pRenderGraph->ImportResource(m_pRenderTarget ? sceneRenderTarget : backBuffer));
+}
+
+void Renderer::UpdateViewRenderTarget(uint16_t viewID)
 {
 	if (m_pRenderTarget)
 	{
-		bgfx::setViewFrameBuffer(GetViewID(), *GetRenderTarget()->GetFrameBufferHandle());
-		bgfx::setViewRect(GetViewID(), 0, 0, GetRenderTarget()->GetWidth(), GetRenderTarget()->GetHeight());
+		bgfx::setViewFrameBuffer(viewID, *GetRenderTarget()->GetFrameBufferHandle());
+		bgfx::setViewRect(viewID, 0, 0, GetRenderTarget()->GetWidth(), GetRenderTarget()->GetHeight());
 	}
 	else
 	{
 		assert(m_pRenderContext);
-		bgfx::setViewRect(GetViewID(), 0, 0, m_pRenderContext->GetBackBufferWidth(), m_pRenderContext->GetBackBufferHeight());
+		bgfx::setViewRect(viewID, 0, 0, m_pRenderContext->GetBackBufferWidth(), m_pRenderContext->GetBackBufferHeight());
 	}
 }
 
@@ -143,22 +152,48 @@ void Renderer::ScreenSpaceQuad(const RenderTarget* pRenderTarget, bool _originBo
 	}
 }
 
-void Renderer::SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle)
+void Renderer::SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags)
 {
 	const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
 	assert(ResourceStatus::Ready == pMeshResource->GetStatus() || ResourceStatus::Optimized == pMeshResource->GetStatus());
-	bgfx::setVertexBuffer(0, bgfx::VertexBufferHandle{ pMeshResource->GetVertexBufferHandle() }, pMeshComponent->GetStartVertex(), pMeshComponent->GetVertexCount());
+	const MeshArenaRange& vertexRange = pMeshResource->GetVertexRange();
+	bgfx::setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ vertexRange.bufferHandle }, vertexRange.offset + pMeshComponent->GetStartVertex(),
+		std::min(pMeshComponent->GetVertexCount(), vertexRange.count - pMeshComponent->GetStartVertex()));
+	uint32_t lod = std::min(pMeshComponent->GetLOD(), pMeshResource->GetLODCount() - 1U);
 	for (uint32_t indexBufferIndex = 0U, indexBufferCount = pMeshResource->GetIndexBufferCount(); indexBufferIndex < indexBufferCount; ++indexBufferIndex)
 	{
-		bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshResource->GetIndexBufferHandle(indexBufferIndex) }, pMeshComponent->GetStartIndex(), pMeshComponent->GetIndexCount());
+		const MeshArenaRange& indexRange = pMeshResource->GetIndexRange(indexBufferIndex, lod);
+		bgfx::setIndexBuffer(bgfx::DynamicIndexBufferHandle{ indexRange.bufferHandle }, indexRange.offset + pMeshComponent->GetStartIndex(),
+			std::min(pMeshComponent->GetIndexCount(), indexRange.count - pMeshComponent->GetStartIndex()));
 
-		GetRenderContext()->Submit(viewID, programHandle);
+		// Vertex buffer, transform and bindings are shared by all index buffers.
+		bool isLastIndexBuffer = indexBufferIndex + 1U == indexBufferCount;
+		GetRenderContext()->Submit(viewID, programHandle, isLastIndexBuffer ? discardFlags : BGFX_DISCARD_INDEX_BUFFER);
 	}
 }
 
-void Renderer::SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, StringCrc programHandleIndex)
+void Renderer::SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags)
+{
+	SubmitStaticMeshDrawCall(pMeshComponent, viewID, m_pRenderContext->GetResourceContext()->GetShaderResource(programHandleIndex)->GetHandle(), discardFlags);
+}
+
+void Renderer::SubmitStaticMeshDrawCall(bgfx::Encoder* pEncoder, const StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags)
 {
-	SubmitStaticMeshDrawCall(pMeshComponent, viewID, m_pRenderContext->GetResourceContext()->GetShaderResource(programHandleIndex)->GetHandle());
+	const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
+	assert(ResourceStatus::Ready == pMeshResource->GetStatus() || ResourceStatus::Optimized == pMeshResource->GetStatus());
+	const MeshArenaRange& vertexRange = pMeshResource->GetVertexRange();
+	pEncoder->setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ vertexRange.bufferHandle }, vertexRange.offset + pMeshComponent->GetStartVertex(),
+		std::min(pMeshComponent->GetVertexCount(), vertexRange.count - pMeshComponent->GetStartVertex()));
+	uint32_t lod = std::min(pMeshComponent->GetLOD(), pMeshResource->GetLODCount() - 1U);
+	for (uint32_t indexBufferIndex = 0U, indexBufferCount = pMeshResource->GetIndexBufferCount(); indexBufferIndex < indexBufferCount; ++indexBufferIndex)
+	{
+		const MeshArenaRange& indexRange = pMeshResource->GetIndexRange(indexBufferIndex, lod);
+		pEncoder->setIndexBuffer(bgfx::DynamicIndexBufferHandle{ indexRange.bufferHandle }, indexRange.offset + pMeshComponent->GetStartIndex(),
+			std::min(pMeshComponent->GetIndexCount(), indexRange.count - pMeshComponent->GetStartIndex()));
+
+		bool isLastIndexBuffer = indexBufferIndex + 1U == indexBufferCount;
+		GetRenderContext()->Submit(pEncoder, viewID, programHandle, isLastIndexBuffer ? discardFlags : BGFX_DISCARD_INDEX_BUFFER);
+	}
 }
 
 }
\ No newline at end of file
@@ -1,11 +1,21 @@
 #pragma once
 
 #include "Core/StringCrc.h"
+#include "RenderGraph.h"
+
+#include <bgfx/defines.h>
 
 #include <cstdint>
 #include <set>
 #include <string>
 
+namespace bgfx
+{
+
+struct Encoder;
+
+}
+
 namespace engine
 {
 
@@ -33,17 +43,26 @@ public:
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) = 0;
 	virtual void Render(float deltaTime) = 0;
 
+	// Declares resources which the renderer reads and writes in the render graph. Called every frame before the graph compiles
+	// for enabled renderers. Renderers write their render targets by default.
+	virtual void SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID);
+
 	uint16_t GetViewID() const { return m_viewID; }
 	
-	void UpdateViewRenderTarget();
+	void UpdateViewRenderTarget() { UpdateViewRenderTarget(GetViewID()); }
+	// Renderers which draw through more than one view point them all to the same target.
+	void UpdateViewRenderTarget(uint16_t viewID);
 	void SetRenderTarget(RenderTarget* pRenderTarget) { m_pRenderTarget = pRenderTarget; }
 	const RenderTarget* GetRenderTarget() const { return m_pRenderTarget; }
 
 	virtual void SetEnable(bool value) { m_isEnable = value; }
 	virtual bool IsEnable() const { return m_isEnable; }
 
-	void SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle);
-	void SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, StringCrc programHandleIndex);
+	// discardFlags : applied after the last index buffer. Previous index buffers only discard themselves.
+	void SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags = BGFX_DISCARD_ALL);
+	void SubmitStaticMeshDrawCall(StaticMeshComponent* pMeshComponent, uint16_t viewID, StringCrc programHandleIndex, uint8_t discardFlags = BGFX_DISCARD_ALL);
+	// Records to an encoder so that it can be called on worker threads. Transform and bindings should be set by the same encoder.
+	void SubmitStaticMeshDrawCall(bgfx::Encoder* pEncoder, const StaticMeshComponent* pMeshComponent, uint16_t viewID, uint16_t programHandle, uint8_t discardFlags = BGFX_DISCARD_ALL);
 
 public:
 	static void ScreenSpaceQuad(const RenderTarget* pRenderTarget, bool _originBottomLeft = false, float _width = 1.0f, float _height = 1.0f);
@@ -2,6 +2,11 @@
 
 #include "Core/StringCrc.h"
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
 namespace engine
 {
 
@@ -38,15 +43,51 @@ public:
 	virtual void Update() = 0;
 	virtual void Reset() = 0;
 
+	// Returns true if next Update() will advance CPU stages between Loading and Built without touching GPU.
+	// ResourceScheduler runs these stages on build threads. Resources which wait for inputs return false.
+	virtual bool CanBuildAsync() const { return false; }
+
+	// Bytes to upload in Built -> Ready. It is used by per frame upload budget.
+	virtual uint64_t GetUploadSize() const { return 0; }
+
+	// Memory owned by the resource. Resources which report zero in both are never evicted.
+	virtual uint64_t GetCPUMemorySize() const { return 0; }
+	virtual uint64_t GetGPUMemorySize() const { return 0; }
+
+	// Count of ResourceHandles. Unreferenced resources can be evicted by ResourceScheduler and reloaded when referenced again.
+	void AddRef() const { m_refCount.fetch_add(1, std::memory_order_relaxed); }
+	void Release() const { [[maybe_unused]] uint32_t refCount = m_refCount.fetch_sub(1, std::memory_order_acq_rel); assert(refCount > 0U); }
+	uint32_t GetRefCount() const { return m_refCount.load(std::memory_order_acquire); }
+
+	// The last frame in which the resource was referenced. Least recently used resources are evicted at first.
+	uint64_t GetLastUsedFrame() const { return m_lastUsedFrame; }
+	void SetLastUsedFrame(uint64_t frame) { m_lastUsedFrame = frame; }
+
 	StringCrc GetName() const { return m_nameCrc; }
 	void SetName(StringCrc crc) { m_nameCrc = crc; }
 
-	ResourceStatus GetStatus() const { return m_status; }
-	void SetStatus(ResourceStatus status) { m_status = status; }
+	ResourceStatus GetStatus() const { return m_status.load(std::memory_order_acquire); }
+	void SetStatus(ResourceStatus status) { m_status.store(status, std::memory_order_release); }
+
+	// Set by ResourceScheduler while a build thread is building the resource.
+	bool IsBuilding() const { return m_isBuilding.load(std::memory_order_acquire); }
+	void SetBuilding(bool building) { m_isBuilding.store(building, std::memory_order_release); }
+
+	// Wait for the worker thread before changing inputs of the resource.
+	void WaitBuild() const
+	{
+		while (IsBuilding())
+		{
+			std::this_thread::yield();
+		}
+	}
 
 private:
 	StringCrc m_nameCrc;
-	ResourceStatus m_status = ResourceStatus::Loading;
+	std::atomic<ResourceStatus> m_status = ResourceStatus::Loading;
+	std::atomic<bool> m_isBuilding = false;
+	mutable std::atomic<uint32_t> m_refCount = 0U;
+	uint64_t m_lastUsedFrame = 0U;
 };
 
 }
\ No newline at end of file
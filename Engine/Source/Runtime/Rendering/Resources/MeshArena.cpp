@@ -0,0 +1,139 @@
+#include "MeshArena.h"
+
+#include "Log/Log.h"
+#include "Rendering/Utility/VertexLayoutUtility.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+
+MeshArena::~MeshArena()
+{
+	for (const auto& [handle, page] : m_vertexPages)
+	{
+		bgfx::destroy(bgfx::DynamicVertexBufferHandle{ handle });
+	}
+
+	for (const auto& [handle, page] : m_indexPages)
+	{
+		bgfx::destroy(bgfx::DynamicIndexBufferHandle{ handle });
+	}
+}
+
+MeshArenaRange MeshArena::AllocateVertices(const cd::VertexFormat& vertexFormat, std::span<const std::byte> vertexData)
+{
+	bgfx::VertexLayout vertexLayout;
+	VertexLayoutUtility::CreateVertexLayout(vertexLayout, vertexFormat.GetVertexAttributeLayouts());
+	uint32_t stride = vertexLayout.getStride();
+	assert(stride > 0U && 0U == vertexData.size() % stride);
+	uint32_t vertexCount = static_cast<uint32_t>(vertexData.size() / stride);
+
+	std::vector<uint16_t>& pool = m_vertexPools[vertexLayout.m_hash];
+	MeshArenaRange range;
+	range.count = vertexCount;
+	for (uint16_t handle : pool)
+	{
+		range.offset = m_vertexPages[handle].allocator.Allocate(vertexCount);
+		if (range.offset != OffsetAllocator::InvalidOffset)
+		{
+			range.bufferHandle = handle;
+			break;
+		}
+	}
+
+	if (!range.IsValid())
+	{
+		uint32_t pageVertexCount = std::max(VertexPageByteSize / stride, vertexCount);
+		bgfx::DynamicVertexBufferHandle handle = bgfx::createDynamicVertexBuffer(pageVertexCount, vertexLayout);
+		if (!bgfx::isValid(handle))
+		{
+			CD_ERROR("Failed to create mesh arena vertex buffer.");
+			return MeshArenaRange{};
+		}
+
+		Page& page = m_vertexPages[handle.idx];
+		page.allocator.Reset(pageVertexCount);
+		page.stride = stride;
+		pool.push_back(handle.idx);
+		range.bufferHandle = handle.idx;
+		range.offset = page.allocator.Allocate(vertexCount);
+	}
+
+	const bgfx::Memory* pVertexBufferRef = bgfx::makeRef(vertexData.data(), static_cast<uint32_t>(vertexData.size()));
+	bgfx::update(bgfx::DynamicVertexBufferHandle{ range.bufferHandle }, range.offset, pVertexBufferRef);
+	m_allocatedByteSize += vertexData.size();
+	return range;
+}
+
+MeshArenaRange MeshArena::AllocateIndices(std::span<const std::byte> indexData, bool useU16Index)
+{
+	uint32_t stride = useU16Index ? sizeof(uint16_t) : sizeof(uint32_t);
+	assert(0U == indexData.size() % stride);
+	uint32_t indexCount = static_cast<uint32_t>(indexData.size() / stride);
+
+	std::vector<uint16_t>& pool = m_indexPools[useU16Index ? 0 : 1];
+	MeshArenaRange range;
+	range.count = indexCount;
+	for (uint16_t handle : pool)
+	{
+		range.offset = m_indexPages[handle].allocator.Allocate(indexCount);
+		if (range.offset != OffsetAllocator::InvalidOffset)
+		{
+			range.bufferHandle = handle;
+			break;
+		}
+	}
+
+	if (!range.IsValid())
+	{
+		uint32_t pageIndexCount = std::max(IndexPageByteSize / stride, indexCount);
+		bgfx::DynamicIndexBufferHandle handle = bgfx::createDynamicIndexBuffer(pageIndexCount, useU16Index ? BGFX_BUFFER_NONE : BGFX_BUFFER_INDEX32);
+		if (!bgfx::isValid(handle))
+		{
+			CD_ERROR("Failed to create mesh arena index buffer.");
+			return MeshArenaRange{};
+		}
+
+		Page& page = m_indexPages[handle.idx];
+		page.allocator.Reset(pageIndexCount);
+		page.stride = stride;
+		pool.push_back(handle.idx);
+		range.bufferHandle = handle.idx;
+		range.offset = page.allocator.Allocate(indexCount);
+	}
+
+	const bgfx::Memory* pIndexBufferRef = bgfx::makeRef(indexData.data(), static_cast<uint32_t>(indexData.size()));
+	bgfx::update(bgfx::DynamicIndexBufferHandle{ range.bufferHandle }, range.offset, pIndexBufferRef);
+	m_allocatedByteSize += indexData.size();
+	return range;
+}
+
+void MeshArena::FreeVertices(MeshArenaRange& range)
+{
+	if (!range.IsValid())
+	{
+		return;
+	}
+
+	Page& page = m_vertexPages.at(range.bufferHandle);
+	page.allocator.Free(range.offset, range.count);
+	m_allocatedByteSize -= static_cast<uint64_t>(range.count) * page.stride;
+	range = MeshArenaRange{};
+}
+
+void MeshArena::FreeIndices(MeshArenaRange& range)
+{
+	if (!range.IsValid())
+	{
+		return;
+	}
+
+	Page& page = m_indexPages.at(range.bufferHandle);
+	page.allocator.Free(range.offset, range.count);
+	m_allocatedByteSize -= static_cast<uint64_t>(range.count) * page.stride;
+	range = MeshArenaRange{};
+}
+
+}
\ No newline at end of file
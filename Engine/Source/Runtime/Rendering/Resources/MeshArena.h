@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Rendering/OffsetAllocator.h"
+#include "Scene/VertexFormat.h"
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// Range of vertices or indices inside a MeshArena buffer. bufferHandle is a bgfx dynamic vertex or index buffer handle.
+// Indices are relative to the first vertex of the mesh so draws bind vertex ranges as base vertex.
+struct MeshArenaRange
+{
+	uint16_t bufferHandle = UINT16_MAX;
+	uint32_t offset = 0U;
+	uint32_t count = 0U;
+
+	bool IsValid() const { return bufferHandle != UINT16_MAX; }
+};
+
+// MeshArena packs vertices and indices of all meshes into a few large buffers : vertex buffers per vertex layout and
+// index buffers per index size. This saves bgfx handles and lets draws of different meshes share buffer bindings.
+// Buffers are created as pages on demand and never shrink. Meshes larger than a page get a page of their own size.
+// Should be used on main thread.
+class MeshArena
+{
+public:
+	static constexpr uint32_t VertexPageByteSize = 32U * 1024U * 1024U;
+	static constexpr uint32_t IndexPageByteSize = 16U * 1024U * 1024U;
+
+public:
+	MeshArena() = default;
+	MeshArena(const MeshArena&) = delete;
+	MeshArena& operator=(const MeshArena&) = delete;
+	MeshArena(MeshArena&&) = delete;
+	MeshArena& operator=(MeshArena&&) = delete;
+	~MeshArena();
+
+	// Data is referenced until bgfx consumes it, so it should stay alive for at least two frames.
+	MeshArenaRange AllocateVertices(const cd::VertexFormat& vertexFormat, std::span<const std::byte> vertexData);
+	MeshArenaRange AllocateIndices(std::span<const std::byte> indexData, bool useU16Index);
+	void FreeVertices(MeshArenaRange& range);
+	void FreeIndices(MeshArenaRange& range);
+
+	uint32_t GetBufferCount() const { return static_cast<uint32_t>(m_vertexPages.size() + m_indexPages.size()); }
+	uint64_t GetAllocatedByteSize() const { return m_allocatedByteSize; }
+
+private:
+	struct Page
+	{
+		OffsetAllocator allocator;
+		uint32_t stride;
+	};
+
+	// Pages are keyed by bgfx handle. Pools list the handles which share a vertex layout or an index size.
+	std::map<uint16_t, Page> m_vertexPages;
+	std::map<uint16_t, Page> m_indexPages;
+	std::map<uint32_t, std::vector<uint16_t>> m_vertexPools;
+	std::vector<uint16_t> m_indexPools[2];
+	uint64_t m_allocatedByteSize = 0U;
+};
+
+}
\ No newline at end of file
@@ -1,49 +1,59 @@
 #include "MeshResource.h"
 
 #include "Log/Log.h"
+#include "Rendering/MeshLOD.h"
+#include "Rendering/OcclusionBuffer.h"
 #include "Rendering/Utility/VertexLayoutUtility.h"
 #include "Utilities/MeshUtils.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
 namespace details
 {
 
-uint16_t SubmitVertexBuffer(const engine::MeshResource::VertexBuffer& vertexBuffer, const cd::VertexFormat& vertexFormat)
+bool UseU16Index(uint32_t vertexCount)
 {
-	bgfx::VertexLayout vertexLayout;
-	engine::VertexLayoutUtility::CreateVertexLayout(vertexLayout, vertexFormat.GetVertexAttributeLayouts());
-	const bgfx::Memory* pVertexBufferRef = bgfx::makeRef(vertexBuffer.data(), static_cast<uint32_t>(vertexBuffer.size()));
-	bgfx::VertexBufferHandle vertexBufferHandle = bgfx::createVertexBuffer(pVertexBufferRef, vertexLayout);
-	assert(bgfx::isValid(vertexBufferHandle));
-	return vertexBufferHandle.idx;
+	return vertexCount <= static_cast<uint32_t>(std::numeric_limits<uint16_t>::max()) + 1U;
 }
 
-enum class IndexBufferType
-{
-	Static,
-	Dynamic
-};
-
-template<IndexBufferType IBT = IndexBufferType::Static>
-uint16_t SubmitIndexBuffer(const engine::MeshResource::IndexBuffer& indexBuffer, bool useU16Index = false)
+engine::MeshLOD::IndexList ReadIndexBuffer(std::span<const std::byte> indexBuffer, bool useU16Index)
 {
-	const bgfx::Memory* pIndexBufferRef = bgfx::makeRef(indexBuffer.data(), static_cast<uint32_t>(indexBuffer.size()));
-	if constexpr (IndexBufferType::Static == IBT)
+	engine::MeshLOD::IndexList indices(indexBuffer.size() / (useU16Index ? sizeof(uint16_t) : sizeof(uint32_t)));
+	for (size_t index = 0; index < indices.size(); ++index)
 	{
-		bgfx::IndexBufferHandle indexBufferHandle = bgfx::createIndexBuffer(pIndexBufferRef, useU16Index ? 0U : BGFX_BUFFER_INDEX32);
-		assert(bgfx::isValid(indexBufferHandle));
-		return indexBufferHandle.idx;
-	}
-	else if constexpr (IndexBufferType::Dynamic == IBT)
-	{
-		bgfx::DynamicIndexBufferHandle indexBufferHandle = bgfx::createDynamicIndexBuffer(pIndexBufferRef, useU16Index ? 0U : BGFX_BUFFER_INDEX32);
-		assert(bgfx::isValid(indexBufferHandle));
-		return indexBufferHandle.idx;
+		if (useU16Index)
+		{
+			uint16_t value;
+			std::memcpy(&value, indexBuffer.data() + index * sizeof(uint16_t), sizeof(uint16_t));
+			indices[index] = value;
+		}
+		else
+		{
+			std::memcpy(&indices[index], indexBuffer.data() + index * sizeof(uint32_t), sizeof(uint32_t));
+		}
 	}
-	else
+	return indices;
+}
+
+engine::MeshResource::IndexBuffer WriteIndexBuffer(const engine::MeshLOD::IndexList& indices, bool useU16Index)
+{
+	engine::MeshResource::IndexBuffer indexBuffer(indices.size() * (useU16Index ? sizeof(uint16_t) : sizeof(uint32_t)));
+	for (size_t index = 0; index < indices.size(); ++index)
 	{
-		static_assert("Unsupported IndexBufferType.");
+		if (useU16Index)
+		{
+			uint16_t value = static_cast<uint16_t>(indices[index]);
+			std::memcpy(indexBuffer.data() + index * sizeof(uint16_t), &value, sizeof(uint16_t));
+		}
+		else
+		{
+			std::memcpy(indexBuffer.data() + index * sizeof(uint32_t), &indices[index], sizeof(uint32_t));
+		}
 	}
-};
+	return indexBuffer;
+}
 
 }
 
@@ -54,19 +64,46 @@ MeshResource::MeshResource() = default;
 
 MeshResource::~MeshResource()
 {
+	WaitBuild();
+
 	// Collect garbage intermediatly.
 	SetStatus(ResourceStatus::Garbage);
 	Update();
 }
 
-uint16_t MeshResource::GetVertexBufferHandle() const
+const MeshArenaRange& MeshResource::GetIndexRange(uint32_t index, uint32_t lod) const
+{
+	assert(lod < m_lodCount);
+	return m_indexRanges[lod * GetIndexBufferCount() + index];
+}
+
+uint16_t MeshResource::GetSortKey() const
 {
-	return m_vertexBufferHandle;
+	// 12 bits for RenderQueue keys. Buffer in high bits and vertex offset, which is unique per mesh in the buffer, hashed into low bits.
+	return static_cast<uint16_t>(((m_vertexRange.bufferHandle & 0xFU) << 8U) | ((m_vertexRange.offset * 2654435761U) >> 24U));
 }
 
-uint16_t MeshResource::GetIndexBufferHandle(uint32_t index) const
+const cd::VertexFormat& MeshResource::GetVertexFormat() const
 {
-	return m_indexBufferHandles[index];
+	return m_quantizedVertexFormat.GetVertexAttributeLayouts().empty() ? m_currentVertexFormat : m_quantizedVertexFormat;
+}
+
+bool MeshResource::IsVertexQuantized() const
+{
+	const cd::VertexAttributeLayout* pPositionLayout = GetVertexFormat().GetVertexAttributeLayout(cd::VertexAttributeType::Position);
+	if (pPositionLayout && cd::AttributeValueType::Int16 == pPositionLayout->attributeValueType)
+	{
+		return true;
+	}
+
+	// Vertex data may not be built yet. Positions are always quantized in the same conditions as QuantizeVertexBuffer.
+	return m_isVertexQuantizationEnabled && m_pSkinAsset.empty() && pPositionLayout &&
+		cd::AttributeValueType::Float == pPositionLayout->attributeValueType && 3U == pPositionLayout->attributeCount;
+}
+
+cd::Matrix4x4 MeshResource::GetDequantizedWorldMatrix(const cd::Matrix4x4& worldMatrix) const
+{
+	return IsVertexQuantized() ? VertexQuantization::GetDequantizedWorldMatrix(worldMatrix, m_positionQuantization) : worldMatrix;
 }
 
 void MeshResource::SetMeshAsset(const cd::Mesh* pMeshAsset)
@@ -88,6 +125,7 @@ void MeshResource::UpdateVertexFormat(const cd::VertexFormat& vertexFormat)
 {
 	// Set mesh asset at first so that MeshResource can analyze if it is suitable.
 	assert(m_pMeshAsset);
+	WaitBuild();
 
 	for (const auto& targetLayout : vertexFormat.GetVertexAttributeLayouts())
 	{
@@ -112,6 +150,70 @@ void MeshResource::UpdateVertexFormat(const cd::VertexFormat& vertexFormat)
 	}
 }
 
+void MeshResource::SetPrebuiltMeshData(std::shared_ptr<const void> pStorage, const cd::VertexFormat& vertexFormat, uint32_t vertexCount, uint32_t polygonCount,
+	std::span<const std::byte> vertexData, std::vector<std::span<const std::byte>> indexDatas, uint32_t lodCount,
+	const VertexQuantization::PositionQuantization& positionQuantization)
+{
+	assert(pStorage && !vertexData.empty() && !indexDatas.empty());
+	assert(lodCount > 0U && 0U == indexDatas.size() % lodCount);
+	m_pPrebuiltStorage = cd::MoveTemp(pStorage);
+	m_currentVertexFormat = vertexFormat;
+	m_quantizedVertexFormat = cd::VertexFormat();
+	m_positionQuantization = positionQuantization;
+	m_vertexCount = vertexCount;
+	m_polygonCount = polygonCount;
+	m_polygonGroupCount = static_cast<uint32_t>(indexDatas.size()) / lodCount;
+	m_lodCount = lodCount;
+	m_prebuiltVertexData = vertexData;
+	m_prebuiltIndexDatas = cd::MoveTemp(indexDatas);
+}
+
+bool MeshResource::BuildMeshData(MeshData& meshData) const
+{
+	if (m_pPrebuiltStorage)
+	{
+		meshData.vertexFormat = m_currentVertexFormat;
+		meshData.positionQuantization = m_positionQuantization;
+		meshData.lodCount = m_lodCount;
+		meshData.vertexBuffer.assign(m_prebuiltVertexData.begin(), m_prebuiltVertexData.end());
+		meshData.indexBuffers.resize(m_prebuiltIndexDatas.size());
+		for (size_t bufferIndex = 0; bufferIndex < m_prebuiltIndexDatas.size(); ++bufferIndex)
+		{
+			meshData.indexBuffers[bufferIndex].assign(m_prebuiltIndexDatas[bufferIndex].begin(), m_prebuiltIndexDatas[bufferIndex].end());
+		}
+		return true;
+	}
+
+	if (!m_pMeshAsset)
+	{
+		return false;
+	}
+
+	std::optional<VertexBuffer> optVertexBuffer = CreateVertexBuffer();
+	if (!optVertexBuffer.has_value())
+	{
+		return false;
+	}
+	meshData.vertexBuffer = cd::MoveTemp(optVertexBuffer.value());
+	meshData.vertexFormat = m_currentVertexFormat;
+	meshData.positionQuantization = VertexQuantization::PositionQuantization{};
+	QuantizeVertexBuffer(meshData.vertexBuffer, meshData.vertexFormat, meshData.positionQuantization);
+
+	meshData.indexBuffers.resize(m_pMeshAsset->GetPolygonGroupCount());
+	for (uint32_t polygonGroupIndex = 0U; polygonGroupIndex < m_pMeshAsset->GetPolygonGroupCount(); ++polygonGroupIndex)
+	{
+		std::optional<cd::IndexBuffer> optIndexBuffer = cd::BuildIndexBufferesForPolygonGroup(*m_pMeshAsset, polygonGroupIndex);
+		if (!optIndexBuffer.has_value())
+		{
+			return false;
+		}
+		meshData.indexBuffers[polygonGroupIndex] = cd::MoveTemp(optIndexBuffer.value());
+	}
+	meshData.lodCount = m_isLODEnabled ? BuildLODIndexBuffers(meshData.indexBuffers) : 1U;
+
+	return true;
+}
+
 void MeshResource::Update()
 {
 	switch (GetStatus())
@@ -125,6 +227,11 @@ void MeshResource::Update()
 			m_polygonGroupCount = m_pMeshAsset->GetPolygonGroupCount();
 			SetStatus(ResourceStatus::Loaded);
 		}
+		else if (m_pPrebuiltStorage)
+		{
+			// Counts are assigned together with prebuilt data.
+			SetStatus(ResourceStatus::Loaded);
+		}
 		break;
 	}
 	case ResourceStatus::Loaded:
@@ -137,16 +244,24 @@ void MeshResource::Update()
 	}
 	case ResourceStatus::Building:
 	{
-		BuildVertexBuffer();
-		BuildIndexBuffer();
+		if (!m_pPrebuiltStorage)
+		{
+			BuildVertexBuffer();
+			if (BuildIndexBuffer() && m_isOccluderEnabled)
+			{
+				BuildOccluder();
+			}
+		}
 		SetStatus(ResourceStatus::Built);
 		break;
 	}
 	case ResourceStatus::Built:
 	{
+		m_gpuMemorySize = GetUploadSize();
 		SubmitVertexBuffer();
 		SubmitIndexBuffer();
 		m_recycleCount = 0U;
+		++m_version;
 		SetStatus(ResourceStatus::Ready);
 		break;
 	}
@@ -163,9 +278,13 @@ void MeshResource::Update()
 	}
 	case ResourceStatus::Garbage:
 	{
-		DestroyVertexBufferHandle();
-		DestroyIndexBufferHandle();
-		// CPU data will destroy after deconstructor.
+		FreeVertexRange();
+		FreeIndexRanges();
+		m_gpuMemorySize = 0U;
+		// Free CPU data too so that evicted resources release all memory until they are reloaded.
+		FreeMeshData();
+		FreeOccluderData();
+		++m_version;
 		SetStatus(ResourceStatus::Destroyed);
 		break;
 	}
@@ -174,27 +293,82 @@ void MeshResource::Update()
 	}
 }
 
+bool MeshResource::CanBuildAsync() const
+{
+	switch (GetStatus())
+	{
+	case ResourceStatus::Loading:
+		return m_pMeshAsset || m_pPrebuiltStorage;
+	case ResourceStatus::Loaded:
+		return m_vertexCount >= 3U && m_polygonCount > 0U;
+	case ResourceStatus::Building:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint64_t MeshResource::GetCPUMemorySize() const
+{
+	uint64_t memorySize = m_vertexBuffer.capacity();
+	for (const IndexBuffer& indexBuffer : m_indexBuffers)
+	{
+		memorySize += indexBuffer.capacity();
+	}
+	memorySize += m_occluderPositions.capacity() * sizeof(cd::Point) + m_occluderIndices.capacity() * sizeof(uint32_t);
+
+	// Prebuilt data is owned by its storage.
+	return memorySize;
+}
+
+uint64_t MeshResource::GetUploadSize() const
+{
+	uint64_t uploadSize = m_pPrebuiltStorage ? m_prebuiltVertexData.size() : m_vertexBuffer.size();
+	if (m_pPrebuiltStorage)
+	{
+		for (std::span<const std::byte> indexData : m_prebuiltIndexDatas)
+		{
+			uploadSize += indexData.size();
+		}
+	}
+	else
+	{
+		for (const IndexBuffer& indexBuffer : m_indexBuffers)
+		{
+			uploadSize += indexBuffer.size();
+		}
+	}
+
+	return uploadSize;
+}
+
 void MeshResource::Reset()
 {
-	DestroyVertexBufferHandle();
-	DestroyIndexBufferHandle();
+	WaitBuild();
+	FreeVertexRange();
+	FreeIndexRanges();
+	m_gpuMemorySize = 0U;
 	ClearMeshData();
+	FreeOccluderData();
+	// Asset and prebuilt data are inputs which are kept to build again.
 	SetStatus(ResourceStatus::Loading);
 }
 
-bool MeshResource::BuildVertexBuffer()
+std::optional<MeshResource::VertexBuffer> MeshResource::CreateVertexBuffer() const
 {
-	assert(m_pMeshAsset && m_vertexCount > 3U);
-	std::optional<cd::VertexBuffer> optVertexBuffer;
 	if (!m_pSkinAsset.empty())
 	{
-		optVertexBuffer = cd::BuildVertexBufferForSkeletalMesh(*m_pMeshAsset, m_currentVertexFormat, *m_pSkinAsset[0], m_pBonesAsset);
-	}
-	else
-	{
-		optVertexBuffer = cd::BuildVertexBufferForStaticMesh(*m_pMeshAsset, m_currentVertexFormat);
+		return cd::BuildVertexBufferForSkeletalMesh(*m_pMeshAsset, m_currentVertexFormat, *m_pSkinAsset[0], m_pBonesAsset);
 	}
 
+	return cd::BuildVertexBufferForStaticMesh(*m_pMeshAsset, m_currentVertexFormat);
+}
+
+bool MeshResource::BuildVertexBuffer()
+{
+	assert(m_pMeshAsset && m_vertexCount > 3U);
+	std::optional<cd::VertexBuffer> optVertexBuffer = CreateVertexBuffer();
+
 	if (!optVertexBuffer.has_value())
 	{
 		CD_ERROR("Failed to build mesh vertex buffer.");
@@ -205,10 +379,94 @@ bool MeshResource::BuildVertexBuffer()
 	m_vertexBuffer.clear();
 	
 	m_vertexBuffer = cd::MoveTemp(optVertexBuffer.value());
+
+	cd::VertexFormat quantizedVertexFormat;
+	m_positionQuantization = VertexQuantization::PositionQuantization{};
+	m_quantizedVertexFormat = QuantizeVertexBuffer(m_vertexBuffer, quantizedVertexFormat, m_positionQuantization) ? cd::MoveTemp(quantizedVertexFormat) : cd::VertexFormat();
 	
 	return true;
 }
 
+bool MeshResource::QuantizeVertexBuffer(VertexBuffer& vertexBuffer, cd::VertexFormat& vertexFormat, VertexQuantization::PositionQuantization& positionQuantization) const
+{
+	if (!m_isVertexQuantizationEnabled || !m_pSkinAsset.empty())
+	{
+		return false;
+	}
+
+	const std::vector<cd::VertexAttributeLayout>& layouts = m_currentVertexFormat.GetVertexAttributeLayouts();
+	std::vector<VertexQuantization::Attribute> attributes;
+	attributes.reserve(layouts.size());
+	bool hasPosition = false;
+	for (const cd::VertexAttributeLayout& layout : layouts)
+	{
+		bgfx::VertexLayout attributeLayout;
+		VertexLayoutUtility::CreateVertexLayout(attributeLayout, layout);
+		VertexQuantization::Attribute attribute{ VertexQuantization::Encoding::None, attributeLayout.getStride() };
+
+		bool isFloat = cd::AttributeValueType::Float == layout.attributeValueType;
+		switch (layout.vertexAttributeType)
+		{
+		case cd::VertexAttributeType::Position:
+			hasPosition = isFloat && 3U == layout.attributeCount;
+			attribute.encoding = hasPosition ? VertexQuantization::Encoding::Position : VertexQuantization::Encoding::None;
+			break;
+		case cd::VertexAttributeType::Normal:
+		case cd::VertexAttributeType::Tangent:
+			attribute.encoding = isFloat && 3U == layout.attributeCount ? VertexQuantization::Encoding::Octahedral : VertexQuantization::Encoding::None;
+			break;
+		case cd::VertexAttributeType::UV:
+			// 16-bit formats of odd component counts are not portable.
+			attribute.encoding = isFloat && 0U == layout.attributeCount % 2U ? VertexQuantization::Encoding::Snorm16 : VertexQuantization::Encoding::None;
+			break;
+		default:
+			break;
+		}
+		attributes.push_back(attribute);
+	}
+
+	// Draws tell quantized meshes by positions.
+	if (!hasPosition)
+	{
+		return false;
+	}
+
+	for (size_t attributeIndex = 0; attributeIndex < attributes.size(); ++attributeIndex)
+	{
+		if (VertexQuantization::Encoding::Snorm16 == attributes[attributeIndex].encoding &&
+			!VertexQuantization::IsSnorm16Range(vertexBuffer, attributes, attributeIndex))
+		{
+			attributes[attributeIndex].encoding = VertexQuantization::Encoding::None;
+		}
+	}
+
+	positionQuantization = VertexQuantization::GetPositionQuantization(vertexBuffer, attributes);
+	vertexBuffer = VertexQuantization::Quantize(vertexBuffer, attributes, positionQuantization);
+
+	vertexFormat = cd::VertexFormat();
+	for (size_t attributeIndex = 0; attributeIndex < attributes.size(); ++attributeIndex)
+	{
+		const cd::VertexAttributeLayout& layout = layouts[attributeIndex];
+		switch (attributes[attributeIndex].encoding)
+		{
+		case VertexQuantization::Encoding::Position:
+			vertexFormat.AddVertexAttributeLayout(layout.vertexAttributeType, cd::AttributeValueType::Int16, 4U);
+			break;
+		case VertexQuantization::Encoding::Octahedral:
+			vertexFormat.AddVertexAttributeLayout(layout.vertexAttributeType, cd::AttributeValueType::Int16, 2U);
+			break;
+		case VertexQuantization::Encoding::Snorm16:
+			vertexFormat.AddVertexAttributeLayout(layout.vertexAttributeType, cd::AttributeValueType::Int16, layout.attributeCount);
+			break;
+		default:
+			vertexFormat.AddVertexAttributeLayout(layout.vertexAttributeType, layout.attributeValueType, layout.attributeCount);
+			break;
+		}
+	}
+
+	return true;
+}
+
 bool MeshResource::BuildIndexBuffer()
 {
 	assert(m_pMeshAsset && m_polygonCount > 0U && m_polygonGroupCount > 0U);
@@ -247,27 +505,132 @@ bool MeshResource::BuildIndexBuffer()
 			CD_ERROR("Failed to build mesh index buffer.");
 		}
 	}
+	m_lodCount = result && m_isLODEnabled ? BuildLODIndexBuffers(m_indexBuffers) : 1U;
 
 	return result;
 }
 
+uint32_t MeshResource::BuildLODIndexBuffers(std::vector<IndexBuffer>& indexBuffers) const
+{
+	// Simplified index buffers follow the ones of LOD 0 in the same index size.
+	assert(m_pMeshAsset && m_pMeshAsset->GetPolygonGroupCount() == indexBuffers.size());
+	const uint32_t vertexCount = m_pMeshAsset->GetVertexCount();
+	const bool useU16Index = details::UseU16Index(vertexCount);
+
+	std::vector<cd::Point> positions;
+	positions.reserve(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		positions.push_back(m_pMeshAsset->GetVertexPosition(vertexIndex));
+	}
+
+	std::vector<MeshLOD::IndexList> groupIndices;
+	groupIndices.reserve(indexBuffers.size());
+	for (const IndexBuffer& indexBuffer : indexBuffers)
+	{
+		groupIndices.push_back(details::ReadIndexBuffer(indexBuffer, useU16Index));
+	}
+
+	std::vector<std::vector<MeshLOD::IndexList>> lods = MeshLOD::BuildLODChain(positions, groupIndices);
+	for (const std::vector<MeshLOD::IndexList>& lodIndices : lods)
+	{
+		for (const MeshLOD::IndexList& indices : lodIndices)
+		{
+			indexBuffers.push_back(details::WriteIndexBuffer(indices, useU16Index));
+		}
+	}
+
+	return 1U + static_cast<uint32_t>(lods.size());
+}
+
+void MeshResource::BuildOccluder()
+{
+	assert(m_pMeshAsset && m_indexBuffers.size() >= m_polygonGroupCount);
+	FreeOccluderData();
+
+	// Occluders only need positions. Weld vertices by position so that attribute seams don't lock simplification.
+	const uint32_t vertexCount = m_pMeshAsset->GetVertexCount();
+	std::vector<uint32_t> sortedVertices(vertexCount);
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		sortedVertices[vertexIndex] = vertexIndex;
+	}
+	auto GetPositionKey = [this](uint32_t vertexIndex)
+	{
+		const cd::Point& position = m_pMeshAsset->GetVertexPosition(vertexIndex);
+		return std::make_tuple(position.x(), position.y(), position.z());
+	};
+	std::sort(sortedVertices.begin(), sortedVertices.end(), [&GetPositionKey](uint32_t lhs, uint32_t rhs) { return GetPositionKey(lhs) < GetPositionKey(rhs); });
+
+	std::vector<cd::Point> weldedPositions;
+	std::vector<uint32_t> weldedVertices(vertexCount);
+	for (uint32_t sortedIndex = 0U; sortedIndex < vertexCount; ++sortedIndex)
+	{
+		uint32_t vertexIndex = sortedVertices[sortedIndex];
+		if (0U == sortedIndex || GetPositionKey(sortedVertices[sortedIndex - 1U]) != GetPositionKey(vertexIndex))
+		{
+			weldedPositions.push_back(m_pMeshAsset->GetVertexPosition(vertexIndex));
+		}
+		weldedVertices[vertexIndex] = static_cast<uint32_t>(weldedPositions.size() - 1);
+	}
+
+	// All polygon groups of LOD 0 are merged as materials don't matter.
+	const bool useU16Index = details::UseU16Index(vertexCount);
+	MeshLOD::IndexList indices;
+	for (uint32_t polygonGroupIndex = 0U; polygonGroupIndex < m_polygonGroupCount; ++polygonGroupIndex)
+	{
+		for (uint32_t vertexIndex : details::ReadIndexBuffer(m_indexBuffers[polygonGroupIndex], useU16Index))
+		{
+			indices.push_back(weldedVertices[vertexIndex]);
+		}
+	}
+
+	constexpr uint32_t maxOccluderIndexCount = OcclusionBuffer::MaxOccluderTriangleCount * 3U;
+	if (indices.size() > maxOccluderIndexCount)
+	{
+		indices = MeshLOD::Simplify(weldedPositions, indices, maxOccluderIndexCount, OcclusionBuffer::OccluderMaxError);
+		if (indices.size() > maxOccluderIndexCount)
+		{
+			return;
+		}
+	}
+
+	// Keep referenced positions only.
+	std::vector<uint32_t> remap(weldedPositions.size(), UINT32_MAX);
+	m_occluderIndices.reserve(indices.size());
+	for (uint32_t vertexIndex : indices)
+	{
+		if (UINT32_MAX == remap[vertexIndex])
+		{
+			remap[vertexIndex] = static_cast<uint32_t>(m_occluderPositions.size());
+			m_occluderPositions.push_back(weldedPositions[vertexIndex]);
+		}
+		m_occluderIndices.push_back(remap[vertexIndex]);
+	}
+}
+
 void MeshResource::SubmitVertexBuffer()
 {
-	if (m_vertexBufferHandle != UINT16_MAX)
+	assert(m_pMeshArena);
+	if (m_vertexRange.IsValid())
 	{
 		return;
 	}
-	m_vertexBufferHandle = details::SubmitVertexBuffer(m_vertexBuffer, m_currentVertexFormat);
+
+	std::span<const std::byte> vertexBuffer = m_pPrebuiltStorage ? m_prebuiltVertexData : std::span<const std::byte>(m_vertexBuffer);
+	m_vertexRange = m_pMeshArena->AllocateVertices(GetVertexFormat(), vertexBuffer);
+	assert(m_vertexRange.IsValid());
 }
 
 void MeshResource::SubmitIndexBuffer()
 {
-	if (!m_indexBufferHandles.empty())
+	assert(m_pMeshArena);
+	if (!m_indexRanges.empty())
 	{
 		bool submit = false;
-		for (uint16_t indexBufferHandle : m_indexBufferHandles)
+		for (const MeshArenaRange& indexRange : m_indexRanges)
 		{
-			if (indexBufferHandle == UINT16_MAX)
+			if (!indexRange.IsValid())
 			{
 				submit = true;
 				break;
@@ -280,16 +643,21 @@ void MeshResource::SubmitIndexBuffer()
 		}
 	}
 
-	size_t indexBufferCount = m_indexBuffers.size();
+	size_t indexBufferCount = m_pPrebuiltStorage ? m_prebuiltIndexDatas.size() : m_indexBuffers.size();
 	assert(indexBufferCount > 0);
-	m_indexBufferHandles.resize(indexBufferCount, UINT16_MAX);
+	m_indexRanges.resize(indexBufferCount);
 
-	const bool useU16Index = m_vertexCount <= static_cast<uint32_t>(std::numeric_limits<uint16_t>::max()) + 1U;
+	const bool useU16Index = details::UseU16Index(m_vertexCount);
 	for (size_t bufferIndex = 0; bufferIndex < indexBufferCount; ++bufferIndex)
 	{
-		const auto& indexBuffer = m_indexBuffers[bufferIndex];
+		if (m_indexRanges[bufferIndex].IsValid())
+		{
+			continue;
+		}
+
+		std::span<const std::byte> indexBuffer = m_pPrebuiltStorage ? m_prebuiltIndexDatas[bufferIndex] : std::span<const std::byte>(m_indexBuffers[bufferIndex]);
 		assert(!indexBuffer.empty());
-		m_indexBufferHandles[bufferIndex] = details::SubmitIndexBuffer(indexBuffer, useU16Index);
+		m_indexRanges[bufferIndex] = m_pMeshArena->AllocateIndices(indexBuffer, useU16Index);
 	}
 }
 
@@ -306,27 +674,31 @@ void MeshResource::FreeMeshData()
 	std::vector<IndexBuffer>().swap(m_indexBuffers);
 }
 
-void MeshResource::DestroyVertexBufferHandle()
+void MeshResource::FreeOccluderData()
+{
+	std::vector<cd::Point>().swap(m_occluderPositions);
+	std::vector<uint32_t>().swap(m_occluderIndices);
+}
+
+void MeshResource::FreeVertexRange()
 {
-	if (m_vertexBufferHandle != UINT16_MAX)
+	if (m_pMeshArena)
 	{
-		bgfx::destroy(bgfx::VertexBufferHandle{ m_vertexBufferHandle });
-		m_vertexBufferHandle = UINT16_MAX;
+		m_pMeshArena->FreeVertices(m_vertexRange);
 	}
 }
 
-void MeshResource::DestroyIndexBufferHandle()
+void MeshResource::FreeIndexRanges()
 {
-	for (uint16_t indexBufferHandle : m_indexBufferHandles)
+	if (m_pMeshArena)
 	{
-		if (indexBufferHandle != UINT16_MAX)
+		for (MeshArenaRange& indexRange : m_indexRanges)
 		{
-			bgfx::destroy(bgfx::IndexBufferHandle{ indexBufferHandle });
-			indexBufferHandle = UINT16_MAX;
+			m_pMeshArena->FreeIndices(indexRange);
 		}
 	}
 
-	m_indexBufferHandles.clear();
+	m_indexRanges.clear();
 }
 
 }
\ No newline at end of file
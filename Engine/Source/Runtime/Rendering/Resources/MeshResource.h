@@ -1,8 +1,14 @@
 #pragma once
 
 #include "IResource.h"
+#include "Math/Vector.hpp"
+#include "MeshArena.h"
+#include "Rendering/VertexQuantization.h"
 #include "Scene/VertexFormat.h"
 
+#include <memory>
+#include <optional>
+#include <span>
 #include <vector>
 
 namespace cd
@@ -23,6 +29,17 @@ public:
 	using VertexBuffer = std::vector<std::byte>;
 	using IndexBuffer = std::vector<std::byte>;
 
+	// Vertex and index data in the same layout as GPU buffers.
+	struct MeshData
+	{
+		cd::VertexFormat vertexFormat;
+		VertexBuffer vertexBuffer;
+		// Index buffers of all polygon groups in LOD 0, then the ones in LOD 1 and so on.
+		std::vector<IndexBuffer> indexBuffers;
+		uint32_t lodCount = 1U;
+		VertexQuantization::PositionQuantization positionQuantization;
+	};
+
 public:
 	MeshResource();
 	MeshResource(const MeshResource&) = default;
@@ -33,6 +50,13 @@ public:
 
 	virtual void Update() override;
 	virtual void Reset() override;
+	virtual bool CanBuildAsync() const override;
+	virtual uint64_t GetUploadSize() const override;
+	virtual uint64_t GetCPUMemorySize() const override;
+	virtual uint64_t GetGPUMemorySize() const override { return m_gpuMemorySize; }
+
+	// GPU buffers are ranges of shared arena buffers. Should be set before submitting.
+	void SetMeshArena(MeshArena* pMeshArena) { m_pMeshArena = pMeshArena; }
 
 	const cd::Mesh* GetMeshAsset() const { return m_pMeshAsset; }
 	void SetMeshAsset(const cd::Mesh* pMeshAsset);
@@ -44,23 +68,72 @@ public:
 	void AddBonesAsset(const cd::Bone&);
 	
 	void UpdateVertexFormat(const cd::VertexFormat& vertexFormat);
-	
+	// Format of GPU vertex data, which is the quantized one after quantized vertex data is built.
+	const cd::VertexFormat& GetVertexFormat() const;
+
+	// Build vertex data in 16-bit values, see VertexQuantization. Normals and tangents are octahedral encoded and UVs are kept in
+	// float if any value is out of [-1, 1]. Materials need ShaderFeature::QUANTIZED_VERTEX to decode them and draws need the world
+	// matrix from GetDequantizedWorldMatrix. Skinned meshes are not quantized.
+	// IsVertexQuantized is known once vertex quantization is enabled so that materials can pick their variant before the mesh is built.
+	bool IsVertexQuantizationEnabled() const { return m_isVertexQuantizationEnabled; }
+	void SetVertexQuantizationEnabled(bool enabled) { m_isVertexQuantizationEnabled = enabled; }
+	bool IsVertexQuantized() const;
+	const VertexQuantization::PositionQuantization& GetPositionQuantization() const { return m_positionQuantization; }
+	cd::Matrix4x4 GetDequantizedWorldMatrix(const cd::Matrix4x4& worldMatrix) const;
+
+	// Generate simplified index buffers together with index buffers from mesh asset.
+	bool IsLODEnabled() const { return m_isLODEnabled; }
+	void SetLODEnabled(bool enabled) { m_isLODEnabled = enabled; }
+
+	// Generate a simplified copy of positions and indices on CPU for occlusion culling. Meshes which can't be simplified
+	// within OcclusionBuffer::MaxOccluderTriangleCount triangles have no occluder. Occluder data is kept after mesh data is freed.
+	bool IsOccluderEnabled() const { return m_isOccluderEnabled; }
+	void SetOccluderEnabled(bool enabled) { m_isOccluderEnabled = enabled; }
+	bool HasOccluder() const { return !m_occluderIndices.empty(); }
+	std::span<const cd::Point> GetOccluderPositions() const { return m_occluderPositions; }
+	std::span<const uint32_t> GetOccluderIndices() const { return m_occluderIndices; }
+
+	// Use vertex and index data which are already built, e.g. from a memory mapped scene snapshot.
+	// They are submitted to GPU in place without copying. pStorage keeps the memory alive while the resource uses it.
+	// indexDatas : index buffers of all polygon groups in LOD 0, then the ones in LOD 1 and so on.
+	// positionQuantization : bounds of quantized positions if vertexFormat stores positions in 16-bit values.
+	void SetPrebuiltMeshData(std::shared_ptr<const void> pStorage, const cd::VertexFormat& vertexFormat, uint32_t vertexCount, uint32_t polygonCount,
+		std::span<const std::byte> vertexData, std::vector<std::span<const std::byte>> indexDatas, uint32_t lodCount = 1U,
+		const VertexQuantization::PositionQuantization& positionQuantization = {});
+
+	// Build data for SetPrebuiltMeshData. It works after CPU data is freed.
+	bool BuildMeshData(MeshData& meshData) const;
+
 	uint32_t GetVertexCount() const { return m_vertexCount; }
 	uint32_t GetPolygonCount() const { return m_polygonCount; }
 	uint32_t GetPolygonGroupCount() const { return m_polygonGroupCount; }
-	uint16_t GetVertexBufferHandle() const;
-	uint32_t GetIndexBufferCount() const { return static_cast<uint32_t>(m_indexBufferHandles.size()); }
-	uint16_t GetIndexBufferHandle(uint32_t index) const;
+	const MeshArenaRange& GetVertexRange() const { return m_vertexRange; }
+	// Index buffers per LOD. All LODs share the vertex buffer.
+	uint32_t GetLODCount() const { return m_lodCount; }
+	uint32_t GetIndexBufferCount() const { return static_cast<uint32_t>(m_indexRanges.size()) / m_lodCount; }
+	const MeshArenaRange& GetIndexRange(uint32_t index, uint32_t lod = 0U) const;
+
+	// Draws sorted by this key bind the same arena buffers in a row and keep draws of the same mesh together.
+	uint16_t GetSortKey() const;
+
+	// Increased whenever GPU data is submitted or destroyed, e.g. after reloading or evicting the mesh.
+	// Caches of rendered geometry compare it to know if they are stale.
+	uint32_t GetVersion() const { return m_version; }
 
 private:
+	std::optional<VertexBuffer> CreateVertexBuffer() const;
+	bool QuantizeVertexBuffer(VertexBuffer& vertexBuffer, cd::VertexFormat& vertexFormat, VertexQuantization::PositionQuantization& positionQuantization) const;
 	bool BuildVertexBuffer();
 	bool BuildIndexBuffer();
+	uint32_t BuildLODIndexBuffers(std::vector<IndexBuffer>& indexBuffers) const;
+	void BuildOccluder();
 	void SubmitVertexBuffer();
 	void SubmitIndexBuffer();
 	void ClearMeshData();
 	void FreeMeshData();
-	void DestroyVertexBufferHandle();
-	void DestroyIndexBufferHandle();
+	void FreeOccluderData();
+	void FreeVertexRange();
+	void FreeIndexRanges();
 
 private:
 	// Asset
@@ -70,18 +143,34 @@ private:
 	uint32_t m_vertexCount = 0U;
 	uint32_t m_polygonCount = 0U;
 	uint32_t m_polygonGroupCount = 0U;
+	uint32_t m_lodCount = 1U;
 
 	// Runtime
 	cd::VertexFormat m_currentVertexFormat;
+	bool m_isLODEnabled = false;
+	bool m_isOccluderEnabled = false;
+	bool m_isVertexQuantizationEnabled = false;
+	cd::VertexFormat m_quantizedVertexFormat;
+	VertexQuantization::PositionQuantization m_positionQuantization;
 
 	// CPU
 	VertexBuffer m_vertexBuffer;
 	std::vector<IndexBuffer> m_indexBuffers;
 	uint32_t m_recycleCount = 0;
+	std::vector<cd::Point> m_occluderPositions;
+	std::vector<uint32_t> m_occluderIndices;
+
+	// Prebuilt
+	std::shared_ptr<const void> m_pPrebuiltStorage;
+	std::span<const std::byte> m_prebuiltVertexData;
+	std::vector<std::span<const std::byte>> m_prebuiltIndexDatas;
 
 	// GPU
-	uint16_t m_vertexBufferHandle = UINT16_MAX;
-	std::vector<uint16_t> m_indexBufferHandles;
+	MeshArena* m_pMeshArena = nullptr;
+	MeshArenaRange m_vertexRange;
+	std::vector<MeshArenaRange> m_indexRanges;
+	uint64_t m_gpuMemorySize = 0U;
+	uint32_t m_version = 0U;
 };
 
 }
\ No newline at end of file
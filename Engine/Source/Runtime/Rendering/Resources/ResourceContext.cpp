@@ -11,14 +11,17 @@ namespace engine
 
 ResourceContext::~ResourceContext()
 {
+	m_scheduler.WaitBuilds();
 }
 
 void ResourceContext::Update()
 {
-	for (auto& [_, resource] : m_resources)
+	m_scheduler.BeginFrame();
+	for (auto& [_, pResource] : m_resources)
 	{
-		resource->Update();
+		m_scheduler.UpdateResource(pResource.get());
 	}
+	m_scheduler.EndFrame();
 }
 
 StringCrc ResourceContext::GetResourceCrc(ResourceType resourceType, StringCrc nameCrc)
@@ -75,7 +78,9 @@ IResource* ResourceContext::AddResourceImpl(StringCrc nameCrc)
 
 	if constexpr (ResourceType::Mesh == RT)
 	{
-		m_resources[resourceCrc] = std::make_unique<MeshResource>();
+		auto pMeshResource = std::make_unique<MeshResource>();
+		pMeshResource->SetMeshArena(&m_meshArena);
+		m_resources[resourceCrc] = cd::MoveTemp(pMeshResource);
 	}
 	else if constexpr (ResourceType::Shader == RT)
 	{
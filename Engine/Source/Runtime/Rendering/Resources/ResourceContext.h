@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Core/StringCrc.h"
+#include "MeshArena.h"
+#include "ResourceScheduler.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 
@@ -15,6 +18,7 @@ class ShaderResource;
 class SkeletonResource;
 class TextureResource;
 
+// ResourceContext owns resources and advances their status machines once per frame by ResourceScheduler.
 class ResourceContext
 {
 public:
@@ -27,8 +31,15 @@ public:
 
 	void Update();
 
+	// Build workers, upload and memory budgets.
+	ResourceScheduler* GetScheduler() { return &m_scheduler; }
+	const ResourceScheduler* GetScheduler() const { return &m_scheduler; }
+
 	StringCrc GetResourceCrc(ResourceType resourceType, StringCrc nameCrc);
 
+	// Vertex and index buffers of all mesh resources.
+	MeshArena* GetMeshArena() { return &m_meshArena; }
+
 	MeshResource* AddMeshResource(StringCrc nameCrc);
 	ShaderResource* AddShaderResource(StringCrc nameCrc);
 	SkeletonResource* AddSkeletonResource(StringCrc nameCrc);
@@ -45,7 +56,12 @@ private:
 	IResource* GetResourceImpl(StringCrc nameCrc);
 
 private:
+	// Declared before resources so that it is destroyed after they return their ranges.
+	MeshArena m_meshArena;
 	std::map<StringCrc, std::unique_ptr<IResource>> m_resources;
+
+	// Declared after resources so that it waits for building resources before they are destroyed.
+	ResourceScheduler m_scheduler;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "IResource.h"
+
+namespace engine
+{
+
+// ResourceHandle holds a reference of resource so that ResourceContext won't evict it.
+// It converts to raw pointer implicitly to keep call sites simple. Raw pointers don't hold references.
+template<typename Resource>
+class ResourceHandle final
+{
+public:
+	ResourceHandle() = default;
+	ResourceHandle(Resource* pResource) : m_pResource(pResource) { AddRef(); }
+	ResourceHandle(const ResourceHandle& other) : m_pResource(other.m_pResource) { AddRef(); }
+	ResourceHandle& operator=(const ResourceHandle& other) { Reset(other.m_pResource); return *this; }
+	ResourceHandle(ResourceHandle&& other) noexcept : m_pResource(other.m_pResource) { other.m_pResource = nullptr; }
+	ResourceHandle& operator=(ResourceHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			m_pResource = other.m_pResource;
+			other.m_pResource = nullptr;
+		}
+		return *this;
+	}
+	ResourceHandle& operator=(Resource* pResource) { Reset(pResource); return *this; }
+	~ResourceHandle() { Release(); }
+
+	Resource* Get() const { return m_pResource; }
+	Resource* operator->() const { return m_pResource; }
+	operator Resource*() const { return m_pResource; }
+
+	void Reset(Resource* pResource = nullptr)
+	{
+		if (pResource != m_pResource)
+		{
+			Release();
+			m_pResource = pResource;
+			AddRef();
+		}
+	}
+
+private:
+	void AddRef()
+	{
+		if (m_pResource)
+		{
+			m_pResource->AddRef();
+		}
+	}
+
+	void Release()
+	{
+		if (m_pResource)
+		{
+			m_pResource->Release();
+		}
+	}
+
+private:
+	Resource* m_pResource = nullptr;
+};
+
+}
\ No newline at end of file
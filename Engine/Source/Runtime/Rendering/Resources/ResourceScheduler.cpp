@@ -0,0 +1,165 @@
+#include "ResourceScheduler.h"
+
+#include "IResource.h"
+#include "Scheduler/ThreadPool.h"
+
+#include <algorithm>
+
+namespace engine
+{
+
+ResourceScheduler::~ResourceScheduler()
+{
+	WaitBuilds();
+}
+
+void ResourceScheduler::SetBuildWorkerCount(uint32_t workerCount)
+{
+	if (workerCount == GetBuildWorkerCount())
+	{
+		return;
+	}
+
+	WaitBuilds();
+	m_pBuildThreadPool = workerCount > 0U ? std::make_unique<ThreadPool>(workerCount) : nullptr;
+}
+
+uint32_t ResourceScheduler::GetBuildWorkerCount() const
+{
+	return m_pBuildThreadPool ? m_pBuildThreadPool->GetWorkerCount() : 0U;
+}
+
+void ResourceScheduler::WaitBuilds()
+{
+	if (m_pBuildThreadPool)
+	{
+		m_pBuildThreadPool->WaitIdle();
+	}
+}
+
+void ResourceScheduler::BeginFrame()
+{
+	++m_frameIndex;
+	m_cpuMemoryUsage = 0U;
+	m_gpuMemoryUsage = 0U;
+	m_evictionCandidates.clear();
+
+	m_uploadBytes = 0U;
+	m_isUploadBudgetExceeded = false;
+	m_frameBeginTime = std::chrono::steady_clock::now();
+}
+
+void ResourceScheduler::UpdateResource(IResource* pResource)
+{
+	if (pResource->IsBuilding())
+	{
+		return;
+	}
+
+	ResourceStatus status = pResource->GetStatus();
+	if (pResource->GetRefCount() > 0U)
+	{
+		pResource->SetLastUsedFrame(m_frameIndex);
+		if (ResourceStatus::Destroyed == status)
+		{
+			// Evicted resource is referenced again.
+			pResource->Reset();
+		}
+	}
+
+	uint64_t cpuMemorySize = pResource->GetCPUMemorySize();
+	uint64_t gpuMemorySize = pResource->GetGPUMemorySize();
+	m_cpuMemoryUsage += cpuMemorySize;
+	m_gpuMemoryUsage += gpuMemorySize;
+	if (0U == pResource->GetRefCount() && (cpuMemorySize > 0U || gpuMemorySize > 0U) &&
+		(ResourceStatus::Ready == status || ResourceStatus::Optimized == status))
+	{
+		m_evictionCandidates.push_back(pResource);
+	}
+
+	if (m_pBuildThreadPool && pResource->CanBuildAsync())
+	{
+		SubmitBuildTask(pResource);
+		return;
+	}
+
+	if (ResourceStatus::Built != pResource->GetStatus())
+	{
+		pResource->Update();
+		return;
+	}
+
+	if (m_isUploadBudgetExceeded)
+	{
+		return;
+	}
+
+	uint64_t uploadSize = pResource->GetUploadSize();
+	if (m_uploadBytes > 0U && m_uploadBytes + uploadSize > m_uploadBudgetBytes)
+	{
+		m_isUploadBudgetExceeded = true;
+		return;
+	}
+
+	pResource->Update();
+	m_uploadBytes += uploadSize;
+
+	std::chrono::duration<float, std::milli> elapsedTime = std::chrono::steady_clock::now() - m_frameBeginTime;
+	m_isUploadBudgetExceeded = elapsedTime.count() >= m_uploadBudgetMilliseconds;
+}
+
+void ResourceScheduler::EndFrame()
+{
+	m_lastUploadBytes = m_uploadBytes;
+
+	EvictResources();
+}
+
+void ResourceScheduler::EvictResources()
+{
+	m_lastEvictedCount = 0U;
+	if (m_cpuMemoryUsage <= m_cpuMemoryBudget && m_gpuMemoryUsage <= m_gpuMemoryBudget)
+	{
+		return;
+	}
+
+	std::sort(m_evictionCandidates.begin(), m_evictionCandidates.end(), [](const IResource* pLhs, const IResource* pRhs)
+	{
+		return pLhs->GetLastUsedFrame() < pRhs->GetLastUsedFrame();
+	});
+
+	for (IResource* pResource : m_evictionCandidates)
+	{
+		if (m_cpuMemoryUsage <= m_cpuMemoryBudget && m_gpuMemoryUsage <= m_gpuMemoryBudget)
+		{
+			break;
+		}
+
+		m_cpuMemoryUsage -= pResource->GetCPUMemorySize();
+		m_gpuMemoryUsage -= pResource->GetGPUMemorySize();
+
+		// Garbage destroys GPU handles and frees CPU data immediately.
+		pResource->SetStatus(ResourceStatus::Garbage);
+		pResource->Update();
+		++m_lastEvictedCount;
+	}
+}
+
+void ResourceScheduler::SubmitBuildTask(IResource* pResource)
+{
+	pResource->SetBuilding(true);
+	m_buildingCount.fetch_add(1, std::memory_order_relaxed);
+	m_pBuildThreadPool->Submit([this, pResource]()
+	{
+		// Run CPU stages until the resource waits for GPU upload or inputs.
+		while (pResource->CanBuildAsync())
+		{
+			pResource->Update();
+		}
+
+		pResource->SetBuilding(false);
+		m_buildingCount.fetch_sub(1, std::memory_order_acq_rel);
+	});
+}
+
+}
\ No newline at end of file
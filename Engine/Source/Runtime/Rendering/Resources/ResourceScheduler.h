@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine
+{
+
+class IResource;
+class ThreadPool;
+
+// ResourceScheduler advances status machines of resources once per frame.
+// CPU stages from Loading to Built run on a build ThreadPool owned by the scheduler. It is separated from the engine
+// ThreadPool so that threads waiting for systems or ParallelFor never pick up a long file load or parse.
+// GPU submission from Built to Ready stays on main thread and is limited by a per frame upload budget.
+// When memory usage exceeds the budget, unreferenced resources are evicted in least recently used order.
+class ResourceScheduler
+{
+public:
+	// Defaults fit integrated GPUs. Applications with more memory can raise them by SetMemoryBudget.
+	static constexpr uint64_t DefaultCPUMemoryBudget = 1024ULL * 1024U * 1024U;
+	static constexpr uint64_t DefaultGPUMemoryBudget = 1024ULL * 1024U * 1024U;
+
+public:
+	ResourceScheduler() = default;
+	ResourceScheduler(const ResourceScheduler&) = delete;
+	ResourceScheduler& operator=(const ResourceScheduler&) = delete;
+	ResourceScheduler(ResourceScheduler&&) = delete;
+	ResourceScheduler& operator=(ResourceScheduler&&) = delete;
+	~ResourceScheduler();
+
+	// 0 to run all stages on main thread. Building resources are waited before workers are replaced.
+	void SetBuildWorkerCount(uint32_t workerCount);
+	uint32_t GetBuildWorkerCount() const;
+
+	// Block until all submitted builds finish. Resources can't be destroyed while workers are building them.
+	void WaitBuilds();
+
+	// Call UpdateResource for every resource between BeginFrame and EndFrame. EndFrame evicts resources over budget.
+	void BeginFrame();
+	void UpdateResource(IResource* pResource);
+	void EndFrame();
+
+	// Uploads in one frame stop when any budget is exceeded. The first upload always runs so that large resources still progress.
+	void SetUploadBudget(uint64_t bytesPerFrame, float millisecondsPerFrame) { m_uploadBudgetBytes = bytesPerFrame; m_uploadBudgetMilliseconds = millisecondsPerFrame; }
+	uint64_t GetUploadBudgetBytes() const { return m_uploadBudgetBytes; }
+	float GetUploadBudgetMilliseconds() const { return m_uploadBudgetMilliseconds; }
+
+	uint64_t GetLastUploadBytes() const { return m_lastUploadBytes; }
+
+	void SetMemoryBudget(uint64_t cpuBytes, uint64_t gpuBytes) { m_cpuMemoryBudget = cpuBytes; m_gpuMemoryBudget = gpuBytes; }
+	uint64_t GetCPUMemoryBudget() const { return m_cpuMemoryBudget; }
+	uint64_t GetGPUMemoryBudget() const { return m_gpuMemoryBudget; }
+
+	// Usages are summarized in last frame after eviction.
+	uint64_t GetCPUMemoryUsage() const { return m_cpuMemoryUsage; }
+	uint64_t GetGPUMemoryUsage() const { return m_gpuMemoryUsage; }
+	uint32_t GetLastEvictedCount() const { return m_lastEvictedCount; }
+	uint32_t GetBuildingCount() const { return m_buildingCount.load(std::memory_order_acquire); }
+
+private:
+	void SubmitBuildTask(IResource* pResource);
+	void EvictResources();
+
+private:
+	std::unique_ptr<ThreadPool> m_pBuildThreadPool;
+	std::atomic<uint32_t> m_buildingCount = 0U;
+
+	uint64_t m_uploadBudgetBytes = 32U * 1024U * 1024U;
+	float m_uploadBudgetMilliseconds = 2.0f;
+	uint64_t m_uploadBytes = 0U;
+	uint64_t m_lastUploadBytes = 0U;
+	bool m_isUploadBudgetExceeded = false;
+	std::chrono::steady_clock::time_point m_frameBeginTime;
+
+	uint64_t m_frameIndex = 0U;
+	uint64_t m_cpuMemoryBudget = DefaultCPUMemoryBudget;
+	uint64_t m_gpuMemoryBudget = DefaultGPUMemoryBudget;
+	uint64_t m_cpuMemoryUsage = 0U;
+	uint64_t m_gpuMemoryUsage = 0U;
+	uint32_t m_lastEvictedCount = 0U;
+
+	// Reused by eviction to avoid allocations.
+	std::vector<IResource*> m_evictionCandidates;
+};
+
+}
\ No newline at end of file
@@ -55,6 +55,8 @@ TextureResource::TextureResource() = default;
 
 TextureResource::~TextureResource()
 {
+	WaitBuild();
+
 	// Collect garbage intermediatly.
 	SetStatus(ResourceStatus::Garbage);
 	Update();
@@ -67,6 +69,7 @@ void TextureResource::SetTextureAsset(const cd::Texture* pTextureAsset)
 
 void TextureResource::SetDDSBuiltTexturePath(std::string ddsFilePath)
 {
+	WaitBuild();
 	m_ddsFilePath = cd::MoveTemp(ddsFilePath);
 }
 
@@ -139,7 +142,8 @@ void TextureResource::Update()
 	{
 		DestroySamplerHandle();
 		DestroyTextureHandle();
-		// CPU data will destroy after deconstructor.
+		// Free CPU data too so that evicted resources release all memory until they are reloaded.
+		FreeTextureData();
 		SetStatus(ResourceStatus::Destroyed);
 		break;
 	}
@@ -148,8 +152,35 @@ void TextureResource::Update()
 	}
 }
 
+bool TextureResource::CanBuildAsync() const
+{
+	switch (GetStatus())
+	{
+	case ResourceStatus::Loading:
+		return !m_ddsFilePath.empty();
+	case ResourceStatus::Loaded:
+		return !m_textureRawData.empty();
+	case ResourceStatus::Building:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint64_t TextureResource::GetCPUMemorySize() const
+{
+	return m_textureRawData.capacity() + GetUploadSize();
+}
+
+uint64_t TextureResource::GetUploadSize() const
+{
+	auto* pImageContainer = reinterpret_cast<const bimg::ImageContainer*>(m_textureImageData);
+	return pImageContainer ? pImageContainer->m_size : 0U;
+}
+
 void TextureResource::Reset()
 {
+	WaitBuild();
 	DestroySamplerHandle();
 	DestroyTextureHandle();
 	FreeTextureData();
@@ -211,6 +242,7 @@ void TextureResource::BuildTextureHandle()
 	m_textureHandle = details::BGFXCreateTexture(pImageContainer->m_width, pImageContainer->m_height, pImageContainer->m_depth, false, pImageContainer->m_numMips > 1,
 		1, static_cast<bgfx::TextureFormat::Enum>(pImageContainer->m_format), GetTextureFlags(), pImageContent).idx;
 	assert(m_textureHandle != UINT16_MAX);
+	m_gpuMemorySize = pImageContainer->m_size;
 }
 
 void TextureResource::ClearTextureData()
@@ -245,6 +277,7 @@ void TextureResource::DestroyTextureHandle()
 	{
 		bgfx::destroy(bgfx::TextureHandle{ m_textureHandle });
 		m_textureHandle = UINT16_MAX;
+		m_gpuMemorySize = 0U;
 	}
 }
 
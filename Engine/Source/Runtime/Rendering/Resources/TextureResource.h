@@ -32,12 +32,19 @@ public:
 
 	virtual void Update() override;
 	virtual void Reset() override;
+	virtual bool CanBuildAsync() const override;
+	virtual uint64_t GetUploadSize() const override;
+	virtual uint64_t GetCPUMemorySize() const override;
+	virtual uint64_t GetGPUMemorySize() const override { return m_gpuMemorySize; }
 
 	// TODO : Move resource builder to engine and aync build not to block main thread.
 	void SetDDSBuiltTexturePath(std::string ddsFilePath);
+	const std::string& GetDDSBuiltTexturePath() const { return m_ddsFilePath; }
 
 	void UpdateTextureType(cd::MaterialPropertyGroup textureType);
 	void UpdateUVMapMode(cd::TextureMapMode u, cd::TextureMapMode v);
+	cd::TextureMapMode GetUMapMode() const { return m_uvMapMode[0]; }
+	cd::TextureMapMode GetVMapMode() const { return m_uvMapMode[1]; }
 
 	const cd::Texture* GetTextureAsset() const { return m_pTextureAsset; }
 	void SetTextureAsset(const cd::Texture* pTextureAsset);
@@ -74,6 +81,7 @@ private:
 	// GPU
 	uint16_t m_samplerHandle = UINT16_MAX;
 	uint16_t m_textureHandle = UINT16_MAX;
+	uint64_t m_gpuMemorySize = 0U;
 };
 
 }
\ No newline at end of file
@@ -25,6 +25,8 @@ enum class ShaderFeature : uint32_t
 	PARTICLE_INSTANCE,
 	ATM,
 	AREAL_LIGHT,
+	INSTANCING,
+	QUANTIZED_VERTEX,
 
 	COUNT,
 };
@@ -41,6 +43,8 @@ constexpr const char* ShaderFeatureNames[] =
 	"PARTICLEINSTANCE;",
 	"ATM;",
 	"AREALLIGHT;",
+	"INSTANCING;",
+	"QUANTIZEDVERTEX;",
 };
 
 static_assert(static_cast<int>(ShaderFeature::COUNT) == sizeof(ShaderFeatureNames) / sizeof(char*),
@@ -0,0 +1,113 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace engine
+{
+
+void ShadowAtlas::Reset(uint16_t atlasSize)
+{
+	assert(std::has_single_bit(atlasSize) && atlasSize >= MinTileSize);
+	m_size = atlasSize;
+
+	// Keep allocated memory of free lists for next frame.
+	uint32_t levelCount = GetLevel(MinTileSize) + 1U;
+	m_freeTiles.resize(levelCount);
+	for (std::vector<ShadowAtlasTile>& freeTiles : m_freeTiles)
+	{
+		freeTiles.clear();
+	}
+	m_freeTiles[0].push_back(ShadowAtlasTile{ 0U, 0U, m_size });
+}
+
+uint16_t ShadowAtlas::GetTileSize(uint16_t tileSize) const
+{
+	return std::clamp(std::bit_ceil(tileSize), MinTileSize, m_size);
+}
+
+uint32_t ShadowAtlas::GetLevel(uint16_t tileSize) const
+{
+	return static_cast<uint32_t>(std::countr_zero(m_size) - std::countr_zero(tileSize));
+}
+
+bool ShadowAtlas::CanAllocate(uint16_t tileSize, uint32_t count) const
+{
+	if (0U == m_size)
+	{
+		return false;
+	}
+
+	// Every free block on a lower level can be split into 4^(levelDelta) tiles.
+	uint32_t targetLevel = GetLevel(GetTileSize(tileSize));
+	uint64_t capacity = 0U;
+	for (uint32_t level = targetLevel + 1U; level-- > 0U;)
+	{
+		capacity += static_cast<uint64_t>(m_freeTiles[level].size()) << (2U * (targetLevel - level));
+		if (capacity >= count)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ShadowAtlas::Allocate(uint16_t tileSize, ShadowAtlasTile& outTile)
+{
+	if (0U == m_size)
+	{
+		return false;
+	}
+
+	// Find the smallest free block which is not smaller than the tile.
+	uint32_t targetLevel = GetLevel(GetTileSize(tileSize));
+	uint32_t level = targetLevel + 1U;
+	while (level-- > 0U && m_freeTiles[level].empty())
+	{
+	}
+
+	if (level > targetLevel)
+	{
+		return false;
+	}
+
+	ShadowAtlasTile tile = m_freeTiles[level].back();
+	m_freeTiles[level].pop_back();
+
+	// Split down to the target level. Children are pushed in reverse order so that the next allocation takes the top-left one.
+	while (level < targetLevel)
+	{
+		++level;
+		uint16_t half = tile.size >> 1;
+		std::vector<ShadowAtlasTile>& freeTiles = m_freeTiles[level];
+		freeTiles.push_back(ShadowAtlasTile{ static_cast<uint16_t>(tile.x + half), static_cast<uint16_t>(tile.y + half), half });
+		freeTiles.push_back(ShadowAtlasTile{ tile.x, static_cast<uint16_t>(tile.y + half), half });
+		freeTiles.push_back(ShadowAtlasTile{ static_cast<uint16_t>(tile.x + half), tile.y, half });
+		tile.size = half;
+	}
+
+	outTile = tile;
+	return true;
+}
+
+uint16_t ShadowAtlas::FitTileSize(uint16_t tileSize, uint32_t count) const
+{
+	if (0U == m_size)
+	{
+		return 0U;
+	}
+
+	for (uint16_t size = GetTileSize(tileSize); size >= MinTileSize; size >>= 1)
+	{
+		if (CanAllocate(size, count))
+		{
+			return size;
+		}
+	}
+
+	return 0U;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace engine
+{
+
+// Pixel rectangle of a shadow view inside the atlas. Origin is the top-left corner.
+struct ShadowAtlasTile
+{
+	uint16_t x = 0U;
+	uint16_t y = 0U;
+	uint16_t size = 0U;
+};
+
+// ShadowAtlas packs square shadow views into one texture by a quadtree. Tile sizes are rounded up to powers of two
+// and a free block is split into four children when a smaller tile is needed, so tiles are aligned to their size and never overlap.
+class ShadowAtlas
+{
+public:
+	static constexpr uint16_t MinTileSize = 64U;
+
+public:
+	ShadowAtlas() = default;
+	ShadowAtlas(const ShadowAtlas&) = delete;
+	ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+	ShadowAtlas(ShadowAtlas&&) = default;
+	ShadowAtlas& operator=(ShadowAtlas&&) = default;
+	~ShadowAtlas() = default;
+
+	// Frees all tiles. atlasSize should be a power of two.
+	void Reset(uint16_t atlasSize);
+	uint16_t GetSize() const { return m_size; }
+
+	bool CanAllocate(uint16_t tileSize, uint32_t count) const;
+	bool Allocate(uint16_t tileSize, ShadowAtlasTile& outTile);
+
+	// Halves tileSize until count tiles can be allocated. Returns 0 if they don't fit even with MinTileSize.
+	uint16_t FitTileSize(uint16_t tileSize, uint32_t count) const;
+
+private:
+	uint16_t GetTileSize(uint16_t tileSize) const;
+	uint32_t GetLevel(uint16_t tileSize) const;
+
+private:
+	uint16_t m_size = 0U;
+
+	// Free blocks per level. Level 0 is the whole atlas and every next level halves the block size.
+	std::vector<std::vector<ShadowAtlasTile>> m_freeTiles;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "ShadowCache.h"
+
+#include <cstring>
+
+namespace engine
+{
+
+void ShadowCache::BeginFrame()
+{
+	++m_frameIndex;
+	m_cachedViewCount = 0U;
+	m_renderedViewCount = 0U;
+}
+
+bool ShadowCache::IsStaticCaster(Entity entity, uint32_t worldMatrixVersion)
+{
+	auto [itCaster, isNewCaster] = m_casterStates.try_emplace(entity, CasterState{ worldMatrixVersion, m_frameIndex - StaticFrameCount, m_frameIndex });
+	CasterState& casterState = itCaster->second;
+	if (!isNewCaster && casterState.worldMatrixVersion != worldMatrixVersion)
+	{
+		casterState.worldMatrixVersion = worldMatrixVersion;
+		casterState.lastChangedFrame = m_frameIndex;
+	}
+	casterState.lastSeenFrame = m_frameIndex;
+
+	return m_frameIndex - casterState.lastChangedFrame >= StaticFrameCount;
+}
+
+ShadowViewUpdate ShadowCache::UpdateView(uint64_t viewKey, const ShadowAtlasTile& tile, const cd::Matrix4x4& viewProjection,
+	const std::vector<ShadowCasterKey>& staticCasters, bool hasDynamicCasters)
+{
+	auto [itView, isNewView] = m_viewStates.try_emplace(viewKey);
+	ViewState& viewState = itView->second;
+
+	bool isStaticLayerDirty = isNewView ||
+		tile.x != viewState.tile.x || tile.y != viewState.tile.y || tile.size != viewState.tile.size ||
+		0 != std::memcmp(viewProjection.begin(), viewState.viewProjection.begin(), 16 * sizeof(float)) ||
+		staticCasters != viewState.staticCasters;
+	if (isStaticLayerDirty)
+	{
+		viewState.tile = tile;
+		viewState.viewProjection = viewProjection;
+		viewState.staticCasters = staticCasters;
+	}
+
+	ShadowViewUpdate update;
+	bool hasStaticCasters = !staticCasters.empty();
+	update.isStaticLayerDirty = isStaticLayerDirty && hasStaticCasters;
+	if (!isStaticLayerDirty && viewState.isTileStatic && !hasDynamicCasters)
+	{
+		update.action = ShadowViewAction::Skip;
+	}
+	else
+	{
+		update.action = hasStaticCasters ? ShadowViewAction::Restore : ShadowViewAction::Clear;
+	}
+
+	// Tile keeps the static layer to next frame only if nothing is drawn on top.
+	viewState.isTileStatic = !hasDynamicCasters;
+	viewState.lastUpdatedFrame = m_frameIndex;
+
+	// Views without static casters are counted in neither.
+	if (update.isStaticLayerDirty)
+	{
+		++m_renderedViewCount;
+	}
+	else if (hasStaticCasters)
+	{
+		++m_cachedViewCount;
+	}
+
+	return update;
+}
+
+void ShadowCache::EndFrame()
+{
+	std::erase_if(m_viewStates, [this](const auto& viewState)
+	{
+		return viewState.second.lastUpdatedFrame != m_frameIndex;
+	});
+
+	std::erase_if(m_casterStates, [this](const auto& casterState)
+	{
+		return m_frameIndex - casterState.second.lastSeenFrame > StaticFrameCount;
+	});
+}
+
+void ShadowCache::Invalidate()
+{
+	m_viewStates.clear();
+}
+
+}
\ No newline at end of file
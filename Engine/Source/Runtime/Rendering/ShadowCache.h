@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ECWorld/Entity.h"
+#include "Math/Matrix.hpp"
+#include "ShadowAtlas.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace engine
+{
+
+enum class ShadowViewAction : uint8_t
+{
+	// Atlas tile still has the static layer from last frame and there are no dynamic casters.
+	Skip,
+	// No static casters. Clear the tile and draw dynamic casters.
+	Clear,
+	// Copy the static layer into the tile and draw dynamic casters on top.
+	Restore,
+};
+
+// Static caster in a shadow view with the geometry which was drawn for it.
+struct ShadowCasterKey
+{
+	Entity entity;
+	// Index buffers of another LOD or mesh data which is reloaded change the shape without moving the caster.
+	uint32_t lod = 0U;
+	uint32_t meshVersion = 0U;
+
+	bool operator==(const ShadowCasterKey&) const = default;
+};
+
+struct ShadowViewUpdate
+{
+	// Static casters should be rendered into the static layer before the view.
+	bool isStaticLayerDirty;
+	ShadowViewAction action;
+};
+
+// ShadowCache decides which shadow views can reuse static casters rendered in previous frames.
+// Casters are static when their world matrices didn't change for StaticFrameCount frames.
+// A static layer is re-rendered when its tile, its view projection or the set of static casters inside the view changes,
+// so moving, stopping, spawning and removing casters only invalidate views which they overlap.
+// Switching LOD or reloading the mesh of a static caster changes its key and invalidates the views too.
+class ShadowCache
+{
+public:
+	static constexpr uint32_t StaticFrameCount = 8U;
+
+public:
+	ShadowCache() = default;
+	ShadowCache(const ShadowCache&) = delete;
+	ShadowCache& operator=(const ShadowCache&) = delete;
+	ShadowCache(ShadowCache&&) = default;
+	ShadowCache& operator=(ShadowCache&&) = default;
+	~ShadowCache() = default;
+
+	void BeginFrame();
+
+	// Casters which are seen the first time are static.
+	bool IsStaticCaster(Entity entity, uint32_t worldMatrixVersion);
+
+	// viewKey : identifies the same shadow view across frames. staticCasters : sorted by entity.
+	ShadowViewUpdate UpdateView(uint64_t viewKey, const ShadowAtlasTile& tile, const cd::Matrix4x4& viewProjection,
+		const std::vector<ShadowCasterKey>& staticCasters, bool hasDynamicCasters);
+
+	// Forgets views which were not updated in current frame and casters which were not seen for a while.
+	void EndFrame();
+
+	// Drops all cached layers such as after recreating the atlas.
+	void Invalidate();
+
+	// Counters of current frame. Cached views didn't render static casters.
+	uint32_t GetCachedViewCount() const { return m_cachedViewCount; }
+	uint32_t GetRenderedViewCount() const { return m_renderedViewCount; }
+
+private:
+	struct CasterState
+	{
+		uint32_t worldMatrixVersion;
+		uint32_t lastChangedFrame;
+		uint32_t lastSeenFrame;
+	};
+
+	struct ViewState
+	{
+		ShadowAtlasTile tile;
+		cd::Matrix4x4 viewProjection;
+		std::vector<ShadowCasterKey> staticCasters;
+		bool isTileStatic;
+		uint32_t lastUpdatedFrame;
+	};
+
+private:
+	uint32_t m_frameIndex = 0U;
+	uint32_t m_cachedViewCount = 0U;
+	uint32_t m_renderedViewCount = 0U;
+
+	std::unordered_map<Entity, CasterState> m_casterStates;
+	std::unordered_map<uint64_t, ViewState> m_viewStates;
+};
+
+}
\ No newline at end of file
@@ -1,17 +1,25 @@
 #include "ShadowMapRenderer.h"
 
 #include "ECWorld/CameraComponent.h"
+#include "ECWorld/CullingSystem.h"
 #include "ECWorld/LightComponent.h"
+#include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "LightUniforms.h"
+#include "Log/Log.h"
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
 #include "Rendering/RenderContext.h"
 #include "Rendering/Resources/MeshResource.h"
+#include "Rendering/Resources/ResourceContext.h"
 #include "Rendering/Resources/ShaderResource.h"
+#include "Scheduler/ThreadPool.h"
+#include "U_Shadow.sh"
 
+#include <algorithm>
+#include <cassert>
 #include <string>
 
 namespace engine
@@ -26,11 +34,66 @@ constexpr const char* lightParams                 = "u_lightParams";
 constexpr const char* lightPosAndFarPlane         = "u_lightWorldPos_farPlane";
 constexpr const char* lightDir                    = "u_LightDir";
 constexpr const char* heightOffsetAndshadowLength = "u_HeightOffsetAndshadowLength";
+constexpr const char* shadowAtlasTexture          = "ShadowAtlasTexture";
+constexpr const char* shadowStaticAtlasTexture    = "ShadowStaticAtlasTexture";
+constexpr const char* shadowStaticAtlas           = "s_shadowStaticAtlas";
 
 constexpr uint64_t samplerFlags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_W_CLAMP;
 constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-constexpr uint64_t depthBufferFlags = BGFX_TEXTURE_RT | BGFX_SAMPLER_COMPARE_LEQUAL;
-constexpr uint64_t linearDepthBufferFlags = BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+constexpr uint64_t shadowAtlasFlags = BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_POINT;
+constexpr uint64_t shadowCacheCopyState = BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_ALWAYS;
+
+// Maps clip space of a shadow view to uv and depth of its tile in the atlas.
+cd::Matrix4x4 GetShadowAtlasTileMatrix(const ShadowAtlasTile& tile)
+{
+	const bgfx::Caps* pCaps = bgfx::getCaps();
+	constexpr float atlasSize = static_cast<float>(SHADOW_MAP_ATLAS_SIZE);
+	float scale = 0.5f * tile.size / atlasSize;
+	float centerU = (tile.x + 0.5f * tile.size) / atlasSize;
+	float centerV = (tile.y + 0.5f * tile.size) / atlasSize;
+
+	// Column major. Viewport rows go down from the top-left corner while ndc y goes up.
+	cd::Matrix4x4 tileMatrix = cd::Matrix4x4::Identity();
+	float* pData = tileMatrix.begin();
+	pData[0] = scale;
+	pData[5] = pCaps->originBottomLeft ? scale : -scale;
+	pData[10] = pCaps->homogeneousDepth ? 0.5f : 1.0f;
+	pData[12] = centerU;
+	pData[13] = pCaps->originBottomLeft ? 1.0f - centerV : centerV;
+	pData[14] = pCaps->homogeneousDepth ? 0.5f : 0.0f;
+	return tileMatrix;
+}
+
+// uv range of the tile shrunk by half texel so that filtering never reads neighbour tiles.
+cd::Vec4f GetShadowAtlasTileRect(const ShadowAtlasTile& tile)
+{
+	constexpr float atlasSize = static_cast<float>(SHADOW_MAP_ATLAS_SIZE);
+	float minU = (tile.x + 0.5f) / atlasSize;
+	float maxU = (tile.x + tile.size - 0.5f) / atlasSize;
+	float minV = (tile.y + 0.5f) / atlasSize;
+	float maxV = (tile.y + tile.size - 0.5f) / atlasSize;
+	if (bgfx::getCaps()->originBottomLeft)
+	{
+		return cd::Vec4f(minU, 1.0f - maxV, maxU, 1.0f - minV);
+	}
+
+	return cd::Vec4f(minU, minV, maxU, maxV);
+}
+
+uint16_t GetShadowViewCount(const LightComponent* pLightComponent)
+{
+	switch (pLightComponent->GetType())
+	{
+	case cd::LightType::Directional:
+		return static_cast<uint16_t>(pLightComponent->GetCascadeNum());
+	case cd::LightType::Point:
+		return 6U;
+	case cd::LightType::Spot:
+		return 1U;
+	default:
+		return 0U;
+	}
+}
 
 }
 
@@ -38,17 +101,42 @@ void ShadowMapRenderer::Init()
 {
 	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("ShadowMapProgram", "vs_shadowMap", "fs_shadowMap"));
 	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("LinearShadowMapProgram", "vs_shadowMap", "fs_shadowMap_linear"));
+	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("ShadowCacheCopyProgram", "vs_shadowCacheCopy", "fs_shadowCacheCopy"));
 
-	for (int lightIndex = 0; lightIndex < shadowLightMaxNum; lightIndex++)
+	// Views execute in the order of IDs so static layers are created first to be ready before copying.
+	for (uint16_t viewIndex = 0U; viewIndex < MAX_SHADOW_VIEW_COUNT; ++viewIndex)
 	{
-		for (int mapId = 0; mapId < shadowTexturePassMaxNum; mapId++)
-		{
-			m_renderPassID[lightIndex * shadowTexturePassMaxNum + mapId] = GetRenderContext()->CreateView();
-			bgfx::setViewName(m_renderPassID[lightIndex * shadowTexturePassMaxNum + mapId], "ShadowMapRenderer");
-		}
+		m_staticRenderPassID[viewIndex] = GetRenderContext()->CreateView();
+		bgfx::setViewName(m_staticRenderPassID[viewIndex], "ShadowMapRenderer_Static");
+	}
+
+	// Static layer is copied before dynamic casters are drawn so that bgfx shouldn't sort draws in the view.
+	for (uint16_t viewIndex = 0U; viewIndex < MAX_SHADOW_VIEW_COUNT; ++viewIndex)
+	{
+		m_renderPassID[viewIndex] = GetRenderContext()->CreateView();
+		bgfx::setViewName(m_renderPassID[viewIndex], "ShadowMapRenderer");
+		bgfx::setViewMode(m_renderPassID[viewIndex], bgfx::ViewMode::Sequential);
 	}
 
+	// All shadow views render into tiles of one depth atlas which WorldRenderer samples directly.
+	bgfx::TextureHandle shadowAtlasTextureHandle = GetRenderContext()->CreateTexture(shadowAtlasTexture, SHADOW_MAP_ATLAS_SIZE, SHADOW_MAP_ATLAS_SIZE, 1,
+		bgfx::TextureFormat::D32F, shadowAtlasFlags);
+	m_shadowAtlasFB = bgfx::createFrameBuffer(1, &shadowAtlasTextureHandle, false);
+
+	m_shadowStaticAtlasTexture = GetRenderContext()->CreateTexture(shadowStaticAtlasTexture, SHADOW_MAP_ATLAS_SIZE, SHADOW_MAP_ATLAS_SIZE, 1,
+		bgfx::TextureFormat::D32F, shadowAtlasFlags);
+	m_shadowStaticAtlasFB = bgfx::createFrameBuffer(1, &m_shadowStaticAtlasTexture, false);
+	m_shadowCache.Invalidate();
+
 	GetRenderContext()->CreateUniform(lightPosAndFarPlane, bgfx::UniformType::Vec4, 1);
+	GetRenderContext()->CreateUniform(shadowStaticAtlas, bgfx::UniformType::Sampler);
+}
+
+void ShadowMapRenderer::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
+{
+	// Shadow atlas is owned by ShadowMapRenderer and sampled by WorldRenderer.
+	constexpr StringCrc shadowAtlas("ShadowAtlas");
+	pRenderGraph->Write(passID, pRenderGraph->ImportResource(shadowAtlas));
 }
 
 void ShadowMapRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
@@ -89,15 +177,36 @@ void ShadowMapRenderer::Render(float deltaTime)
 			return worldPos.xyz() / worldPos.w();
 		};
 
-		uint16_t shadowNum = 0U;
+		m_shadowPasses.clear();
+		m_shadowAtlas.Reset(SHADOW_MAP_ATLAS_SIZE);
 		for (auto lightEntity : lightEntities)
 		{
 			LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntity);
+			lightComponent->ClearLightViewProjMatrix();
+			lightComponent->ClearShadowAtlasRects();
 
 			// Non-shadow-casting lights(include area lights) are excluded
-			if (!lightComponent->IsCastShadow())
+			uint16_t shadowViewCount = GetShadowViewCount(lightComponent);
+			if (!lightComponent->IsCastShadow() || 0U == shadowViewCount)
 			{
-				//continue;
+				continue;
+			}
+
+			if (m_shadowPasses.size() + shadowViewCount > MAX_SHADOW_VIEW_COUNT)
+			{
+				if (!m_isShadowViewLimitReported)
+				{
+					CD_ENGINE_WARN("Shadow views are more than {0}, lights after them are not shadowed!", MAX_SHADOW_VIEW_COUNT);
+					m_isShadowViewLimitReported = true;
+				}
+				continue;
+			}
+
+			// Lights are served in order. Tiles of a light are halved when the atlas has no room for the requested size.
+			uint16_t tileSize = m_shadowAtlas.FitTileSize(lightComponent->GetShadowMapSize(), shadowViewCount);
+			if (0U == tileSize)
+			{
+				continue;
 			}
 
 			// Render shadow map
@@ -106,17 +215,6 @@ void ShadowMapRenderer::Render(float deltaTime)
 			case cd::LightType::Directional:
 			{
 				uint16_t cascadeNum = lightComponent->GetCascadeNum();
-				// Initialize(if not initialized) frame buffer
-				if (!lightComponent->IsShadowMapFBsValid())
-				{
-					lightComponent->ClearShadowMapFBs();	
-					for (int i = 0; i < cascadeNum; ++i)
-					{
-						uint16_t shadowMapFB = bgfx::createFrameBuffer(lightComponent->GetShadowMapSize(),
-							lightComponent->GetShadowMapSize(), bgfx::TextureFormat::D32F).idx;
-						lightComponent->AddShadowMapFB(shadowMapFB);
-					}
-				}
 
 				// Compute the split distances based on the partitioning mode
 				float CascadeSplits[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -173,7 +271,6 @@ void ShadowMapRenderer::Render(float deltaTime)
 
 				// Set cascade split dividing values for choosing cascade level in world renderer
 				lightComponent->SetComputedCascadeSplit(&CascadeSplits[0]);
-				lightComponent->ClearLightViewProjMatrix();
 				for (uint16_t cascadeIndex = 0; cascadeIndex < cascadeNum; ++cascadeIndex)
 				{
 					// Compute every light view and every orthographic projection matrices for each cascade
@@ -217,73 +314,19 @@ void ShadowMapRenderer::Render(float deltaTime)
 					cd::Matrix4x4 lightProjection = cd::Matrix4x4::Orthographic(minX, maxX, maxY, minY, minZ, maxZ,
 						0, ndcDepthMinusOneToOne);
 
-					// Settings
-					bgfx::setState(defaultRenderingState);
-
-					uint16_t viewId = m_renderPassID[shadowNum * shadowTexturePassMaxNum + cascadeIndex];
-					bgfx::setViewRect(viewId, 0, 0, lightComponent->GetShadowMapSize(), lightComponent->GetShadowMapSize());
-					bgfx::setViewFrameBuffer(viewId, static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(cascadeIndex)));
-					bgfx::setViewClear(viewId, BGFX_CLEAR_DEPTH, 0xffffffff, 1.0f, 0);
-					bgfx::setViewTransform(viewId, lightView.begin(), lightProjection.begin());
-
-					// Set transform for projecting coordinates to light space in wolrd renderer 
-					cd::Matrix4x4 lightCSMViewProj = lightProjection * lightView;
-					lightComponent->AddLightViewProjMatrix(lightCSMViewProj);
-
-					// Submit draw call (TODO : one pass MRT
-					for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
-					{
-						// No mesh attached?
-						StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-						if (!pMeshComponent)
-						{
-							continue;
-						}
-						const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
-						if (ResourceStatus::Ready != pMeshResource->GetStatus() &&
-							ResourceStatus::Optimized != pMeshResource->GetStatus())
-						{
-							continue;
-						}
-
-						BlendShapeComponent* pBlendShapeComponent = m_pCurrentSceneWorld->GetBlendShapeComponent(entity);
-						if (pBlendShapeComponent)
-						{
-							continue;
-						}
-
-						// Transform
-						if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-						{
-							bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
-						}
-
-						// Mesh
-						constexpr StringCrc programHandleIndex{ "ShadowMapProgram" };
-						SubmitStaticMeshDrawCall(pMeshComponent, viewId, programHandleIndex);
-					}
+					// Submit draw call for casters inside the cascade (TODO : one pass MRT
+					AddShadowPass(lightEntity, lightComponent, tileSize, lightView, lightProjection);
 				}
 			}
 			break;
 			case cd::LightType::Point:
 			{
-				// Initialize(if not initialized) frame buffer
-				if (!lightComponent->IsShadowMapFBsValid())
-				{
-					for (uint16_t i = 0U; i < 6U; ++i)
-					{
-						/*---------bgfx cube map----------
-						  0:+X 1:-X 2:+Y 3:-Y 4:+Z 5:-Z
-								 +Y
-							-X +Z +X -Z
-								 -Y
-						------------------------------------*/
-						uint16_t shadowMapFB = bgfx::createFrameBuffer(lightComponent->GetShadowMapSize(),
-							lightComponent->GetShadowMapSize(), bgfx::TextureFormat::R32F).idx;
-						lightComponent->AddShadowMapFB(shadowMapFB);
-					}
-				}
-
+				/*---------bgfx cube map----------
+				  0:+X 1:-X 2:+Y 3:-Y 4:+Z 5:-Z
+						 +Y
+					-X +Z +X -Z
+						 -Y
+				------------------------------------*/
 				// Compute 6 light view and 1 perspective projection matrices according to ndc depth of different graphic backends
 				const cd::Point lightPosition = lightComponent->GetPosition();
 				float range = lightComponent->GetRange();
@@ -299,61 +342,17 @@ void ShadowMapRenderer::Render(float deltaTime)
 				};
 				cd::Matrix4x4 lightProjection = cd::Matrix4x4::Perspective(90.0f, 1.0f, 0.01f, range, ndcDepthMinusOneToOne);
 
-				// Settings
-				bgfx::setState(defaultRenderingState);
 				// 6 faces
+				cd::Vec4f lightPosAndFarPlaneData = cd::Vec4f(lightPosition.x(), lightPosition.y(), lightPosition.z(), range);
 				for (uint16_t i = 0U; i < 6U; ++i)
 				{
-					// Settings
-					uint16_t viewId = m_renderPassID[shadowNum * shadowTexturePassMaxNum + i];
-					bgfx::setViewRect(viewId, 0, 0, lightComponent->GetShadowMapSize(), lightComponent->GetShadowMapSize());
-					bgfx::setViewFrameBuffer(viewId, static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(i)));
-					bgfx::setViewClear(viewId, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0xffffffff, 1.0f, 0);
-					bgfx::setViewTransform(viewId, lightView[i].begin(), lightProjection.begin());
-
-					constexpr StringCrc lightPosAndFarPlaneCrc(lightPosAndFarPlane);
-					cd::Vec4f lightPosAndFarPlaneData = cd::Vec4f(lightComponent->GetPosition().x(), lightComponent->GetPosition().y(),
-						lightComponent->GetPosition().z(), lightComponent->GetRange());
-					GetRenderContext()->FillUniform(lightPosAndFarPlaneCrc, &lightPosAndFarPlaneData, 1);
-
 					// Submit draw call
-					for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
-					{
-						// No mesh attached?
-						StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-						if (!pMeshComponent)
-						{
-							continue;
-						}
-						const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
-						if (ResourceStatus::Ready != pMeshResource->GetStatus() &&
-							ResourceStatus::Optimized != pMeshResource->GetStatus())
-						{
-							continue;
-						}
-
-						// Transform
-						if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-						{
-							bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
-						}
-
-						constexpr StringCrc programHandleIndex{ "LinearShadowMapProgram" };
-						SubmitStaticMeshDrawCall(pMeshComponent, viewId, programHandleIndex);
-					}
+					AddShadowPass(lightEntity, lightComponent, tileSize, lightView[i], lightProjection, &lightPosAndFarPlaneData);
 				}
 			}
 			break;
 			case cd::LightType::Spot:
 			{
-				// Initialize(if not initialized) frame buffer
-				if (!lightComponent->IsShadowMapFBsValid())
-				{
-					uint16_t shadowMapFB = bgfx::createFrameBuffer(lightComponent->GetShadowMapSize(),
-						lightComponent->GetShadowMapSize(), bgfx::TextureFormat::D32F).idx;
-					lightComponent->AddShadowMapFB(shadowMapFB);
-				}
-
 				// Compute 1 light view and 1 perspective projection matrices according to ndc depth of different graphic backends
 				const cd::Point lightPosition = lightComponent->GetPosition();
 				const cd::Point lightDirection = lightComponent->GetDirection();
@@ -363,63 +362,243 @@ void ShadowMapRenderer::Render(float deltaTime)
 				cd::Matrix4x4 lightView = cd::Matrix4x4::LookAt<cd::Handedness::Left>(lightPosition, lightPosition + lightDirection, upOrRight);
 				cd::Matrix4x4 lightProjection = cd::Matrix4x4::Perspective(2.0f*lightComponent->GetInnerAndOuter().y(), 1.0f, 0.1f, range, ndcDepthMinusOneToOne);
 
-				// Settings
-				uint64_t state = defaultRenderingState;
-				bgfx::setState(state);
-				uint16_t viewId = m_renderPassID[shadowNum * shadowTexturePassMaxNum + 0];
-				bgfx::setViewRect(viewId, 0, 0, lightComponent->GetShadowMapSize(), lightComponent->GetShadowMapSize());
-				bgfx::setViewFrameBuffer(viewId, static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(0)));
-				bgfx::setViewClear(viewId, BGFX_CLEAR_DEPTH, 0xffffffff, 1.0f, 0);
-				bgfx::setViewTransform(viewId, lightView.begin(), lightProjection.begin());
+				// Submit draw call
+				AddShadowPass(lightEntity, lightComponent, tileSize, lightView, lightProjection);
+			}
+			break;
+			}
+		}
 
-				// Set transform for projecting coordinates to light space in wolrd renderer 
-				lightComponent->ClearLightViewProjMatrix();
-				cd::Matrix4x4 lightCSMViewProj = lightProjection * lightView;
-				lightComponent->AddLightViewProjMatrix(lightCSMViewProj);
+		RecordShadowPasses();
+	}
+}
 
-				// Submit draw call
-				for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
-				{
-					// No mesh attached?
-					StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-					if (!pMeshComponent)
-					{
-						continue;
-					}
-					const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
-					if (ResourceStatus::Ready != pMeshResource->GetStatus() &&
-						ResourceStatus::Optimized != pMeshResource->GetStatus())
-					{
-						continue;
-					}
+void ShadowMapRenderer::AddShadowPass(Entity lightEntity, LightComponent* pLightComponent, uint16_t tileSize, const cd::Matrix4x4& view, const cd::Matrix4x4& projection,
+	const cd::Vec4f* pLightPosAndFarPlane)
+{
+	ShadowAtlasTile tile;
+	[[maybe_unused]] bool isAllocated = m_shadowAtlas.Allocate(tileSize, tile);
+	assert(isAllocated && "Tile size should be fitted to the atlas before allocating.");
+
+	// The same light view across frames such as the second cascade of a directional light.
+	uint64_t localViewIndex = pLightComponent->GetLightViewProjMatrix().size();
+	uint64_t cacheKey = (static_cast<uint64_t>(lightEntity) << 32) | localViewIndex;
+
+	// Set transform for projecting coordinates to the tile in world renderer
+	cd::Matrix4x4 viewProjection = projection * view;
+	pLightComponent->AddLightViewProjMatrix(GetShadowAtlasTileMatrix(tile) * viewProjection);
+	pLightComponent->AddShadowAtlasRect(GetShadowAtlasTileRect(tile));
+
+	// Point lights store linear depth.
+	constexpr StringCrc shadowMapProgramCrc{ "ShadowMapProgram" };
+	constexpr StringCrc linearShadowMapProgramCrc{ "LinearShadowMapProgram" };
+	bool isLinearDepth = pLightPosAndFarPlane != nullptr;
+	StringCrc programCrc = isLinearDepth ? linearShadowMapProgramCrc : shadowMapProgramCrc;
+
+	size_t passIndex = m_shadowPasses.size();
+	ShadowPass& shadowPass = m_shadowPasses.emplace_back();
+	shadowPass.view = view;
+	shadowPass.projection = projection;
+	shadowPass.viewProjection = viewProjection;
+	shadowPass.lightPosAndFarPlane = isLinearDepth ? *pLightPosAndFarPlane : cd::Vec4f::Zero();
+	shadowPass.tile = tile;
+	shadowPass.cacheKey = cacheKey;
+	shadowPass.viewID = m_renderPassID[passIndex];
+	shadowPass.staticViewID = m_staticRenderPassID[passIndex];
+	shadowPass.programHandle = GetRenderContext()->GetResourceContext()->GetShaderResource(programCrc)->GetHandle();
+	shadowPass.isLinearDepth = isLinearDepth;
+}
 
-					BlendShapeComponent* pBlendShapeComponent = m_pCurrentSceneWorld->GetBlendShapeComponent(entity);
-					if (pBlendShapeComponent)
-					{
-						continue;
-					}
+bool ShadowMapRenderer::IsShadowCaster(Entity entity, bool isLinearDepth) const
+{
+	const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+	if (!pMeshComponent || !m_pCurrentSceneWorld->GetMaterialComponent(entity))
+	{
+		return false;
+	}
 
-					// Transform
-					if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-					{
-						bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
-					}
+	const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
+	if (ResourceStatus::Ready != pMeshResource->GetStatus() &&
+		ResourceStatus::Optimized != pMeshResource->GetStatus())
+	{
+		return false;
+	}
 
-					// Mesh
-					constexpr StringCrc programHandleIndex{ "ShadowMapProgram" };
-					SubmitStaticMeshDrawCall(pMeshComponent, viewId, programHandleIndex);
-				}
+	// TODO : Blend shape casters are only supported by linear shadow maps now.
+	return isLinearDepth || !m_pCurrentSceneWorld->GetBlendShapeComponent(entity);
+}
+
+void ShadowMapRenderer::RecordShadowPasses()
+{
+	size_t passCount = m_shadowPasses.size();
+	if (m_shadowCasterEntities.size() < passCount)
+	{
+		m_shadowCasterEntities.resize(passCount);
+		m_staticCasterEntities.resize(passCount);
+		m_occlusionBuffers.resize(passCount);
+	}
+
+	auto CullShadowPasses = [this](size_t begin, size_t end)
+	{
+		for (size_t passIndex = begin; passIndex < end; ++passIndex)
+		{
+			const ShadowPass& shadowPass = m_shadowPasses[passIndex];
+			std::vector<Entity>& shadowCasterEntities = m_shadowCasterEntities[passIndex];
+			m_pCurrentSceneWorld->GetCullingSystem()->CullView(shadowPass.viewProjection, shadowCasterEntities, &m_occlusionBuffers[passIndex]);
+			std::erase_if(shadowCasterEntities, [this, &shadowPass](Entity entity)
+			{
+				return !IsShadowCaster(entity, shadowPass.isLinearDepth);
+			});
+		}
+	};
+
+	auto RecordShadowPassRange = [this](size_t begin, size_t end)
+	{
+		bgfx::Encoder* pEncoder = GetRenderContext()->BeginEncoder();
+		for (size_t passIndex = begin; passIndex < end; ++passIndex)
+		{
+			RecordShadowPass(pEncoder, passIndex);
+		}
+		GetRenderContext()->EndEncoder(pEncoder);
+	};
+
+	ThreadPool* pThreadPool = GetRenderContext()->GetThreadPool();
+	if (!pThreadPool || passCount < 2)
+	{
+		CullShadowPasses(0, passCount);
+		UpdateShadowCache();
+		RecordShadowPassRange(0, passCount);
+		return;
+	}
+
+	// Culling and recording run in jobs. Cache states and bgfx view settings are updated on main thread between them.
+	// One encoder per job. bgfx limits how many encoders can be alive at the same time.
+	size_t jobCount = std::min<size_t>(pThreadPool->GetWorkerCount() + 1, GetRenderContext()->GetMaxWorkerEncoderCount());
+	size_t batchSize = (passCount + jobCount - 1) / jobCount;
+	pThreadPool->ParallelFor(passCount, batchSize, CullShadowPasses);
+	UpdateShadowCache();
+	pThreadPool->ParallelFor(passCount, batchSize, RecordShadowPassRange);
+}
+
+void ShadowMapRenderer::UpdateShadowCache()
+{
+	m_shadowCache.BeginFrame();
+	for (size_t passIndex = 0; passIndex < m_shadowPasses.size(); ++passIndex)
+	{
+		ShadowPass& shadowPass = m_shadowPasses[passIndex];
+
+		// Split casters into static and dynamic ones. Animated casters change their shapes without moving.
+		std::vector<Entity>& dynamicCasterEntities = m_shadowCasterEntities[passIndex];
+		std::vector<Entity>& staticCasterEntities = m_staticCasterEntities[passIndex];
+		staticCasterEntities.clear();
+		std::erase_if(dynamicCasterEntities, [this, &staticCasterEntities](Entity entity)
+		{
+			if (m_pCurrentSceneWorld->GetAnimationComponent(entity) || m_pCurrentSceneWorld->GetBlendShapeComponent(entity))
+			{
+				return false;
 			}
-			break;
+
+			// Casters without a TransformComponent never move.
+			const TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity);
+			uint32_t worldMatrixVersion = pTransformComponent ? pTransformComponent->GetWorldMatrixVersion() : 0U;
+			if (!m_shadowCache.IsStaticCaster(entity, worldMatrixVersion))
+			{
+				return false;
 			}
 
-			++shadowNum;
-			if (3 == shadowNum)
+			staticCasterEntities.push_back(entity);
+			return true;
+		});
+		std::sort(staticCasterEntities.begin(), staticCasterEntities.end());
+
+		// Keys use the LOD which RecordShadowPass draws.
+		m_staticCasterKeys.clear();
+		for (Entity entity : staticCasterEntities)
+		{
+			const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+			const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
+			uint32_t lod = std::min(pMeshComponent->GetLOD(), pMeshResource->GetLODCount() - 1U);
+			m_staticCasterKeys.push_back(ShadowCasterKey{ entity, lod, pMeshResource->GetVersion() });
+		}
+
+		shadowPass.update = m_shadowCache.UpdateView(shadowPass.cacheKey, shadowPass.tile, shadowPass.viewProjection,
+			m_staticCasterKeys, !dynamicCasterEntities.empty());
+
+		const ShadowAtlasTile& tile = shadowPass.tile;
+		if (shadowPass.update.isStaticLayerDirty)
+		{
+			uint16_t staticViewID = shadowPass.staticViewID;
+			bgfx::setViewRect(staticViewID, tile.x, tile.y, tile.size, tile.size);
+			bgfx::setViewFrameBuffer(staticViewID, m_shadowStaticAtlasFB);
+			bgfx::setViewClear(staticViewID, BGFX_CLEAR_DEPTH, 0xffffffff, 1.0f, 0);
+			bgfx::setViewTransform(staticViewID, shadowPass.view.begin(), shadowPass.projection.begin());
+		}
+
+		// Restored tiles are fully overwritten by the copy. Skipped tiles keep last frame.
+		uint16_t viewID = shadowPass.viewID;
+		bgfx::setViewRect(viewID, tile.x, tile.y, tile.size, tile.size);
+		bgfx::setViewFrameBuffer(viewID, m_shadowAtlasFB);
+		bgfx::setViewTransform(viewID, shadowPass.view.begin(), shadowPass.projection.begin());
+		if (ShadowViewAction::Clear == shadowPass.update.action)
+		{
+			bgfx::setViewClear(viewID, BGFX_CLEAR_DEPTH, 0xffffffff, 1.0f, 0);
+			bgfx::touch(viewID);
+		}
+		else
+		{
+			bgfx::setViewClear(viewID, BGFX_CLEAR_NONE);
+		}
+	}
+	m_shadowCache.EndFrame();
+
+	DrawStats shadowCacheStats;
+	shadowCacheStats.cachedShadowViewCount = m_shadowCache.GetCachedViewCount();
+	shadowCacheStats.renderedShadowViewCount = m_shadowCache.GetRenderedViewCount();
+	GetRenderContext()->GetDrawStats().Merge(shadowCacheStats);
+}
+
+void ShadowMapRenderer::RecordShadowPass(bgfx::Encoder* pEncoder, size_t passIndex)
+{
+	const ShadowPass& shadowPass = m_shadowPasses[passIndex];
+	if (ShadowViewAction::Skip == shadowPass.update.action)
+	{
+		return;
+	}
+
+	bgfx::UniformHandle lightPosAndFarPlaneUniform = GetRenderContext()->GetUniform(StringCrc(lightPosAndFarPlane));
+	auto SubmitCasters = [&](const std::vector<Entity>& casterEntities, uint16_t viewID)
+	{
+		for (Entity entity : casterEntities)
+		{
+			// Encoders start from empty states so that everything is set per draw.
+			pEncoder->setState(defaultRenderingState);
+			const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+			const cd::Matrix4x4& worldMatrix = m_pCurrentSceneWorld->GetWorldMatrix(entity);
+			pEncoder->setTransform(pMeshComponent->GetMeshResource()->GetDequantizedWorldMatrix(worldMatrix).begin());
+			if (shadowPass.isLinearDepth)
 			{
-				break;
+				pEncoder->setUniform(lightPosAndFarPlaneUniform, &shadowPass.lightPosAndFarPlane, 1);
 			}
+
+			SubmitStaticMeshDrawCall(pEncoder, pMeshComponent, viewID, shadowPass.programHandle);
 		}
+	};
+
+	if (shadowPass.update.isStaticLayerDirty)
+	{
+		SubmitCasters(m_staticCasterEntities[passIndex], shadowPass.staticViewID);
 	}
+
+	if (ShadowViewAction::Restore == shadowPass.update.action)
+	{
+		constexpr StringCrc shadowCacheCopyProgramCrc{ "ShadowCacheCopyProgram" };
+		pEncoder->setState(shadowCacheCopyState);
+		pEncoder->setTexture(0, GetRenderContext()->GetUniform(StringCrc(shadowStaticAtlas)), m_shadowStaticAtlasTexture);
+		pEncoder->setVertexCount(3);
+		GetRenderContext()->Submit(pEncoder, shadowPass.viewID, GetRenderContext()->GetResourceContext()->GetShaderResource(shadowCacheCopyProgramCrc)->GetHandle());
+	}
+
+	SubmitCasters(m_shadowCasterEntities[passIndex], shadowPass.viewID);
 }
 
 }
\ No newline at end of file
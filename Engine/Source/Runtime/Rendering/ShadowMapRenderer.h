@@ -1,15 +1,22 @@
 #pragma once
 
+#include "ECWorld/Entity.h"
+#include "Light.h"
+#include "Math/Matrix.hpp"
+#include "OcclusionBuffer.h"
 #include "Renderer.h"
+#include "ShadowAtlas.h"
+#include "ShadowCache.h"
+#include "U_Shadow.sh"
+
+#include <bgfx/bgfx.h>
+
+#include <vector>
 
 namespace engine
 {
-namespace 
-{
-constexpr uint16_t shadowLightMaxNum = 3U;
-constexpr uint16_t shadowTexturePassMaxNum = 6U;
-}
 
+class LightComponent;
 class SceneWorld;
 
 class ShadowMapRenderer final : public Renderer
@@ -20,12 +27,58 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
+	virtual void SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+private:
+	// Shadow views are set up on main thread and recorded by jobs. Every pass has its own view so they don't share bgfx states.
+	struct ShadowPass
+	{
+		cd::Matrix4x4 view;
+		cd::Matrix4x4 projection;
+		cd::Matrix4x4 viewProjection;
+		cd::Vec4f lightPosAndFarPlane;
+		ShadowAtlasTile tile;
+		uint64_t cacheKey;
+		ShadowViewUpdate update;
+		uint16_t viewID;
+		uint16_t staticViewID;
+		uint16_t programHandle;
+		bool isLinearDepth;
+	};
+
+	// Allocates a tile of the shadow atlas. The light gets the matrix from world space to the tile.
+	void AddShadowPass(Entity lightEntity, LightComponent* pLightComponent, uint16_t tileSize, const cd::Matrix4x4& view, const cd::Matrix4x4& projection,
+		const cd::Vec4f* pLightPosAndFarPlane = nullptr);
+	bool IsShadowCaster(Entity entity, bool isLinearDepth) const;
+	void RecordShadowPasses();
+	void UpdateShadowCache();
+	void RecordShadowPass(bgfx::Encoder* pEncoder, size_t passIndex);
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
-	uint16_t m_renderPassID[18];
+	uint16_t m_renderPassID[MAX_SHADOW_VIEW_COUNT];
+	uint16_t m_staticRenderPassID[MAX_SHADOW_VIEW_COUNT];
+	// Lights beyond the shadow view limit are rendered without shadows. It is reported once.
+	bool m_isShadowViewLimitReported = false;
+
+	ShadowAtlas m_shadowAtlas;
+	bgfx::FrameBufferHandle m_shadowAtlasFB = BGFX_INVALID_HANDLE;
+
+	// Static casters are kept in a second atlas with the same tile layout and copied into the shadow atlas under dynamic casters.
+	ShadowCache m_shadowCache;
+	bgfx::TextureHandle m_shadowStaticAtlasTexture = BGFX_INVALID_HANDLE;
+	bgfx::FrameBufferHandle m_shadowStaticAtlasFB = BGFX_INVALID_HANDLE;
+
+	std::vector<ShadowPass> m_shadowPasses;
+	// Casters per shadow pass so that jobs don't share the output. Dynamic casters are drawn every frame.
+	std::vector<std::vector<Entity>> m_shadowCasterEntities;
+	std::vector<std::vector<Entity>> m_staticCasterEntities;
+	// Reused to build cache keys of static casters.
+	std::vector<ShadowCasterKey> m_staticCasterKeys;
+	// Casters hide other casters behind them from the light.
+	std::vector<OcclusionBuffer> m_occlusionBuffers;
 };
 
 }
\ No newline at end of file
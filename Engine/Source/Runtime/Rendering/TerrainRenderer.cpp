@@ -1,6 +1,7 @@
 #include "TerrainRenderer.h"
 
 #include "ECWorld/CameraComponent.h"
+#include "ECWorld/CullingSystem.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/SkyComponent.h"
@@ -13,9 +14,12 @@
 #include "Rendering/Resources/MeshResource.h"
 #include "Rendering/Resources/ShaderResource.h"
 #include "Scene/Texture.h"
+#include "Scheduler/ThreadPool.h"
 #include "U_IBL.sh"
 #include "U_Terrain.sh"
 
+#include <algorithm>
+
 namespace engine
 {
 
@@ -100,26 +104,24 @@ void TerrainRenderer::UpdateView(const float* pViewMatrix, const float* pProject
 
 void TerrainRenderer::Render(float deltaTime)
 {
-	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
-	const CameraComponent* pMainCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
-	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
 	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
 
-	for (Entity entity : m_pCurrentSceneWorld->GetTerrainEntities())
-	{		
+	// Resources are created and updated on main thread because RenderContext caches are not thread safe.
+	m_terrainEntities.clear();
+	for (Entity entity : m_pCurrentSceneWorld->GetCullingSystem()->GetVisibleEntities(CullingSystem::MainCameraView))
+	{
 		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if (!pMaterialComponent ||
-			pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetTerrainMaterialType())
+		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		TerrainComponent* pTerrainComponent = m_pCurrentSceneWorld->GetTerrainComponent(entity);
+		if (!pMaterialComponent || !pMeshComponent || !pTerrainComponent)
 		{
-			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
-			// For example, terrain/particle/...
 			continue;
 		}
 
-		// No mesh attached?
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
+		if (pMaterialComponent->GetMaterialType() != m_pCurrentSceneWorld->GetTerrainMaterialType())
 		{
+			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
+			// For example, terrain/particle/...
 			continue;
 		}
 
@@ -137,105 +139,153 @@ void TerrainRenderer::Render(float deltaTime)
 			continue;
 		}
 
-		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
-		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
-		}
-
-		// Material
-		bgfx::setTexture(TERRAIN_TOP_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(snowSampler)),
-			GetRenderContext()->GetTexture(StringCrc(snowTexture)));
-
-		bgfx::setTexture(TERRAIN_MEDIUM_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(rockSampler)),
-			GetRenderContext()->GetTexture(StringCrc(rockTexture)));
-
-		bgfx::setTexture(TERRAIN_BOTTOM_ALBEDO_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(grassSampler)),
-			GetRenderContext()->GetTexture(StringCrc(grassTexture)));
-
-		TerrainComponent* pTerrainComponent = m_pCurrentSceneWorld->GetTerrainComponent(entity);
 		GetRenderContext()->UpdateTexture(elevationTexture, 0, 0, 0, 0, 0, pTerrainComponent->GetTexWidth(), pTerrainComponent->GetTexDepth(),
 			1, pTerrainComponent->GetElevationRawData(), pTerrainComponent->GetElevationRawDataSize());
+		m_terrainEntities.push_back(entity);
+	}
 
-		bgfx::setTexture(TERRAIN_ELEVATION_MAP_SLOT,
-			GetRenderContext()->GetUniform(StringCrc(elevationSampler)),
-			GetRenderContext()->GetTexture(StringCrc(elevationTexture)));
+	if (m_terrainEntities.empty())
+	{
+		return;
+	}
 
-		// Sky
-		SkyType crtSkyType = pSkyComponent->GetSkyType();
-		if (crtSkyType == SkyType::SkyBox)
-		{
-			constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_IRRADIANCE_SLOT,
-				GetRenderContext()->GetUniform(irrSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
-
-			constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_RADIANCE_SLOT,
-				GetRenderContext()->GetUniform(radSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
-
-			constexpr StringCrc iblStrengthCrc{ iblStrength };
-			GetRenderContext()->FillUniform(iblStrengthCrc, &(pMaterialComponent->GetIblStrengeth()));
-
-			constexpr StringCrc lutsamplerCrc(lutSampler);
-			constexpr StringCrc luttextureCrc(lutTexture);
-			bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
-		}
+	if (SkyType::SkyBox == pSkyComponent->GetSkyType())
+	{
+		GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+		GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+	}
 
-		// Submit uniform values : camera settings
-		constexpr StringCrc cameraPosCrc(cameraPos);
-		GetRenderContext()->FillUniform(cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
-
-		constexpr StringCrc cameraNearFarPlaneCrc(cameraNearFarPlane);
-		float cameraNearFarPlanedata[2] { pMainCameraComponent->GetNearPlane(), pMainCameraComponent->GetFarPlane() };
-		GetRenderContext()->FillUniform(cameraNearFarPlaneCrc, cameraNearFarPlanedata, 1);
-
-		// Submit  uniform values : material settings
-		constexpr StringCrc albedoColorCrc(albedoColor);
-		GetRenderContext()->FillUniform(albedoColorCrc, pMaterialComponent->GetFactor<cd::Vec3f>(cd::MaterialPropertyGroup::BaseColor), 1);
-
-		cd::Vec4f u_metallicRoughnessRefectanceFactorData(
-			*(pMaterialComponent->GetFactor<float>(cd::MaterialPropertyGroup::Metallic)),
-			*(pMaterialComponent->GetFactor<float>(cd::MaterialPropertyGroup::Roughness)),
-			pMaterialComponent->GetReflectance(),
-			1.0f);
-		constexpr StringCrc mrrFactorCrc(metallicRoughnessRefectanceFactor);
-		GetRenderContext()->FillUniform(mrrFactorCrc, u_metallicRoughnessRefectanceFactorData.begin(), 1);
-
-		constexpr StringCrc emissiveColorCrc(emissiveColor);
-		GetRenderContext()->FillUniform(emissiveColorCrc, pMaterialComponent->GetFactor<cd::Vec4f>(cd::MaterialPropertyGroup::Emissive), 1);
-
-		// Submit  uniform values : light settings
-		auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-		size_t lightEntityCount = lightEntities.size();
-		constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
-		static cd::Vec4f lightInfoData(0, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
-		GetRenderContext()->FillUniform(lightCountAndStrideCrc, lightInfoData.begin(), 1);
-		if (lightEntityCount > 0)
+	// Light components are not guaranteed to be contiguous in component storage so that copy them into one array.
+	m_lightParams.clear();
+	for (Entity lightEntity : m_pCurrentSceneWorld->GetLightEntities())
+	{
+		if (m_lightParams.size() >= MAX_LIGHT_COUNT)
 		{
-			// Light component storage has continus memory address and layout.
-			float* pLightDataBegin = reinterpret_cast<float*>(m_pCurrentSceneWorld->GetLightComponent(lightEntities[0]));
-			constexpr engine::StringCrc lightParamsCrc(lightParams);
-			GetRenderContext()->FillUniform(lightParamsCrc, pLightDataBegin, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+			break;
 		}
+		m_lightParams.push_back(*m_pCurrentSceneWorld->GetLightComponent(lightEntity)->GetLightUniformData());
+	}
 
-		uint64_t state = defaultRenderingState;
-		if (!pMaterialComponent->GetTwoSided())
+	auto RecordTerrainRange = [this](size_t begin, size_t end)
+	{
+		bgfx::Encoder* pEncoder = GetRenderContext()->BeginEncoder();
+		for (size_t entityIndex = begin; entityIndex < end; ++entityIndex)
 		{
-			state |= BGFX_STATE_CULL_CCW;
+			RecordTerrain(pEncoder, m_terrainEntities[entityIndex]);
 		}
+		GetRenderContext()->EndEncoder(pEncoder);
+	};
+
+	// The view sorts draws by itself so that encoders can record terrains in any order.
+	ThreadPool* pThreadPool = GetRenderContext()->GetThreadPool();
+	size_t terrainCount = m_terrainEntities.size();
+	if (!pThreadPool || terrainCount < 2)
+	{
+		RecordTerrainRange(0, terrainCount);
+		return;
+	}
 
-		bgfx::setState(state);
+	size_t jobCount = std::min<size_t>(pThreadPool->GetWorkerCount() + 1, GetRenderContext()->GetMaxWorkerEncoderCount());
+	size_t batchSize = (terrainCount + jobCount - 1) / jobCount;
+	pThreadPool->ParallelFor(terrainCount, batchSize, RecordTerrainRange);
+}
 
-		SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), pShaderResource->GetHandle());
+void TerrainRenderer::RecordTerrain(bgfx::Encoder* pEncoder, Entity entity)
+{
+	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
+	const CameraComponent* pMainCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+
+	MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+	StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+	const ShaderResource* pShaderResource = pMaterialComponent->GetShaderResource();
+
+	// Transform
+	pEncoder->setTransform(m_pCurrentSceneWorld->GetWorldMatrix(entity).begin());
+
+	// Material
+	pEncoder->setTexture(TERRAIN_TOP_ALBEDO_MAP_SLOT,
+		GetRenderContext()->GetUniform(StringCrc(snowSampler)),
+		GetRenderContext()->GetTexture(StringCrc(snowTexture)));
+
+	pEncoder->setTexture(TERRAIN_MEDIUM_ALBEDO_MAP_SLOT,
+		GetRenderContext()->GetUniform(StringCrc(rockSampler)),
+		GetRenderContext()->GetTexture(StringCrc(rockTexture)));
+
+	pEncoder->setTexture(TERRAIN_BOTTOM_ALBEDO_MAP_SLOT,
+		GetRenderContext()->GetUniform(StringCrc(grassSampler)),
+		GetRenderContext()->GetTexture(StringCrc(grassTexture)));
+
+	pEncoder->setTexture(TERRAIN_ELEVATION_MAP_SLOT,
+		GetRenderContext()->GetUniform(StringCrc(elevationSampler)),
+		GetRenderContext()->GetTexture(StringCrc(elevationTexture)));
+
+	// Sky
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
+	if (crtSkyType == SkyType::SkyBox)
+	{
+		constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
+		pEncoder->setTexture(IBL_IRRADIANCE_SLOT,
+			GetRenderContext()->GetUniform(irrSamplerCrc),
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
+
+		constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
+		pEncoder->setTexture(IBL_RADIANCE_SLOT,
+			GetRenderContext()->GetUniform(radSamplerCrc),
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
+
+		constexpr StringCrc iblStrengthCrc{ iblStrength };
+		GetRenderContext()->FillUniform(pEncoder, iblStrengthCrc, &(pMaterialComponent->GetIblStrengeth()));
+
+		constexpr StringCrc lutsamplerCrc(lutSampler);
+		constexpr StringCrc luttextureCrc(lutTexture);
+		pEncoder->setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+	}
+
+	// Submit uniform values : camera settings
+	constexpr StringCrc cameraPosCrc(cameraPos);
+	GetRenderContext()->FillUniform(pEncoder, cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
+
+	constexpr StringCrc cameraNearFarPlaneCrc(cameraNearFarPlane);
+	float cameraNearFarPlanedata[2] { pMainCameraComponent->GetNearPlane(), pMainCameraComponent->GetFarPlane() };
+	GetRenderContext()->FillUniform(pEncoder, cameraNearFarPlaneCrc, cameraNearFarPlanedata, 1);
+
+	// Submit  uniform values : material settings
+	constexpr StringCrc albedoColorCrc(albedoColor);
+	GetRenderContext()->FillUniform(pEncoder, albedoColorCrc, pMaterialComponent->GetFactor<cd::Vec3f>(cd::MaterialPropertyGroup::BaseColor), 1);
+
+	cd::Vec4f u_metallicRoughnessRefectanceFactorData(
+		*(pMaterialComponent->GetFactor<float>(cd::MaterialPropertyGroup::Metallic)),
+		*(pMaterialComponent->GetFactor<float>(cd::MaterialPropertyGroup::Roughness)),
+		pMaterialComponent->GetReflectance(),
+		1.0f);
+	constexpr StringCrc mrrFactorCrc(metallicRoughnessRefectanceFactor);
+	GetRenderContext()->FillUniform(pEncoder, mrrFactorCrc, u_metallicRoughnessRefectanceFactorData.begin(), 1);
+
+	constexpr StringCrc emissiveColorCrc(emissiveColor);
+	GetRenderContext()->FillUniform(pEncoder, emissiveColorCrc, pMaterialComponent->GetFactor<cd::Vec4f>(cd::MaterialPropertyGroup::Emissive), 1);
+
+	// Submit  uniform values : light settings
+	size_t lightCount = m_lightParams.size();
+	constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
+	cd::Vec4f lightInfoData(static_cast<float>(lightCount), LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
+	GetRenderContext()->FillUniform(pEncoder, lightCountAndStrideCrc, lightInfoData.begin(), 1);
+	if (lightCount > 0)
+	{
+		constexpr engine::StringCrc lightParamsCrc(lightParams);
+		GetRenderContext()->FillUniform(pEncoder, lightParamsCrc, m_lightParams.data(), static_cast<uint16_t>(lightCount * LightUniform::LIGHT_STRIDE));
 	}
+
+	uint64_t state = defaultRenderingState;
+	if (!pMaterialComponent->GetTwoSided())
+	{
+		state |= BGFX_STATE_CULL_CCW;
+	}
+
+	pEncoder->setState(state);
+
+	SubmitStaticMeshDrawCall(pEncoder, pMeshComponent, GetViewID(), pShaderResource->GetHandle());
 }
 
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "ECWorld/Entity.h"
+#include "Light.h"
 #include "Renderer.h"
 
+#include <vector>
+
 namespace engine
 {
 
@@ -18,8 +22,14 @@ public:
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+private:
+	// Records on worker threads. Resources used by the draw should be created before.
+	void RecordTerrain(bgfx::Encoder* pEncoder, Entity entity);
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+	std::vector<Entity> m_terrainEntities;
+	std::vector<U_Light> m_lightParams;
 };
 
 }
\ No newline at end of file
@@ -91,6 +91,8 @@ void ConvertVertexLayout(const cd::VertexAttributeLayout& vertexAttributeLayout,
 		break;
 	case cd::AttributeValueType::Int16:
 		vertexAttributeValue = bgfx::AttribType::Enum::Int16;
+		// 16-bit values of float attributes are quantized in snorm. Bone indices stay integers.
+		normalized = vertexAttribute != bgfx::Attrib::Enum::Indices;
 		break;
 	case cd::AttributeValueType::Float:
 		vertexAttributeValue = bgfx::AttribType::Enum::Float;
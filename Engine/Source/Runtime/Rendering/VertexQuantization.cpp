@@ -0,0 +1,246 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+uint32_t GetStride(std::span<const engine::VertexQuantization::Attribute> attributes)
+{
+	uint32_t stride = 0U;
+	for (const engine::VertexQuantization::Attribute& attribute : attributes)
+	{
+		stride += attribute.byteSize;
+	}
+	return stride;
+}
+
+uint32_t GetAttributeOffset(std::span<const engine::VertexQuantization::Attribute> attributes, size_t attributeIndex)
+{
+	return GetStride(attributes.first(attributeIndex));
+}
+
+float ReadFloat(const std::byte* pData, uint32_t componentIndex)
+{
+	float value;
+	std::memcpy(&value, pData + componentIndex * sizeof(float), sizeof(float));
+	return value;
+}
+
+void WriteSnorm16(std::byte* pData, uint32_t componentIndex, int16_t value)
+{
+	std::memcpy(pData + componentIndex * sizeof(int16_t), &value, sizeof(int16_t));
+}
+
+float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+}
+
+namespace engine
+{
+
+int16_t VertexQuantization::EncodeSnorm16(float value)
+{
+	return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float VertexQuantization::DecodeSnorm16(int16_t value)
+{
+	// Same as GPU normalized formats : -32768 and -32767 are both -1.
+	return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+void VertexQuantization::EncodeOctahedral(const cd::Direction& direction, int16_t* pEncoded)
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half onto the upper one.
+	float length = std::abs(direction.x()) + std::abs(direction.y()) + std::abs(direction.z());
+	float x = length > 0.0f ? direction.x() / length : 0.0f;
+	float y = length > 0.0f ? direction.y() / length : 0.0f;
+	if (length > 0.0f && direction.z() < 0.0f)
+	{
+		float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+		float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	pEncoded[0] = EncodeSnorm16(x);
+	pEncoded[1] = EncodeSnorm16(y);
+}
+
+cd::Direction VertexQuantization::DecodeOctahedral(const int16_t* pEncoded)
+{
+	float x = DecodeSnorm16(pEncoded[0]);
+	float y = DecodeSnorm16(pEncoded[1]);
+	float z = 1.0f - std::abs(x) - std::abs(y);
+	float fold = std::max(-z, 0.0f);
+	x += x >= 0.0f ? -fold : fold;
+	y += y >= 0.0f ? -fold : fold;
+
+	float length = std::sqrt(x * x + y * y + z * z);
+	return cd::Direction(x / length, y / length, z / length);
+}
+
+uint32_t VertexQuantization::GetEncodedSize(const Attribute& attribute)
+{
+	switch (attribute.encoding)
+	{
+	case Encoding::Position:
+		return 4U * sizeof(int16_t);
+	case Encoding::Octahedral:
+		return 2U * sizeof(int16_t);
+	case Encoding::Snorm16:
+		return attribute.byteSize / sizeof(float) * sizeof(int16_t);
+	default:
+		return attribute.byteSize;
+	}
+}
+
+bool VertexQuantization::IsSnorm16Range(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes, size_t attributeIndex)
+{
+	const uint32_t stride = GetStride(attributes);
+	const uint32_t offset = GetAttributeOffset(attributes, attributeIndex);
+	const uint32_t componentCount = attributes[attributeIndex].byteSize / sizeof(float);
+	assert(stride > 0U && 0U == sourceVertices.size() % stride);
+
+	for (size_t vertexOffset = 0; vertexOffset < sourceVertices.size(); vertexOffset += stride)
+	{
+		const std::byte* pSource = sourceVertices.data() + vertexOffset + offset;
+		for (uint32_t componentIndex = 0U; componentIndex < componentCount; ++componentIndex)
+		{
+			if (std::abs(ReadFloat(pSource, componentIndex)) > 1.0f)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+VertexQuantization::PositionQuantization VertexQuantization::GetPositionQuantization(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes)
+{
+	auto itPosition = std::find_if(attributes.begin(), attributes.end(), [](const Attribute& attribute) { return Encoding::Position == attribute.encoding; });
+	if (itPosition == attributes.end() || sourceVertices.empty())
+	{
+		return PositionQuantization{};
+	}
+
+	const uint32_t stride = GetStride(attributes);
+	const uint32_t offset = GetAttributeOffset(attributes, std::distance(attributes.begin(), itPosition));
+	assert(stride > 0U && 0U == sourceVertices.size() % stride);
+
+	float minPosition[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxPosition[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t vertexOffset = 0; vertexOffset < sourceVertices.size(); vertexOffset += stride)
+	{
+		const std::byte* pSource = sourceVertices.data() + vertexOffset + offset;
+		for (uint32_t componentIndex = 0U; componentIndex < 3U; ++componentIndex)
+		{
+			float value = ReadFloat(pSource, componentIndex);
+			minPosition[componentIndex] = std::min(minPosition[componentIndex], value);
+			maxPosition[componentIndex] = std::max(maxPosition[componentIndex], value);
+		}
+	}
+
+	// One scale for all axes keeps dequantization uniform.
+	PositionQuantization positionQuantization;
+	float center[3];
+	float halfExtent = 0.0f;
+	for (uint32_t componentIndex = 0U; componentIndex < 3U; ++componentIndex)
+	{
+		center[componentIndex] = 0.5f * (minPosition[componentIndex] + maxPosition[componentIndex]);
+		halfExtent = std::max(halfExtent, 0.5f * (maxPosition[componentIndex] - minPosition[componentIndex]));
+	}
+	positionQuantization.offset = cd::Point(center[0], center[1], center[2]);
+	positionQuantization.scale = halfExtent > 0.0f ? halfExtent : 1.0f;
+
+	return positionQuantization;
+}
+
+std::vector<std::byte> VertexQuantization::Quantize(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes,
+	const PositionQuantization& positionQuantization)
+{
+	const uint32_t sourceStride = GetStride(attributes);
+	assert(sourceStride > 0U && 0U == sourceVertices.size() % sourceStride);
+
+	uint32_t stride = 0U;
+	for (const Attribute& attribute : attributes)
+	{
+		stride += GetEncodedSize(attribute);
+	}
+
+	const size_t vertexCount = sourceVertices.size() / sourceStride;
+	std::vector<std::byte> vertices(vertexCount * stride);
+	const float offset[3] = { positionQuantization.offset.x(), positionQuantization.offset.y(), positionQuantization.offset.z() };
+	const float inverseScale = 1.0f / positionQuantization.scale;
+	for (size_t vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		const std::byte* pSource = sourceVertices.data() + vertexIndex * sourceStride;
+		std::byte* pTarget = vertices.data() + vertexIndex * stride;
+		for (const Attribute& attribute : attributes)
+		{
+			switch (attribute.encoding)
+			{
+			case Encoding::Position:
+			{
+				for (uint32_t componentIndex = 0U; componentIndex < 3U; ++componentIndex)
+				{
+					float value = (ReadFloat(pSource, componentIndex) - offset[componentIndex]) * inverseScale;
+					WriteSnorm16(pTarget, componentIndex, EncodeSnorm16(value));
+				}
+				WriteSnorm16(pTarget, 3U, 0);
+				break;
+			}
+			case Encoding::Octahedral:
+			{
+				int16_t encoded[2];
+				EncodeOctahedral(cd::Direction(ReadFloat(pSource, 0U), ReadFloat(pSource, 1U), ReadFloat(pSource, 2U)), encoded);
+				std::memcpy(pTarget, encoded, sizeof(encoded));
+				break;
+			}
+			case Encoding::Snorm16:
+			{
+				for (uint32_t componentIndex = 0U; componentIndex < attribute.byteSize / sizeof(float); ++componentIndex)
+				{
+					WriteSnorm16(pTarget, componentIndex, EncodeSnorm16(ReadFloat(pSource, componentIndex)));
+				}
+				break;
+			}
+			default:
+				std::memcpy(pTarget, pSource, attribute.byteSize);
+				break;
+			}
+
+			pSource += attribute.byteSize;
+			pTarget += GetEncodedSize(attribute);
+		}
+	}
+
+	return vertices;
+}
+
+cd::Matrix4x4 VertexQuantization::GetDequantizedWorldMatrix(const cd::Matrix4x4& worldMatrix, const PositionQuantization& positionQuantization)
+{
+	// worldMatrix * translate(offset) * scale(scale) in column major.
+	cd::Matrix4x4 matrix = worldMatrix;
+	float* pMatrix = matrix.begin();
+	const cd::Point& offset = positionQuantization.offset;
+	for (int row = 0; row < 4; ++row)
+	{
+		pMatrix[12 + row] += pMatrix[row] * offset.x() + pMatrix[4 + row] * offset.y() + pMatrix[8 + row] * offset.z();
+		pMatrix[row] *= positionQuantization.scale;
+		pMatrix[4 + row] *= positionQuantization.scale;
+		pMatrix[8 + row] *= positionQuantization.scale;
+	}
+	return matrix;
+}
+
+}
\ No newline at end of file
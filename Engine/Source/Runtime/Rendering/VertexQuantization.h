@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine
+{
+
+// VertexQuantization packs float vertex attributes into snorm16 values which GPU expands by normalized vertex attributes.
+// Positions are stored relative to mesh bounds with the same step on all axes, so dequantization is a uniform scale and
+// a translation. It folds into the world matrix and doesn't change normal transforms after normalization.
+// Directions are octahedral encoded into two values which shaders decode by DecodeOctahedral in common.sh.
+class VertexQuantization
+{
+public:
+	enum class Encoding : uint8_t
+	{
+		// Source bytes are copied.
+		None,
+		// 3 floats to 4 snorm16 values relative to bounds. The last one is padding as 3 component 16-bit formats are not portable.
+		Position,
+		// 3 floats of a direction to 2 snorm16 values.
+		Octahedral,
+		// Floats in [-1, 1] to snorm16 values.
+		Snorm16,
+	};
+
+	struct Attribute
+	{
+		Encoding encoding;
+		// Size in source vertex.
+		uint32_t byteSize;
+	};
+
+	// position = quantized position * scale + offset
+	struct PositionQuantization
+	{
+		cd::Point offset = cd::Point(0.0f, 0.0f, 0.0f);
+		float scale = 1.0f;
+	};
+
+public:
+	VertexQuantization() = delete;
+	VertexQuantization(const VertexQuantization&) = delete;
+	VertexQuantization& operator=(const VertexQuantization&) = delete;
+	VertexQuantization(VertexQuantization&&) = delete;
+	VertexQuantization& operator=(VertexQuantization&&) = delete;
+	~VertexQuantization() = delete;
+
+	static int16_t EncodeSnorm16(float value);
+	static float DecodeSnorm16(int16_t value);
+	static void EncodeOctahedral(const cd::Direction& direction, int16_t* pEncoded);
+	static cd::Direction DecodeOctahedral(const int16_t* pEncoded);
+
+	static uint32_t GetEncodedSize(const Attribute& attribute);
+
+	// Checks if all values of the attribute can be encoded as Snorm16.
+	static bool IsSnorm16Range(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes, size_t attributeIndex);
+
+	// Bounds of the Position attribute. Returns default quantization if there is no such attribute.
+	static PositionQuantization GetPositionQuantization(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes);
+
+	// attributes : layout of source vertices in order.
+	static std::vector<std::byte> Quantize(std::span<const std::byte> sourceVertices, std::span<const Attribute> attributes,
+		const PositionQuantization& positionQuantization);
+
+	// World matrix which transforms quantized positions to world space.
+	static cd::Matrix4x4 GetDequantizedWorldMatrix(const cd::Matrix4x4& worldMatrix, const PositionQuantization& positionQuantization);
+};
+
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "Rendering/RenderContext.h"
 #include "Rendering/Resources/MeshResource.h"
 #include "Rendering/Resources/ShaderResource.h"
+#include "Rendering/ShaderFeature.h"
 #include "Scene/Texture.h"
 
 namespace engine
@@ -15,6 +16,8 @@ namespace engine
 void WhiteModelRenderer::Init()
 {
 	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("WhiteModelProgram", "vs_whiteModel", "fs_whiteModel"));
+	AddDependentShaderResource(GetRenderContext()->RegisterShaderProgram("WhiteModelProgram", "vs_whiteModel", "fs_whiteModel",
+		GetFeatureName(ShaderFeature::QUANTIZED_VERTEX)));
 
 	bgfx::setViewName(GetViewID(), "WhiteModelRenderer");
 }
@@ -65,15 +68,17 @@ void WhiteModelRenderer::Render(float deltaTime)
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
 			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
+			bgfx::setTransform(pMeshResource->GetDequantizedWorldMatrix(pTransformComponent->GetWorldMatrix()).begin());
 		}
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS |
 			BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
 		bgfx::setState(state);
 
+		// Program names are suffixed by feature combines.
 		constexpr StringCrc programHandleIndex{ "WhiteModelProgram" };
-		SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), programHandleIndex);
+		constexpr StringCrc quantizedProgramHandleIndex{ "WhiteModelProgramQUANTIZEDVERTEX;" };
+		SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), pMeshResource->IsVertexQuantized() ? quantizedProgramHandleIndex : programHandleIndex);
 	}
 }
 
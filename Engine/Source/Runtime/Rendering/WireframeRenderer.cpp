@@ -72,7 +72,7 @@ void WireframeRenderer::Render(float deltaTime)
 		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
 		{
 			pTransformComponent->Build();
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
+			bgfx::setTransform(pMeshResource->GetDequantizedWorldMatrix(pTransformComponent->GetWorldMatrix()).begin());
 		}
 
 		constexpr uint64_t state = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LEQUAL |
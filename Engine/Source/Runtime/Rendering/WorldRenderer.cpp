@@ -1,23 +1,35 @@
 #include "WorldRenderer.h"
 
 #include "ECWorld/CameraComponent.h"
+#include "ECWorld/CollisionMeshComponent.h"
+#include "ECWorld/CullingSystem.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/SceneWorld.h"
 #include "ECWorld/SkyComponent.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
 #include "LightUniforms.h"
+#include "MeshLOD.h"
 #include "Material/ShaderSchema.h"
 #include "Math/Transform.hpp"
 #include "Rendering/RenderContext.h"
+#include "Rendering/RenderQueue.h"
 #include "Rendering/Resources/MeshResource.h"
 #include "Rendering/Resources/ShaderResource.h"
 #include "Rendering/Resources/TextureResource.h"
 #include "Scene/Texture.h"
+#include "Scheduler/ThreadPool.h"
 #include "U_AtmophericScattering.sh"
 #include "U_IBL.sh"
 #include "U_Shadow.sh"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
 namespace engine
 {
 
@@ -39,27 +51,130 @@ constexpr const char* metallicRoughnessRefectanceFactor = "u_metallicRoughnessRe
 constexpr const char* albedoUVOffsetAndScale            = "u_albedoUVOffsetAndScale";
 constexpr const char* alphaCutOff                       = "u_alphaCutOff";
 											            
-constexpr const char* lightCountAndStride               = "u_lightCountAndStride";
-constexpr const char* lightParams                       = "u_lightParams";
+constexpr const char* lightClusterParams                = "u_lightClusterParams";
+constexpr const char* lightParamsSampler                = "s_lightParams";
+constexpr const char* lightClustersSampler              = "s_lightClusters";
+constexpr const char* lightParamsTexture                = "LightParamsTexture";
+constexpr const char* lightClustersTexture              = "LightClustersTexture";
 											            
 constexpr const char* LightDir                          = "u_LightDir";
 constexpr const char* HeightOffsetAndshadowLength       = "u_HeightOffsetAndshadowLength";
 												        
-constexpr const char* lightViewProjs                    = "u_lightViewProjs";
-constexpr const char* cubeShadowMapSamplers[3]          = { "s_texCubeShadowMap_1", "s_texCubeShadowMap_2" ,  "s_texCubeShadowMap_3" };
+constexpr const char* shadowViewsSampler                = "s_shadowViews";
+constexpr const char* shadowViewsTexture                = "ShadowViewsTexture";
+constexpr const char* shadowAtlasSampler                = "s_shadowAtlas";
+constexpr const char* shadowAtlasTexture                = "ShadowAtlasTexture";
 												        
 constexpr const char* cameraNearFarPlane                = "u_cameraNearFarPlane";
 constexpr const char* cameraLookAt                      = "u_cameraLookAt";
 constexpr const char* clipFrustumDepth                  = "u_clipFrustumDepth";
-												        
-constexpr const char* IsCastShadow                      = "u_isCastShadow";
-constexpr const char* directionShadowMapTexture         = "DirectionShadowMapTexture";
-constexpr const char* pointShadowMapTexture             = "PointShadowMapTexture";
-constexpr const char* spotShadowMapTexture              = "SpotShadowMapTexture";
 
 constexpr uint64_t samplerFlags          = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_W_CLAMP;
+constexpr uint64_t lightTextureFlags     = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP | BGFX_SAMPLER_POINT;
 constexpr uint64_t defaultRenderingState = BGFX_STATE_WRITE_MASK | BGFX_STATE_MSAA | BGFX_STATE_DEPTH_TEST_LESS;
-constexpr uint64_t blitDstTextureFlags   = BGFX_TEXTURE_BLIT_DST | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
+constexpr uint16_t instanceDataStride  = sizeof(cd::Matrix4x4);
+
+uint32_t HashFactor(uint32_t hash, const std::variant<float, cd::Vec3f, cd::Vec4f>& factor)
+{
+	return std::visit([hash](const auto& value)
+	{
+		uint32_t result = hash;
+		const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t byteIndex = 0; byteIndex < sizeof(value); ++byteIndex)
+		{
+			result = (result ^ pBytes[byteIndex]) * 16777619U;
+		}
+		return result;
+	}, factor);
+}
+
+bool IsSameFactor(const std::variant<float, cd::Vec3f, cd::Vec4f>& lhs, const std::variant<float, cd::Vec3f, cd::Vec4f>& rhs)
+{
+	return lhs.index() == rhs.index() && std::visit([&rhs](const auto& lhsValue)
+	{
+		using ValueType = std::decay_t<decltype(lhsValue)>;
+		return 0 == std::memcmp(&lhsValue, std::get_if<ValueType>(&rhs), sizeof(ValueType));
+	}, lhs);
+}
+
+// Materials sharing the same textures and factors get the same key so that binds are skipped between their draws
+// and instancing groups stay adjacent after sorting.
+uint16_t GetMaterialSortKey(const MaterialComponent* pMaterialComponent)
+{
+	uint32_t hash = 2166136261U;
+	for (const auto& [textureType, propertyGroup] : pMaterialComponent->GetPropertyGroups())
+	{
+		const TextureResource* pTextureResource = propertyGroup.textureInfo.pTextureResource.Get();
+		uint16_t textureHandle = propertyGroup.useTexture && pTextureResource ? pTextureResource->GetTextureHandle() : bgfx::kInvalidHandle;
+		hash = (hash ^ textureHandle) * 16777619U;
+		hash = HashFactor(hash, propertyGroup.factor);
+	}
+	return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+// Screen size of the sphere around world space bounds, which are transformed from the local box in the same way as CullingSystem.
+float GetScreenSize(const cd::AABB& aabb, const float* pWorldMatrix, const float* pCameraPosition, float projectionScale)
+{
+	float localCenter[3] = { 0.5f * (aabb.Min().x() + aabb.Max().x()), 0.5f * (aabb.Min().y() + aabb.Max().y()), 0.5f * (aabb.Min().z() + aabb.Max().z()) };
+	float localExtent[3] = { 0.5f * (aabb.Max().x() - aabb.Min().x()), 0.5f * (aabb.Max().y() - aabb.Min().y()), 0.5f * (aabb.Max().z() - aabb.Min().z()) };
+	float radiusSquared = 0.0f;
+	float distanceSquared = 0.0f;
+	for (int row = 0; row < 3; ++row)
+	{
+		float worldCenter = pWorldMatrix[row] * localCenter[0] + pWorldMatrix[4 + row] * localCenter[1] + pWorldMatrix[8 + row] * localCenter[2] + pWorldMatrix[12 + row];
+		float worldExtent = std::abs(pWorldMatrix[row]) * localExtent[0] + std::abs(pWorldMatrix[4 + row]) * localExtent[1] + std::abs(pWorldMatrix[8 + row]) * localExtent[2];
+
+		float offset = worldCenter - pCameraPosition[row];
+		radiusSquared += worldExtent * worldExtent;
+		distanceSquared += offset * offset;
+	}
+
+	return MeshLOD::GetScreenSize(std::sqrt(radiusSquared), std::sqrt(distanceSquared), projectionScale);
+}
+
+// Instances share all uniforms and bindings of the first entity in group so that material parameters must be same.
+bool IsSameMaterial(const MaterialComponent* pLhs, const MaterialComponent* pRhs)
+{
+	if (pLhs == pRhs)
+	{
+		return true;
+	}
+
+	if (pLhs->GetMaterialType() != pRhs->GetMaterialType() ||
+		pLhs->GetShaderResource() != pRhs->GetShaderResource() ||
+		pLhs->GetBlendMode() != pRhs->GetBlendMode() ||
+		pLhs->GetTwoSided() != pRhs->GetTwoSided() ||
+		pLhs->GetAlphaCutOff() != pRhs->GetAlphaCutOff() ||
+		pLhs->GetIblStrengeth() != pRhs->GetIblStrengeth() ||
+		pLhs->GetReflectance() != pRhs->GetReflectance() ||
+		pLhs->GetPropertyGroups().size() != pRhs->GetPropertyGroups().size())
+	{
+		return false;
+	}
+
+	auto itRhs = pRhs->GetPropertyGroups().begin();
+	for (const auto& [textureType, lhsGroup] : pLhs->GetPropertyGroups())
+	{
+		const auto& [rhsTextureType, rhsGroup] = *itRhs++;
+		const MaterialComponent::TextureInfo& lhsTexture = lhsGroup.textureInfo;
+		const MaterialComponent::TextureInfo& rhsTexture = rhsGroup.textureInfo;
+		if (textureType != rhsTextureType ||
+			lhsGroup.useTexture != rhsGroup.useTexture ||
+			!IsSameFactor(lhsGroup.factor, rhsGroup.factor) ||
+			lhsTexture.slot != rhsTexture.slot ||
+			lhsTexture.pTextureResource.Get() != rhsTexture.pTextureResource.Get() ||
+			lhsTexture.GetUVOffset().x() != rhsTexture.GetUVOffset().x() ||
+			lhsTexture.GetUVOffset().y() != rhsTexture.GetUVOffset().y() ||
+			lhsTexture.GetUVScale().x() != rhsTexture.GetUVScale().x() ||
+			lhsTexture.GetUVScale().y() != rhsTexture.GetUVScale().y())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
 
 }
 
@@ -83,28 +198,65 @@ void WorldRenderer::Init()
 	GetRenderContext()->CreateUniform(albedoUVOffsetAndScale, bgfx::UniformType::Vec4, 1);
 	GetRenderContext()->CreateUniform(alphaCutOff, bgfx::UniformType::Vec4, 1);
 
-	GetRenderContext()->CreateUniform(lightCountAndStride, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(lightParams, bgfx::UniformType::Vec4, LightUniform::VEC4_COUNT);
+	// Lights are stored in textures so that their count isn't limited by uniform arrays.
+	GetRenderContext()->CreateUniform(lightClusterParams, bgfx::UniformType::Vec4, 1);
+	GetRenderContext()->CreateUniform(lightParamsSampler, bgfx::UniformType::Sampler);
+	GetRenderContext()->CreateUniform(lightClustersSampler, bgfx::UniformType::Sampler);
+	GetRenderContext()->CreateTexture(lightParamsTexture, LightUniform::LIGHT_STRIDE, MAX_CLUSTERED_LIGHT_COUNT, 1,
+		bgfx::TextureFormat::RGBA32F, lightTextureFlags);
+	GetRenderContext()->CreateTexture(lightClustersTexture, LightClusters::TextureWidth, LightClusters::TextureHeight, 1,
+		bgfx::TextureFormat::RG32F, lightTextureFlags);
 
 	GetRenderContext()->CreateUniform(LightDir, bgfx::UniformType::Vec4, 1);
 	GetRenderContext()->CreateUniform(HeightOffsetAndshadowLength, bgfx::UniformType::Vec4, 1);
 
-	GetRenderContext()->CreateUniform(lightViewProjs, bgfx::UniformType::Mat4, 12);
-	GetRenderContext()->CreateUniform(cubeShadowMapSamplers[0], bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(cubeShadowMapSamplers[1], bgfx::UniformType::Sampler);
-	GetRenderContext()->CreateUniform(cubeShadowMapSamplers[2], bgfx::UniformType::Sampler);
+	// Shadow views are stored in a texture like lights.
+	GetRenderContext()->CreateUniform(shadowViewsSampler, bgfx::UniformType::Sampler);
+	GetRenderContext()->CreateTexture(shadowViewsTexture, SHADOW_VIEW_TEXTURE_WIDTH, MAX_SHADOW_VIEW_COUNT, 1,
+		bgfx::TextureFormat::RGBA32F, lightTextureFlags);
+	GetRenderContext()->CreateUniform(shadowAtlasSampler, bgfx::UniformType::Sampler);
 
 	GetRenderContext()->CreateUniform(cameraNearFarPlane, bgfx::UniformType::Vec4, 1);
 	GetRenderContext()->CreateUniform(clipFrustumDepth, bgfx::UniformType::Vec4, 1);
-	GetRenderContext()->CreateUniform(IsCastShadow, bgfx::UniformType::Vec4, 1);
 
 	bgfx::setViewName(GetViewID(), "WorldRenderer");
+
+	// Draws are sorted by RenderQueue and rely on bindings of previous draws.
+	bgfx::setViewMode(GetViewID(), bgfx::ViewMode::Sequential);
+
+	// Chunk views are created right after the world view so that no other view executes between them.
+	for (uint16_t chunkIndex = 1U; chunkIndex < GetRenderContext()->GetMaxWorkerEncoderCount(); ++chunkIndex)
+	{
+		uint16_t viewID = GetRenderContext()->CreateView();
+		assert(viewID == GetViewID() + chunkIndex);
+		bgfx::setViewName(viewID, "WorldRenderer_Chunk");
+		bgfx::setViewMode(viewID, bgfx::ViewMode::Sequential);
+		m_chunkViewIDs.push_back(viewID);
+	}
+	m_drawStateCaches.resize(m_chunkViewIDs.size() + 1);
+
+	m_isInstancingSupported = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING);
+}
+
+void WorldRenderer::SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID)
+{
+	Renderer::SetupRenderPass(pRenderGraph, passID);
+
+	constexpr StringCrc shadowAtlas("ShadowAtlas");
+	pRenderGraph->Read(passID, pRenderGraph->ImportResource(shadowAtlas));
 }
 
 void WorldRenderer::UpdateView(const float* pViewMatrix, const float* pProjectionMatrix)
 {
 	UpdateViewRenderTarget();
 	bgfx::setViewTransform(GetViewID(), pViewMatrix, pProjectionMatrix);
+
+	// Chunk views draw on top of the world view without clearing.
+	for (uint16_t viewID : m_chunkViewIDs)
+	{
+		UpdateViewRenderTarget(viewID);
+		bgfx::setViewTransform(viewID, pViewMatrix, pProjectionMatrix);
+	}
 }
 
 void WorldRenderer::Render(float deltaTime)
@@ -112,77 +264,20 @@ void WorldRenderer::Render(float deltaTime)
 	// TODO : Remove it. If every renderer need to submit camera related uniform, it should be done not inside Renderer class.
 	const CameraComponent* pMainCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
 	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
-	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
 
-	const auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
-	size_t lightEntityCount = lightEntities.size();
-
-	// Blit RTV to SRV to update light shadow map
-	for (int i = 0; i < lightEntityCount; i++)
-	{
-		LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[i]);
-		cd::LightType lightType = lightComponent->GetType();
-		if (cd::LightType::Directional == lightType)
-		{
-			uint16_t cascadeNum = lightComponent->GetCascadeNum();
-			// Create textureCube if not valid
-			if (!lightComponent->IsShadowMapTextureValid())
-			{
-				bgfx::TextureHandle blitDstShadowMapTexture = bgfx::createTextureCube(lightComponent->GetShadowMapSize(),
-					false, 1, bgfx::TextureFormat::D32F, blitDstTextureFlags);
-				GetRenderContext()->SetTexture(engine::StringCrc(directionShadowMapTexture), blitDstShadowMapTexture);
-				lightComponent->SetShadowMapTexture(blitDstShadowMapTexture.idx);
-			}
-			// Blit RTV(FrameBuffer Texture) to SRV(Texture)
-			bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-			for (uint16_t cascadeIdx = 0; cascadeIdx < cascadeNum; ++cascadeIdx)
-			{
-				bgfx::TextureHandle blitSrcShadowMapTexture = bgfx::getTexture(static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(cascadeIdx)));
-				bgfx::blit(GetViewID(), blitDstShadowMapTexture, 0, 0, 0, cascadeIdx, blitSrcShadowMapTexture, 0, 0, 0, 0);
-			}
-		}
-		else if (cd::LightType::Point == lightType)
-		{
-			// Create textureCube if not valid
-			if (!lightComponent->IsShadowMapTextureValid())
-			{
-				StringCrc blitDstShadowMapTextureName = StringCrc(pointShadowMapTexture);
-				bgfx::TextureHandle blitDstShadowMapTexture = bgfx::createTextureCube(lightComponent->GetShadowMapSize(),
-					false, 1, bgfx::TextureFormat::R32F, blitDstTextureFlags);
-				GetRenderContext()->SetTexture(blitDstShadowMapTextureName, blitDstShadowMapTexture);
-				lightComponent->SetShadowMapTexture(blitDstShadowMapTexture.idx);
-			}
-			// Blit RTV(FrameBuffer Texture) to SRV(Texture)
-			bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-			for (uint16_t i = 0; i < 6; ++i)
-			{
-				bgfx::TextureHandle blitSrcShadowMapTexture = bgfx::getTexture(static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(i)));
-				bgfx::blit(GetViewID(), blitDstShadowMapTexture, 0, 0, 0, i, blitSrcShadowMapTexture, 0, 0, 0, 0);
-			}
-		}
-		else if (cd::LightType::Spot == lightType)
-		{
-			// Create texture2D if not valid
-			if (!lightComponent->IsShadowMapTextureValid())
-			{
-				bgfx::TextureHandle blitDstShadowMapTexture = bgfx::createTextureCube(lightComponent->GetShadowMapSize(),
-					false, 1, bgfx::TextureFormat::D32F, blitDstTextureFlags);
-				lightComponent->SetShadowMapTexture(blitDstShadowMapTexture.idx);
-			}
-			// Blit RTV(FrameBuffer Texture) to SRV(Texture)
-			bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-			bgfx::TextureHandle blitSrcShadowMapTexture = bgfx::getTexture(static_cast<bgfx::FrameBufferHandle>(lightComponent->GetShadowMapFBs().at(0)));
-			bgfx::blit(GetViewID(), blitDstShadowMapTexture, 0, 0, 0, 0, blitSrcShadowMapTexture, 0, 0, 0, 0);
-		}
-	}
-
-	for (Entity entity : m_pCurrentSceneWorld->GetMaterialEntities())
+	// Collect draw packets of visible entities. Sorting by program, textures and mesh lets DrawStateCache skip most of binds.
+	const float* pCameraPosition = &cameraTransform.GetTranslation().x();
+	float inverseFarPlane = 1.0f / std::max(pMainCameraComponent->GetFarPlane(), 0.001f);
+	// Element (1, 1) of the projection matrix scales view space height to NDC.
+	float projectionScale = pMainCameraComponent->GetProjectionMatrix().begin()[5];
+	m_renderQueue.Clear();
+	m_drawEntities.clear();
+	for (Entity entity : m_pCurrentSceneWorld->GetCullingSystem()->GetVisibleEntities(CullingSystem::MainCameraView))
 	{
 		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
-		if (!pMaterialComponent)
+		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		if (!pMaterialComponent || !pMeshComponent)
 		{
-			// TODO : improve this condition. As we want to skip some feature-specified entities to render.
-			// For example, terrain/particle/...
 			continue;
 		}
 
@@ -194,13 +289,6 @@ void WorldRenderer::Render(float deltaTime)
 			continue;
 		}
 
-		// No mesh attached?
-		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
-		if (!pMeshComponent)
-		{
-			continue;
-		}
-
 		const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
 		if (ResourceStatus::Ready != pMeshResource->GetStatus() &&
 			ResourceStatus::Optimized != pMeshResource->GetStatus())
@@ -221,10 +309,114 @@ void WorldRenderer::Render(float deltaTime)
 			//continue;
 		}
 
+		const float* pWorldMatrix = m_pCurrentSceneWorld->GetWorldMatrix(entity).begin();
+		const CollisionMeshComponent* pCollisionMeshComponent = m_pCurrentSceneWorld->GetCollisionMeshComponent(entity);
+		if (pMeshResource->GetLODCount() > 1U && pCollisionMeshComponent)
+		{
+			float screenSize = GetScreenSize(pCollisionMeshComponent->GetAABB(), pWorldMatrix, pCameraPosition, projectionScale);
+			pMeshComponent->SetLOD(MeshLOD::SelectLOD(screenSize, pMeshResource->GetLODCount()));
+		}
+
+		float offset[3] = { pWorldMatrix[12] - pCameraPosition[0], pWorldMatrix[13] - pCameraPosition[1], pWorldMatrix[14] - pCameraPosition[2] };
+		float depth = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]) * inverseFarPlane;
+
+		uint16_t programKey = pShaderResource->GetHandle();
+		uint16_t materialKey = GetMaterialSortKey(pMaterialComponent);
+		uint16_t meshKey = pMeshResource->GetSortKey();
+		cd::BlendMode blendMode = pMaterialComponent->GetBlendMode();
+		bool isTranslucent = cd::BlendMode::Opaque != blendMode && cd::BlendMode::Mask != blendMode;
+		uint64_t sortKey = isTranslucent ? RenderQueue::MakeTranslucentKey(GetViewID(), programKey, materialKey, meshKey, depth) :
+			RenderQueue::MakeOpaqueKey(GetViewID(), programKey, materialKey, meshKey, depth);
+		m_renderQueue.Push(sortKey, static_cast<uint32_t>(m_drawEntities.size()));
+		m_drawEntities.push_back(entity);
+	}
+	m_renderQueue.Sort();
+	BuildInstancingGroups();
+	if (m_renderQueue.IsEmpty())
+	{
+		return;
+	}
+
+	// Camera, sky, light and shadow data are same for all draws. bgfx keeps uniform values and bindings
+	// in a sequential view until they are overwritten, so only transform and material are set per draw.
+	UpdateViewConstants();
+	AllocateInstanceData();
+
+	// Every chunk binds view constants again so that small queues stay in one chunk.
+	constexpr size_t minDrawChunkSize = 64;
+	ThreadPool* pThreadPool = GetRenderContext()->GetThreadPool();
+	size_t maxChunkCount = pThreadPool ? std::min<size_t>(pThreadPool->GetWorkerCount() + 1, m_drawStateCaches.size()) : 1;
+	RenderQueue::SplitChunks(m_instancingGroupSizes, maxChunkCount, minDrawChunkSize, m_drawChunkEnds);
+
+	auto RecordDrawChunks = [this](size_t begin, size_t end)
+	{
+		for (size_t chunkIndex = begin; chunkIndex < end; ++chunkIndex)
+		{
+			RecordDrawChunk(chunkIndex);
+		}
+	};
+
+	size_t chunkCount = m_drawChunkEnds.size();
+	if (!pThreadPool || chunkCount < 2)
+	{
+		RecordDrawChunks(0, chunkCount);
+	}
+	else
+	{
+		pThreadPool->ParallelFor(chunkCount, 1, RecordDrawChunks);
+	}
+
+	for (size_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+	{
+		GetRenderContext()->GetDrawStats().Merge(m_drawStateCaches[chunkIndex].GetStats());
+	}
+}
+
+void WorldRenderer::RecordDrawChunk(size_t chunkIndex)
+{
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+	const std::vector<RenderQueue::DrawPacket>& drawPackets = m_renderQueue.GetPackets();
+	size_t beginPacketIndex = chunkIndex > 0 ? m_drawChunkEnds[chunkIndex - 1] : 0;
+	size_t endPacketIndex = m_drawChunkEnds[chunkIndex];
+	uint16_t viewID = chunkIndex > 0 ? m_chunkViewIDs[chunkIndex - 1] : GetViewID();
+
+	// Bindings are kept between draws in the chunk view so that only changed state is set.
+	bgfx::Encoder* pEncoder = GetRenderContext()->BeginEncoder();
+	DrawStateCache& drawStateCache = m_drawStateCaches[chunkIndex];
+	drawStateCache.SetEncoder(pEncoder);
+	drawStateCache.Reset();
+	drawStateCache.ResetStats();
+	SubmitViewConstants(drawStateCache);
+
+	uint32_t instanceCount = 1U;
+	for (size_t packetIndex = beginPacketIndex; packetIndex < endPacketIndex; packetIndex += instanceCount)
+	{
+		Entity entity = m_drawEntities[drawPackets[packetIndex].payload];
+		MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+		StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+		const ShaderResource* pShaderResource = pMaterialComponent->GetShaderResource();
+		const MeshResource* pMeshResource = pMeshComponent->GetMeshResource();
+
 		// Transform
-		if (TransformComponent* pTransformComponent = m_pCurrentSceneWorld->GetTransformComponent(entity))
+		instanceCount = m_instancingGroupSizes[packetIndex];
+		if (instanceCount > 1U)
 		{
-			bgfx::setTransform(pTransformComponent->GetWorldMatrix().begin());
+			// Draw the group by the first entity's bindings and world matrices from instance data.
+			const bgfx::InstanceDataBuffer& instanceDataBuffer = m_instanceDataBuffers[packetIndex];
+			uint8_t* pInstanceData = instanceDataBuffer.data;
+			for (uint32_t instanceIndex = 0U; instanceIndex < instanceCount; ++instanceIndex)
+			{
+				Entity instanceEntity = m_drawEntities[drawPackets[packetIndex + instanceIndex].payload];
+				const cd::Matrix4x4& worldMatrix = m_pCurrentSceneWorld->GetWorldMatrix(instanceEntity);
+				std::memcpy(pInstanceData, pMeshResource->GetDequantizedWorldMatrix(worldMatrix).begin(), instanceDataStride);
+				pInstanceData += instanceDataStride;
+			}
+			pEncoder->setInstanceDataBuffer(&instanceDataBuffer);
+			pShaderResource = m_instancedShaderResources.at(pShaderResource).Get();
+		}
+		else
+		{
+			pEncoder->setTransform(pMeshResource->GetDequantizedWorldMatrix(m_pCurrentSceneWorld->GetWorldMatrix(entity)).begin());
 		}
 
 		// Material
@@ -254,64 +446,16 @@ void WorldRenderer::Render(float deltaTime)
 				constexpr StringCrc albedoUVOffsetAndScaleCrc(albedoUVOffsetAndScale);
 				cd::Vec4f uvOffsetAndScaleData(textureInfo.GetUVOffset().x(), textureInfo.GetUVOffset().y(),
 					textureInfo.GetUVScale().x(), textureInfo.GetUVScale().y());
-				GetRenderContext()->FillUniform(albedoUVOffsetAndScaleCrc, &uvOffsetAndScaleData, 1);
+				drawStateCache.SetUniform(GetRenderContext()->GetUniform(albedoUVOffsetAndScaleCrc), &uvOffsetAndScaleData, 1);
 			}
 
 			textureSlotBindTable[textureInfo.slot] = true;
-			bgfx::setTexture(textureInfo.slot, bgfx::UniformHandle{ pTextureResource->GetSamplerHandle() }, bgfx::TextureHandle{ pTextureResource->GetTextureHandle() });
-		}
-
-		// Sky
-		SkyType crtSkyType = pSkyComponent->GetSkyType();
-		if (SkyType::SkyBox == crtSkyType)
-		{
-			// Create a new TextureHandle each frame if the skybox texture path has been updated,
-			// otherwise RenderContext::CreateTexture will skip it automatically.
-
-			constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_IRRADIANCE_SLOT,
-				GetRenderContext()->GetUniform(irrSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
-
-			constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
-			GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
-			bgfx::setTexture(IBL_RADIANCE_SLOT,
-				GetRenderContext()->GetUniform(radSamplerCrc),
-				GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
-
-			constexpr StringCrc iblStrengthCrc{ iblStrength };
-			GetRenderContext()->FillUniform(iblStrengthCrc, &(pMaterialComponent->GetIblStrengeth()));
-
-			constexpr StringCrc lutsamplerCrc{ lutSampler };
-			constexpr StringCrc luttextureCrc{ lutTexture };
-			bgfx::setTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+			drawStateCache.SetTexture(textureInfo.slot, bgfx::UniformHandle{ pTextureResource->GetSamplerHandle() }, bgfx::TextureHandle{ pTextureResource->GetTextureHandle() });
 		}
-		else if (SkyType::AtmosphericScattering == crtSkyType)
-		{
-			bgfx::setImage(ATM_TRANSMITTANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMTransmittanceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-			bgfx::setImage(ATM_IRRADIANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMIrradianceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-			bgfx::setImage(ATM_SCATTERING_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMScatteringCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
-
-			constexpr StringCrc LightDirCrc(LightDir);
-			GetRenderContext()->FillUniform(LightDirCrc, &(pSkyComponent->GetSunDirection().x()), 1);
-
-			constexpr StringCrc HeightOffsetAndshadowLengthCrc(HeightOffsetAndshadowLength);
-			cd::Vec4f tmpHeightOffsetAndshadowLength = cd::Vec4f(pSkyComponent->GetHeightOffset(), pSkyComponent->GetShadowLength(), 0.0f, 0.0f);
-			GetRenderContext()->FillUniform(HeightOffsetAndshadowLengthCrc, &(tmpHeightOffsetAndshadowLength.x()), 1);
-		}
-
-		// Submit uniform values : camera settings
-		constexpr StringCrc cameraPosCrc(cameraPos);
-		GetRenderContext()->FillUniform(cameraPosCrc, &cameraTransform.GetTranslation().x(), 1);
-
-		constexpr StringCrc cameraNearFarPlaneCrc(cameraNearFarPlane);
-		float cameraNearFarPlanedata[2]{ pMainCameraComponent->GetNearPlane(), pMainCameraComponent->GetFarPlane() };
-		GetRenderContext()->FillUniform(cameraNearFarPlaneCrc, cameraNearFarPlanedata, 1);
 
 		// Submit uniform values : material settings
 		constexpr StringCrc albedoColorCrc(albedoColor);
-		GetRenderContext()->FillUniform(albedoColorCrc, pMaterialComponent->GetFactor<cd::Vec3f>(cd::MaterialPropertyGroup::BaseColor), 1);
+		drawStateCache.SetUniform(GetRenderContext()->GetUniform(albedoColorCrc), pMaterialComponent->GetFactor<cd::Vec3f>(cd::MaterialPropertyGroup::BaseColor), 1);
 
 		cd::Vec4f metallicRoughnessRefectanceFactorData(
 			*(pMaterialComponent->GetFactor<float>(cd::MaterialPropertyGroup::Metallic)),
@@ -319,88 +463,15 @@ void WorldRenderer::Render(float deltaTime)
 			pMaterialComponent->GetReflectance(),
 			1.0f);
 		constexpr StringCrc mrrFactorCrc(metallicRoughnessRefectanceFactor);
-		GetRenderContext()->FillUniform(mrrFactorCrc, metallicRoughnessRefectanceFactorData.begin(), 1);
+		drawStateCache.SetUniform(GetRenderContext()->GetUniform(mrrFactorCrc), metallicRoughnessRefectanceFactorData.begin(), 1);
 
 		constexpr StringCrc emissiveColorCrc(emissiveColorAndFactor);
-		GetRenderContext()->FillUniform(emissiveColorCrc, pMaterialComponent->GetFactor<cd::Vec4f>(cd::MaterialPropertyGroup::Emissive), 1);
-
-		// Submit light data
-		constexpr engine::StringCrc lightCountAndStrideCrc(lightCountAndStride);
-		static cd::Vec4f lightInfoData(0, LightUniform::LIGHT_STRIDE, 0.0f, 0.0f);
-		lightInfoData.x() = static_cast<float>(lightEntityCount);
-		GetRenderContext()->FillUniform(lightCountAndStrideCrc, lightInfoData.begin(), 1);
-		int totalLightViewProjOffset = 0;
-		float lightData[4 *7 * 3] = { 0 };
-		for (uint16_t i = 0U; i < lightEntityCount; ++i)
-		{
-			LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[i]);
-			if (cd::LightType::Directional == lightComponent->GetType())
-			{
-				lightComponent->SetLightViewProjOffset(totalLightViewProjOffset);
-				totalLightViewProjOffset += 4;
-			}
-			else if (cd::LightType::Spot == lightComponent->GetType())
-			{
-				lightComponent->SetLightViewProjOffset(totalLightViewProjOffset);
-				totalLightViewProjOffset++;
-			}
-			memcpy(&lightData[4 * 7 * i], lightComponent->GetLightUniformData(), sizeof(U_Light));
-		}
-		constexpr engine::StringCrc lightParamsCrc(lightParams);
-		GetRenderContext()->FillUniform(lightParamsCrc, lightData, static_cast<uint16_t>(lightEntityCount * LightUniform::LIGHT_STRIDE));
+		drawStateCache.SetUniform(GetRenderContext()->GetUniform(emissiveColorCrc), pMaterialComponent->GetFactor<cd::Vec4f>(cd::MaterialPropertyGroup::Emissive), 1);
 
-		// Submit light view&projection transform
-		std::vector<cd::Matrix4x4> lightViewProjsData;
-		for (uint16_t i = 0U; i < lightEntityCount; ++i)
+		if (SkyType::SkyBox == pSkyComponent->GetSkyType())
 		{
-			LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[i]);
-			const std::vector<cd::Matrix4x4>& lightViewProjs = lightComponent->GetLightViewProjMatrix();
-			for (auto lightViewProj : lightViewProjs)
-			{
-				lightViewProjsData.push_back(lightViewProj);
-			}
-		}
-		constexpr engine::StringCrc lightViewProjsCrc(lightViewProjs);
-		GetRenderContext()->FillUniform(lightViewProjsCrc, lightViewProjsData.data(), totalLightViewProjOffset);
-
-		// Submit shadow map and settings of each light
-		constexpr StringCrc shadowMapSamplerCrcs[3] = { StringCrc(cubeShadowMapSamplers[0]), StringCrc(cubeShadowMapSamplers[1]), StringCrc(cubeShadowMapSamplers[2]) };
-		for (int lightIndex = 0; lightIndex < lightEntityCount; lightIndex++)
-		{
-			auto lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[lightIndex]);
-			cd::LightType lightType = lightComponent->GetType();
-
-			constexpr StringCrc CastShadowIntensityCrc(IsCastShadow);
-			if (lightComponent->IsCastShadow())
-			{
-				cd::Vec4f vec4 = cd::Vec4f::One();
-				GetRenderContext()->FillUniform(CastShadowIntensityCrc, &vec4);
-			}
-			else
-			{
-				cd::Vec4f vec4 = cd::Vec4f::Zero();
-				GetRenderContext()->FillUniform(CastShadowIntensityCrc, &vec4);
-			}
-			//GetRenderContext()->FillUniform(CastShadowIntensityCrc, &lightComponent->IsCastShadow());
-			if (cd::LightType::Directional == lightType)
-			{
-				bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-				bgfx::setTexture(SHADOW_MAP_CUBE_FIRST_SLOT + lightIndex, GetRenderContext()->GetUniform(shadowMapSamplerCrcs[lightIndex]), blitDstShadowMapTexture);
-				// TODO : manual 
-				constexpr StringCrc clipFrustumDepthCrc(clipFrustumDepth);
-				GetRenderContext()->FillUniform(clipFrustumDepthCrc, lightComponent->GetComputedCascadeSplit(), 1);
-			}
-			else if (cd::LightType::Point == lightType)
-			{
-				bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-				bgfx::setTexture(SHADOW_MAP_CUBE_FIRST_SLOT + lightIndex, GetRenderContext()->GetUniform(shadowMapSamplerCrcs[lightIndex]), blitDstShadowMapTexture);
-			}
-			else if (cd::LightType::Spot == lightType)
-			{
-				// Blit RTV(FrameBuffer Texture) to SRV(Texture)
-				bgfx::TextureHandle blitDstShadowMapTexture = static_cast<bgfx::TextureHandle>(lightComponent->GetShadowMapTexture());
-				bgfx::setTexture(SHADOW_MAP_CUBE_FIRST_SLOT + lightIndex, GetRenderContext()->GetUniform(shadowMapSamplerCrcs[lightIndex]), blitDstShadowMapTexture);
-			}
+			constexpr StringCrc iblStrengthCrc{ iblStrength };
+			drawStateCache.SetUniform(GetRenderContext()->GetUniform(iblStrengthCrc), &(pMaterialComponent->GetIblStrengeth()));
 		}
 
 		uint64_t state = defaultRenderingState;
@@ -412,24 +483,338 @@ void WorldRenderer::Render(float deltaTime)
 		if (cd::BlendMode::Mask == pMaterialComponent->GetBlendMode())
 		{
 			constexpr StringCrc alphaCutOffCrc(alphaCutOff);
-			GetRenderContext()->FillUniform(alphaCutOffCrc, &pMaterialComponent->GetAlphaCutOff(), 1);
+			drawStateCache.SetUniform(GetRenderContext()->GetUniform(alphaCutOffCrc), &pMaterialComponent->GetAlphaCutOff(), 1);
 		}
 
-		bgfx::setState(state);
+		drawStateCache.SetState(state);
+
+		// Last draw of the chunk clears all bindings so that they don't leak into other renderers.
+		bool isLastDraw = packetIndex + instanceCount == endPacketIndex;
+		uint8_t discardFlags = isLastDraw ? BGFX_DISCARD_ALL : DrawStateCache::KeepBindingsDiscardFlags;
 
 		// Mesh
 		if (BlendShapeComponent* pBlendShapeComponent = m_pCurrentSceneWorld->GetBlendShapeComponent(entity))
 		{
-			bgfx::setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pBlendShapeComponent->GetFinalMorphAffectedVB() });
-			bgfx::setVertexBuffer(1, bgfx::VertexBufferHandle{ pBlendShapeComponent->GetNonMorphAffectedVB() });
+			pEncoder->setVertexBuffer(0, bgfx::DynamicVertexBufferHandle{ pBlendShapeComponent->GetFinalMorphAffectedVB() });
+			pEncoder->setVertexBuffer(1, bgfx::VertexBufferHandle{ pBlendShapeComponent->GetNonMorphAffectedVB() });
 			// TODO : BlendShape + multiple index buffers.
-			bgfx::setIndexBuffer(bgfx::IndexBufferHandle{ pMeshComponent->GetMeshResource()->GetIndexBufferHandle(0U) });
-			GetRenderContext()->Submit(GetViewID(), pShaderResource->GetHandle());
+			const MeshArenaRange& indexRange = pMeshResource->GetIndexRange(0U);
+			pEncoder->setIndexBuffer(bgfx::DynamicIndexBufferHandle{ indexRange.bufferHandle }, indexRange.offset, indexRange.count);
+			GetRenderContext()->Submit(pEncoder, viewID, pShaderResource->GetHandle(), discardFlags);
+		}
+		else
+		{
+			SubmitStaticMeshDrawCall(pEncoder, pMeshComponent, viewID, pShaderResource->GetHandle(), discardFlags);
+		}
+		drawStateCache.OnDraw(pShaderResource->GetHandle(), instanceCount);
+	}
+
+	drawStateCache.SetEncoder(nullptr);
+	GetRenderContext()->EndEncoder(pEncoder);
+}
+
+void WorldRenderer::AllocateInstanceData()
+{
+	const std::vector<RenderQueue::DrawPacket>& drawPackets = m_renderQueue.GetPackets();
+	m_instanceDataBuffers.resize(drawPackets.size());
+	for (size_t packetIndex = 0; packetIndex < drawPackets.size(); packetIndex += m_instancingGroupSizes[packetIndex])
+	{
+		uint32_t instanceCount = m_instancingGroupSizes[packetIndex];
+		if (instanceCount < 2U)
+		{
+			continue;
+		}
+
+		// Transient instance data memory is limited per frame. The rest of group is drawn as the next group.
+		uint32_t availableCount = std::max(bgfx::getAvailInstanceDataBuffer(instanceCount, instanceDataStride), 1U);
+		if (availableCount < instanceCount)
+		{
+			m_instancingGroupSizes[packetIndex + availableCount] = instanceCount - availableCount;
+			m_instancingGroupSizes[packetIndex] = availableCount;
+			instanceCount = availableCount;
+		}
+
+		if (instanceCount > 1U)
+		{
+			bgfx::allocInstanceDataBuffer(&m_instanceDataBuffers[packetIndex], instanceCount, instanceDataStride);
+		}
+	}
+}
+
+void WorldRenderer::UpdateViewConstants()
+{
+	const CameraComponent* pMainCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+
+	const auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
+	size_t lightEntityCount = lightEntities.size();
+
+	// Sky
+	if (SkyType::SkyBox == pSkyComponent->GetSkyType())
+	{
+		// Create a new TextureHandle each frame if the skybox texture path has been updated,
+		// otherwise RenderContext::CreateTexture will skip it automatically.
+		GetRenderContext()->CreateTexture(pSkyComponent->GetIrradianceTexturePath().c_str(), samplerFlags);
+		GetRenderContext()->CreateTexture(pSkyComponent->GetRadianceTexturePath().c_str(), samplerFlags);
+	}
+
+	int totalLightViewProjOffset = 0;
+	for (uint16_t i = 0U; i < lightEntityCount; ++i)
+	{
+		// Lights without shadow views in the atlas are not shadowed.
+		LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[i]);
+		int shadowViewCount = static_cast<int>(lightComponent->GetLightViewProjMatrix().size());
+		lightComponent->SetLightViewProjOffset(shadowViewCount > 0 ? totalLightViewProjOffset : -1);
+		totalLightViewProjOffset += shadowViewCount;
+	}
+	UpdateLightClusters(pMainCameraComponent);
+
+	// Light view&projection transform and tile of each shadow view in the atlas
+	static_assert(sizeof(ShadowView) == SHADOW_VIEW_TEXTURE_WIDTH * 4 * sizeof(float), "A shadow view should fill a texture row.");
+	m_shadowViews.clear();
+	for (uint16_t i = 0U; i < lightEntityCount; ++i)
+	{
+		LightComponent* lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[i]);
+		const std::vector<cd::Matrix4x4>& lightViewProjs = lightComponent->GetLightViewProjMatrix();
+		const std::vector<cd::Vec4f>& lightShadowAtlasRects = lightComponent->GetShadowAtlasRects();
+		assert(lightViewProjs.size() == lightShadowAtlasRects.size());
+		for (size_t viewIndex = 0; viewIndex < lightViewProjs.size(); ++viewIndex)
+		{
+			m_shadowViews.push_back({ lightViewProjs[viewIndex], lightShadowAtlasRects[viewIndex] });
+		}
+	}
+
+	// ShadowMapRenderer doesn't assign more views than the texture can store.
+	assert(m_shadowViews.size() <= MAX_SHADOW_VIEW_COUNT);
+	if (!m_shadowViews.empty())
+	{
+		constexpr StringCrc shadowViewsTextureCrc(shadowViewsTexture);
+		bgfx::updateTexture2D(GetRenderContext()->GetTexture(shadowViewsTextureCrc), 0, 0, 0, 0, SHADOW_VIEW_TEXTURE_WIDTH, static_cast<uint16_t>(m_shadowViews.size()),
+			bgfx::copy(m_shadowViews.data(), static_cast<uint32_t>(m_shadowViews.size() * sizeof(ShadowView))));
+	}
+}
+
+void WorldRenderer::SubmitViewConstants(DrawStateCache& drawStateCache)
+{
+	const CameraComponent* pMainCameraComponent = m_pCurrentSceneWorld->GetCameraComponent(m_pCurrentSceneWorld->GetMainCameraEntity());
+	const cd::Transform& cameraTransform = m_pCurrentSceneWorld->GetTransformComponent(m_pCurrentSceneWorld->GetMainCameraEntity())->GetTransform();
+	SkyComponent* pSkyComponent = m_pCurrentSceneWorld->GetSkyComponent(m_pCurrentSceneWorld->GetSkyEntity());
+
+	const auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
+	size_t lightEntityCount = lightEntities.size();
+
+	// Sky
+	SkyType crtSkyType = pSkyComponent->GetSkyType();
+	if (SkyType::SkyBox == crtSkyType)
+	{
+		constexpr StringCrc irrSamplerCrc(cubeIrradianceSampler);
+		drawStateCache.SetTexture(IBL_IRRADIANCE_SLOT,
+			GetRenderContext()->GetUniform(irrSamplerCrc),
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetIrradianceTexturePath())));
+
+		constexpr StringCrc radSamplerCrc(cubeRadianceSampler);
+		drawStateCache.SetTexture(IBL_RADIANCE_SLOT,
+			GetRenderContext()->GetUniform(radSamplerCrc),
+			GetRenderContext()->GetTexture(StringCrc(pSkyComponent->GetRadianceTexturePath())));
+
+		constexpr StringCrc lutsamplerCrc{ lutSampler };
+		constexpr StringCrc luttextureCrc{ lutTexture };
+		drawStateCache.SetTexture(BRDF_LUT_SLOT, GetRenderContext()->GetUniform(lutsamplerCrc), GetRenderContext()->GetTexture(luttextureCrc));
+	}
+	else if (SkyType::AtmosphericScattering == crtSkyType)
+	{
+		drawStateCache.SetImage(ATM_TRANSMITTANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMTransmittanceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
+		drawStateCache.SetImage(ATM_IRRADIANCE_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMIrradianceCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
+		drawStateCache.SetImage(ATM_SCATTERING_SLOT, GetRenderContext()->GetTexture(pSkyComponent->GetATMScatteringCrc()), 0, bgfx::Access::Read, bgfx::TextureFormat::RGBA32F);
+
+		constexpr StringCrc LightDirCrc(LightDir);
+		drawStateCache.SetUniform(GetRenderContext()->GetUniform(LightDirCrc), &(pSkyComponent->GetSunDirection().x()), 1);
+
+		constexpr StringCrc HeightOffsetAndshadowLengthCrc(HeightOffsetAndshadowLength);
+		cd::Vec4f tmpHeightOffsetAndshadowLength = cd::Vec4f(pSkyComponent->GetHeightOffset(), pSkyComponent->GetShadowLength(), 0.0f, 0.0f);
+		drawStateCache.SetUniform(GetRenderContext()->GetUniform(HeightOffsetAndshadowLengthCrc), &(tmpHeightOffsetAndshadowLength.x()), 1);
+	}
+
+	// Submit uniform values : camera settings
+	constexpr StringCrc cameraPosCrc(cameraPos);
+	drawStateCache.SetUniform(GetRenderContext()->GetUniform(cameraPosCrc), &cameraTransform.GetTranslation().x(), 1);
+
+	constexpr StringCrc cameraNearFarPlaneCrc(cameraNearFarPlane);
+	float cameraNearFarPlanedata[2]{ pMainCameraComponent->GetNearPlane(), pMainCameraComponent->GetFarPlane() };
+	drawStateCache.SetUniform(GetRenderContext()->GetUniform(cameraNearFarPlaneCrc), cameraNearFarPlanedata, 1);
+
+	// Submit light data
+	constexpr StringCrc lightParamsSamplerCrc(lightParamsSampler);
+	constexpr StringCrc lightParamsTextureCrc(lightParamsTexture);
+	drawStateCache.SetTexture(LIGHT_PARAMS_SLOT, GetRenderContext()->GetUniform(lightParamsSamplerCrc), GetRenderContext()->GetTexture(lightParamsTextureCrc));
+	constexpr StringCrc lightClustersSamplerCrc(lightClustersSampler);
+	constexpr StringCrc lightClustersTextureCrc(lightClustersTexture);
+	drawStateCache.SetTexture(LIGHT_CLUSTER_SLOT, GetRenderContext()->GetUniform(lightClustersSamplerCrc), GetRenderContext()->GetTexture(lightClustersTextureCrc));
+
+	constexpr StringCrc lightClusterParamsCrc(lightClusterParams);
+	drawStateCache.SetUniform(GetRenderContext()->GetUniform(lightClusterParamsCrc), m_lightClusterParams.begin(), 1);
+
+	// Submit light view&projection transform and tile of each shadow view in the atlas
+	constexpr StringCrc shadowViewsSamplerCrc(shadowViewsSampler);
+	constexpr StringCrc shadowViewsTextureCrc(shadowViewsTexture);
+	drawStateCache.SetTexture(SHADOW_VIEWS_SLOT, GetRenderContext()->GetUniform(shadowViewsSamplerCrc), GetRenderContext()->GetTexture(shadowViewsTextureCrc));
+
+	// All lights sample shadows from one atlas.
+	constexpr StringCrc shadowAtlasTextureCrc(shadowAtlasTexture);
+	bgfx::TextureHandle shadowAtlasTextureHandle = GetRenderContext()->GetTexture(shadowAtlasTextureCrc);
+	if (bgfx::isValid(shadowAtlasTextureHandle))
+	{
+		constexpr StringCrc shadowAtlasSamplerCrc(shadowAtlasSampler);
+		drawStateCache.SetTexture(SHADOW_MAP_ATLAS_SLOT, GetRenderContext()->GetUniform(shadowAtlasSamplerCrc), shadowAtlasTextureHandle);
+	}
+
+	for (int lightIndex = 0; lightIndex < lightEntityCount; lightIndex++)
+	{
+		auto lightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntities[lightIndex]);
+		if (cd::LightType::Directional == lightComponent->GetType())
+		{
+			// TODO : manual 
+			constexpr StringCrc clipFrustumDepthCrc(clipFrustumDepth);
+			drawStateCache.SetUniform(GetRenderContext()->GetUniform(clipFrustumDepthCrc), lightComponent->GetComputedCascadeSplit(), 1);
+		}
+	}
+}
+
+void WorldRenderer::UpdateLightClusters(const CameraComponent* pMainCameraComponent)
+{
+	static_assert(sizeof(U_Light) == LightUniform::LIGHT_STRIDE * 4 * sizeof(float), "A light should fill a texture row.");
+
+	const auto lightEntities = m_pCurrentSceneWorld->GetLightEntities();
+	m_lightClusters.Reset(pMainCameraComponent->GetViewMatrix(), pMainCameraComponent->GetProjectionMatrix(),
+		pMainCameraComponent->GetNearPlane(), pMainCameraComponent->GetFarPlane());
+	m_lightParams.clear();
+
+	// Lights which affect everything come first. Point and spot lights follow them and are binned into clusters.
+	auto IsLocalLight = [](const LightComponent* pLightComponent)
+	{
+		return cd::LightType::Point == pLightComponent->GetType() || cd::LightType::Spot == pLightComponent->GetType();
+	};
+
+	for (Entity lightEntity : lightEntities)
+	{
+		LightComponent* pLightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntity);
+		if (!IsLocalLight(pLightComponent) && m_lightParams.size() < MAX_CLUSTERED_LIGHT_COUNT)
+		{
+			m_lightParams.push_back(*pLightComponent->GetLightUniformData());
+		}
+	}
+	uint16_t globalLightCount = static_cast<uint16_t>(m_lightParams.size());
+
+	for (Entity lightEntity : lightEntities)
+	{
+		LightComponent* pLightComponent = m_pCurrentSceneWorld->GetLightComponent(lightEntity);
+		if (!IsLocalLight(pLightComponent) || m_lightParams.size() >= MAX_CLUSTERED_LIGHT_COUNT)
+		{
+			continue;
+		}
+
+		uint16_t lightIndex = static_cast<uint16_t>(m_lightParams.size());
+		m_lightParams.push_back(*pLightComponent->GetLightUniformData());
+		if (cd::LightType::Point == pLightComponent->GetType())
+		{
+			m_lightClusters.AddPointLight(lightIndex, pLightComponent->GetPosition(), pLightComponent->GetRange());
 		}
 		else
 		{
-			SubmitStaticMeshDrawCall(pMeshComponent, GetViewID(), pShaderResource->GetHandle());
+			m_lightClusters.AddSpotLight(lightIndex, pLightComponent->GetPosition(), pLightComponent->GetDirection(), pLightComponent->GetRange(),
+				cd::Math::DegreeToRadian(pLightComponent->GetInnerAndOuter().y()));
+		}
+	}
+	m_lightClusters.Build();
+
+	// Only rows used in current frame are uploaded. Data is copied because bgfx reads it after the frame is submitted.
+	constexpr StringCrc lightParamsTextureCrc(lightParamsTexture);
+	bgfx::TextureHandle lightParamsTextureHandle = GetRenderContext()->GetTexture(lightParamsTextureCrc);
+	if (!m_lightParams.empty())
+	{
+		bgfx::updateTexture2D(lightParamsTextureHandle, 0, 0, 0, 0, LightUniform::LIGHT_STRIDE, static_cast<uint16_t>(m_lightParams.size()),
+			bgfx::copy(m_lightParams.data(), static_cast<uint32_t>(m_lightParams.size() * sizeof(U_Light))));
+	}
+
+	constexpr StringCrc lightClustersTextureCrc(lightClustersTexture);
+	bgfx::TextureHandle lightClustersTextureHandle = GetRenderContext()->GetTexture(lightClustersTextureCrc);
+	uint16_t lightClustersRowCount = m_lightClusters.GetTextureRowCount();
+	bgfx::updateTexture2D(lightClustersTextureHandle, 0, 0, 0, 0, LightClusters::TextureWidth, lightClustersRowCount,
+		bgfx::copy(m_lightClusters.GetTextureData().data(), lightClustersRowCount * LightClusters::TextureWidth * 2U * sizeof(float)));
+
+	m_lightClusterParams = cd::Vec4f(static_cast<float>(globalLightCount), m_lightClusters.GetDepthSliceScale(), m_lightClusters.GetDepthSliceBias(), 0.0f);
+}
+
+bool WorldRenderer::IsInstancingCandidate(Entity entity) const
+{
+	// Skinned and morphed meshes have their own vertex data per entity.
+	if (m_pCurrentSceneWorld->GetAnimationComponent(entity) || m_pCurrentSceneWorld->GetBlendShapeComponent(entity))
+	{
+		return false;
+	}
+
+	const MaterialComponent* pMaterialComponent = m_pCurrentSceneWorld->GetMaterialComponent(entity);
+	return pMaterialComponent->GetMaterialType() == m_pCurrentSceneWorld->GetPBRMaterialType() && pMaterialComponent->IsInstancingSupported();
+}
+
+bool WorldRenderer::CanDrawAsInstances(Entity firstEntity, Entity entity) const
+{
+	const StaticMeshComponent* pFirstMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(firstEntity);
+	const StaticMeshComponent* pMeshComponent = m_pCurrentSceneWorld->GetStaticMeshComponent(entity);
+	return pMeshComponent->GetMeshResource() == pFirstMeshComponent->GetMeshResource() &&
+		pMeshComponent->GetStartIndex() == pFirstMeshComponent->GetStartIndex() &&
+		pMeshComponent->GetIndexCount() == pFirstMeshComponent->GetIndexCount() &&
+		pMeshComponent->GetLOD() == pFirstMeshComponent->GetLOD() &&
+		IsInstancingCandidate(entity) &&
+		IsSameMaterial(m_pCurrentSceneWorld->GetMaterialComponent(firstEntity), m_pCurrentSceneWorld->GetMaterialComponent(entity));
+}
+
+const ShaderResource* WorldRenderer::GetInstancedShaderResource(const MaterialComponent* pMaterialComponent)
+{
+	const ShaderResource* pShaderResource = pMaterialComponent->GetShaderResource();
+	auto itInstancedShaderResource = m_instancedShaderResources.find(pShaderResource);
+	if (itInstancedShaderResource == m_instancedShaderResources.end())
+	{
+		ShaderResource* pInstancedShaderResource = GetRenderContext()->RegisterShaderVariant(pShaderResource, pMaterialComponent->GetInstancedFeaturesCombine());
+		// Active variants are rebuilt by shader hot reload.
+		pInstancedShaderResource->SetActive(true);
+		itInstancedShaderResource = m_instancedShaderResources.emplace(pShaderResource, pInstancedShaderResource).first;
+	}
+
+	return itInstancedShaderResource->second.Get();
+}
+
+void WorldRenderer::BuildInstancingGroups()
+{
+	const std::vector<RenderQueue::DrawPacket>& drawPackets = m_renderQueue.GetPackets();
+	m_instancingGroupSizes.assign(drawPackets.size(), 1U);
+	if (!m_isInstancingSupported)
+	{
+		return;
+	}
+
+	size_t packetIndex = 0;
+	while (packetIndex < drawPackets.size())
+	{
+		Entity firstEntity = m_drawEntities[drawPackets[packetIndex].payload];
+		size_t endPacketIndex = packetIndex + 1;
+		if (IsInstancingCandidate(firstEntity))
+		{
+			endPacketIndex = m_renderQueue.GetGroupEnd(packetIndex, [this, firstEntity](const RenderQueue::DrawPacket&, const RenderQueue::DrawPacket& packet)
+			{
+				return CanDrawAsInstances(firstEntity, m_drawEntities[packet.payload]);
+			});
+		}
+
+		if (endPacketIndex - packetIndex > 1U)
+		{
+			const ShaderResource* pInstancedShaderResource = GetInstancedShaderResource(m_pCurrentSceneWorld->GetMaterialComponent(firstEntity));
+			if (ResourceStatus::Ready == pInstancedShaderResource->GetStatus() || ResourceStatus::Optimized == pInstancedShaderResource->GetStatus())
+			{
+				m_instancingGroupSizes[packetIndex] = static_cast<uint32_t>(endPacketIndex - packetIndex);
+			}
 		}
+		packetIndex = endPacketIndex;
 	}
 }
 
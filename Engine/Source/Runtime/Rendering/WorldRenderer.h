@@ -1,10 +1,23 @@
 #pragma once
 
+#include "DrawStateCache.h"
+#include "ECWorld/Entity.h"
+#include "Light.h"
+#include "LightClusters.h"
+#include "Math/Matrix.hpp"
 #include "Renderer.h"
+#include "RenderQueue.h"
+#include "Resources/ResourceHandle.h"
+#include "Resources/ShaderResource.h"
+
+#include <unordered_map>
+#include <vector>
 
 namespace engine
 {
 
+class CameraComponent;
+class MaterialComponent;
 class SceneWorld;
 
 class WorldRenderer final : public Renderer
@@ -15,11 +28,51 @@ public:
 	virtual void Init() override;
 	virtual void UpdateView(const float* pViewMatrix, const float* pProjectionMatrix) override;
 	virtual void Render(float deltaTime) override;
+	virtual void SetupRenderPass(RenderGraph* pRenderGraph, RenderGraph::PassID passID) override;
 
 	void SetSceneWorld(SceneWorld* pSceneWorld) { m_pCurrentSceneWorld = pSceneWorld; }
 
+private:
+	// Resources and light data are updated on main thread. Every encoder binds them again because encoders don't share bindings.
+	void UpdateViewConstants();
+	void UpdateLightClusters(const CameraComponent* pMainCameraComponent);
+	void SubmitViewConstants(DrawStateCache& drawStateCache);
+	bool IsInstancingCandidate(Entity entity) const;
+	bool CanDrawAsInstances(Entity firstEntity, Entity entity) const;
+	// Instanced variants are registered on first use so that they are not compiled with all variants of materials.
+	const ShaderResource* GetInstancedShaderResource(const MaterialComponent* pMaterialComponent);
+	// Splits sorted packets into groups which are drawn as instances. Packets are drawn one by one until the instanced variant is loaded.
+	void BuildInstancingGroups();
+	// Instance data is allocated on main thread because checking and allocating transient memory are not atomic together.
+	void AllocateInstanceData();
+	// Sorted packets are split into chunks. Each chunk is recorded by one encoder into its own sequential view.
+	void RecordDrawChunk(size_t chunkIndex);
+
 private:
 	SceneWorld* m_pCurrentSceneWorld = nullptr;
+
+	RenderQueue m_renderQueue;
+	std::vector<Entity> m_drawEntities;
+	// Views after the world view with the same target. Views execute in the order of IDs so chunks keep the sorted order.
+	std::vector<uint16_t> m_chunkViewIDs;
+	std::vector<size_t> m_drawChunkEnds;
+	std::vector<DrawStateCache> m_drawStateCaches;
+	// One texture row per shadow view.
+	struct ShadowView
+	{
+		cd::Matrix4x4 viewProjection;
+		cd::Vec4f atlasRect;
+	};
+	std::vector<ShadowView> m_shadowViews;
+	LightClusters m_lightClusters;
+	std::vector<U_Light> m_lightParams;
+	cd::Vec4f m_lightClusterParams;
+	bool m_isInstancingSupported = false;
+	// Group size at the first packet of every group.
+	std::vector<uint32_t> m_instancingGroupSizes;
+	std::vector<bgfx::InstanceDataBuffer> m_instanceDataBuffers;
+	// Key : program of material, Value : instanced variant of it.
+	std::unordered_map<const ShaderResource*, ResourceHandle<ShaderResource>> m_instancedShaderResources;
 };
 
 }
\ No newline at end of file
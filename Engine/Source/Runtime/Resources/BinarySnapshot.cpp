@@ -0,0 +1,140 @@
+#include "BinarySnapshot.h"
+
+#include "Base/Template.h"
+#include "MappedFile.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace engine
+{
+
+BinarySnapshotWriter::BinarySnapshotWriter(uint32_t version)
+{
+	SnapshotHeader header{};
+	header.magic = SnapshotHeader::Magic;
+	header.version = version;
+	Append(&header, sizeof(SnapshotHeader));
+}
+
+uint64_t BinarySnapshotWriter::Append(const void* pData, uint64_t size)
+{
+	uint64_t offset = (m_data.size() + SnapshotAlignment - 1) & ~(SnapshotAlignment - 1);
+	m_data.resize(static_cast<size_t>(offset + size));
+	if (size > 0)
+	{
+		std::memcpy(m_data.data() + offset, pData, static_cast<size_t>(size));
+	}
+	return offset;
+}
+
+void BinarySnapshotWriter::AddSection(uint32_t id, const void* pData, uint32_t elementSize, uint64_t elementCount)
+{
+	assert(elementSize > 0);
+	SnapshotSection& section = m_sections.emplace_back();
+	section.id = id;
+	section.elementSize = elementSize;
+	section.elementCount = elementCount;
+	section.offset = Append(pData, elementSize * elementCount);
+}
+
+SnapshotBlob BinarySnapshotWriter::AddBlob(const void* pData, uint64_t size)
+{
+	SnapshotBlob blob;
+	blob.offset = Append(pData, size);
+	blob.size = size;
+	return blob;
+}
+
+bool BinarySnapshotWriter::Write(const char* pFilePath) const
+{
+	uint64_t sectionTableOffset = (m_data.size() + SnapshotAlignment - 1) & ~(SnapshotAlignment - 1);
+	uint64_t sectionTableSize = m_sections.size() * sizeof(SnapshotSection);
+
+	SnapshotHeader header;
+	std::memcpy(&header, m_data.data(), sizeof(SnapshotHeader));
+	header.sectionCount = static_cast<uint32_t>(m_sections.size());
+	header.sectionTableOffset = sectionTableOffset;
+	header.fileSize = sectionTableOffset + sectionTableSize;
+
+	std::ofstream fout(pFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fout.is_open())
+	{
+		return false;
+	}
+
+	const char padding[SnapshotAlignment] = {};
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(SnapshotHeader));
+	fout.write(reinterpret_cast<const char*>(m_data.data() + sizeof(SnapshotHeader)), m_data.size() - sizeof(SnapshotHeader));
+	fout.write(padding, static_cast<std::streamsize>(sectionTableOffset - m_data.size()));
+	fout.write(reinterpret_cast<const char*>(m_sections.data()), static_cast<std::streamsize>(sectionTableSize));
+	fout.close();
+
+	return !fout.fail();
+}
+
+bool BinarySnapshotReader::Open(const char* pFilePath, uint32_t version)
+{
+	m_pMappedFile.reset();
+	m_pData = nullptr;
+	m_sections = {};
+
+	auto pMappedFile = std::make_shared<MappedFile>();
+	if (!pMappedFile->Open(pFilePath) || pMappedFile->GetSize() < sizeof(SnapshotHeader))
+	{
+		return false;
+	}
+
+	const std::byte* pData = pMappedFile->GetData();
+	const uint64_t fileSize = pMappedFile->GetSize();
+	const auto* pHeader = reinterpret_cast<const SnapshotHeader*>(pData);
+	if (pHeader->magic != SnapshotHeader::Magic || pHeader->version != version || pHeader->fileSize != fileSize ||
+		pHeader->sectionTableOffset % SnapshotAlignment != 0 ||
+		pHeader->sectionTableOffset + pHeader->sectionCount * sizeof(SnapshotSection) > fileSize)
+	{
+		return false;
+	}
+
+	auto sections = std::span<const SnapshotSection>(reinterpret_cast<const SnapshotSection*>(pData + pHeader->sectionTableOffset), pHeader->sectionCount);
+	for (const SnapshotSection& section : sections)
+	{
+		// Checked by division to avoid overflow of corrupted counts.
+		if (0 == section.elementSize || section.offset % SnapshotAlignment != 0 || section.offset > fileSize ||
+			section.elementCount > (fileSize - section.offset) / section.elementSize)
+		{
+			return false;
+		}
+	}
+
+	m_pMappedFile = cd::MoveTemp(pMappedFile);
+	m_pData = pData;
+	m_sections = sections;
+	return true;
+}
+
+const SnapshotSection* BinarySnapshotReader::GetSection(uint32_t id) const
+{
+	for (const SnapshotSection& section : m_sections)
+	{
+		if (section.id == id)
+		{
+			return &section;
+		}
+	}
+
+	return nullptr;
+}
+
+std::span<const std::byte> BinarySnapshotReader::GetBlob(const SnapshotBlob& blob) const
+{
+	uint64_t fileSize = m_pMappedFile ? m_pMappedFile->GetSize() : 0;
+	if (blob.offset > fileSize || blob.size > fileSize - blob.offset)
+	{
+		return {};
+	}
+
+	return std::span<const std::byte>(m_pData + blob.offset, static_cast<size_t>(blob.size));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace engine
+{
+
+class MappedFile;
+
+// BinarySnapshot is a relocatable container of plain data arrays :
+// [SnapshotHeader][section data and blobs aligned to SnapshotAlignment][SnapshotSection table]
+// All offsets are relative to the beginning of file and no pointer is stored so that the file can be memory mapped
+// at any address and used in place. Data is stored in native little endian layout.
+struct SnapshotHeader
+{
+	static constexpr uint32_t Magic = 0x53534443; // "CDSS"
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sectionCount;
+	uint32_t reserved;
+	uint64_t sectionTableOffset;
+	uint64_t fileSize;
+};
+
+struct SnapshotSection
+{
+	uint32_t id;
+	uint32_t elementSize;
+	uint64_t elementCount;
+	uint64_t offset;
+};
+
+// Reference to a blob stored in the same snapshot.
+struct SnapshotBlob
+{
+	uint64_t offset;
+	uint64_t size;
+};
+
+static_assert(sizeof(SnapshotHeader) == 32 && sizeof(SnapshotSection) == 24 && sizeof(SnapshotBlob) == 16);
+
+constexpr uint64_t SnapshotAlignment = 16;
+
+class BinarySnapshotWriter final
+{
+public:
+	// version : user defined version of sections layout. Reader rejects snapshots in other versions.
+	explicit BinarySnapshotWriter(uint32_t version);
+	BinarySnapshotWriter(const BinarySnapshotWriter&) = delete;
+	BinarySnapshotWriter& operator=(const BinarySnapshotWriter&) = delete;
+	BinarySnapshotWriter(BinarySnapshotWriter&&) = default;
+	BinarySnapshotWriter& operator=(BinarySnapshotWriter&&) = default;
+	~BinarySnapshotWriter() = default;
+
+	// Add an array of elements which can be queried by id.
+	void AddSection(uint32_t id, const void* pData, uint32_t elementSize, uint64_t elementCount);
+
+	template<typename T>
+	void AddSection(uint32_t id, const std::vector<T>& elements)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		AddSection(id, elements.data(), static_cast<uint32_t>(sizeof(T)), elements.size());
+	}
+
+	// Add raw data which is referenced by other sections.
+	SnapshotBlob AddBlob(const void* pData, uint64_t size);
+
+	bool Write(const char* pFilePath) const;
+
+private:
+	uint64_t Append(const void* pData, uint64_t size);
+
+private:
+	std::vector<std::byte> m_data;
+	std::vector<SnapshotSection> m_sections;
+};
+
+class BinarySnapshotReader final
+{
+public:
+	BinarySnapshotReader() = default;
+	BinarySnapshotReader(const BinarySnapshotReader&) = delete;
+	BinarySnapshotReader& operator=(const BinarySnapshotReader&) = delete;
+	BinarySnapshotReader(BinarySnapshotReader&&) = default;
+	BinarySnapshotReader& operator=(BinarySnapshotReader&&) = default;
+	~BinarySnapshotReader() = default;
+
+	// Map file and validate header and section table. Section data is not touched so it is paged in on demand.
+	bool Open(const char* pFilePath, uint32_t version);
+
+	bool IsOpen() const { return m_pMappedFile != nullptr; }
+
+	const SnapshotSection* GetSection(uint32_t id) const;
+
+	// Returns empty span if section doesn't exist or its element size mismatches.
+	template<typename T>
+	std::span<const T> GetElements(uint32_t id) const
+	{
+		static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= SnapshotAlignment);
+		const SnapshotSection* pSection = GetSection(id);
+		if (!pSection || pSection->elementSize != sizeof(T))
+		{
+			return {};
+		}
+
+		return std::span<const T>(reinterpret_cast<const T*>(m_pData + pSection->offset), static_cast<size_t>(pSection->elementCount));
+	}
+
+	// Returns empty span if blob is out of file range.
+	std::span<const std::byte> GetBlob(const SnapshotBlob& blob) const;
+
+	// Shared owner of mapped memory. Systems which use data in place hold it to keep mapping alive after reader is destroyed.
+	const std::shared_ptr<const MappedFile>& GetMappedFile() const { return m_pMappedFile; }
+
+private:
+	std::shared_ptr<const MappedFile> m_pMappedFile;
+	const std::byte* m_pData = nullptr;
+	std::span<const SnapshotSection> m_sections;
+};
+
+}
\ No newline at end of file
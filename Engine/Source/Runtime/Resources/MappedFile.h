@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace engine
+{
+
+// MappedFile maps a whole file into read only virtual memory.
+// Pages are loaded by the OS on first access so that opening a large file costs nearly nothing
+// and the memory can be passed to other systems without copying.
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+	~MappedFile();
+
+	bool Open(const char* pFilePath);
+	void Close();
+
+	bool IsOpen() const { return m_pData != nullptr; }
+	const std::byte* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const std::byte* m_pData = nullptr;
+	size_t m_size = 0;
+
+#if defined(_WIN32)
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "SystemScheduler.h"
+
+#include "Base/Template.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+
+namespace
+{
+
+bool Intersects(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+	for (uint32_t id : a)
+	{
+		if (std::find(b.begin(), b.end(), id) != b.end())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+float ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+}
+
+bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+{
+	if (m_writeAll || other.m_writeAll)
+	{
+		return true;
+	}
+
+	return Intersects(m_writes, other.m_writes) || Intersects(m_writes, other.m_reads) || Intersects(m_reads, other.m_writes);
+}
+
+SystemScheduler::SystemScheduler(ThreadPool* pThreadPool) :
+	m_pThreadPool(pThreadPool)
+{
+}
+
+SystemScheduler::~SystemScheduler()
+{
+}
+
+SystemScheduler::SystemID SystemScheduler::AddSystem(std::string name, SystemAccess access, SystemFunc func)
+{
+	auto pSystem = std::make_unique<System>();
+	pSystem->name = cd::MoveTemp(name);
+	pSystem->access = cd::MoveTemp(access);
+	pSystem->func = cd::MoveTemp(func);
+	m_systems.emplace_back(cd::MoveTemp(pSystem));
+	m_isGraphDirty = true;
+
+	return static_cast<SystemID>(m_systems.size() - 1);
+}
+
+void SystemScheduler::RemoveAllSystems()
+{
+	m_systems.clear();
+	m_isGraphDirty = true;
+}
+
+void SystemScheduler::SetSystemEnable(SystemID systemID, bool enable)
+{
+	System& system = *m_systems[systemID];
+	if (system.isEnable != enable)
+	{
+		system.isEnable = enable;
+		m_isGraphDirty = true;
+	}
+}
+
+uint32_t SystemScheduler::GetThreadCount() const
+{
+	return m_pThreadPool ? m_pThreadPool->GetWorkerCount() + 1U : 1U;
+}
+
+void SystemScheduler::BuildGraph()
+{
+	m_rootSystems.clear();
+	for (std::unique_ptr<System>& pSystem : m_systems)
+	{
+		pSystem->dependents.clear();
+		pSystem->dependencyCount = 0U;
+	}
+
+	// Graph is rebuilt only when systems change. O(N^2) is fine for tens of systems.
+	for (SystemID systemID = 0U; systemID < m_systems.size(); ++systemID)
+	{
+		System& system = *m_systems[systemID];
+		if (!system.isEnable)
+		{
+			continue;
+		}
+
+		for (SystemID previousID = 0U; previousID < systemID; ++previousID)
+		{
+			System& previousSystem = *m_systems[previousID];
+			if (previousSystem.isEnable && system.access.ConflictsWith(previousSystem.access))
+			{
+				previousSystem.dependents.push_back(systemID);
+				++system.dependencyCount;
+			}
+		}
+
+		if (0U == system.dependencyCount)
+		{
+			m_rootSystems.push_back(systemID);
+		}
+	}
+
+	m_isGraphDirty = false;
+}
+
+void SystemScheduler::Execute(float deltaTime)
+{
+	if (m_isGraphDirty)
+	{
+		BuildGraph();
+	}
+
+	m_deltaTime = deltaTime;
+	m_frameBeginTime = std::chrono::steady_clock::now();
+
+	uint32_t enabledSystemCount = 0U;
+	for (std::unique_ptr<System>& pSystem : m_systems)
+	{
+		if (pSystem->isEnable)
+		{
+			pSystem->remainingDependencyCount.store(pSystem->dependencyCount, std::memory_order_relaxed);
+			++enabledSystemCount;
+		}
+	}
+	m_remainingSystemCount.store(enabledSystemCount, std::memory_order_release);
+
+	for (SystemID systemID : m_rootSystems)
+	{
+		Dispatch(systemID);
+	}
+
+	std::vector<SystemID> readySystems;
+	while (m_remainingSystemCount.load(std::memory_order_acquire) > 0U)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+			readySystems.swap(m_mainThreadReadySystems);
+		}
+
+		if (!readySystems.empty())
+		{
+			for (SystemID systemID : readySystems)
+			{
+				Run(systemID);
+			}
+			readySystems.clear();
+			continue;
+		}
+
+		if (m_pThreadPool && m_pThreadPool->TryRunPendingTask())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mainThreadMutex);
+		m_mainThreadCondition.wait(lock, [this]() { return !m_mainThreadReadySystems.empty() ||
+			0U == m_remainingSystemCount.load(std::memory_order_acquire); });
+	}
+
+	m_frameTime = ToMilliseconds(std::chrono::steady_clock::now() - m_frameBeginTime);
+}
+
+void SystemScheduler::Dispatch(SystemID systemID)
+{
+	if (!m_pThreadPool || m_systems[systemID]->access.IsMainThread())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+			m_mainThreadReadySystems.push_back(systemID);
+		}
+		m_mainThreadCondition.notify_one();
+		return;
+	}
+
+	m_pThreadPool->Submit([this, systemID]() { Run(systemID); });
+}
+
+void SystemScheduler::Run(SystemID systemID)
+{
+	System& system = *m_systems[systemID];
+
+	uint32_t workerIndex = m_pThreadPool ? m_pThreadPool->GetCurrentWorkerIndex() : ThreadPool::InvalidWorkerIndex;
+	system.stats.threadIndex = ThreadPool::InvalidWorkerIndex == workerIndex ? MainThreadIndex : workerIndex + 1U;
+	system.stats.beginTime = ToMilliseconds(std::chrono::steady_clock::now() - m_frameBeginTime);
+	system.func(m_deltaTime);
+	system.stats.endTime = ToMilliseconds(std::chrono::steady_clock::now() - m_frameBeginTime);
+
+	for (SystemID dependentID : system.dependents)
+	{
+		if (1U == m_systems[dependentID]->remainingDependencyCount.fetch_sub(1, std::memory_order_acq_rel))
+		{
+			Dispatch(dependentID);
+		}
+	}
+
+	if (1U == m_remainingSystemCount.fetch_sub(1, std::memory_order_acq_rel))
+	{
+		std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+		m_mainThreadCondition.notify_one();
+	}
+}
+
+}
\ No newline at end of file
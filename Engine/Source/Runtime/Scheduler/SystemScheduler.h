@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Core/StringCrc.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+
+class ThreadPool;
+
+// SystemAccess declares which data a system reads and writes.
+// Components are identified by their class names. Other shared objects such as RenderContext or ImGui
+// can be declared as resources by name.
+class SystemAccess
+{
+public:
+	template<typename... Components>
+	SystemAccess& Read()
+	{
+		(m_reads.push_back(Components::GetClassName().Value()), ...);
+		return *this;
+	}
+
+	template<typename... Components>
+	SystemAccess& Write()
+	{
+		(m_writes.push_back(Components::GetClassName().Value()), ...);
+		return *this;
+	}
+
+	SystemAccess& ReadResource(StringCrc resourceCrc) { m_reads.push_back(resourceCrc.Value()); return *this; }
+	SystemAccess& WriteResource(StringCrc resourceCrc) { m_writes.push_back(resourceCrc.Value()); return *this; }
+
+	// Conflicts with all other systems. Used by systems which can change anything such as editor UI.
+	SystemAccess& WriteAll() { m_writeAll = true; return *this; }
+
+	// Run on the thread which calls SystemScheduler::Execute. Required by systems which call graphics or UI APIs.
+	SystemAccess& MainThread() { m_mainThread = true; return *this; }
+
+	bool ConflictsWith(const SystemAccess& other) const;
+
+	const std::vector<uint32_t>& GetReads() const { return m_reads; }
+	const std::vector<uint32_t>& GetWrites() const { return m_writes; }
+	bool IsWriteAll() const { return m_writeAll; }
+	bool IsMainThread() const { return m_mainThread; }
+
+private:
+	std::vector<uint32_t> m_reads;
+	std::vector<uint32_t> m_writes;
+	bool m_writeAll = false;
+	bool m_mainThread = false;
+};
+
+// SystemScheduler executes registered systems every frame.
+// A dependency DAG is built from registration order and declared access : a system depends on every earlier
+// system which conflicts with it. Systems without dependencies between each other run in parallel on the thread pool.
+// The main thread runs main thread systems and helps workers when it has nothing to do.
+class SystemScheduler
+{
+public:
+	using SystemFunc = std::function<void(float deltaTime)>;
+	using SystemID = uint32_t;
+	static constexpr SystemID InvalidSystemID = static_cast<SystemID>(-1);
+	static constexpr uint32_t MainThreadIndex = 0U;
+
+	struct SystemStats
+	{
+		// Milliseconds relative to the beginning of Execute.
+		float beginTime = 0.0f;
+		float endTime = 0.0f;
+		// 0 is main thread. Workers start from 1.
+		uint32_t threadIndex = MainThreadIndex;
+	};
+
+public:
+	// pThreadPool : nullptr to run all systems on the main thread in registration order.
+	explicit SystemScheduler(ThreadPool* pThreadPool);
+	SystemScheduler(const SystemScheduler&) = delete;
+	SystemScheduler& operator=(const SystemScheduler&) = delete;
+	SystemScheduler(SystemScheduler&&) = delete;
+	SystemScheduler& operator=(SystemScheduler&&) = delete;
+	~SystemScheduler();
+
+	SystemID AddSystem(std::string name, SystemAccess access, SystemFunc func);
+	void RemoveAllSystems();
+
+	// Disabled systems are skipped and don't block their dependents.
+	void SetSystemEnable(SystemID systemID, bool enable);
+	bool IsSystemEnable(SystemID systemID) const { return m_systems[systemID]->isEnable; }
+
+	void Execute(float deltaTime);
+
+	size_t GetSystemCount() const { return m_systems.size(); }
+	const std::string& GetSystemName(SystemID systemID) const { return m_systems[systemID]->name; }
+	const SystemStats& GetSystemStats(SystemID systemID) const { return m_systems[systemID]->stats; }
+	uint32_t GetThreadCount() const;
+
+	// Wall time of last Execute in milliseconds.
+	float GetFrameTime() const { return m_frameTime; }
+
+private:
+	struct System
+	{
+		std::string name;
+		SystemAccess access;
+		SystemFunc func;
+		bool isEnable = true;
+
+		// Indexes of systems which depend on this one.
+		std::vector<SystemID> dependents;
+		uint32_t dependencyCount = 0U;
+		std::atomic<uint32_t> remainingDependencyCount = 0U;
+
+		SystemStats stats;
+	};
+
+	void BuildGraph();
+	void Dispatch(SystemID systemID);
+	void Run(SystemID systemID);
+
+private:
+	ThreadPool* m_pThreadPool;
+	std::vector<std::unique_ptr<System>> m_systems;
+	bool m_isGraphDirty = true;
+
+	// Frame states.
+	float m_deltaTime = 0.0f;
+	float m_frameTime = 0.0f;
+	std::chrono::steady_clock::time_point m_frameBeginTime;
+	std::atomic<uint32_t> m_remainingSystemCount = 0U;
+
+	std::mutex m_mainThreadMutex;
+	std::condition_variable m_mainThreadCondition;
+	std::vector<SystemID> m_mainThreadReadySystems;
+	std::vector<SystemID> m_rootSystems;
+};
+
+}
\ No newline at end of file
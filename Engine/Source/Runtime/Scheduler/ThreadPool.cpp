@@ -0,0 +1,189 @@
+#include "ThreadPool.h"
+
+#include "Base/Template.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace engine
+{
+
+namespace
+{
+
+// Worker index is cached per thread. Pool pointer is compared so that workers of other pools are not confused.
+thread_local const ThreadPool* t_pCurrentPool = nullptr;
+thread_local uint32_t t_currentWorkerIndex = ThreadPool::InvalidWorkerIndex;
+
+}
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+	if (0U == workerCount)
+	{
+		uint32_t hardwareCount = std::thread::hardware_concurrency();
+		workerCount = hardwareCount > 1U ? hardwareCount - 1U : 1U;
+	}
+
+	m_workerCount = workerCount;
+	m_pQueues = std::make_unique<WorkerQueue[]>(workerCount);
+	m_workers.reserve(workerCount);
+	for (uint32_t workerIndex = 0U; workerIndex < workerCount; ++workerIndex)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerMain, this, workerIndex);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	WaitIdle();
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_isStopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+uint32_t ThreadPool::GetCurrentWorkerIndex() const
+{
+	return t_pCurrentPool == this ? t_currentWorkerIndex : InvalidWorkerIndex;
+}
+
+void ThreadPool::Submit(Task task)
+{
+	uint32_t queueIndex = GetCurrentWorkerIndex();
+	if (InvalidWorkerIndex == queueIndex)
+	{
+		queueIndex = m_nextQueueIndex.fetch_add(1, std::memory_order_relaxed) % GetWorkerCount();
+	}
+
+	m_unfinishedTaskCount.fetch_add(1, std::memory_order_relaxed);
+	{
+		WorkerQueue& queue = m_pQueues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(cd::MoveTemp(task));
+	}
+
+	{
+		// Increase under the sleep mutex so that a worker which is going to sleep won't miss the notification.
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_pendingTaskCount.fetch_add(1, std::memory_order_release);
+	}
+	m_wakeCondition.notify_one();
+}
+
+bool ThreadPool::TryRunPendingTask()
+{
+	Task task;
+	uint32_t workerIndex = GetCurrentWorkerIndex();
+	bool found = InvalidWorkerIndex != workerIndex ? PopTask(workerIndex, task) : false;
+	if (!found && !StealTask(workerIndex, task))
+	{
+		return false;
+	}
+
+	RunTask(task);
+	return true;
+}
+
+void ThreadPool::WaitIdle()
+{
+	while (m_unfinishedTaskCount.load(std::memory_order_acquire) > 0U)
+	{
+		if (!TryRunPendingTask())
+		{
+			// Remaining tasks are running on other threads.
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_idleCondition.wait(lock, [this]() { return 0U == m_unfinishedTaskCount.load(std::memory_order_acquire) ||
+				m_pendingTaskCount.load(std::memory_order_acquire) > 0U; });
+		}
+	}
+}
+
+void ThreadPool::WorkerMain(uint32_t workerIndex)
+{
+	t_pCurrentPool = this;
+	t_currentWorkerIndex = workerIndex;
+
+	while (true)
+	{
+		Task task;
+		if (PopTask(workerIndex, task) || StealTask(workerIndex, task))
+		{
+			RunTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.wait(lock, [this]() { return m_isStopping || m_pendingTaskCount.load(std::memory_order_acquire) > 0U; });
+		if (m_isStopping && 0U == m_pendingTaskCount.load(std::memory_order_acquire))
+		{
+			break;
+		}
+	}
+
+	t_pCurrentPool = nullptr;
+	t_currentWorkerIndex = InvalidWorkerIndex;
+}
+
+bool ThreadPool::PopTask(uint32_t workerIndex, Task& task)
+{
+	WorkerQueue& queue = m_pQueues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+	{
+		return false;
+	}
+
+	task = cd::MoveTemp(queue.tasks.back());
+	queue.tasks.pop_back();
+	m_pendingTaskCount.fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+
+bool ThreadPool::StealTask(uint32_t thiefIndex, Task& task)
+{
+	uint32_t workerCount = GetWorkerCount();
+	uint32_t startIndex = InvalidWorkerIndex != thiefIndex ? thiefIndex + 1U : 0U;
+	for (uint32_t offset = 0U; offset < workerCount; ++offset)
+	{
+		uint32_t victimIndex = (startIndex + offset) % workerCount;
+		if (victimIndex == thiefIndex)
+		{
+			continue;
+		}
+
+		WorkerQueue& queue = m_pQueues[victimIndex];
+		std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+		if (!lock.owns_lock() || queue.tasks.empty())
+		{
+			continue;
+		}
+
+		task = cd::MoveTemp(queue.tasks.front());
+		queue.tasks.pop_front();
+		m_pendingTaskCount.fetch_sub(1, std::memory_order_acq_rel);
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::RunTask(Task& task)
+{
+	task();
+
+	if (1U == m_unfinishedTaskCount.fetch_sub(1, std::memory_order_acq_rel))
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_idleCondition.notify_all();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine
+{
+
+// ThreadPool runs tasks on a fixed count of worker threads.
+// Every worker owns a task queue. Tasks submitted from a worker go to its own queue and are popped in LIFO order
+// to reuse hot caches. Idle workers steal from the front of other queues so that load is balanced without a global lock.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+	static constexpr uint32_t InvalidWorkerIndex = static_cast<uint32_t>(-1);
+
+public:
+	// workerCount : 0 means hardware concurrency minus one for the main thread.
+	explicit ThreadPool(uint32_t workerCount = 0U);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	~ThreadPool();
+
+	uint32_t GetWorkerCount() const { return m_workerCount; }
+
+	// Returns worker index of current thread, or InvalidWorkerIndex if it is not a worker of this pool.
+	uint32_t GetCurrentWorkerIndex() const;
+
+	void Submit(Task task);
+
+	// Run one pending task on current thread. Returns false if all queues are empty.
+	// Threads which wait for tasks can call it to help instead of blocking.
+	bool TryRunPendingTask();
+
+	// Block until all submitted tasks are finished. Calling thread helps to run tasks.
+	void WaitIdle();
+
+	// Invoke func(size_t begin, size_t end) for [0, count) split into batches. The first batch runs on calling thread
+	// and it helps to run other tasks until all batches finish. Small ranges run inline without submitting any task.
+	template<typename Func>
+	void ParallelFor(size_t count, size_t batchSize, Func&& func)
+	{
+		if (count <= batchSize || 0U == batchSize)
+		{
+			func(static_cast<size_t>(0), count);
+			return;
+		}
+
+		size_t batchCount = (count + batchSize - 1) / batchSize;
+		std::atomic<size_t> remainingBatchCount = batchCount - 1;
+		for (size_t batchIndex = 1; batchIndex < batchCount; ++batchIndex)
+		{
+			size_t begin = batchIndex * batchSize;
+			size_t end = std::min(begin + batchSize, count);
+			Submit([&func, &remainingBatchCount, begin, end]()
+			{
+				func(begin, end);
+				remainingBatchCount.fetch_sub(1, std::memory_order_release);
+			});
+		}
+
+		func(static_cast<size_t>(0), batchSize);
+
+		while (remainingBatchCount.load(std::memory_order_acquire) > 0U)
+		{
+			if (!TryRunPendingTask())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+private:
+	struct alignas(64) WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void WorkerMain(uint32_t workerIndex);
+	bool PopTask(uint32_t workerIndex, Task& task);
+	bool StealTask(uint32_t thiefIndex, Task& task);
+	void RunTask(Task& task);
+
+private:
+	uint32_t m_workerCount;
+	std::vector<std::thread> m_workers;
+	std::unique_ptr<WorkerQueue[]> m_pQueues;
+
+	std::atomic<uint32_t> m_nextQueueIndex = 0U;
+	std::atomic<uint32_t> m_pendingTaskCount = 0U;
+	std::atomic<uint32_t> m_unfinishedTaskCount = 0U;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_idleCondition;
+	bool m_isStopping = false;
+};
+
+}
\ No newline at end of file
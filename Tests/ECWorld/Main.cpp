@@ -1,16 +1,26 @@
 #include "Core/StringCrc.h"
 #include "ECWorld/CameraComponent.h"
+#include "ECWorld/CollisionMeshComponent.h"
+#include "ECWorld/CullingSystem.h"
+#include "ECWorld/EntityCommandBuffer.h"
 #include "ECWorld/LightComponent.h"
 #include "ECWorld/MaterialComponent.h"
 #include "ECWorld/HierarchyComponent.h"
 #include "ECWorld/World.h"
 #include "ECWorld/StaticMeshComponent.h"
 #include "ECWorld/TransformComponent.h"
+#include "ECWorld/TransformSystem.h"
+#include "Scheduler/ThreadPool.h"
 #include "Utilities/PerformanceProfiler.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <random>
 #include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 namespace
 {
@@ -44,6 +54,234 @@ void Test_CreateEntity()
 	printf("[Success] Test_CreateEntity\n");
 }
 
+void Test_RecycleEntity()
+{
+	cdtools::PerformanceProfiler perf("Test_RecycleEntity");
+
+	World world;
+	auto* pTransformStorage = world.Register<TransformComponent>();
+
+	Entity oldEntity = world.CreateEntity();
+	pTransformStorage->CreateComponent(oldEntity);
+	assert(world.IsValid(oldEntity));
+	assert(1 == world.GetEntityCount());
+
+	world.DeleteEntity(oldEntity);
+	assert(!world.IsValid(oldEntity));
+	assert(0 == world.GetEntityCount());
+	assert(0 == pTransformStorage->GetCount());
+
+	// Index isn't recycled until enough indexes are free.
+	std::vector<Entity> tempEntities;
+	for (uint32_t index = 0U; index < MIN_FREE_ENTITY_INDEX_COUNT; ++index)
+	{
+		tempEntities.push_back(world.CreateEntity());
+		assert(GetEntityIndex(tempEntities.back()) != GetEntityIndex(oldEntity));
+	}
+	world.DeleteEntities(tempEntities.data(), tempEntities.size());
+
+	// The oldest index is recycled with a new generation.
+	Entity newEntity = world.CreateEntity();
+	assert(GetEntityIndex(newEntity) == GetEntityIndex(oldEntity));
+	assert(GetEntityGeneration(newEntity) == GetEntityGeneration(oldEntity) + 1);
+	assert(world.IsValid(newEntity));
+	assert(!world.IsValid(oldEntity));
+
+	// Stale handle can't access components of the new entity.
+	pTransformStorage->CreateComponent(newEntity);
+	assert(pTransformStorage->Contains(newEntity));
+	assert(!pTransformStorage->Contains(oldEntity));
+	assert(nullptr == pTransformStorage->GetComponent(oldEntity));
+	pTransformStorage->RemoveComponent(oldEntity);
+	assert(1 == pTransformStorage->GetCount());
+
+	// Stale handle stays invalid after its index is recycled as many times as generation values.
+	Entity deletedEntity = world.CreateEntity();
+	world.DeleteEntity(deletedEntity);
+	for (uint32_t cycle = 0U; cycle <= ENTITY_GENERATION_MASK; ++cycle)
+	{
+		world.DeleteEntity(world.CreateEntity());
+		assert(!world.IsValid(deletedEntity));
+	}
+
+	// Entity ids are allocated per world.
+	World anotherWorld;
+	assert(GetEntityIndex(anotherWorld.CreateEntity()) == 0);
+
+	printf("\n[Success] Test_RecycleEntity\n");
+}
+
+void Test_EntityCommandBuffer()
+{
+	cdtools::PerformanceProfiler perf("Test_EntityCommandBuffer");
+
+	World world;
+	auto* pTransformStorage = world.Register<TransformComponent>();
+	auto* pHierarchyStorage = world.Register<HierarchyComponent>();
+	EntityCommandBuffer commandBuffer(&world);
+
+	constexpr int allocateCount = 10000;
+	Entity entities[allocateCount];
+
+#pragma omp parallel for
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		entities[i] = world.CreateEntity();
+		commandBuffer.CreateComponent<TransformComponent>(entities[i]);
+		commandBuffer.CreateComponent<HierarchyComponent>(entities[i]);
+	}
+
+	// Nothing changes before playback.
+	assert(0 == pTransformStorage->GetCount());
+	assert(allocateCount * 2 == commandBuffer.GetCommandCount());
+	commandBuffer.Playback();
+	assert(commandBuffer.IsEmpty());
+	assert(allocateCount == pTransformStorage->GetCount());
+	assert(allocateCount == pHierarchyStorage->GetCount());
+
+#pragma omp parallel for
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		if (i % 2 == 0)
+		{
+			commandBuffer.RemoveComponent<HierarchyComponent>(entities[i]);
+		}
+		else if (i % 3 == 0)
+		{
+			commandBuffer.DeleteEntity(entities[i]);
+		}
+	}
+	commandBuffer.Playback();
+
+	size_t deletedCount = 0;
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		bool isDeleted = i % 2 != 0 && i % 3 == 0;
+		deletedCount += isDeleted ? 1 : 0;
+		assert(world.IsValid(entities[i]) != isDeleted);
+		assert(pTransformStorage->Contains(entities[i]) != isDeleted);
+		assert(pHierarchyStorage->Contains(entities[i]) == (i % 2 != 0 && !isDeleted));
+	}
+	assert(allocateCount - deletedCount == pTransformStorage->GetCount());
+
+	// Dense arrays are still consistent with sparse indexes after batch removal.
+	for (size_t index = 0; index < pTransformStorage->GetCount(); ++index)
+	{
+		Entity entity = pTransformStorage->GetEntities()[index];
+		assert(pTransformStorage->GetComponent(entity) == &pTransformStorage->GetComponents()[index]);
+	}
+
+	printf("\n[Success] Test_EntityCommandBuffer\n");
+}
+
+// Keeps one entity alive like SceneWorld keeps the main camera.
+class ProtectedEntityDeleter
+{
+public:
+	World* pWorld;
+	Entity protectedEntity;
+
+	void DeleteEntities(const Entity* pEntities, size_t count)
+	{
+		for (size_t index = 0; index < count; ++index)
+		{
+			if (pEntities[index] != protectedEntity)
+			{
+				pWorld->DeleteEntity(pEntities[index]);
+			}
+		}
+	}
+};
+
+void Test_EntityCommandBufferOrder()
+{
+	cdtools::PerformanceProfiler perf("Test_EntityCommandBufferOrder");
+
+	World world;
+	auto* pTransformStorage = world.Register<TransformComponent>();
+	auto* pHierarchyStorage = world.Register<HierarchyComponent>();
+	EntityCommandBuffer commandBuffer(&world);
+
+	// Commands are applied in recorded order instead of grouped by type.
+	Entity recreatedEntity = world.CreateEntity();
+	Entity createdThenDeletedEntity = world.CreateEntity();
+	Entity deletedThenCreatedEntity = world.CreateEntity();
+	pHierarchyStorage->CreateComponent(recreatedEntity);
+	commandBuffer.RemoveComponent<HierarchyComponent>(recreatedEntity);
+	HierarchyComponent hierarchyComponent;
+	hierarchyComponent.SetParentEntity(createdThenDeletedEntity);
+	commandBuffer.CreateComponent<HierarchyComponent>(recreatedEntity, hierarchyComponent);
+	commandBuffer.CreateComponent<TransformComponent>(createdThenDeletedEntity);
+	commandBuffer.DeleteEntity(createdThenDeletedEntity);
+	commandBuffer.DeleteEntity(deletedThenCreatedEntity);
+	commandBuffer.CreateComponent<TransformComponent>(deletedThenCreatedEntity);
+	commandBuffer.Playback();
+	assert(pHierarchyStorage->Contains(recreatedEntity));
+	assert(pHierarchyStorage->GetComponent(recreatedEntity)->GetParentEntity() == createdThenDeletedEntity);
+	assert(!world.IsValid(createdThenDeletedEntity) && !world.IsValid(deletedThenCreatedEntity));
+	assert(0 == pTransformStorage->GetCount());
+
+	// Interleaved removals are grouped per storage. Creation after removal still recreates the component
+	// and creation for an entity which already has the component is skipped.
+	Entity firstEntity = world.CreateEntity();
+	Entity secondEntity = world.CreateEntity();
+	for (Entity entity : { firstEntity, secondEntity })
+	{
+		pTransformStorage->CreateComponent(entity);
+		pHierarchyStorage->CreateComponent(entity);
+	}
+	commandBuffer.RemoveComponent<TransformComponent>(firstEntity);
+	commandBuffer.RemoveComponent<HierarchyComponent>(firstEntity);
+	commandBuffer.RemoveComponent<TransformComponent>(secondEntity);
+	hierarchyComponent.SetParentEntity(secondEntity);
+	commandBuffer.CreateComponent<HierarchyComponent>(firstEntity, hierarchyComponent);
+	hierarchyComponent.SetParentEntity(firstEntity);
+	commandBuffer.CreateComponent<HierarchyComponent>(secondEntity, hierarchyComponent);
+	commandBuffer.CreateComponent<TransformComponent>(secondEntity);
+	commandBuffer.CreateComponent<TransformComponent>(secondEntity);
+	commandBuffer.Playback();
+	assert(!pTransformStorage->Contains(firstEntity) && pTransformStorage->Contains(secondEntity));
+	assert(pHierarchyStorage->GetComponent(firstEntity)->GetParentEntity() == secondEntity);
+	assert(pHierarchyStorage->GetComponent(secondEntity)->GetParentEntity() == INVALID_ENTITY);
+	world.DeleteEntity(firstEntity);
+	world.DeleteEntity(secondEntity);
+	assert(0 == pTransformStorage->GetCount());
+
+	// Lanes grow when more threads record than ever before.
+	constexpr int threadCount = 100;
+	std::vector<Entity> entities;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		entities.push_back(world.CreateEntity());
+	}
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; ++i)
+	{
+		threads.emplace_back([&commandBuffer, &entities, i]()
+		{
+			commandBuffer.CreateComponent<TransformComponent>(entities[i]);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	assert(threadCount == commandBuffer.GetCommandCount());
+	commandBuffer.Playback();
+	assert(threadCount == pTransformStorage->GetCount());
+
+	// Deletions are forwarded to the bound handler.
+	ProtectedEntityDeleter deleter{ &world, entities[0] };
+	commandBuffer.OnDeleteEntities.Bind<ProtectedEntityDeleter, &ProtectedEntityDeleter::DeleteEntities>(&deleter);
+	commandBuffer.DeleteEntity(entities[0]);
+	commandBuffer.DeleteEntity(entities[1]);
+	commandBuffer.Playback();
+	assert(world.IsValid(entities[0]) && pTransformStorage->Contains(entities[0]));
+	assert(!world.IsValid(entities[1]) && !pTransformStorage->Contains(entities[1]));
+
+	printf("\n[Success] Test_EntityCommandBufferOrder\n");
+}
+
 class Factory
 {
 public:
@@ -184,11 +422,760 @@ void Test_RemoveEntityComponentsByOrder(Factory& factory, const std::vector<Enti
 	printf("\n[Success] Test_RemoveEntityComponentsByOrder\n");
 }
 
+// The previous ComponentsStorage implementation which maps entity to component index by std::unordered_map.
+// Only used as a baseline in benchmarks.
+template<typename Component>
+class MapComponentsStorage
+{
+public:
+	bool Contains(Entity entity) const { return m_entityToIndex.find(entity) != m_entityToIndex.end(); }
+	size_t GetCount() const { return m_entityToIndex.size(); }
+
+	Component* GetComponent(Entity entity)
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		return itIndex == m_entityToIndex.end() ? nullptr : &m_components[itIndex->second];
+	}
+
+	Component& CreateComponent(Entity entity)
+	{
+		m_entityToIndex[entity] = m_components.size();
+		m_entities.emplace_back(entity);
+		m_components.emplace_back();
+		return m_components.back();
+	}
+
+	void RemoveComponent(Entity entity)
+	{
+		auto itIndex = m_entityToIndex.find(entity);
+		if (itIndex == m_entityToIndex.end())
+		{
+			return;
+		}
+
+		if (m_entityToIndex.size() > 1)
+		{
+			size_t unusedIndex = itIndex->second;
+			Entity lastEntity = m_entities.back();
+			m_entities[unusedIndex] = lastEntity;
+			m_components[unusedIndex] = cd::MoveTemp(m_components.back());
+			m_entityToIndex[lastEntity] = unusedIndex;
+		}
+
+		m_entities.pop_back();
+		m_components.pop_back();
+		m_entityToIndex.erase(entity);
+	}
+
+private:
+	std::vector<Entity> m_entities;
+	std::vector<Component> m_components;
+	std::unordered_map<Entity, size_t> m_entityToIndex;
+};
+
+struct BenchmarkComponent
+{
+	static constexpr StringCrc GetClassName()
+	{
+		constexpr StringCrc className("BenchmarkComponent");
+		return className;
+	}
+
+	float data[16];
+};
+
+template<typename Storage>
+void Benchmark_ComponentsStorage(const char* pStorageName, const std::vector<Entity>& entities, const std::vector<Entity>& shuffledEntities)
+{
+	std::string prefix = std::string(pStorageName) + "_" + std::to_string(entities.size());
+	Storage storage;
+
+	{
+		cdtools::PerformanceProfiler perf((prefix + "_Create").c_str());
+		for (Entity entity : entities)
+		{
+			storage.CreateComponent(entity);
+		}
+	}
+
+	float sum = 0.0f;
+	{
+		cdtools::PerformanceProfiler perf((prefix + "_RandomGet").c_str());
+		for (Entity entity : shuffledEntities)
+		{
+			sum += storage.GetComponent(entity)->data[0];
+		}
+	}
+
+	size_t containsCount = 0;
+	{
+		cdtools::PerformanceProfiler perf((prefix + "_Contains").c_str());
+		for (Entity entity : shuffledEntities)
+		{
+			containsCount += storage.Contains(entity) ? 1 : 0;
+		}
+	}
+	assert(containsCount == entities.size());
+
+	{
+		cdtools::PerformanceProfiler perf((prefix + "_RandomRemove").c_str());
+		for (Entity entity : shuffledEntities)
+		{
+			storage.RemoveComponent(entity);
+		}
+	}
+	assert(0 == storage.GetCount());
+
+	// Avoid optimizing the lookups out.
+	printf("%s checksum : %f\n", prefix.c_str(), sum);
+}
+
+void Benchmark_ComponentsStorages()
+{
+	constexpr size_t entityCounts[] = { 10000, 100000, 1000000 };
+	for (size_t entityCount : entityCounts)
+	{
+		std::vector<Entity> entities(entityCount);
+		for (size_t i = 0; i < entityCount; ++i)
+		{
+			entities[i] = static_cast<Entity>(i);
+		}
+
+		std::vector<Entity> shuffledEntities = entities;
+		std::shuffle(shuffledEntities.begin(), shuffledEntities.end(), std::default_random_engine(static_cast<uint32_t>(entityCount)));
+
+		Benchmark_ComponentsStorage<MapComponentsStorage<BenchmarkComponent>>("UnorderedMap", entities, shuffledEntities);
+		Benchmark_ComponentsStorage<ComponentsStorage<BenchmarkComponent>>("SparseSet", entities, shuffledEntities);
+	}
+
+	printf("\n[Success] Benchmark_ComponentsStorages\n");
+}
+
+#define DEFINE_BENCHMARK_COMPONENT(ComponentType) \
+struct ComponentType \
+{ \
+	static constexpr StringCrc GetClassName() \
+	{ \
+		constexpr StringCrc className(#ComponentType); \
+		return className; \
+	} \
+	float data[4]; \
+}
+
+DEFINE_BENCHMARK_COMPONENT(BenchmarkPosition);
+DEFINE_BENCHMARK_COMPONENT(BenchmarkVelocity);
+DEFINE_BENCHMARK_COMPONENT(BenchmarkMass);
+DEFINE_BENCHMARK_COMPONENT(BenchmarkTag);
+
+void Test_ComponentsView()
+{
+	cdtools::PerformanceProfiler perf("Test_ComponentsView");
+
+	World world;
+	auto* pPositionStorage = world.Register<BenchmarkPosition>();
+	auto* pVelocityStorage = world.Register<BenchmarkVelocity>();
+	auto* pTagStorage = world.Register<BenchmarkTag>();
+
+	constexpr int allocateCount = 1000;
+	std::vector<Entity> entities;
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		Entity entity = world.CreateEntity();
+		pPositionStorage->CreateComponent(entity).data[0] = static_cast<float>(i);
+		if (i % 2 == 0)
+		{
+			pVelocityStorage->CreateComponent(entity).data[0] = static_cast<float>(i);
+		}
+		if (i % 3 == 0)
+		{
+			pTagStorage->CreateComponent(entity);
+		}
+		entities.push_back(entity);
+	}
+
+	// Entities without velocity are excluded. Components are referenced from storages.
+	auto view = world.View<BenchmarkPosition, BenchmarkVelocity>();
+	assert(view.GetMaxCount() == pVelocityStorage->GetCount());
+	std::set<Entity> visitedEntities;
+	for (auto [entity, position, velocity] : view)
+	{
+		assert(position.data[0] == velocity.data[0]);
+		assert(&position == pPositionStorage->GetComponent(entity));
+		velocity.data[1] = 1.0f;
+		visitedEntities.insert(entity);
+	}
+	assert(visitedEntities.size() == allocateCount / 2);
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		assert((i % 2 == 0) == (visitedEntities.count(entities[i]) > 0));
+		const BenchmarkVelocity* pVelocity = pVelocityStorage->GetComponent(entities[i]);
+		assert(!pVelocity || pVelocity->data[1] == 1.0f);
+	}
+
+	size_t taggedCount = 0;
+	world.View<BenchmarkPosition, BenchmarkVelocity, BenchmarkTag>().Each([&taggedCount](Entity, BenchmarkPosition& position, BenchmarkVelocity&, BenchmarkTag&)
+	{
+		assert(static_cast<int>(position.data[0]) % 6 == 0);
+		++taggedCount;
+	});
+	assert(taggedCount == (allocateCount + 5) / 6);
+
+	// Removing components of the current entity doesn't skip or repeat other entities.
+	visitedEntities.clear();
+	for (auto [entity, position, velocity] : world.View<BenchmarkVelocity, BenchmarkPosition>())
+	{
+		assert(visitedEntities.insert(entity).second);
+		if (static_cast<int>(position.data[0]) % 4 == 0)
+		{
+			pVelocityStorage->RemoveComponent(entity);
+			pTagStorage->RemoveComponent(entity);
+		}
+	}
+	assert(visitedEntities.size() == allocateCount / 2);
+	assert(pVelocityStorage->GetCount() == allocateCount / 4);
+
+	size_t viewCount = 0;
+	for (auto [entity, position, velocity] : world.View<BenchmarkPosition, BenchmarkVelocity>())
+	{
+		assert(static_cast<int>(position.data[0]) % 4 == 2);
+		++viewCount;
+	}
+	assert(viewCount == allocateCount / 4);
+
+	printf("\n[Success] Test_ComponentsView\n");
+}
+
+void Test_ArchetypeStorage()
+{
+	cdtools::PerformanceProfiler perf("Test_ArchetypeStorage");
+
+	World world;
+	world.EnableArchetypeStorage();
+	auto* pPositionStorage = world.Register<BenchmarkPosition>();
+	auto* pVelocityStorage = world.Register<BenchmarkVelocity>();
+
+	constexpr int allocateCount = 10000;
+	std::vector<Entity> entities;
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		Entity entity = world.CreateEntity();
+		pPositionStorage->CreateComponent(entity).data[0] = static_cast<float>(i);
+		if (i % 2 == 0)
+		{
+			pVelocityStorage->CreateComponent(entity).data[0] = static_cast<float>(i);
+		}
+		entities.push_back(entity);
+	}
+
+	// Moving entities between archetypes should keep component values.
+	for (int i = 0; i < allocateCount; i += 4)
+	{
+		pVelocityStorage->RemoveComponent(entities[i]);
+	}
+
+	for (int i = 0; i < allocateCount; ++i)
+	{
+		assert(pPositionStorage->GetComponent(entities[i])->data[0] == static_cast<float>(i));
+		const BenchmarkVelocity* pVelocity = pVelocityStorage->GetComponent(entities[i]);
+		assert((i % 4 == 2) == (pVelocity != nullptr));
+		assert(!pVelocity || pVelocity->data[0] == static_cast<float>(i));
+	}
+
+	size_t viewCount = 0;
+	for (auto [entity, position, velocity] : world.View<BenchmarkPosition, BenchmarkVelocity>())
+	{
+		assert(position.data[0] == velocity.data[0]);
+		++viewCount;
+	}
+	assert(viewCount == allocateCount / 4);
+	assert(pVelocityStorage->GetCount() == allocateCount / 4);
+
+	printf("\n[Success] Test_ArchetypeStorage\n");
+}
+
+template<typename Func>
+void Benchmark_BuildWorld(World& world, size_t entityCount, Func&& func)
+{
+	auto* pPositionStorage = world.Register<BenchmarkPosition>();
+	auto* pVelocityStorage = world.Register<BenchmarkVelocity>();
+	auto* pMassStorage = world.Register<BenchmarkMass>();
+	auto* pTagStorage = world.Register<BenchmarkTag>();
+
+	for (size_t i = 0; i < entityCount; ++i)
+	{
+		Entity entity = world.CreateEntity();
+		pPositionStorage->CreateComponent(entity);
+		pVelocityStorage->CreateComponent(entity).data[0] = 1.0f;
+		pMassStorage->CreateComponent(entity).data[0] = 2.0f;
+
+		// Split entities into different archetypes.
+		if (i % 3 == 0)
+		{
+			pTagStorage->CreateComponent(entity);
+		}
+	}
+
+	func();
+}
+
+void Benchmark_ArchetypeStorage()
+{
+	constexpr size_t entityCounts[] = { 10000, 100000, 1000000 };
+	constexpr int frameCount = 10;
+	for (size_t entityCount : entityCounts)
+	{
+		std::string prefix = std::to_string(entityCount);
+
+		float sparseSetSum = 0.0f;
+		World sparseSetWorld;
+		Benchmark_BuildWorld(sparseSetWorld, entityCount, [&]()
+		{
+			cdtools::PerformanceProfiler perf(("SparseSetView_" + prefix).c_str());
+			auto view = sparseSetWorld.View<BenchmarkPosition, BenchmarkVelocity, BenchmarkMass>();
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				for (auto [entity, position, velocity, mass] : view)
+				{
+					position.data[0] += velocity.data[0] * mass.data[0];
+				}
+			}
+			sparseSetSum = sparseSetWorld.GetComponents<BenchmarkPosition>()->GetComponents().back().data[0];
+		});
+
+		float archetypeSum = 0.0f;
+		World archetypeWorld;
+		archetypeWorld.EnableArchetypeStorage();
+		Benchmark_BuildWorld(archetypeWorld, entityCount, [&]()
+		{
+			cdtools::PerformanceProfiler perf(("ArchetypeChunk_" + prefix).c_str());
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				archetypeWorld.GetArchetypeStorage()->ForEachChunk<BenchmarkPosition, BenchmarkVelocity, BenchmarkMass>(
+					[](uint32_t rowCount, const Entity*, BenchmarkPosition* pPositions, BenchmarkVelocity* pVelocities, BenchmarkMass* pMasses)
+				{
+					for (uint32_t row = 0; row < rowCount; ++row)
+					{
+						pPositions[row].data[0] += pVelocities[row].data[0] * pMasses[row].data[0];
+					}
+				});
+			}
+			archetypeSum = archetypeWorld.GetComponents<BenchmarkPosition>()->GetComponent(archetypeWorld.GetComponents<BenchmarkPosition>()->GetEntities().back())->data[0];
+		});
+
+		assert(sparseSetSum == archetypeSum);
+		printf("%s checksum : %f %f\n", prefix.c_str(), sparseSetSum, archetypeSum);
+	}
+
+	printf("\n[Success] Benchmark_ArchetypeStorage\n");
+}
+
+// Build a tree : one root, childCount children and grandChildCount children per child.
+std::vector<Entity> Test_BuildHierarchy(World& world, size_t childCount, size_t grandChildCount)
+{
+	auto* pTransformStorage = world.GetComponents<TransformComponent>();
+	auto* pHierarchyStorage = world.GetComponents<HierarchyComponent>();
+
+	std::vector<Entity> entities;
+	Entity rootEntity = world.CreateEntity();
+	pTransformStorage->CreateComponent(rootEntity).SetTransform(cd::Transform(cd::Vec3f(1.0f, 2.0f, 3.0f),
+		cd::Quaternion::Identity(), cd::Vec3f::One()));
+	entities.push_back(rootEntity);
+
+	for (size_t childIndex = 0; childIndex < childCount; ++childIndex)
+	{
+		Entity childEntity = world.CreateEntity();
+		pTransformStorage->CreateComponent(childEntity).SetTransform(cd::Transform(cd::Vec3f(static_cast<float>(childIndex), 0.0f, 0.0f),
+			cd::Quaternion::Identity(), cd::Vec3f(2.0f, 2.0f, 2.0f)));
+		pHierarchyStorage->CreateComponent(childEntity).SetParentEntity(rootEntity);
+		entities.push_back(childEntity);
+
+		for (size_t grandChildIndex = 0; grandChildIndex < grandChildCount; ++grandChildIndex)
+		{
+			Entity grandChildEntity = world.CreateEntity();
+			pTransformStorage->CreateComponent(grandChildEntity).SetTransform(cd::Transform(cd::Vec3f(0.0f, static_cast<float>(grandChildIndex), 0.0f),
+				cd::Quaternion::Identity(), cd::Vec3f::One()));
+			pHierarchyStorage->CreateComponent(grandChildEntity).SetParentEntity(childEntity);
+			entities.push_back(grandChildEntity);
+		}
+	}
+
+	return entities;
+}
+
+void Test_CheckWorldMatrices(World& world, const std::vector<Entity>& entities)
+{
+	auto* pTransformStorage = world.GetComponents<TransformComponent>();
+	auto* pHierarchyStorage = world.GetComponents<HierarchyComponent>();
+	for (Entity entity : entities)
+	{
+		cd::Matrix4x4 expected = pTransformStorage->GetComponent(entity)->GetTransform().GetMatrix();
+		const HierarchyComponent* pHierarchyComponent = pHierarchyStorage->GetComponent(entity);
+		while (pHierarchyComponent)
+		{
+			Entity parentEntity = pHierarchyComponent->GetParentEntity();
+			expected = pTransformStorage->GetComponent(parentEntity)->GetTransform().GetMatrix() * expected;
+			pHierarchyComponent = pHierarchyStorage->GetComponent(parentEntity);
+		}
+
+		const cd::Matrix4x4& actual = pTransformStorage->GetComponent(entity)->GetWorldMatrix();
+		for (int index = 0; index < 16; ++index)
+		{
+			assert(std::abs(actual.begin()[index] - expected.begin()[index]) < 0.001f);
+		}
+	}
+}
+
+void Test_TransformSystem()
+{
+	cdtools::PerformanceProfiler perf("Test_TransformSystem");
+
+	World world;
+	auto* pTransformStorage = world.Register<TransformComponent>();
+	world.Register<HierarchyComponent>();
+	std::vector<Entity> entities = Test_BuildHierarchy(world, 10, 10);
+
+	TransformSystem transformSystem(&world);
+	transformSystem.Update();
+	assert(entities.size() == transformSystem.GetNodeCount());
+	assert(3 == transformSystem.GetLevelCount());
+	assert(entities.size() == transformSystem.GetUpdatedNodeCount());
+	Test_CheckWorldMatrices(world, entities);
+
+	// Nothing is dirty.
+	transformSystem.Update();
+	assert(0 == transformSystem.GetUpdatedNodeCount());
+
+	// Moving one child only updates its subtree.
+	Entity childEntity = entities[1];
+	pTransformStorage->GetComponent(childEntity)->GetTransform().SetTranslation(cd::Vec3f(5.0f, 5.0f, 5.0f));
+	pTransformStorage->GetComponent(childEntity)->Dirty();
+	transformSystem.Update();
+	assert(11 == transformSystem.GetUpdatedNodeCount());
+	Test_CheckWorldMatrices(world, entities);
+
+	// Moving root updates all nodes.
+	pTransformStorage->GetComponent(entities[0])->SetTransform(cd::Transform(cd::Vec3f(-1.0f, 0.0f, 0.0f),
+		cd::Quaternion::FromAxisAngle(cd::Vec3f(0.0f, 1.0f, 0.0f), 0.5f), cd::Vec3f::One()));
+	transformSystem.Update();
+	assert(entities.size() == transformSystem.GetUpdatedNodeCount());
+	Test_CheckWorldMatrices(world, entities);
+
+	// Removing an entity is detected by storage count.
+	world.DeleteEntity(entities.back());
+	entities.pop_back();
+	transformSystem.Update();
+	assert(entities.size() == transformSystem.GetNodeCount());
+	Test_CheckWorldMatrices(world, entities);
+
+	printf("\n[Success] Test_TransformSystem\n");
+}
+
+void Test_ArchetypeSceneSetup()
+{
+	cdtools::PerformanceProfiler perf("Test_ArchetypeSceneSetup");
+
+	World world;
+	world.EnableArchetypeStorage();
+	auto* pTransformStorage = world.Register<TransformComponent>();
+	world.Register<HierarchyComponent>();
+	auto* pLightStorage = world.Register<LightComponent>();
+
+	// Scene setup finishes a component before adding the next one to the same entity.
+	std::vector<Entity> lightEntities;
+	for (int index = 0; index < 100; ++index)
+	{
+		Entity entity = world.CreateEntity();
+		auto& transformComponent = world.CreateComponent<TransformComponent>(entity);
+		transformComponent.SetTransform(cd::Transform(cd::Vec3f(static_cast<float>(index), 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()));
+		transformComponent.Build();
+
+		auto& lightComponent = world.CreateComponent<LightComponent>(entity);
+		lightComponent.SetIntensity(static_cast<float>(index));
+		lightEntities.push_back(entity);
+	}
+
+	// Removing lights moves entities between archetypes and fills holes by rows of other entities.
+	for (size_t index = 0; index < lightEntities.size(); index += 2)
+	{
+		pLightStorage->RemoveComponent(lightEntities[index]);
+	}
+
+	for (size_t index = 0; index < lightEntities.size(); ++index)
+	{
+		Entity entity = lightEntities[index];
+		assert(pTransformStorage->GetComponent(entity)->GetTransform().GetTranslation().x() == static_cast<float>(index));
+		const LightComponent* pLightComponent = pLightStorage->GetComponent(entity);
+		assert((index % 2 == 1) == (pLightComponent != nullptr));
+		assert(!pLightComponent || pLightComponent->GetIntensity() == static_cast<float>(index));
+	}
+
+	// Systems look up components by entity so that they work in archetype storage mode.
+	std::vector<Entity> entities = Test_BuildHierarchy(world, 10, 10);
+	TransformSystem transformSystem(&world);
+	transformSystem.Update();
+	Test_CheckWorldMatrices(world, entities);
+
+	world.DeleteEntity(entities.back());
+	entities.pop_back();
+	pTransformStorage->GetComponent(entities[0])->SetTransform(cd::Transform(cd::Vec3f(-1.0f, 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()));
+	transformSystem.Update();
+	Test_CheckWorldMatrices(world, entities);
+
+	printf("\n[Success] Test_ArchetypeSceneSetup\n");
+}
+
+void Benchmark_TransformSystem()
+{
+	World world;
+	auto* pTransformStorage = world.Register<TransformComponent>();
+	world.Register<HierarchyComponent>();
+	std::vector<Entity> entities = Test_BuildHierarchy(world, 50, 1000);
+
+	ThreadPool threadPool;
+	TransformSystem transformSystem(&world);
+	{
+		cdtools::PerformanceProfiler perf("TransformSystem_Rebuild_50K");
+		transformSystem.Update(&threadPool);
+	}
+
+	constexpr int frameCount = 100;
+	{
+		cdtools::PerformanceProfiler perf("TransformSystem_Clean_50K_100Frames");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			transformSystem.Update(&threadPool);
+		}
+	}
+
+	TransformComponent* pRootTransformComponent = pTransformStorage->GetComponent(entities[0]);
+	{
+		cdtools::PerformanceProfiler perf("TransformSystem_MoveRoot_50K_100Frames");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			pRootTransformComponent->GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(frame), 0.0f, 0.0f));
+			pRootTransformComponent->Dirty();
+			transformSystem.Update(&threadPool);
+		}
+	}
+	assert(entities.size() == transformSystem.GetUpdatedNodeCount());
+	Test_CheckWorldMatrices(world, entities);
+
+	{
+		cdtools::PerformanceProfiler perf("TransformSystem_MoveRoot_50K_100Frames_SingleThread");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			pRootTransformComponent->GetTransform().SetTranslation(cd::Vec3f(static_cast<float>(frame), 0.0f, 0.0f));
+			pRootTransformComponent->Dirty();
+			transformSystem.Update();
+		}
+	}
+
+	printf("\n[Success] Benchmark_TransformSystem\n");
+}
+
+Entity Test_CreateCullingEntity(World& world, const cd::Transform& transform, bool hasBounds)
+{
+	Entity entity = world.CreateEntity();
+	world.CreateComponent<TransformComponent>(entity).SetWorldMatrix(transform.GetMatrix());
+	if (hasBounds)
+	{
+		world.CreateComponent<CollisionMeshComponent>(entity).SetAABB(cd::AABB(cd::Point(-0.5f), cd::Point(0.5f)));
+	}
+	return entity;
+}
+
+// Orthographic view projection which maps [-halfSize, halfSize] box around center to clip space.
+cd::Matrix4x4 Test_BoxViewProjection(const cd::Vec3f& center, float halfSize)
+{
+	cd::Matrix4x4 viewProjection = cd::Matrix4x4::Identity();
+	float scale = 1.0f / halfSize;
+	viewProjection.begin()[0] = viewProjection.begin()[5] = viewProjection.begin()[10] = scale;
+	viewProjection.begin()[12] = -center.x() * scale;
+	viewProjection.begin()[13] = -center.y() * scale;
+	viewProjection.begin()[14] = -center.z() * scale;
+	return viewProjection;
+}
+
+void Test_CullingSystem()
+{
+	cdtools::PerformanceProfiler perf("Test_CullingSystem");
+
+	World world;
+	world.Register<TransformComponent>();
+	world.Register<CollisionMeshComponent>();
+
+	const cd::Vec3f axisY(0.0f, 1.0f, 0.0f);
+	const cd::Vec3f axisZ(0.0f, 0.0f, 1.0f);
+	const float quarterPi = 0.7853982f;
+	Entity unboundedEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(100.0f, 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), false);
+	Entity insideEntity = Test_CreateCullingEntity(world, cd::Transform::Identity(), true);
+	Entity outsideEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(20.0f, 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	Entity crossingEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(10.4f, 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	Entity scaledEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(12.0f, 0.0f, 0.0f), cd::Quaternion::Identity(), cd::Vec3f(5.0f, 1.0f, 1.0f)), true);
+	Entity rotatedOutsideEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(12.0f, 0.0f, 0.0f),
+		cd::Quaternion::FromAxisAngle(axisY, quarterPi), cd::Vec3f::One()), true);
+	Entity rotatedCrossingEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(10.6f, 0.0f, 0.0f),
+		cd::Quaternion::FromAxisAngle(axisZ, quarterPi), cd::Vec3f::One()), true);
+
+	CullingSystem cullingSystem(&world);
+	CullingSystem::ViewIndex mainView = cullingSystem.AddView(Test_BoxViewProjection(cd::Vec3f::Zero(), 10.0f));
+	CullingSystem::ViewIndex farView = cullingSystem.AddView(Test_BoxViewProjection(cd::Vec3f(100.0f, 0.0f, 0.0f), 10.0f));
+	assert(CullingSystem::MainCameraView == mainView);
+	cullingSystem.Update();
+	assert(7 == cullingSystem.GetCandidateCount());
+	assert(6 == cullingSystem.GetBoundedCount());
+
+	// Bounded entities come first and unbounded ones are always visible.
+	const std::vector<Entity>& mainVisibleEntities = cullingSystem.GetVisibleEntities(mainView);
+	std::set<Entity> mainVisibleSet(mainVisibleEntities.begin(), mainVisibleEntities.end());
+	assert(5 == mainVisibleEntities.size());
+	assert(unboundedEntity == mainVisibleEntities.back());
+	assert(mainVisibleSet.count(insideEntity) && mainVisibleSet.count(crossingEntity) && mainVisibleSet.count(scaledEntity) &&
+		mainVisibleSet.count(rotatedCrossingEntity));
+	assert(!mainVisibleSet.count(outsideEntity) && !mainVisibleSet.count(rotatedOutsideEntity));
+
+	const std::vector<Entity>& farVisibleEntities = cullingSystem.GetVisibleEntities(farView);
+	assert(1 == farVisibleEntities.size() && unboundedEntity == farVisibleEntities[0]);
+
+	// Random boxes without rotation are compared with exact interval tests.
+	std::mt19937 randomEngine(7);
+	std::uniform_real_distribution<float> positionDistribution(-30.0f, 30.0f);
+	std::uniform_real_distribution<float> scaleDistribution(0.1f, 4.0f);
+	for (int index = 0; index < 1000; ++index)
+	{
+		cd::Vec3f position(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+		cd::Vec3f scale(scaleDistribution(randomEngine), scaleDistribution(randomEngine), scaleDistribution(randomEngine));
+		Test_CreateCullingEntity(world, cd::Transform(position, cd::Quaternion::Identity(), scale), true);
+	}
+
+	ThreadPool threadPool(4U);
+	cullingSystem.Update(&threadPool);
+
+	std::vector<Entity> visibleEntities;
+	cullingSystem.CullView(Test_BoxViewProjection(cd::Vec3f(5.0f, -5.0f, 0.0f), 15.0f), visibleEntities);
+	std::set<Entity> visibleSet(visibleEntities.begin(), visibleEntities.end());
+	for (Entity entity : world.GetComponents<CollisionMeshComponent>()->GetEntities())
+	{
+		const float* pWorldMatrix = world.GetComponents<TransformComponent>()->GetComponent(entity)->GetWorldMatrix().begin();
+		const float viewCenter[3] = { 5.0f, -5.0f, 0.0f };
+		bool isOverlapped = true;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float extent = 0.5f * std::abs(pWorldMatrix[axis * 5]);
+			float distance = std::abs(pWorldMatrix[12 + axis] - viewCenter[axis]);
+			isOverlapped &= distance <= 15.0f + extent;
+		}
+		assert(isOverlapped == (visibleSet.count(entity) > 0));
+	}
+
+	// Entities without a TransformComponent are placed at the origin.
+	Entity untransformedEntity = world.CreateEntity();
+	world.CreateComponent<CollisionMeshComponent>(untransformedEntity).SetAABB(cd::AABB(cd::Point(-0.5f), cd::Point(0.5f)));
+	cullingSystem.Update();
+	const std::vector<Entity>& untransformedMainEntities = cullingSystem.GetVisibleEntities(mainView);
+	const std::vector<Entity>& untransformedFarEntities = cullingSystem.GetVisibleEntities(farView);
+	assert(std::find(untransformedMainEntities.begin(), untransformedMainEntities.end(), untransformedEntity) != untransformedMainEntities.end());
+	assert(std::find(untransformedFarEntities.begin(), untransformedFarEntities.end(), untransformedEntity) == untransformedFarEntities.end());
+
+	printf("\n[Success] Test_CullingSystem\n");
+}
+
+void Test_OcclusionCulling()
+{
+	cdtools::PerformanceProfiler perf("Test_OcclusionCulling");
+
+	World world;
+	world.Register<TransformComponent>();
+	world.Register<CollisionMeshComponent>();
+
+	// View looks along +z. A 16x16 wall hides boxes behind it from the view.
+	const std::vector<cd::Point> wallPositions = { cd::Point(-0.5f, -0.5f, 0.0f), cd::Point(0.5f, -0.5f, 0.0f), cd::Point(0.5f, 0.5f, 0.0f), cd::Point(-0.5f, 0.5f, 0.0f) };
+	const std::vector<uint32_t> wallIndices = { 0U, 1U, 2U, 0U, 2U, 3U };
+	Entity wallEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(0.0f, 0.0f, 2.0f), cd::Quaternion::Identity(), cd::Vec3f(16.0f, 16.0f, 1.0f)), true);
+	Entity behindEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(0.0f, 0.0f, 7.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	Entity besideEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(9.0f, 0.0f, 7.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	Entity frontEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(0.0f, 0.0f, 0.5f), cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	Entity unboundedEntity = Test_CreateCullingEntity(world, cd::Transform(cd::Vec3f(0.0f, 0.0f, 5.0f), cd::Quaternion::Identity(), cd::Vec3f::One()), false);
+
+	CullingSystem cullingSystem(&world);
+	CullingSystem::ViewIndex occlusionView = cullingSystem.AddView(Test_BoxViewProjection(cd::Vec3f::Zero(), 10.0f), true);
+	CullingSystem::ViewIndex frustumView = cullingSystem.AddView(Test_BoxViewProjection(cd::Vec3f::Zero(), 10.0f));
+	cullingSystem.AddOccluder(wallEntity, wallPositions, wallIndices);
+	cullingSystem.Update();
+	assert(1 == cullingSystem.GetOccluderCount());
+
+	const std::vector<Entity>& occlusionVisibleEntities = cullingSystem.GetVisibleEntities(occlusionView);
+	std::set<Entity> occlusionVisibleSet(occlusionVisibleEntities.begin(), occlusionVisibleEntities.end());
+	assert(4 == occlusionVisibleEntities.size());
+	assert(occlusionVisibleSet.count(wallEntity) && occlusionVisibleSet.count(besideEntity) && occlusionVisibleSet.count(frontEntity) &&
+		occlusionVisibleSet.count(unboundedEntity));
+	assert(0 == occlusionVisibleSet.count(behindEntity));
+	const std::vector<Entity>& frustumVisibleEntities = cullingSystem.GetVisibleEntities(frustumView);
+	assert(5 == frustumVisibleEntities.size());
+	assert(std::find(frustumVisibleEntities.begin(), frustumVisibleEntities.end(), behindEntity) != frustumVisibleEntities.end());
+
+	// Occluders without bounds are dropped.
+	Entity unboundedOccluderEntity = Test_CreateCullingEntity(world, cd::Transform::Identity(), false);
+	cullingSystem.ClearOccluders();
+	cullingSystem.AddOccluder(unboundedOccluderEntity, wallPositions, wallIndices);
+	cullingSystem.Update();
+	assert(0 == cullingSystem.GetOccluderCount());
+	assert(6 == cullingSystem.GetVisibleEntities(occlusionView).size());
+
+	printf("\n[Success] Test_OcclusionCulling\n");
+}
+
+void Benchmark_CullingSystem()
+{
+	World world;
+	world.Register<TransformComponent>();
+	world.Register<CollisionMeshComponent>();
+
+	std::mt19937 randomEngine(11);
+	std::uniform_real_distribution<float> positionDistribution(-1000.0f, 1000.0f);
+	for (int index = 0; index < 100000; ++index)
+	{
+		cd::Vec3f position(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine));
+		Test_CreateCullingEntity(world, cd::Transform(position, cd::Quaternion::Identity(), cd::Vec3f::One()), true);
+	}
+
+	ThreadPool threadPool;
+	CullingSystem cullingSystem(&world);
+	for (int viewIndex = 0; viewIndex < 5; ++viewIndex)
+	{
+		cullingSystem.AddView(Test_BoxViewProjection(cd::Vec3f(viewIndex * 100.0f, 0.0f, 0.0f), 300.0f));
+	}
+
+	constexpr int frameCount = 100;
+	{
+		cdtools::PerformanceProfiler perf("CullingSystem_100K_5Views_100Frames");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			cullingSystem.Update(&threadPool);
+		}
+	}
+
+	std::vector<Entity> visibleEntities;
+	{
+		cdtools::PerformanceProfiler perf("CullingSystem_CullView_100K_100Frames");
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			cullingSystem.CullView(Test_BoxViewProjection(cd::Vec3f::Zero(), 300.0f), visibleEntities);
+		}
+	}
+	printf("Visible : %zu / %zu\n", visibleEntities.size(), cullingSystem.GetCandidateCount());
+
+	printf("\n[Success] Benchmark_CullingSystem\n");
+}
+
 }
 
 int main()
 {
 	Test_CreateEntity();
+	Test_RecycleEntity();
+	Test_EntityCommandBuffer();
+	Test_EntityCommandBufferOrder();
 
 	World world;
 	Factory factory = Test_RegisterComponentStorages(world);
@@ -196,5 +1183,19 @@ int main()
 	Test_RemoveEntityComponentsRandly(factory, meshEntites);
 	Test_RemoveEntityComponentsByOrder(factory, meshEntites);
 
+	Benchmark_ComponentsStorages();
+
+	Test_ComponentsView();
+	Test_ArchetypeStorage();
+	Benchmark_ArchetypeStorage();
+
+	Test_TransformSystem();
+	Test_ArchetypeSceneSetup();
+	Benchmark_TransformSystem();
+
+	Test_CullingSystem();
+	Test_OcclusionCulling();
+	Benchmark_CullingSystem();
+
 	return 0;
 }
\ No newline at end of file
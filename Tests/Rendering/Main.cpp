@@ -0,0 +1,1257 @@
+#include "Rendering/LightClusters.h"
+#include "Rendering/MeshLOD.h"
+#include "Rendering/MeshOptimizer.h"
+#include "Rendering/OcclusionBuffer.h"
+#include "Rendering/OffsetAllocator.h"
+#include "Rendering/RenderGraph.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/ShadowAtlas.h"
+#include "Rendering/ShadowCache.h"
+#include "Rendering/VertexQuantization.h"
+#include "Scene/Mesh.h"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+void Test_RenderQueueKey()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueueKey");
+
+	uint64_t nearKey = RenderQueue::MakeOpaqueKey(3U, 7U, 100U, 20U, 0.1f);
+	uint64_t farKey = RenderQueue::MakeOpaqueKey(3U, 7U, 100U, 20U, 0.9f);
+	uint64_t otherProgramKey = RenderQueue::MakeOpaqueKey(3U, 8U, 0U, 0U, 0.0f);
+	uint64_t translucentNearKey = RenderQueue::MakeTranslucentKey(3U, 1U, 1U, 1U, 0.1f);
+	uint64_t translucentFarKey = RenderQueue::MakeTranslucentKey(3U, 1U, 1U, 1U, 0.9f);
+	uint64_t nextViewKey = RenderQueue::MakeOpaqueKey(4U, 0U, 0U, 0U, 0.0f);
+
+	// Opaque : state first and then front to back.
+	assert(nearKey < farKey);
+	assert(farKey < otherProgramKey);
+
+	// Translucent after opaque, back to front.
+	assert(otherProgramKey < translucentFarKey);
+	assert(translucentFarKey < translucentNearKey);
+	assert(RenderQueue::IsTranslucentKey(translucentNearKey) && !RenderQueue::IsTranslucentKey(farKey));
+
+	// View has the highest priority.
+	assert(translucentNearKey < nextViewKey);
+	assert(3U == RenderQueue::GetViewID(translucentNearKey) && 4U == RenderQueue::GetViewID(nextViewKey));
+
+	// Out of range depth is clamped.
+	assert(RenderQueue::MakeOpaqueKey(0U, 0U, 0U, 0U, -1.0f) == RenderQueue::MakeOpaqueKey(0U, 0U, 0U, 0U, 0.0f));
+	assert(RenderQueue::MakeOpaqueKey(0U, 0U, 0U, 0U, 2.0f) == RenderQueue::MakeOpaqueKey(0U, 0U, 0U, 0U, 1.0f));
+
+	printf("\n[Success] Test_RenderQueueKey\n");
+}
+
+void Test_RenderQueueSort()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueueSort");
+
+	std::mt19937 random(42U);
+	std::uniform_int_distribution<uint32_t> smallDistribution(0U, 15U);
+
+	RenderQueue renderQueue;
+	renderQueue.Sort();
+	assert(renderQueue.IsEmpty());
+
+	constexpr uint32_t packetCount = 5000U;
+	std::vector<RenderQueue::DrawPacket> expectedPackets;
+	for (uint32_t packetIndex = 0U; packetIndex < packetCount; ++packetIndex)
+	{
+		uint16_t programKey = static_cast<uint16_t>(smallDistribution(random));
+		uint16_t materialKey = static_cast<uint16_t>(smallDistribution(random));
+		uint16_t meshKey = static_cast<uint16_t>(smallDistribution(random));
+
+		// Few depth values so that equal keys exist and stability is tested.
+		float depth = static_cast<float>(smallDistribution(random) % 4U) / 4.0f;
+		uint64_t key = 0 == packetIndex % 3 ? RenderQueue::MakeTranslucentKey(2U, programKey, materialKey, meshKey, depth) :
+			RenderQueue::MakeOpaqueKey(2U, programKey, materialKey, meshKey, depth);
+		renderQueue.Push(key, packetIndex);
+		expectedPackets.push_back(RenderQueue::DrawPacket{ key, packetIndex });
+	}
+	assert(packetCount == renderQueue.GetCount());
+
+	renderQueue.Sort();
+	std::stable_sort(expectedPackets.begin(), expectedPackets.end(),
+		[](const RenderQueue::DrawPacket& lhs, const RenderQueue::DrawPacket& rhs) { return lhs.key < rhs.key; });
+
+	const std::vector<RenderQueue::DrawPacket>& sortedPackets = renderQueue.GetPackets();
+	for (uint32_t packetIndex = 0U; packetIndex < packetCount; ++packetIndex)
+	{
+		assert(sortedPackets[packetIndex].key == expectedPackets[packetIndex].key);
+		assert(sortedPackets[packetIndex].payload == expectedPackets[packetIndex].payload);
+	}
+
+	// Bytes of view and unused key bits are the same for all packets so that their passes are skipped.
+	assert(renderQueue.GetLastSortPassCount() < 8U);
+
+	renderQueue.Clear();
+	assert(renderQueue.IsEmpty());
+
+	printf("\n[Success] Test_RenderQueueSort\n");
+}
+
+void Test_RenderQueueGroup()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueueGroup");
+
+	// Payload indexes mesh IDs. Draws of the same mesh can be drawn as instances except mesh 3 which is skinned.
+	const std::vector<uint32_t> meshIDs = { 1U, 1U, 2U, 1U, 1U, 2U, 3U, 3U, 1U, 1U, 1U };
+	RenderQueue renderQueue;
+	for (uint32_t payload = 0U; payload < 8U; ++payload)
+	{
+		uint16_t meshKey = static_cast<uint16_t>(meshIDs[payload]);
+		renderQueue.Push(RenderQueue::MakeOpaqueKey(0U, 1U, 1U, meshKey, static_cast<float>(payload) / 8.0f), payload);
+	}
+	for (uint32_t payload = 8U; payload < 11U; ++payload)
+	{
+		renderQueue.Push(RenderQueue::MakeTranslucentKey(0U, 1U, 1U, 1U, static_cast<float>(payload) / 16.0f), payload);
+	}
+	renderQueue.Sort();
+
+	auto CanGroup = [&meshIDs](const RenderQueue::DrawPacket& firstPacket, const RenderQueue::DrawPacket& packet)
+	{
+		return meshIDs[packet.payload] == meshIDs[firstPacket.payload] && meshIDs[packet.payload] != 3U;
+	};
+
+	std::vector<size_t> groupSizes;
+	for (size_t packetIndex = 0; packetIndex < renderQueue.GetCount();)
+	{
+		size_t endIndex = renderQueue.GetGroupEnd(packetIndex, CanGroup);
+		assert(endIndex > packetIndex && endIndex <= renderQueue.GetCount());
+		groupSizes.push_back(endIndex - packetIndex);
+		packetIndex = endIndex;
+	}
+
+	// Sorted by mesh : 4 draws of mesh 1, 2 draws of mesh 2, mesh 3 one by one, and translucent draws one by one.
+	const std::vector<size_t> expectedGroupSizes = { 4U, 2U, 1U, 1U, 1U, 1U, 1U };
+	assert(expectedGroupSizes == groupSizes);
+
+	printf("\n[Success] Test_RenderQueueGroup\n");
+}
+
+void Test_RenderQueueSplitChunks()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderQueueSplitChunks");
+
+	// Group sizes at first packets : [0, 4) [4, 5) [5, 12) [12, 13) ... [19, 20). Sizes inside groups are never read.
+	std::vector<uint32_t> groupSizes(20U, 1U);
+	groupSizes[0] = 4U;
+	groupSizes[5] = 7U;
+
+	auto IsGroupStart = [&groupSizes](size_t packetIndex)
+	{
+		for (size_t groupStart = 0; groupStart < groupSizes.size(); groupStart += groupSizes[groupStart])
+		{
+			if (groupStart == packetIndex)
+			{
+				return true;
+			}
+		}
+		return packetIndex == groupSizes.size();
+	};
+
+	std::vector<size_t> chunkEnds;
+	for (size_t maxChunkCount = 1; maxChunkCount <= 8; ++maxChunkCount)
+	{
+		RenderQueue::SplitChunks(groupSizes, maxChunkCount, 1, chunkEnds);
+		assert(!chunkEnds.empty() && chunkEnds.size() <= maxChunkCount);
+		assert(groupSizes.size() == chunkEnds.back());
+		for (size_t chunkIndex = 0; chunkIndex < chunkEnds.size(); ++chunkIndex)
+		{
+			assert(0 == chunkIndex || chunkEnds[chunkIndex - 1] < chunkEnds[chunkIndex]);
+			assert(IsGroupStart(chunkEnds[chunkIndex]));
+		}
+	}
+
+	// Boundaries of 4 chunks are at 5, 10 and 15. The second one moves to the end of the large group.
+	RenderQueue::SplitChunks(groupSizes, 4, 1, chunkEnds);
+	const std::vector<size_t> expectedChunkEnds = { 5U, 12U, 15U, 20U };
+	assert(expectedChunkEnds == chunkEnds);
+
+	// Small queues stay in one chunk so that view constants are not bound by every encoder.
+	RenderQueue::SplitChunks(groupSizes, 4, 8, chunkEnds);
+	assert(2U == chunkEnds.size());
+	RenderQueue::SplitChunks(groupSizes, 4, 64, chunkEnds);
+	assert(1U == chunkEnds.size() && 20U == chunkEnds[0]);
+
+	RenderQueue::SplitChunks({}, 4, 1, chunkEnds);
+	assert(chunkEnds.empty());
+
+	printf("\n[Success] Test_RenderQueueSplitChunks\n");
+}
+
+void Benchmark_RenderQueueSort()
+{
+	constexpr uint32_t packetCount = 100000U;
+	std::mt19937 random(7U);
+	std::uniform_int_distribution<uint32_t> keyDistribution(0U, 1023U);
+	std::uniform_real_distribution<float> depthDistribution(0.0f, 1.0f);
+
+	RenderQueue renderQueue;
+	std::vector<uint64_t> keys;
+	for (uint32_t packetIndex = 0U; packetIndex < packetCount; ++packetIndex)
+	{
+		keys.push_back(RenderQueue::MakeOpaqueKey(0U, static_cast<uint16_t>(keyDistribution(random)), static_cast<uint16_t>(keyDistribution(random)),
+			static_cast<uint16_t>(keyDistribution(random)), depthDistribution(random)));
+	}
+
+	{
+		cdtools::PerformanceProfiler perf("Benchmark_RenderQueueSort_Radix");
+		for (uint32_t packetIndex = 0U; packetIndex < packetCount; ++packetIndex)
+		{
+			renderQueue.Push(keys[packetIndex], packetIndex);
+		}
+		renderQueue.Sort();
+	}
+
+	{
+		cdtools::PerformanceProfiler perf("Benchmark_RenderQueueSort_Std");
+		std::vector<RenderQueue::DrawPacket> packets;
+		for (uint32_t packetIndex = 0U; packetIndex < packetCount; ++packetIndex)
+		{
+			packets.push_back(RenderQueue::DrawPacket{ keys[packetIndex], packetIndex });
+		}
+		std::stable_sort(packets.begin(), packets.end(),
+			[](const RenderQueue::DrawPacket& lhs, const RenderQueue::DrawPacket& rhs) { return lhs.key < rhs.key; });
+	}
+
+	printf("\n[Success] Benchmark_RenderQueueSort\n");
+}
+
+void Test_RenderGraphCulling()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderGraphCulling");
+
+	RenderGraph renderGraph;
+	RenderGraph::ResourceID sceneTarget = renderGraph.ImportResource(StringCrc("SceneTarget"), true);
+	RenderGraph::ResourceID shadowMaps = renderGraph.ImportResource(StringCrc("ShadowMaps"));
+	RenderGraph::ResourceID unusedTexture = renderGraph.CreateTexture(StringCrc("Unused"), RenderGraphTextureDesc{ 64U, 64U, 1U, 0U });
+	assert(shadowMaps == renderGraph.ImportResource(StringCrc("ShadowMaps")));
+
+	RenderGraph::PassID shadowPass = renderGraph.AddPass("Shadow");
+	renderGraph.Write(shadowPass, shadowMaps);
+
+	RenderGraph::PassID unusedPass = renderGraph.AddPass("Unused");
+	renderGraph.Read(unusedPass, sceneTarget);
+	renderGraph.Write(unusedPass, unusedTexture);
+
+	RenderGraph::PassID worldPass = renderGraph.AddPass("World");
+	renderGraph.Read(worldPass, shadowMaps);
+	renderGraph.Write(worldPass, sceneTarget);
+
+	RenderGraph::PassID disabledPass = renderGraph.AddPass("Disabled", false);
+	renderGraph.Write(disabledPass, sceneTarget);
+
+	renderGraph.Compile();
+	assert(renderGraph.IsPassActive(shadowPass) && renderGraph.IsPassActive(worldPass));
+	assert(!renderGraph.IsPassActive(unusedPass) && !renderGraph.IsPassActive(disabledPass));
+	assert(2U == renderGraph.GetActivePassCount());
+
+	// Transient texture of a culled pass is not allocated.
+	assert(RenderGraph::InvalidID == renderGraph.GetPhysicalTextureIndex(unusedTexture));
+	assert(renderGraph.GetPhysicalTextureDescs().empty());
+
+	// Shadow pass is culled when its reader is disabled.
+	renderGraph.Reset();
+	sceneTarget = renderGraph.ImportResource(StringCrc("SceneTarget"), true);
+	shadowMaps = renderGraph.ImportResource(StringCrc("ShadowMaps"));
+	shadowPass = renderGraph.AddPass("Shadow");
+	renderGraph.Write(shadowPass, shadowMaps);
+	worldPass = renderGraph.AddPass("World", false);
+	renderGraph.Read(worldPass, shadowMaps);
+	renderGraph.Write(worldPass, sceneTarget);
+	renderGraph.Compile();
+	assert(0U == renderGraph.GetActivePassCount());
+
+	printf("\n[Success] Test_RenderGraphCulling\n");
+}
+
+void Test_RenderGraphAliasing()
+{
+	cdtools::PerformanceProfiler perf("Test_RenderGraphAliasing");
+
+	constexpr RenderGraphTextureDesc fullDesc{ 1280U, 720U, 1U, 0U };
+	constexpr RenderGraphTextureDesc halfDesc{ 640U, 360U, 1U, 0U };
+
+	RenderGraph renderGraph;
+	RenderGraph::ResourceID sceneTarget = renderGraph.ImportResource(StringCrc("SceneTarget"), true);
+	RenderGraph::ResourceID textureA = renderGraph.CreateTexture(StringCrc("A"), fullDesc);
+	RenderGraph::ResourceID textureB = renderGraph.CreateTexture(StringCrc("B"), fullDesc);
+	RenderGraph::ResourceID textureC = renderGraph.CreateTexture(StringCrc("C"), fullDesc);
+	RenderGraph::ResourceID textureD = renderGraph.CreateTexture(StringCrc("D"), halfDesc);
+
+	// A -> B, B -> C, C -> scene. A and C don't overlap so that they share a physical texture.
+	RenderGraph::PassID firstPass = renderGraph.AddPass("First");
+	renderGraph.Read(firstPass, sceneTarget);
+	renderGraph.Write(firstPass, textureA);
+
+	RenderGraph::PassID secondPass = renderGraph.AddPass("Second");
+	renderGraph.Read(secondPass, textureA);
+	renderGraph.Write(secondPass, textureB);
+
+	RenderGraph::PassID thirdPass = renderGraph.AddPass("Third");
+	renderGraph.Read(thirdPass, textureB);
+	renderGraph.Write(thirdPass, textureC);
+	renderGraph.Write(thirdPass, textureD);
+
+	RenderGraph::PassID lastPass = renderGraph.AddPass("Last");
+	renderGraph.Read(lastPass, textureC);
+	renderGraph.Read(lastPass, textureD);
+	renderGraph.Write(lastPass, sceneTarget);
+
+	renderGraph.Compile();
+	assert(4U == renderGraph.GetActivePassCount());
+	assert(4U == renderGraph.GetTransientTextureCount());
+	assert(3U == renderGraph.GetPhysicalTextureDescs().size());
+
+	uint32_t physicalA = renderGraph.GetPhysicalTextureIndex(textureA);
+	uint32_t physicalB = renderGraph.GetPhysicalTextureIndex(textureB);
+	uint32_t physicalC = renderGraph.GetPhysicalTextureIndex(textureC);
+	uint32_t physicalD = renderGraph.GetPhysicalTextureIndex(textureD);
+	assert(physicalA == physicalC);
+	assert(physicalA != physicalB && physicalB != physicalC);
+	assert(physicalD != physicalA && physicalD != physicalB);
+	assert(halfDesc == renderGraph.GetPhysicalTextureDescs()[physicalD]);
+	assert(physicalC == renderGraph.GetPhysicalTextureIndex(StringCrc("C")));
+
+	printf("\n[Success] Test_RenderGraphAliasing\n");
+}
+
+void Test_ShadowAtlas()
+{
+	cdtools::PerformanceProfiler perf("Test_ShadowAtlas");
+
+	auto IsOverlapped = [](const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+	{
+		return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+	};
+
+	ShadowAtlas shadowAtlas;
+	shadowAtlas.Reset(4096U);
+
+	// Mixed sizes fill the atlas without overlap.
+	std::vector<ShadowAtlasTile> tiles;
+	const uint16_t tileSizes[] = { 1024U, 2048U, 1000U, 512U, 2048U, 512U, 1024U, 2048U };
+	for (uint16_t tileSize : tileSizes)
+	{
+		ShadowAtlasTile tile;
+		assert(shadowAtlas.Allocate(tileSize, tile));
+		assert(tile.size >= tileSize && 0U == tile.x % tile.size && 0U == tile.y % tile.size);
+		assert(tile.x + tile.size <= 4096U && tile.y + tile.size <= 4096U);
+		for (const ShadowAtlasTile& otherTile : tiles)
+		{
+			assert(!IsOverlapped(tile, otherTile));
+		}
+		tiles.push_back(tile);
+	}
+
+	// 3 * 2048^2 + 3 * 1024^2 + 2 * 512^2 are used. Two 512 blocks are left.
+	assert(!shadowAtlas.CanAllocate(1024U, 1U));
+	assert(shadowAtlas.CanAllocate(512U, 2U) && !shadowAtlas.CanAllocate(512U, 3U));
+	assert(shadowAtlas.CanAllocate(64U, 128U));
+	assert(512U == shadowAtlas.FitTileSize(2048U, 2U));
+	assert(256U == shadowAtlas.FitTileSize(2048U, 8U));
+	assert(0U == shadowAtlas.FitTileSize(2048U, 129U));
+
+	ShadowAtlasTile tile;
+	assert(!shadowAtlas.Allocate(1024U, tile));
+
+	// 3 point lights need 18 views of 1024 which only fit after halving.
+	shadowAtlas.Reset(4096U);
+	assert(512U == shadowAtlas.FitTileSize(1024U, 18U));
+	assert(1024U == shadowAtlas.FitTileSize(1024U, 16U));
+	for (uint32_t tileIndex = 0U; tileIndex < 16U; ++tileIndex)
+	{
+		assert(shadowAtlas.Allocate(1024U, tile));
+	}
+	assert(!shadowAtlas.CanAllocate(64U, 1U));
+
+	printf("\n[Success] Test_ShadowAtlas\n");
+}
+
+void Test_ShadowCache()
+{
+	cdtools::PerformanceProfiler perf("Test_ShadowCache");
+
+	ShadowCache shadowCache;
+	ShadowAtlasTile tile{ 0U, 0U, 1024U };
+	cd::Matrix4x4 viewProjection = cd::Matrix4x4::Identity();
+	constexpr uint64_t viewKey = 1U;
+	constexpr Entity wall = 10U;
+	constexpr Entity player = 20U;
+
+	// Frame 1 : casters seen the first time are static. The static layer is rendered.
+	shadowCache.BeginFrame();
+	assert(shadowCache.IsStaticCaster(wall, 0U));
+	assert(shadowCache.IsStaticCaster(player, 0U));
+	ShadowViewUpdate update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(update.isStaticLayerDirty && ShadowViewAction::Restore == update.action);
+	assert(1U == shadowCache.GetRenderedViewCount() && 0U == shadowCache.GetCachedViewCount());
+	shadowCache.EndFrame();
+
+	// Frame 2 : nothing changed so the atlas tile is reused as is.
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(!update.isStaticLayerDirty && ShadowViewAction::Skip == update.action);
+	assert(0U == shadowCache.GetRenderedViewCount() && 1U == shadowCache.GetCachedViewCount());
+	shadowCache.EndFrame();
+
+	// Frame 3 : player moves. It leaves the static layer which is rendered again, and it's drawn on top.
+	shadowCache.BeginFrame();
+	assert(shadowCache.IsStaticCaster(wall, 0U));
+	assert(!shadowCache.IsStaticCaster(player, 1U));
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall } }, true);
+	assert(update.isStaticLayerDirty && ShadowViewAction::Restore == update.action);
+	shadowCache.EndFrame();
+
+	// Player keeps moving. Static layer is restored under it without rendering static casters.
+	for (uint32_t frameIndex = 0U; frameIndex < ShadowCache::StaticFrameCount - 1U; ++frameIndex)
+	{
+		shadowCache.BeginFrame();
+		assert(shadowCache.IsStaticCaster(wall, 0U));
+		assert(!shadowCache.IsStaticCaster(player, 2U + frameIndex));
+		update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall } }, true);
+		assert(!update.isStaticLayerDirty && ShadowViewAction::Restore == update.action);
+		assert(1U == shadowCache.GetCachedViewCount());
+		shadowCache.EndFrame();
+	}
+
+	// Player stops. It becomes static after StaticFrameCount frames and is rendered into the static layer again.
+	uint32_t stopVersion = ShadowCache::StaticFrameCount + 1U;
+	uint32_t movingFrameCount = 0U;
+	while (true)
+	{
+		shadowCache.BeginFrame();
+		bool isStatic = shadowCache.IsStaticCaster(player, stopVersion);
+		std::vector<ShadowCasterKey> staticCasters = isStatic ? std::vector<ShadowCasterKey>{ { wall }, { player } } : std::vector<ShadowCasterKey>{ { wall } };
+		update = shadowCache.UpdateView(viewKey, tile, viewProjection, staticCasters, !isStatic);
+		shadowCache.EndFrame();
+		if (isStatic)
+		{
+			assert(update.isStaticLayerDirty);
+			break;
+		}
+		++movingFrameCount;
+	}
+	assert(ShadowCache::StaticFrameCount == movingFrameCount);
+
+	// Light moves.
+	viewProjection(0, 3) = 1.0f;
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+
+	// Tile changes after atlas is repacked.
+	tile.size = 512U;
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+
+	// Wall switches LOD and back. Both change the geometry of the static layer.
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall, 1U, 0U }, { player } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+
+	// Mesh of the player is evicted and reloaded without moving.
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player, 0U, 2U } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player, 0U, 2U } }, false);
+	assert(!update.isStaticLayerDirty && ShadowViewAction::Skip == update.action);
+	shadowCache.EndFrame();
+
+	// View without static casters is cleared once and then skipped.
+	constexpr uint64_t emptyViewKey = 2U;
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(emptyViewKey, ShadowAtlasTile{ 1024U, 0U, 1024U }, viewProjection, {}, false);
+	assert(!update.isStaticLayerDirty && ShadowViewAction::Clear == update.action);
+	shadowCache.EndFrame();
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(emptyViewKey, ShadowAtlasTile{ 1024U, 0U, 1024U }, viewProjection, {}, false);
+	assert(ShadowViewAction::Skip == update.action);
+	shadowCache.EndFrame();
+
+	// Views which are not updated in a frame are forgotten.
+	shadowCache.BeginFrame();
+	shadowCache.EndFrame();
+	shadowCache.BeginFrame();
+	update = shadowCache.UpdateView(viewKey, tile, viewProjection, { { wall }, { player } }, false);
+	assert(update.isStaticLayerDirty);
+	shadowCache.EndFrame();
+
+	printf("\n[Success] Test_ShadowCache\n");
+}
+
+void Test_LightClusters()
+{
+	cdtools::PerformanceProfiler perf("Test_LightClusters");
+
+	// Camera at the origin looks along +z.
+	constexpr float nearPlane = 0.1f;
+	constexpr float farPlane = 1000.0f;
+	cd::Matrix4x4 viewMatrix = cd::Matrix4x4::Identity();
+	cd::Matrix4x4 projectionMatrix = cd::Matrix4x4::Perspective(90.0f, 1.0f, nearPlane, farPlane, false);
+
+	LightClusters lightClusters;
+	lightClusters.Reset(viewMatrix, projectionMatrix, nearPlane, farPlane);
+	assert(0U == lightClusters.GetDepthSlice(nearPlane));
+	assert(LightClusters::ClusterCountZ - 1U == lightClusters.GetDepthSlice(farPlane));
+	assert(LightClusters::ClusterCountZ / 2U == lightClusters.GetDepthSlice(std::sqrt(nearPlane * farPlane) * 1.01f));
+
+	// Small light in the center, light behind the camera and light outside of the screen.
+	lightClusters.AddPointLight(0U, cd::Point(0.0f, 0.0f, 10.0f), 0.1f);
+	lightClusters.AddPointLight(1U, cd::Point(0.0f, 0.0f, -10.0f), 1.0f);
+	lightClusters.AddPointLight(2U, cd::Point(100.0f, 0.0f, 10.0f), 1.0f);
+	lightClusters.Build();
+	uint32_t centerSlice = lightClusters.GetDepthSlice(10.0f);
+	uint32_t centerX = LightClusters::ClusterCountX / 2U;
+	uint32_t centerY = LightClusters::ClusterCountY / 2U;
+	assert(1U == lightClusters.GetClusterLightCount(centerX, centerY, centerSlice));
+	assert(0U == lightClusters.GetClusterLightIndex(centerX, centerY, centerSlice, 0U));
+	assert(0U == lightClusters.GetClusterLightCount(0U, 0U, centerSlice));
+	assert(lightClusters.GetLightIndexCount() <= 8U);
+
+	// Every cluster which a light covers lists it, no matter how many lights overlap.
+	lightClusters.Reset(viewMatrix, projectionMatrix, nearPlane, farPlane);
+	std::mt19937 randomEngine(7);
+	std::uniform_real_distribution<float> positionDistribution(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> rangeDistribution(1.0f, 10.0f);
+	constexpr uint16_t lightCount = 256U;
+	std::vector<cd::Point> lightPositions;
+	std::vector<float> lightRanges;
+	for (uint16_t lightIndex = 0U; lightIndex < lightCount; ++lightIndex)
+	{
+		lightPositions.emplace_back(positionDistribution(randomEngine), positionDistribution(randomEngine), positionDistribution(randomEngine) + 50.0f);
+		lightRanges.push_back(rangeDistribution(randomEngine));
+		lightClusters.AddPointLight(lightIndex, lightPositions.back(), lightRanges.back());
+	}
+	lightClusters.Build();
+	assert(0U == lightClusters.GetDroppedLightIndexCount());
+
+	// Sample points inside light spheres and check that their clusters contain the lights, which is the shader lookup.
+	std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+	for (uint32_t sampleIndex = 0U; sampleIndex < 4096U; ++sampleIndex)
+	{
+		uint16_t lightIndex = static_cast<uint16_t>(sampleIndex % lightCount);
+		const cd::Point& position = lightPositions[lightIndex];
+		float scale = lightRanges[lightIndex] * 0.57f;
+		cd::Vec4f samplePosition(position.x() + unitDistribution(randomEngine) * scale, position.y() + unitDistribution(randomEngine) * scale,
+			position.z() + unitDistribution(randomEngine) * scale, 1.0f);
+		cd::Vec4f clipPosition = projectionMatrix * samplePosition;
+		float ndcX = clipPosition.x() / clipPosition.w();
+		float ndcY = clipPosition.y() / clipPosition.w();
+		if (samplePosition.z() < nearPlane || std::abs(ndcX) >= 1.0f || std::abs(ndcY) >= 1.0f)
+		{
+			continue;
+		}
+
+		uint32_t x = static_cast<uint32_t>((ndcX * 0.5f + 0.5f) * LightClusters::ClusterCountX);
+		uint32_t y = static_cast<uint32_t>((ndcY * 0.5f + 0.5f) * LightClusters::ClusterCountY);
+		uint32_t z = lightClusters.GetDepthSlice(samplePosition.z());
+		bool isFound = false;
+		for (uint32_t index = 0U; index < lightClusters.GetClusterLightCount(x, y, z); ++index)
+		{
+			isFound |= lightIndex == lightClusters.GetClusterLightIndex(x, y, z, index);
+		}
+		assert(isFound);
+	}
+
+	// Texture packs ranges as texel offsets followed by light indices.
+	const std::vector<float>& textureData = lightClusters.GetTextureData();
+	uint32_t lastClusterIndex = LightClusters::ClusterCount - 1U;
+	uint32_t lastOffset = static_cast<uint32_t>(textureData[lastClusterIndex * 2U]);
+	uint32_t lastCount = static_cast<uint32_t>(textureData[lastClusterIndex * 2U + 1U]);
+	assert(lastOffset + lastCount == LightClusters::ClusterCount + lightClusters.GetLightIndexCount());
+	assert(lightClusters.GetTextureRowCount() * LightClusters::TextureWidth >= lastOffset + lastCount);
+
+	printf("\n[Success] Test_LightClusters\n");
+}
+
+void Test_MeshLOD()
+{
+	cdtools::PerformanceProfiler perf("Test_MeshLOD");
+
+	// Unit sphere from a subdivided octahedron, which is closed and has no seams.
+	std::vector<cd::Point> positions;
+	MeshLOD::IndexList sphereIndices;
+	{
+		constexpr uint32_t subdivision = 24U;
+		auto AddVertex = [&positions](float x, float y, float z)
+		{
+			float length = std::sqrt(x * x + y * y + z * z);
+			positions.emplace_back(x / length, y / length, z / length);
+			return static_cast<uint32_t>(positions.size() - 1);
+		};
+
+		// Every face of the octahedron is a triangular grid. Edges between faces are welded by position so vertices are duplicated
+		// on them. Simplifier treats them as seams, which also tests that seams stay closed.
+		for (uint32_t face = 0U; face < 8U; ++face)
+		{
+			float sx = (face & 1U) ? -1.0f : 1.0f;
+			float sy = (face & 2U) ? -1.0f : 1.0f;
+			float sz = (face & 4U) ? -1.0f : 1.0f;
+			bool isMirrored = (sx * sy * sz) < 0.0f;
+			std::vector<uint32_t> rowStarts;
+			for (uint32_t row = 0U; row <= subdivision; ++row)
+			{
+				rowStarts.push_back(static_cast<uint32_t>(positions.size()));
+				for (uint32_t column = 0U; column <= subdivision - row; ++column)
+				{
+					float x = static_cast<float>(subdivision - row - column) / subdivision;
+					float y = static_cast<float>(column) / subdivision;
+					float z = static_cast<float>(row) / subdivision;
+					AddVertex(x * sx, y * sy, z * sz);
+				}
+			}
+
+			auto AddTriangle = [&sphereIndices, isMirrored](uint32_t a, uint32_t b, uint32_t c)
+			{
+				sphereIndices.insert(sphereIndices.end(), { a, isMirrored ? c : b, isMirrored ? b : c });
+			};
+			for (uint32_t row = 0U; row < subdivision; ++row)
+			{
+				for (uint32_t column = 0U; column < subdivision - row; ++column)
+				{
+					uint32_t current = rowStarts[row] + column;
+					uint32_t above = rowStarts[row + 1U] + column;
+					AddTriangle(current, current + 1U, above);
+					if (column + 1U < subdivision - row)
+					{
+						AddTriangle(current + 1U, above + 1U, above);
+					}
+				}
+			}
+		}
+	}
+
+	auto GetNormal = [](const std::vector<cd::Point>& trianglePositions, const uint32_t* pTriangle)
+	{
+		const cd::Point& a = trianglePositions[pTriangle[0]];
+		const cd::Point& b = trianglePositions[pTriangle[1]];
+		const cd::Point& c = trianglePositions[pTriangle[2]];
+		float e0[3] = { b.x() - a.x(), b.y() - a.y(), b.z() - a.z() };
+		float e1[3] = { c.x() - a.x(), c.y() - a.y(), c.z() - a.z() };
+		return cd::Vec3f(e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0]);
+	};
+
+	// Sphere is outward facing so every simplified triangle should still face away from the center.
+	auto CheckOutwardFacing = [&positions, &GetNormal](const MeshLOD::IndexList& indices)
+	{
+		assert(0U == indices.size() % 3U);
+		for (size_t index = 0; index < indices.size(); index += 3)
+		{
+			assert(indices[index] < positions.size() && indices[index + 1] < positions.size() && indices[index + 2] < positions.size());
+			cd::Vec3f normal = GetNormal(positions, &indices[index]);
+			const cd::Point& a = positions[indices[index]];
+			assert(normal.x() * a.x() + normal.y() * a.y() + normal.z() * a.z() > 0.0f);
+		}
+	};
+	CheckOutwardFacing(sphereIndices);
+
+	uint32_t halfIndexCount = static_cast<uint32_t>(sphereIndices.size() / 6U * 3U);
+	MeshLOD::IndexList halfIndices = MeshLOD::Simplify(positions, sphereIndices, halfIndexCount, 1.0f);
+	assert(halfIndices.size() <= halfIndexCount && halfIndices.size() > halfIndexCount / 2U);
+	CheckOutwardFacing(halfIndices);
+
+	// Zero error only allows collapses on flat areas, and octahedron faces are curved on the sphere.
+	MeshLOD::IndexList exactIndices = MeshLOD::Simplify(positions, sphereIndices, 0U, 0.0f);
+	assert(exactIndices.size() == sphereIndices.size());
+
+	// Flat grid collapses to its locked border.
+	std::vector<cd::Point> gridPositions;
+	MeshLOD::IndexList gridIndices;
+	constexpr uint32_t gridSize = 16U;
+	for (uint32_t y = 0U; y <= gridSize; ++y)
+	{
+		for (uint32_t x = 0U; x <= gridSize; ++x)
+		{
+			gridPositions.emplace_back(static_cast<float>(x), static_cast<float>(y), 0.0f);
+		}
+	}
+	for (uint32_t y = 0U; y < gridSize; ++y)
+	{
+		for (uint32_t x = 0U; x < gridSize; ++x)
+		{
+			uint32_t corner = y * (gridSize + 1U) + x;
+			gridIndices.insert(gridIndices.end(), { corner, corner + 1U, corner + gridSize + 1U, corner + 1U, corner + gridSize + 2U, corner + gridSize + 1U });
+		}
+	}
+	MeshLOD::IndexList flatIndices = MeshLOD::Simplify(gridPositions, gridIndices, 0U, 0.0f);
+	assert(flatIndices.size() < gridIndices.size() / 4U);
+	std::vector<bool> isBorderUsed(gridPositions.size(), false);
+	float area = 0.0f;
+	for (size_t index = 0; index < flatIndices.size(); index += 3)
+	{
+		cd::Vec3f normal = GetNormal(gridPositions, &flatIndices[index]);
+		assert(normal.z() > 0.0f);
+		area += 0.5f * normal.z();
+		for (uint32_t corner = 0U; corner < 3U; ++corner)
+		{
+			isBorderUsed[flatIndices[index + corner]] = true;
+		}
+	}
+	assert(std::abs(area - static_cast<float>(gridSize * gridSize)) < 0.01f);
+	for (uint32_t x = 0U; x <= gridSize; ++x)
+	{
+		assert(isBorderUsed[x] && isBorderUsed[gridSize * (gridSize + 1U) + x]);
+	}
+
+	// Chain halves triangles per level until the error bound stops it.
+	std::vector<MeshLOD::IndexList> groups{ sphereIndices };
+	std::vector<std::vector<MeshLOD::IndexList>> lods = MeshLOD::BuildLODChain(positions, groups);
+	assert(!lods.empty() && lods.size() < MeshLOD::MaxLODCount);
+	size_t previousIndexCount = sphereIndices.size();
+	for (const std::vector<MeshLOD::IndexList>& lod : lods)
+	{
+		assert(1U == lod.size());
+		assert(lod[0].size() * 4U <= previousIndexCount * 3U);
+		CheckOutwardFacing(lod[0]);
+		previousIndexCount = lod[0].size();
+	}
+
+	// Selection by screen size.
+	assert(0U == MeshLOD::SelectLOD(1.0f, 4U));
+	assert(0U == MeshLOD::SelectLOD(MeshLOD::LOD1ScreenSize, 4U));
+	assert(1U == MeshLOD::SelectLOD(MeshLOD::LOD1ScreenSize * 0.9f, 4U));
+	assert(2U == MeshLOD::SelectLOD(MeshLOD::LOD1ScreenSize * 0.4f, 4U));
+	assert(3U == MeshLOD::SelectLOD(0.0f, 4U));
+	assert(0U == MeshLOD::SelectLOD(0.0f, 1U));
+	assert(1.0f == MeshLOD::GetScreenSize(2.0f, 1.0f, 1.0f));
+	assert(std::abs(MeshLOD::GetScreenSize(1.0f, 10.0f, 2.0f) - 0.2f) < 0.0001f);
+
+	printf("\n[Success] Test_MeshLOD\n");
+}
+
+void Test_OcclusionBuffer()
+{
+	cdtools::PerformanceProfiler perf("Test_OcclusionBuffer");
+
+	// Camera at the origin looks along +z. A 4x4 wall at depth 10 is drawn in both windings.
+	cd::Matrix4x4 viewProjection = cd::Matrix4x4::Perspective(90.0f, 2.0f, 0.1f, 1000.0f, false);
+	std::vector<cd::Point> wallPositions = { cd::Point(-2.0f, -2.0f, 0.0f), cd::Point(2.0f, -2.0f, 0.0f), cd::Point(2.0f, 2.0f, 0.0f), cd::Point(-2.0f, 2.0f, 0.0f) };
+	std::vector<uint32_t> wallIndices = { 0U, 1U, 2U, 0U, 3U, 2U };
+	cd::Matrix4x4 wallMatrix = cd::Matrix4x4::Identity();
+	wallMatrix(2, 3) = 10.0f;
+
+	OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Clear(viewProjection);
+	occlusionBuffer.RasterizeOccluder(wallMatrix, wallPositions, wallIndices);
+	occlusionBuffer.BuildHiZ();
+	assert(2U == occlusionBuffer.GetRasterizedTriangleCount());
+	assert(occlusionBuffer.GetDepth(0U, OcclusionBuffer::Width / 2U, OcclusionBuffer::Height / 2U) < 1.0f);
+	assert(occlusionBuffer.GetDepth(0U, 0U, 0U) > 1.0f);
+
+	// Every Hi-Z texel keeps the farthest depth of its footprint.
+	for (uint32_t level = 1U; level < occlusionBuffer.GetLevelCount(); ++level)
+	{
+		for (uint32_t y = 0U; y < occlusionBuffer.GetLevelHeight(level); ++y)
+		{
+			for (uint32_t x = 0U; x < occlusionBuffer.GetLevelWidth(level); ++x)
+			{
+				float depth = occlusionBuffer.GetDepth(level, x, y);
+				uint32_t sourceX = std::min(x * 2U, occlusionBuffer.GetLevelWidth(level - 1U) - 1U);
+				uint32_t sourceY = std::min(y * 2U, occlusionBuffer.GetLevelHeight(level - 1U) - 1U);
+				assert(depth >= occlusionBuffer.GetDepth(level - 1U, sourceX, sourceY));
+			}
+		}
+	}
+	assert(1U == occlusionBuffer.GetLevelWidth(occlusionBuffer.GetLevelCount() - 1U));
+
+	// Boxes behind the wall are occluded unless they reach out of it or cross the near plane.
+	const float extent[3] = { 0.5f, 0.5f, 0.5f };
+	const float behindCenter[3] = { 0.0f, 0.0f, 20.0f };
+	const float frontCenter[3] = { 0.0f, 0.0f, 5.0f };
+	const float besideCenter[3] = { 8.0f, 0.0f, 20.0f };
+	const float crossingCenter[3] = { 0.0f, 0.0f, 0.0f };
+	const float largeExtent[3] = { 20.0f, 0.5f, 0.5f };
+	assert(!occlusionBuffer.IsVisible(behindCenter, extent));
+	assert(occlusionBuffer.IsVisible(frontCenter, extent));
+	assert(occlusionBuffer.IsVisible(besideCenter, extent));
+	assert(occlusionBuffer.IsVisible(crossingCenter, extent));
+	assert(occlusionBuffer.IsVisible(behindCenter, largeExtent));
+
+	// Triangles crossing the near plane are clipped instead of dropped.
+	std::vector<cd::Point> floorPositions = { cd::Point(-500.0f, -1.0f, -500.0f), cd::Point(500.0f, -1.0f, -500.0f), cd::Point(500.0f, -1.0f, 500.0f), cd::Point(-500.0f, -1.0f, 500.0f) };
+	occlusionBuffer.Clear(viewProjection);
+	occlusionBuffer.RasterizeOccluder(cd::Matrix4x4::Identity(), floorPositions, wallIndices);
+	occlusionBuffer.BuildHiZ();
+	assert(occlusionBuffer.GetRasterizedTriangleCount() >= 2U);
+	const float underCenter[3] = { 0.0f, -3.0f, 3.0f };
+	const float overCenter[3] = { 0.0f, 1.0f, 3.0f };
+	assert(!occlusionBuffer.IsVisible(underCenter, extent));
+	assert(occlusionBuffer.IsVisible(overCenter, extent));
+
+	printf("\n[Success] Test_OcclusionBuffer\n");
+}
+
+void Benchmark_OcclusionBuffer()
+{
+	constexpr uint32_t occluderCount = OcclusionBuffer::MaxOccluderCountPerView;
+	constexpr uint32_t boxCount = 100000U;
+	std::mt19937 random(7U);
+	std::uniform_real_distribution<float> sideDistribution(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> depthDistribution(5.0f, 100.0f);
+
+	// Occluders are boxes of 12 triangles.
+	std::vector<cd::Point> boxPositions;
+	for (uint32_t corner = 0U; corner < 8U; ++corner)
+	{
+		boxPositions.emplace_back((corner & 1U) ? 1.0f : -1.0f, (corner & 2U) ? 1.0f : -1.0f, (corner & 4U) ? 1.0f : -1.0f);
+	}
+	std::vector<uint32_t> boxIndices = { 0U, 1U, 3U, 0U, 3U, 2U, 4U, 6U, 7U, 4U, 7U, 5U, 0U, 4U, 5U, 0U, 5U, 1U,
+		2U, 3U, 7U, 2U, 7U, 6U, 0U, 2U, 6U, 0U, 6U, 4U, 1U, 5U, 7U, 1U, 7U, 3U };
+
+	std::vector<cd::Matrix4x4> occluderMatrices;
+	for (uint32_t occluderIndex = 0U; occluderIndex < occluderCount; ++occluderIndex)
+	{
+		cd::Matrix4x4 matrix = cd::Matrix4x4::Identity();
+		matrix(0, 0) = matrix(1, 1) = matrix(2, 2) = 3.0f;
+		matrix(0, 3) = sideDistribution(random);
+		matrix(1, 3) = sideDistribution(random);
+		matrix(2, 3) = depthDistribution(random);
+		occluderMatrices.push_back(matrix);
+	}
+
+	std::vector<float> boxCenters;
+	for (uint32_t boxIndex = 0U; boxIndex < boxCount; ++boxIndex)
+	{
+		boxCenters.insert(boxCenters.end(), { sideDistribution(random), sideDistribution(random), depthDistribution(random) });
+	}
+
+	OcclusionBuffer occlusionBuffer;
+	cd::Matrix4x4 viewProjection = cd::Matrix4x4::Perspective(90.0f, 2.0f, 0.1f, 1000.0f, false);
+	{
+		cdtools::PerformanceProfiler perf("Benchmark_OcclusionBuffer_Rasterize");
+		occlusionBuffer.Clear(viewProjection);
+		for (const cd::Matrix4x4& matrix : occluderMatrices)
+		{
+			occlusionBuffer.RasterizeOccluder(matrix, boxPositions, boxIndices);
+		}
+		occlusionBuffer.BuildHiZ();
+	}
+
+	uint32_t visibleCount = 0U;
+	{
+		cdtools::PerformanceProfiler perf("Benchmark_OcclusionBuffer_Test");
+		const float extent[3] = { 0.5f, 0.5f, 0.5f };
+		for (uint32_t boxIndex = 0U; boxIndex < boxCount; ++boxIndex)
+		{
+			visibleCount += occlusionBuffer.IsVisible(&boxCenters[boxIndex * 3U], extent) ? 1U : 0U;
+		}
+	}
+	assert(visibleCount > 0U && visibleCount < boxCount);
+
+	printf("\n[Success] Benchmark_OcclusionBuffer %u / %u visible\n", visibleCount, boxCount);
+}
+
+
+void Test_OffsetAllocator()
+{
+	cdtools::PerformanceProfiler perf("Test_OffsetAllocator");
+
+	OffsetAllocator allocator(100U);
+	uint32_t first = allocator.Allocate(30U);
+	uint32_t second = allocator.Allocate(30U);
+	uint32_t third = allocator.Allocate(30U);
+	assert(0U == first && 30U == second && 60U == third);
+	assert(10U == allocator.GetFreeSize() && 1U == allocator.GetFreeRangeCount());
+	assert(OffsetAllocator::InvalidOffset == allocator.Allocate(11U));
+
+	// Freed ranges are merged with free neighbors on both sides.
+	allocator.Free(first, 30U);
+	assert(2U == allocator.GetFreeRangeCount() && 30U == allocator.GetLargestFreeSize());
+	allocator.Free(third, 30U);
+	assert(2U == allocator.GetFreeRangeCount() && 40U == allocator.GetLargestFreeSize());
+	allocator.Free(second, 30U);
+	assert(1U == allocator.GetFreeRangeCount() && allocator.IsEmpty());
+
+	// Best fit takes the smallest range which is large enough.
+	allocator.Reset(100U);
+	uint32_t small = allocator.Allocate(10U);
+	allocator.Allocate(10U);
+	uint32_t large = allocator.Allocate(40U);
+	allocator.Allocate(10U);
+	allocator.Free(small, 10U);
+	allocator.Free(large, 40U);
+	assert(small == allocator.Allocate(8U));
+	assert(large == allocator.Allocate(35U));
+
+	// Random allocations never overlap and all space comes back after freeing them.
+	std::mt19937 random(7U);
+	std::uniform_int_distribution<uint32_t> sizeDistribution(1U, 1000U);
+	constexpr uint32_t capacity = 1U << 20U;
+	allocator.Reset(capacity);
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	std::vector<uint8_t> used(capacity, 0U);
+	for (uint32_t step = 0U; step < 20000U; ++step)
+	{
+		if (!ranges.empty() && 0U == random() % 3U)
+		{
+			size_t rangeIndex = random() % ranges.size();
+			auto [offset, size] = ranges[rangeIndex];
+			std::fill(used.begin() + offset, used.begin() + offset + size, 0U);
+			allocator.Free(offset, size);
+			ranges[rangeIndex] = ranges.back();
+			ranges.pop_back();
+			continue;
+		}
+
+		uint32_t size = sizeDistribution(random);
+		uint32_t offset = allocator.Allocate(size);
+		if (OffsetAllocator::InvalidOffset == offset)
+		{
+			assert(allocator.GetLargestFreeSize() < size);
+			continue;
+		}
+
+		assert(offset + size <= capacity);
+		assert(std::none_of(used.begin() + offset, used.begin() + offset + size, [](uint8_t value) { return value != 0U; }));
+		std::fill(used.begin() + offset, used.begin() + offset + size, 1U);
+		ranges.emplace_back(offset, size);
+	}
+
+	for (auto [offset, size] : ranges)
+	{
+		allocator.Free(offset, size);
+	}
+	assert(allocator.IsEmpty() && 1U == allocator.GetFreeRangeCount());
+
+	printf("\n[Success] Test_OffsetAllocator\n");
+}
+
+
+void Test_VertexQuantization()
+{
+	cdtools::PerformanceProfiler perf("Test_VertexQuantization");
+
+	assert(32767 == VertexQuantization::EncodeSnorm16(2.0f) && -32767 == VertexQuantization::EncodeSnorm16(-1.0f));
+	assert(-1.0f == VertexQuantization::DecodeSnorm16(-32768) && 0.0f == VertexQuantization::DecodeSnorm16(0));
+
+	// Axes, octahedron edges in the folded half and random directions.
+	std::vector<cd::Direction> directions = { cd::Direction(1.0f, 0.0f, 0.0f), cd::Direction(0.0f, -1.0f, 0.0f), cd::Direction(0.0f, 0.0f, 1.0f),
+		cd::Direction(0.0f, 0.0f, -1.0f), cd::Direction(-0.6f, 0.0f, -0.8f), cd::Direction(0.0f, 0.6f, -0.8f) };
+	std::mt19937 random(7U);
+	std::normal_distribution<float> distribution;
+	for (uint32_t directionIndex = 0U; directionIndex < 10000U; ++directionIndex)
+	{
+		float x = distribution(random);
+		float y = distribution(random);
+		float z = distribution(random);
+		float length = std::sqrt(x * x + y * y + z * z);
+		directions.emplace_back(x / length, y / length, z / length);
+	}
+
+	float maxError = 0.0f;
+	for (const cd::Direction& direction : directions)
+	{
+		int16_t encoded[2];
+		VertexQuantization::EncodeOctahedral(direction, encoded);
+		cd::Direction decoded = VertexQuantization::DecodeOctahedral(encoded);
+		float error[3] = { decoded.x() - direction.x(), decoded.y() - direction.y(), decoded.z() - direction.z() };
+		maxError = std::max(maxError, std::sqrt(error[0] * error[0] + error[1] * error[1] + error[2] * error[2]));
+	}
+	printf("Octahedral max error : %f degrees\n", maxError * 180.0f / 3.14159265f);
+	assert(maxError < 1e-4f);
+
+	// Vertices of position, normal and UV.
+	const VertexQuantization::Attribute attributes[] = {
+		{ VertexQuantization::Encoding::Position, 3U * sizeof(float) },
+		{ VertexQuantization::Encoding::Octahedral, 3U * sizeof(float) },
+		{ VertexQuantization::Encoding::Snorm16, 2U * sizeof(float) },
+	};
+	const float sourceData[][8] = {
+		{ 10.0f, -2.0f, 3.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f },
+		{ 14.0f, 2.0f, 3.5f, 0.0f, 0.0f, -1.0f, 0.5f, -0.25f },
+		{ 12.0f, 0.0f, 4.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+	};
+	std::vector<std::byte> sourceVertices(sizeof(sourceData));
+	std::memcpy(sourceVertices.data(), sourceData, sizeof(sourceData));
+	assert(VertexQuantization::IsSnorm16Range(sourceVertices, attributes, 2U) && !VertexQuantization::IsSnorm16Range(sourceVertices, attributes, 0U));
+
+	// Same scale on all axes from the largest extent.
+	VertexQuantization::PositionQuantization positionQuantization = VertexQuantization::GetPositionQuantization(sourceVertices, attributes);
+	assert(12.0f == positionQuantization.offset.x() && 0.0f == positionQuantization.offset.y() && 3.5f == positionQuantization.offset.z());
+	assert(2.0f == positionQuantization.scale);
+
+	std::vector<std::byte> vertices = VertexQuantization::Quantize(sourceVertices, attributes, positionQuantization);
+	constexpr uint32_t stride = 8U * sizeof(int16_t);
+	assert(3U * stride == vertices.size());
+
+	// Translation by (1, 2, 3) and rotation by 90 degrees around z.
+	cd::Matrix4x4 worldMatrix = cd::Matrix4x4::Identity();
+	float* pWorldMatrix = worldMatrix.begin();
+	pWorldMatrix[0] = 0.0f;
+	pWorldMatrix[1] = 1.0f;
+	pWorldMatrix[4] = -1.0f;
+	pWorldMatrix[5] = 0.0f;
+	pWorldMatrix[12] = 1.0f;
+	pWorldMatrix[13] = 2.0f;
+	pWorldMatrix[14] = 3.0f;
+	cd::Matrix4x4 dequantizedWorldMatrix = VertexQuantization::GetDequantizedWorldMatrix(worldMatrix, positionQuantization);
+	const float* pMatrix = dequantizedWorldMatrix.begin();
+
+	for (uint32_t vertexIndex = 0U; vertexIndex < 3U; ++vertexIndex)
+	{
+		int16_t encoded[8];
+		std::memcpy(encoded, vertices.data() + vertexIndex * stride, stride);
+		const float* pSource = sourceData[vertexIndex];
+
+		float position[3] = { VertexQuantization::DecodeSnorm16(encoded[0]), VertexQuantization::DecodeSnorm16(encoded[1]), VertexQuantization::DecodeSnorm16(encoded[2]) };
+		for (int row = 0; row < 3; ++row)
+		{
+			float worldPosition = pMatrix[row] * position[0] + pMatrix[4 + row] * position[1] + pMatrix[8 + row] * position[2] + pMatrix[12 + row];
+			float expected = pWorldMatrix[row] * pSource[0] + pWorldMatrix[4 + row] * pSource[1] + pWorldMatrix[8 + row] * pSource[2] + pWorldMatrix[12 + row];
+			assert(std::abs(worldPosition - expected) < 1e-4f);
+		}
+		assert(0 == encoded[3]);
+
+		cd::Direction normal = VertexQuantization::DecodeOctahedral(encoded + 4);
+		assert(std::abs(normal.x() - pSource[3]) < 1e-4f && std::abs(normal.y() - pSource[4]) < 1e-4f && std::abs(normal.z() - pSource[5]) < 1e-4f);
+
+		assert(std::abs(VertexQuantization::DecodeSnorm16(encoded[6]) - pSource[6]) < 1e-4f);
+		assert(std::abs(VertexQuantization::DecodeSnorm16(encoded[7]) - pSource[7]) < 1e-4f);
+	}
+
+	printf("\n[Success] Test_VertexQuantization\n");
+}
+
+void Test_MeshOptimizer()
+{
+	cdtools::PerformanceProfiler perf("Test_MeshOptimizer");
+
+	// UV sphere with one unused vertex at the end. Triangles are shuffled as importers may emit them in any order.
+	constexpr uint32_t rings = 48U;
+	constexpr uint32_t segments = 96U;
+	std::vector<cd::Point> positions;
+	MeshOptimizer::IndexList indices;
+	for (uint32_t ring = 0U; ring <= rings; ++ring)
+	{
+		float theta = 3.14159265f * static_cast<float>(ring) / rings;
+		for (uint32_t segment = 0U; segment <= segments; ++segment)
+		{
+			float phi = 2.0f * 3.14159265f * static_cast<float>(segment) / segments;
+			positions.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		}
+	}
+	for (uint32_t ring = 0U; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0U; segment < segments; ++segment)
+		{
+			uint32_t current = ring * (segments + 1U) + segment;
+			uint32_t below = current + segments + 1U;
+			indices.insert(indices.end(), { current, current + 1U, below, current + 1U, below + 1U, below });
+		}
+	}
+	positions.emplace_back(0.0f, 0.0f, 0.0f);
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+	std::vector<uint32_t> triangleOrder(indices.size() / 3);
+	for (uint32_t triangleIndex = 0U; triangleIndex < triangleOrder.size(); ++triangleIndex)
+	{
+		triangleOrder[triangleIndex] = triangleIndex;
+	}
+	std::shuffle(triangleOrder.begin(), triangleOrder.end(), std::mt19937(11U));
+	MeshOptimizer::IndexList shuffledIndices;
+	for (uint32_t triangleIndex : triangleOrder)
+	{
+		shuffledIndices.insert(shuffledIndices.end(), indices.begin() + triangleIndex * 3U, indices.begin() + triangleIndex * 3U + 3U);
+	}
+
+	// Triangles rotated to start from the smallest index keep winding, so sorted lists compare triangle sets.
+	auto GetSortedTriangles = [](const MeshOptimizer::IndexList& triangleIndices)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t indexOffset = 0; indexOffset < triangleIndices.size(); indexOffset += 3)
+		{
+			std::array<uint32_t, 3> triangle = { triangleIndices[indexOffset], triangleIndices[indexOffset + 1], triangleIndices[indexOffset + 2] };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	const auto sourceTriangles = GetSortedTriangles(indices);
+
+	float shuffledACMR = MeshOptimizer::GetACMR(shuffledIndices, vertexCount);
+	MeshOptimizer::IndexList cacheOptimizedIndices = MeshOptimizer::OptimizeVertexCache(shuffledIndices, vertexCount);
+	float cacheOptimizedACMR = MeshOptimizer::GetACMR(cacheOptimizedIndices, vertexCount);
+	assert(GetSortedTriangles(cacheOptimizedIndices) == sourceTriangles);
+	assert(shuffledACMR > 2.5f && cacheOptimizedACMR < 0.8f);
+
+	MeshOptimizer::IndexList overdrawOptimizedIndices = MeshOptimizer::OptimizeOverdraw(positions, cacheOptimizedIndices);
+	float overdrawOptimizedACMR = MeshOptimizer::GetACMR(overdrawOptimizedIndices, vertexCount);
+	assert(GetSortedTriangles(overdrawOptimizedIndices) == sourceTriangles);
+	assert(overdrawOptimizedACMR < cacheOptimizedACMR * MeshOptimizer::DefaultOverdrawThreshold + 0.05f);
+	printf("ACMR : shuffled %f, vertex cache %f, overdraw %f\n", shuffledACMR, cacheOptimizedACMR, overdrawOptimizedACMR);
+
+	// Vertices are renumbered by first use and the unused one goes last.
+	MeshOptimizer::IndexList fetchOptimizedIndices = overdrawOptimizedIndices;
+	std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(fetchOptimizedIndices, vertexCount);
+	assert(vertexCount - 1U == remap.back());
+	std::vector<uint32_t> sortedRemap = remap;
+	std::sort(sortedRemap.begin(), sortedRemap.end());
+	for (uint32_t vertexIndex = 0U; vertexIndex < vertexCount; ++vertexIndex)
+	{
+		assert(vertexIndex == sortedRemap[vertexIndex]);
+	}
+
+	uint32_t nextNewVertex = 0U;
+	for (size_t index = 0; index < fetchOptimizedIndices.size(); ++index)
+	{
+		assert(fetchOptimizedIndices[index] <= nextNewVertex);
+		nextNewVertex = std::max(nextNewVertex, fetchOptimizedIndices[index] + 1U);
+		assert(remap[overdrawOptimizedIndices[index]] == fetchOptimizedIndices[index]);
+	}
+	assert(MeshOptimizer::GetACMR(fetchOptimizedIndices, vertexCount) == overdrawOptimizedACMR);
+
+	printf("\n[Success] Test_MeshOptimizer\n");
+}
+
+}
+
+void Test_OptimizeMesh()
+{
+	cdtools::PerformanceProfiler perf("Test_OptimizeMesh");
+
+	// Grid whose left and right halves are two polygon groups in shuffled order. Vertex attributes are derived from grid
+	// coordinates so that remapped vertices can be checked against their positions.
+	constexpr uint32_t gridSize = 32U;
+	constexpr uint32_t rowVertexCount = gridSize + 1U;
+	auto GetGridVertex = [](const cd::Point& position)
+	{
+		return static_cast<uint32_t>(std::lround(position.y())) * rowVertexCount + static_cast<uint32_t>(std::lround(position.x()));
+	};
+
+	cd::Mesh mesh;
+	mesh.Init(rowVertexCount * rowVertexCount + 1U);
+	mesh.SetVertexUVSetCount(1U);
+	for (uint32_t vertexIndex = 0U; vertexIndex < mesh.GetVertexCount(); ++vertexIndex)
+	{
+		float x = static_cast<float>(vertexIndex % rowVertexCount);
+		float y = static_cast<float>(vertexIndex / rowVertexCount);
+		mesh.SetVertexPosition(vertexIndex, cd::Point(x, y, 0.0f));
+		mesh.SetVertexNormal(vertexIndex, cd::Direction(x, y, 1.0f));
+		mesh.SetVertexUV(0U, vertexIndex, cd::UV(x / gridSize, y / gridSize));
+	}
+
+	std::mt19937 randomEngine(7U);
+	for (uint32_t polygonGroupIndex = 0U; polygonGroupIndex < 2U; ++polygonGroupIndex)
+	{
+		cd::PolygonGroup polygonGroup;
+		for (uint32_t row = 0U; row < gridSize; ++row)
+		{
+			for (uint32_t column = polygonGroupIndex * gridSize / 2U; column < (polygonGroupIndex + 1U) * gridSize / 2U; ++column)
+			{
+				uint32_t current = row * rowVertexCount + column;
+				uint32_t above = current + rowVertexCount;
+				polygonGroup.push_back(cd::Polygon{ current, current + 1U, above });
+				polygonGroup.push_back(cd::Polygon{ current + 1U, above + 1U, above });
+			}
+		}
+		std::shuffle(polygonGroup.begin(), polygonGroup.end(), randomEngine);
+		mesh.AddPolygonGroup(cd::MoveTemp(polygonGroup));
+	}
+
+	cd::VertexFormat vertexFormat;
+	vertexFormat.AddVertexAttributeLayout(cd::VertexAttributeType::Position, cd::AttributeValueType::Float, 3U);
+	vertexFormat.AddVertexAttributeLayout(cd::VertexAttributeType::Normal, cd::AttributeValueType::Float, 3U);
+	vertexFormat.AddVertexAttributeLayout(cd::VertexAttributeType::UV, cd::AttributeValueType::Float, 2U);
+	mesh.SetVertexFormat(cd::MoveTemp(vertexFormat));
+
+	// Triangles of a group in grid vertices, rotated to start from the smallest one and sorted.
+	auto GetGroupTriangles = [&mesh, &GetGridVertex](uint32_t polygonGroupIndex)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (const cd::Polygon& polygon : mesh.GetPolygonGroup(polygonGroupIndex))
+		{
+			std::array<uint32_t, 3> triangle;
+			for (uint32_t corner = 0U; corner < 3U; ++corner)
+			{
+				triangle[corner] = GetGridVertex(mesh.GetVertexPosition(polygon[corner].Data()));
+			}
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	const auto sourceLeftTriangles = GetGroupTriangles(0U);
+	const auto sourceRightTriangles = GetGroupTriangles(1U);
+
+	std::optional<MeshOptimizer::MeshOptimizeResult> optResult = MeshOptimizer::OptimizeMesh(mesh);
+	assert(optResult.has_value());
+	assert(optResult->optimizedACMR < optResult->sourceACMR);
+	printf("ACMR : source %f, optimized %f\n", optResult->sourceACMR, optResult->optimizedACMR);
+
+	// Triangles stay in their groups and attributes follow their vertices.
+	assert(GetGroupTriangles(0U) == sourceLeftTriangles);
+	assert(GetGroupTriangles(1U) == sourceRightTriangles);
+	for (uint32_t vertexIndex = 0U; vertexIndex < mesh.GetVertexCount(); ++vertexIndex)
+	{
+		const cd::Point& position = mesh.GetVertexPosition(vertexIndex);
+		const cd::Direction& normal = mesh.GetVertexNormal(vertexIndex);
+		const cd::UV& uv = mesh.GetVertexUV(0U, vertexIndex);
+		assert(normal.x() == position.x() && normal.y() == position.y());
+		assert(uv.x() == position.x() / gridSize && uv.y() == position.y() / gridSize);
+	}
+
+	// Vertices are renumbered by first use across groups and the unused one goes last.
+	assert(0U == mesh.GetPolygonGroup(0U)[0][0].Data());
+	assert(rowVertexCount * rowVertexCount == GetGridVertex(mesh.GetVertexPosition(mesh.GetVertexCount() - 1U)));
+
+	// Meshes which are not triangulated are left unchanged.
+	cd::Mesh quadMesh;
+	quadMesh.Init(4U);
+	quadMesh.AddPolygonGroup(cd::PolygonGroup{ cd::Polygon{ 0U, 1U, 2U, 3U } });
+	assert(!MeshOptimizer::OptimizeMesh(quadMesh).has_value());
+	assert(3U == quadMesh.GetPolygonGroup(0U)[0][3].Data());
+
+	printf("\n[Success] Test_OptimizeMesh\n");
+}
+
+int main()
+{
+	Test_RenderQueueKey();
+	Test_RenderQueueSort();
+	Test_RenderQueueGroup();
+	Test_RenderQueueSplitChunks();
+	Benchmark_RenderQueueSort();
+	Test_RenderGraphCulling();
+	Test_RenderGraphAliasing();
+	Test_ShadowAtlas();
+	Test_ShadowCache();
+	Test_LightClusters();
+	Test_MeshLOD();
+	Test_OcclusionBuffer();
+	Benchmark_OcclusionBuffer();
+	Test_OffsetAllocator();
+	Test_VertexQuantization();
+	Test_MeshOptimizer();
+	Test_OptimizeMesh();
+
+	return 0;
+}
\ No newline at end of file
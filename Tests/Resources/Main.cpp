@@ -0,0 +1,348 @@
+#include "Rendering/Resources/IResource.h"
+#include "Rendering/Resources/ResourceHandle.h"
+#include "Rendering/Resources/ResourceScheduler.h"
+#include "Scheduler/ThreadPool.h"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+// Walks through the same status machine as mesh and texture resources without any GPU work.
+class TestResource : public IResource
+{
+public:
+	virtual void Update() override
+	{
+		switch (GetStatus())
+		{
+		case ResourceStatus::Loading:
+			if (m_hasInput)
+			{
+				SetStatus(ResourceStatus::Loaded);
+			}
+			break;
+		case ResourceStatus::Loaded:
+			SetStatus(ResourceStatus::Building);
+			break;
+		case ResourceStatus::Building:
+			m_buildThreadID = std::this_thread::get_id();
+			m_cpuMemorySize = m_dataSize;
+			SetStatus(ResourceStatus::Built);
+			break;
+		case ResourceStatus::Built:
+			m_uploadThreadID = std::this_thread::get_id();
+			m_gpuMemorySize = m_dataSize;
+			SetStatus(ResourceStatus::Ready);
+			break;
+		case ResourceStatus::Garbage:
+			m_cpuMemorySize = 0U;
+			m_gpuMemorySize = 0U;
+			SetStatus(ResourceStatus::Destroyed);
+			break;
+		default:
+			break;
+		}
+	}
+
+	virtual void Reset() override
+	{
+		m_cpuMemorySize = 0U;
+		m_gpuMemorySize = 0U;
+		SetStatus(ResourceStatus::Loading);
+	}
+
+	virtual bool CanBuildAsync() const override
+	{
+		ResourceStatus status = GetStatus();
+		return (ResourceStatus::Loading == status && m_hasInput) || ResourceStatus::Loaded == status || ResourceStatus::Building == status;
+	}
+
+	virtual uint64_t GetUploadSize() const override { return m_dataSize; }
+	virtual uint64_t GetCPUMemorySize() const override { return m_cpuMemorySize; }
+	virtual uint64_t GetGPUMemorySize() const override { return m_gpuMemorySize; }
+
+	void SetDataSize(uint64_t dataSize) { m_dataSize = dataSize; }
+	void SetInput(bool hasInput) { m_hasInput = hasInput; }
+	std::thread::id GetBuildThreadID() const { return m_buildThreadID; }
+	std::thread::id GetUploadThreadID() const { return m_uploadThreadID; }
+
+private:
+	uint64_t m_dataSize = 0U;
+	uint64_t m_cpuMemorySize = 0U;
+	uint64_t m_gpuMemorySize = 0U;
+	bool m_hasInput = true;
+	std::thread::id m_buildThreadID;
+	std::thread::id m_uploadThreadID;
+};
+
+void UpdateFrame(ResourceScheduler& scheduler, std::vector<TestResource>& resources)
+{
+	scheduler.BeginFrame();
+	for (TestResource& resource : resources)
+	{
+		scheduler.UpdateResource(&resource);
+	}
+	scheduler.EndFrame();
+}
+
+void Test_StatusProgression()
+{
+	cdtools::PerformanceProfiler perf("Test_StatusProgression");
+
+	// Without build workers, every frame advances one stage on main thread.
+	ResourceScheduler scheduler;
+	assert(0U == scheduler.GetBuildWorkerCount());
+
+	std::vector<TestResource> resources(1);
+	TestResource& resource = resources[0];
+	resource.SetInput(false);
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Loading == resource.GetStatus());
+
+	resource.SetInput(true);
+	const ResourceStatus expectedStatus[] = { ResourceStatus::Loaded, ResourceStatus::Building, ResourceStatus::Built, ResourceStatus::Ready };
+	for (ResourceStatus status : expectedStatus)
+	{
+		UpdateFrame(scheduler, resources);
+		assert(status == resource.GetStatus());
+	}
+	assert(std::this_thread::get_id() == resource.GetBuildThreadID());
+	assert(std::this_thread::get_id() == resource.GetUploadThreadID());
+
+	// Ready resources stay ready.
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Ready == resource.GetStatus());
+
+	printf("\n[Success] Test_StatusProgression\n");
+}
+
+void Test_AsyncBuild()
+{
+	cdtools::PerformanceProfiler perf("Test_AsyncBuild");
+
+	ResourceScheduler scheduler;
+	scheduler.SetBuildWorkerCount(2U);
+	assert(2U == scheduler.GetBuildWorkerCount());
+
+	// Engine pool which runs systems. Its helpers must never pick up resource builds.
+	ThreadPool enginePool(2U);
+
+	std::vector<TestResource> resources(64);
+	UpdateFrame(scheduler, resources);
+	while (enginePool.TryRunPendingTask())
+	{
+	}
+	assert(!enginePool.TryRunPendingTask());
+
+	// CPU stages from Loading to Built finish in one build task.
+	// Poll instead of WaitBuilds() which helps on calling thread.
+	while (scheduler.GetBuildingCount() > 0U)
+	{
+		std::this_thread::yield();
+	}
+	for (const TestResource& resource : resources)
+	{
+		assert(ResourceStatus::Built == resource.GetStatus());
+		assert(!resource.IsBuilding());
+		assert(std::this_thread::get_id() != resource.GetBuildThreadID());
+	}
+
+	// Uploads stay on main thread.
+	scheduler.SetUploadBudget(UINT64_MAX, 1000.0f);
+	UpdateFrame(scheduler, resources);
+	for (const TestResource& resource : resources)
+	{
+		assert(ResourceStatus::Ready == resource.GetStatus());
+		assert(std::this_thread::get_id() == resource.GetUploadThreadID());
+	}
+
+	// Resources waiting for inputs are not submitted.
+	std::vector<TestResource> waitingResources(1);
+	waitingResources[0].SetInput(false);
+	UpdateFrame(scheduler, waitingResources);
+	assert(0U == scheduler.GetBuildingCount());
+	assert(ResourceStatus::Loading == waitingResources[0].GetStatus());
+
+	// Switching back to main thread waits for building resources.
+	waitingResources[0].SetInput(true);
+	UpdateFrame(scheduler, waitingResources);
+	scheduler.SetBuildWorkerCount(0U);
+	assert(0U == scheduler.GetBuildWorkerCount());
+	assert(ResourceStatus::Built == waitingResources[0].GetStatus());
+
+	printf("\n[Success] Test_AsyncBuild\n");
+}
+
+void Test_UploadBudget()
+{
+	cdtools::PerformanceProfiler perf("Test_UploadBudget");
+
+	ResourceScheduler scheduler;
+	scheduler.SetUploadBudget(250U, 1000.0f);
+
+	std::vector<TestResource> resources(5);
+	for (TestResource& resource : resources)
+	{
+		resource.SetDataSize(100U);
+		resource.SetStatus(ResourceStatus::Built);
+	}
+
+	auto CountReady = [&resources]()
+	{
+		uint32_t readyCount = 0U;
+		for (const TestResource& resource : resources)
+		{
+			readyCount += ResourceStatus::Ready == resource.GetStatus() ? 1U : 0U;
+		}
+		return readyCount;
+	};
+
+	UpdateFrame(scheduler, resources);
+	assert(2U == CountReady());
+	assert(200U == scheduler.GetLastUploadBytes());
+
+	UpdateFrame(scheduler, resources);
+	assert(4U == CountReady());
+
+	UpdateFrame(scheduler, resources);
+	assert(5U == CountReady());
+	assert(100U == scheduler.GetLastUploadBytes());
+
+	// The first upload always runs even if it is larger than the budget.
+	std::vector<TestResource> largeResources(2);
+	for (TestResource& resource : largeResources)
+	{
+		resource.SetDataSize(1000U);
+		resource.SetStatus(ResourceStatus::Built);
+	}
+	UpdateFrame(scheduler, largeResources);
+	assert(ResourceStatus::Ready == largeResources[0].GetStatus());
+	assert(ResourceStatus::Built == largeResources[1].GetStatus());
+	assert(1000U == scheduler.GetLastUploadBytes());
+
+	printf("\n[Success] Test_UploadBudget\n");
+}
+
+void Test_Eviction()
+{
+	cdtools::PerformanceProfiler perf("Test_Eviction");
+
+	ResourceScheduler scheduler;
+	assert(ResourceScheduler::DefaultCPUMemoryBudget == scheduler.GetCPUMemoryBudget());
+	assert(ResourceScheduler::DefaultGPUMemoryBudget == scheduler.GetGPUMemoryBudget());
+	scheduler.SetUploadBudget(UINT64_MAX, 1000.0f);
+
+	std::vector<TestResource> resources(4);
+	for (TestResource& resource : resources)
+	{
+		resource.SetDataSize(100U);
+		resource.SetStatus(ResourceStatus::Built);
+	}
+
+	// Resource 0 is used in every frame. Resource 1 and 2 were used in earlier frames than resource 3.
+	ResourceHandle<TestResource> pHandle0(&resources[0]);
+	ResourceHandle<TestResource> pHandle1(&resources[1]);
+	ResourceHandle<TestResource> pHandle2(&resources[2]);
+	ResourceHandle<TestResource> pHandle3(&resources[3]);
+	UpdateFrame(scheduler, resources);
+	pHandle1.Reset();
+	pHandle2.Reset();
+	UpdateFrame(scheduler, resources);
+	pHandle3.Reset();
+	UpdateFrame(scheduler, resources);
+	assert(400U == scheduler.GetGPUMemoryUsage());
+	assert(0U == scheduler.GetLastEvictedCount());
+
+	// Least recently used resources are evicted until usage fits the budget. Referenced ones are never evicted.
+	scheduler.SetMemoryBudget(UINT64_MAX, 250U);
+	UpdateFrame(scheduler, resources);
+	assert(2U == scheduler.GetLastEvictedCount());
+	assert(200U == scheduler.GetGPUMemoryUsage());
+	assert(ResourceStatus::Ready == resources[0].GetStatus());
+	assert(ResourceStatus::Destroyed == resources[1].GetStatus());
+	assert(ResourceStatus::Destroyed == resources[2].GetStatus());
+	assert(ResourceStatus::Ready == resources[3].GetStatus());
+
+	scheduler.SetMemoryBudget(UINT64_MAX, 50U);
+	UpdateFrame(scheduler, resources);
+	assert(1U == scheduler.GetLastEvictedCount());
+	assert(ResourceStatus::Ready == resources[0].GetStatus());
+	assert(ResourceStatus::Destroyed == resources[3].GetStatus());
+	assert(100U == scheduler.GetGPUMemoryUsage());
+
+	// Usage can stay over budget when all resources are referenced.
+	UpdateFrame(scheduler, resources);
+	assert(0U == scheduler.GetLastEvictedCount());
+	assert(100U == scheduler.GetGPUMemoryUsage());
+
+	printf("\n[Success] Test_Eviction\n");
+}
+
+void Test_Reload()
+{
+	cdtools::PerformanceProfiler perf("Test_Reload");
+
+	ResourceScheduler scheduler;
+	scheduler.SetBuildWorkerCount(1U);
+	scheduler.SetUploadBudget(UINT64_MAX, 1000.0f);
+	scheduler.SetMemoryBudget(0U, 0U);
+
+	std::vector<TestResource> resources(1);
+	TestResource& resource = resources[0];
+	resource.SetDataSize(100U);
+	resource.SetStatus(ResourceStatus::Built);
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Ready == resource.GetStatus());
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Destroyed == resource.GetStatus());
+	assert(0U == resource.GetCPUMemorySize() && 0U == resource.GetGPUMemorySize());
+
+	// Evicted resource goes through all stages again as soon as it is referenced.
+	ResourceHandle<TestResource> pHandle(&resource);
+	assert(1U == resource.GetRefCount());
+	UpdateFrame(scheduler, resources);
+	scheduler.WaitBuilds();
+	assert(ResourceStatus::Built == resource.GetStatus());
+
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Ready == resource.GetStatus());
+	UpdateFrame(scheduler, resources);
+	assert(0U == scheduler.GetLastEvictedCount());
+	assert(100U == scheduler.GetGPUMemoryUsage());
+
+	// Copies and moves of handles keep the count.
+	{
+		ResourceHandle<TestResource> pCopy = pHandle;
+		assert(2U == resource.GetRefCount());
+		ResourceHandle<TestResource> pMoved = cd::MoveTemp(pCopy);
+		assert(2U == resource.GetRefCount());
+	}
+	assert(1U == resource.GetRefCount());
+
+	pHandle.Reset();
+	assert(0U == resource.GetRefCount());
+	UpdateFrame(scheduler, resources);
+	assert(ResourceStatus::Destroyed == resource.GetStatus());
+
+	printf("\n[Success] Test_Reload\n");
+}
+
+}
+
+int main()
+{
+	Test_StatusProgression();
+	Test_AsyncBuild();
+	Test_UploadBudget();
+	Test_Eviction();
+	Test_Reload();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "Core/StringCrc.h"
+#include "Scheduler/SystemScheduler.h"
+#include "Scheduler/ThreadPool.h"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+#define DEFINE_TEST_COMPONENT(Name) \
+struct Name \
+{ \
+	static constexpr StringCrc GetClassName() \
+	{ \
+		constexpr StringCrc className(#Name); \
+		return className; \
+	} \
+}
+
+DEFINE_TEST_COMPONENT(ComponentA);
+DEFINE_TEST_COMPONENT(ComponentB);
+DEFINE_TEST_COMPONENT(ComponentC);
+
+void Test_ThreadPool()
+{
+	cdtools::PerformanceProfiler perf("Test_ThreadPool");
+
+	ThreadPool threadPool(4U);
+	assert(4U == threadPool.GetWorkerCount());
+	assert(ThreadPool::InvalidWorkerIndex == threadPool.GetCurrentWorkerIndex());
+
+	constexpr int taskCount = 10000;
+	std::atomic<int> sum = 0;
+	for (int taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+	{
+		threadPool.Submit([&sum, &threadPool, taskIndex]()
+		{
+			assert(threadPool.GetCurrentWorkerIndex() < threadPool.GetWorkerCount() ||
+				ThreadPool::InvalidWorkerIndex == threadPool.GetCurrentWorkerIndex());
+
+			// Nested tasks go to the queue of current worker.
+			if (taskIndex % 2 == 0)
+			{
+				threadPool.Submit([&sum]() { sum.fetch_add(1); });
+			}
+			sum.fetch_add(1);
+		});
+	}
+	threadPool.WaitIdle();
+	assert(taskCount + taskCount / 2 == sum.load());
+
+	printf("\n[Success] Test_ThreadPool\n");
+}
+
+void Test_SystemDependency()
+{
+	cdtools::PerformanceProfiler perf("Test_SystemDependency");
+
+	assert(SystemAccess().Write<ComponentA>().ConflictsWith(SystemAccess().Read<ComponentA>()));
+	assert(SystemAccess().Read<ComponentA>().ConflictsWith(SystemAccess().Write<ComponentA>()));
+	assert(!SystemAccess().Read<ComponentA>().ConflictsWith(SystemAccess().Read<ComponentA>()));
+	assert(!SystemAccess().Write<ComponentA>().ConflictsWith(SystemAccess().Write<ComponentB>()));
+	assert(SystemAccess().WriteAll().ConflictsWith(SystemAccess()));
+	assert(SystemAccess().WriteResource(StringCrc("Resource")).ConflictsWith(SystemAccess().ReadResource(StringCrc("Resource"))));
+
+	ThreadPool threadPool(3U);
+	SystemScheduler scheduler(&threadPool);
+
+	std::thread::id mainThreadID = std::this_thread::get_id();
+	std::vector<int> order;
+	std::mutex orderMutex;
+	auto record = [&order, &orderMutex](int value)
+	{
+		std::lock_guard<std::mutex> lock(orderMutex);
+		order.push_back(value);
+	};
+
+	int valueA = 0;
+	int valueB = 0;
+	int valueC = 0;
+
+	// 0 : Write A
+	// 1 : Write B, runs in parallel with 0
+	// 2 : Read A, Read B, Write C, waits 0 and 1
+	// 3 : Main thread, Read C, waits 2
+	scheduler.AddSystem("WriteA", SystemAccess().Write<ComponentA>(), [&](float)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		valueA = 1;
+		record(0);
+	});
+	scheduler.AddSystem("WriteB", SystemAccess().Write<ComponentB>(), [&](float)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		valueB = 2;
+		record(1);
+	});
+	scheduler.AddSystem("ReadABWriteC", SystemAccess().Read<ComponentA, ComponentB>().Write<ComponentC>(), [&](float)
+	{
+		assert(1 == valueA && 2 == valueB);
+		valueC = valueA + valueB;
+		record(2);
+	});
+	SystemScheduler::SystemID readCID = scheduler.AddSystem("ReadC", SystemAccess().Read<ComponentC>().MainThread(), [&](float)
+	{
+		assert(std::this_thread::get_id() == mainThreadID);
+		assert(3 == valueC);
+		record(3);
+	});
+
+	for (int frame = 0; frame < 100; ++frame)
+	{
+		order.clear();
+		valueA = valueB = valueC = 0;
+		scheduler.Execute(0.016f);
+
+		assert(4 == order.size());
+		assert(2 == order[2] && 3 == order[3]);
+		assert(SystemScheduler::MainThreadIndex == scheduler.GetSystemStats(readCID).threadIndex);
+	}
+
+	// WriteA and WriteB sleep 5ms in parallel so that frame time should be less than serial execution.
+	const SystemScheduler::SystemStats& statsA = scheduler.GetSystemStats(0U);
+	const SystemScheduler::SystemStats& statsB = scheduler.GetSystemStats(1U);
+	printf("WriteA : [%.2f, %.2f] ms on thread %u\n", statsA.beginTime, statsA.endTime, statsA.threadIndex);
+	printf("WriteB : [%.2f, %.2f] ms on thread %u\n", statsB.beginTime, statsB.endTime, statsB.threadIndex);
+	printf("Frame : %.2f ms\n", scheduler.GetFrameTime());
+
+	// Disabled systems don't block dependents. ReadC runs immediately while WriteA and WriteB are sleeping.
+	scheduler.SetSystemEnable(2U, false);
+	order.clear();
+	valueC = 3;
+	scheduler.Execute(0.016f);
+	assert(3 == order.size());
+	assert(3 == order[0]);
+
+	printf("\n[Success] Test_SystemDependency\n");
+}
+
+void Test_SingleThread()
+{
+	cdtools::PerformanceProfiler perf("Test_SingleThread");
+
+	SystemScheduler scheduler(nullptr);
+	assert(1U == scheduler.GetThreadCount());
+
+	std::vector<int> order;
+	for (int index = 0; index < 8; ++index)
+	{
+		scheduler.AddSystem("System", SystemAccess(), [&order, index](float) { order.push_back(index); });
+	}
+	scheduler.Execute(0.016f);
+
+	assert(8 == order.size());
+	for (int index = 0; index < 8; ++index)
+	{
+		assert(index == order[index]);
+	}
+
+	printf("\n[Success] Test_SingleThread\n");
+}
+
+}
+
+int main()
+{
+	Test_ThreadPool();
+	Test_SystemDependency();
+	Test_SingleThread();
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "Resources/BinarySnapshot.h"
+#include "Resources/MappedFile.h"
+#include "Utilities/PerformanceProfiler.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+using namespace engine;
+
+constexpr uint32_t TestVersion = 7U;
+
+struct TestNode
+{
+	float position[3];
+	uint32_t parent;
+};
+
+std::string GetTestFilePath(const char* pFileName)
+{
+	return (std::filesystem::temp_directory_path() / pFileName).string();
+}
+
+void Test_MappedFile()
+{
+	cdtools::PerformanceProfiler perf("Test_MappedFile");
+
+	std::string filePath = GetTestFilePath("CatDogTestMappedFile.bin");
+	{
+		std::ofstream fout(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		fout.write("CatDog", 6);
+	}
+
+	MappedFile mappedFile;
+	assert(!mappedFile.IsOpen());
+	assert(mappedFile.Open(filePath.c_str()));
+	assert(6 == mappedFile.GetSize());
+	assert(0 == std::memcmp(mappedFile.GetData(), "CatDog", 6));
+	mappedFile.Close();
+	assert(!mappedFile.IsOpen() && nullptr == mappedFile.GetData());
+
+	assert(!mappedFile.Open(GetTestFilePath("CatDogTestMissingFile.bin").c_str()));
+	std::filesystem::remove(filePath);
+
+	printf("\n[Success] Test_MappedFile\n");
+}
+
+void Test_BinarySnapshot()
+{
+	cdtools::PerformanceProfiler perf("Test_BinarySnapshot");
+
+	constexpr uint32_t nodeCount = 1000U;
+	std::vector<TestNode> nodes(nodeCount);
+	std::vector<std::byte> blobData(12345);
+	for (uint32_t nodeIndex = 0U; nodeIndex < nodeCount; ++nodeIndex)
+	{
+		nodes[nodeIndex] = TestNode{ { static_cast<float>(nodeIndex), 1.0f, 2.0f }, nodeIndex / 2U };
+	}
+	for (size_t byteIndex = 0; byteIndex < blobData.size(); ++byteIndex)
+	{
+		blobData[byteIndex] = static_cast<std::byte>(byteIndex % 251);
+	}
+
+	std::string filePath = GetTestFilePath("CatDogTestSnapshot.cdsnap");
+	{
+		BinarySnapshotWriter writer(TestVersion);
+		SnapshotBlob blob = writer.AddBlob(blobData.data(), blobData.size());
+		writer.AddSection(0U, nodes);
+		writer.AddSection(1U, std::vector<SnapshotBlob>{ blob });
+		writer.AddSection(2U, std::vector<uint32_t>());
+		assert(writer.Write(filePath.c_str()));
+	}
+
+	{
+		BinarySnapshotReader reader;
+		assert(!reader.Open(filePath.c_str(), TestVersion + 1U));
+		assert(reader.Open(filePath.c_str(), TestVersion));
+
+		std::span<const TestNode> readNodes = reader.GetElements<TestNode>(0U);
+		assert(nodeCount == readNodes.size());
+		assert(0 == reinterpret_cast<uintptr_t>(readNodes.data()) % SnapshotAlignment);
+		for (uint32_t nodeIndex = 0U; nodeIndex < nodeCount; ++nodeIndex)
+		{
+			assert(readNodes[nodeIndex].position[0] == static_cast<float>(nodeIndex));
+			assert(readNodes[nodeIndex].parent == nodeIndex / 2U);
+		}
+
+		// Element size mismatch and missing sections return empty spans.
+		assert(reader.GetElements<uint32_t>(0U).empty());
+		assert(reader.GetElements<uint32_t>(2U).empty());
+		assert(nullptr != reader.GetSection(2U));
+		assert(nullptr == reader.GetSection(3U));
+
+		std::span<const SnapshotBlob> blobs = reader.GetElements<SnapshotBlob>(1U);
+		assert(1 == blobs.size());
+		std::span<const std::byte> readBlob = reader.GetBlob(blobs[0]);
+		assert(readBlob.size() == blobData.size());
+		assert(0 == std::memcmp(readBlob.data(), blobData.data(), blobData.size()));
+		assert(reader.GetBlob(SnapshotBlob{ blobs[0].offset, UINT64_MAX }).empty());
+
+		// Mapping is still valid after reader is destroyed as long as someone shares it.
+		std::shared_ptr<const MappedFile> pMappedFile = reader.GetMappedFile();
+		reader = BinarySnapshotReader();
+		assert(0 == std::memcmp(pMappedFile->GetData() + blobs[0].offset, blobData.data(), blobData.size()));
+	}
+
+	// Truncated file is rejected.
+	std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) - 8);
+	{
+		BinarySnapshotReader reader;
+		assert(!reader.Open(filePath.c_str(), TestVersion));
+	}
+	std::filesystem::remove(filePath);
+
+	printf("\n[Success] Test_BinarySnapshot\n");
+}
+
+}
+
+int main()
+{
+	Test_MappedFile();
+	Test_BinarySnapshot();
+
+	return 0;
+}
\ No newline at end of file